@@ -41,6 +41,7 @@
 #include "allocation.h"
 
 #include "cap.h"
+#include "cos_table.h"
 #include "cpu_registers.h"
 #include "cpuinfo.h"
 #include "log.h"
@@ -99,6 +100,41 @@ hw_alloc_assoc_read(const unsigned lcore, unsigned *class_id)
         return PQOS_RETVAL_OK;
 }
 
+/**
+ * @brief Checks occupancy table if COS is used in selected domains
+ *
+ * @param [in] l2_only COS is checked in L2 cluster only
+ * @param [in] l3cat_id_set L3 CAT domain is selected
+ * @param [in] l3cat_id L3 CAT resource id
+ * @param [in] l2cat_id L2 CAT resource id
+ * @param [in] mba_id_set MBA domain is selected
+ * @param [in] mba_id MBA resource id
+ * @param [in] cos class of service
+ *
+ * @return number of cores using \a cos
+ */
+static unsigned
+cos_table_used(const int l2_only,
+               const int l3cat_id_set,
+               const unsigned l3cat_id,
+               const unsigned l2cat_id,
+               const int mba_id_set,
+               const unsigned mba_id,
+               const unsigned cos)
+{
+        unsigned used = 0;
+
+        if (l2_only)
+                return cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, l2cat_id, cos);
+
+        if (l3cat_id_set)
+                used += cos_table_refcnt(TOPO_OBJ_L3CAT, l3cat_id, cos);
+        if (mba_id_set)
+                used += cos_table_refcnt(TOPO_OBJ_MBA, mba_id, cos);
+
+        return used;
+}
+
 /**
  * @brief Gets unused COS on a socket or L2 cluster
  *
@@ -187,6 +223,53 @@ hw_alloc_assoc_unused(const unsigned technology,
                         }
         }
 
+        /* Find unused COS in occupancy table */
+        ret = cos_table_sync(cpu);
+        if (ret == PQOS_RETVAL_OK) {
+                int verified = 0;
+
+                for (cos = num_cos - 1; cos != 0; cos--) {
+                        /* COS does not support L3CAT and MBA need to check
+                        L2 cluster only */
+                        const int l2_only = cos >= num_l3_cos &&
+                                            cos >= num_mba_cos && l2cat_id_set;
+
+                        if (cos_table_used(l2_only, l3cat_id_set, l3cat_id,
+                                           l2cat_id, mba_id_set, mba_id,
+                                           cos))
+                                continue;
+
+                        /* Table may miss changes made outside of the
+                        library, check hardware before handing out COS */
+                        if (!verified) {
+                                if (l3cat_id_set)
+                                        ret = cos_table_verify(TOPO_OBJ_L3CAT,
+                                                               l3cat_id);
+                                if (ret == PQOS_RETVAL_OK && mba_id_set)
+                                        ret = cos_table_verify(TOPO_OBJ_MBA,
+                                                               mba_id);
+                                if (ret == PQOS_RETVAL_OK && l2cat_id_set)
+                                        ret = cos_table_verify(
+                                            TOPO_OBJ_L2_CLUSTER, l2cat_id);
+                                if (ret != PQOS_RETVAL_OK)
+                                        return ret;
+                                verified = 1;
+
+                                if (cos_table_used(l2_only, l3cat_id_set,
+                                                   l3cat_id, l2cat_id,
+                                                   mba_id_set, mba_id, cos))
+                                        continue;
+                        }
+
+                        *class_id = cos;
+                        return PQOS_RETVAL_OK;
+                }
+
+                return PQOS_RETVAL_RESOURCE;
+        }
+        if (ret != PQOS_RETVAL_RESOURCE)
+                return ret;
+
         /* Create a list of used COS */
         for (i = 0; i < cpu->num_cores; i++) {
                 if (l3cat_id_set && cpu->cores[i].l3cat_id != l3cat_id)
@@ -253,7 +336,10 @@ pqos_alloc_init(const struct pqos_cpuinfo *cpu,
         if (interface == PQOS_INTER_OS ||
             interface == PQOS_INTER_OS_RESCTRL_MON)
                 ret = os_alloc_init(cpu, cap);
+        else
 #endif
+                cos_table_init();
+
         return ret;
 }
 
@@ -268,6 +354,8 @@ pqos_alloc_fini(void)
             interface == PQOS_INTER_OS_RESCTRL_MON)
                 ret = os_alloc_fini();
 #endif
+        cos_table_fini();
+
         return ret;
 }
 
@@ -1114,6 +1202,8 @@ hw_alloc_assoc_write(const unsigned lcore, const unsigned class_id)
         if (ret != MACHINE_RETVAL_OK)
                 return PQOS_RETVAL_ERROR;
 
+        cos_table_update(lcore, class_id);
+
         return PQOS_RETVAL_OK;
 }
 
@@ -1189,17 +1279,16 @@ hw_alloc_assoc_get(const unsigned lcore, unsigned *class_id)
 }
 
 int
-hw_alloc_assign(const unsigned technology,
-                const unsigned *core_array,
-                const unsigned core_num,
-                unsigned *class_id)
+hw_alloc_cos_unused(const unsigned technology,
+                    const unsigned *core_array,
+                    const unsigned core_num,
+                    unsigned *class_id)
 {
         const int l3_req = ((technology & (1 << PQOS_CAP_TYPE_L3CA)) != 0);
         const int l2_req = ((technology & (1 << PQOS_CAP_TYPE_L2CA)) != 0);
         const int mba_req = ((technology & (1 << PQOS_CAP_TYPE_MBA)) != 0);
         unsigned l3cat_id = 0, l2cat_id = 0, mba_id = 0;
         unsigned i;
-        int ret;
         const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
 
         ASSERT(core_num > 0);
@@ -1212,51 +1301,59 @@ hw_alloc_assign(const unsigned technology,
                 const struct pqos_coreinfo *pi = NULL;
 
                 pi = pqos_cpu_get_core_info(cpu, core_array[i]);
-                if (pi == NULL) {
-                        ret = PQOS_RETVAL_PARAM;
-                        goto pqos_alloc_assign_exit;
-                }
+                if (pi == NULL)
+                        return PQOS_RETVAL_PARAM;
 
                 if (l3_req) {
-                        if (i != 0 && l3cat_id != pi->l3cat_id) {
-                                ret = PQOS_RETVAL_PARAM;
-                                goto pqos_alloc_assign_exit;
-                        }
+                        if (i != 0 && l3cat_id != pi->l3cat_id)
+                                return PQOS_RETVAL_PARAM;
                         l3cat_id = pi->l3cat_id;
                 }
                 if (mba_req) {
-                        if (i != 0 && mba_id != pi->mba_id) {
-                                ret = PQOS_RETVAL_PARAM;
-                                goto pqos_alloc_assign_exit;
-                        }
+                        if (i != 0 && mba_id != pi->mba_id)
+                                return PQOS_RETVAL_PARAM;
                         mba_id = pi->mba_id;
                 }
                 if (l2_req && !l3_req && !mba_req) {
                         /* only L2 is requested
                          * The smallest manageable entity is L2 cluster
                          */
-                        if (i != 0 && l2cat_id != pi->l2_id) {
-                                ret = PQOS_RETVAL_PARAM;
-                                goto pqos_alloc_assign_exit;
-                        }
+                        if (i != 0 && l2cat_id != pi->l2_id)
+                                return PQOS_RETVAL_PARAM;
                         l2cat_id = pi->l2_id;
                 }
         }
 
         /* find an unused class from highest down */
-        ret = hw_alloc_assoc_unused(technology, l3cat_id, l2cat_id, mba_id,
-                                    class_id);
+        return hw_alloc_assoc_unused(technology, l3cat_id, l2cat_id, mba_id,
+                                     class_id);
+}
+
+int
+hw_alloc_assign(const unsigned technology,
+                const unsigned *core_array,
+                const unsigned core_num,
+                unsigned *class_id)
+{
+        unsigned i;
+        int ret;
+
+        ASSERT(core_num > 0);
+        ASSERT(core_array != NULL);
+        ASSERT(class_id != NULL);
+        ASSERT(technology != 0);
+
+        ret = hw_alloc_cos_unused(technology, core_array, core_num, class_id);
         if (ret != PQOS_RETVAL_OK)
-                goto pqos_alloc_assign_exit;
+                return ret;
 
         /* assign cores to the unused class */
         for (i = 0; i < core_num; i++) {
                 ret = hw_alloc_assoc_write(core_array[i], *class_id);
                 if (ret != PQOS_RETVAL_OK)
-                        goto pqos_alloc_assign_exit;
+                        return ret;
         }
 
-pqos_alloc_assign_exit:
         return ret;
 }
 
@@ -134,6 +134,28 @@ PQOS_LOCAL int hw_alloc_assoc_unused(const unsigned technology,
                                      unsigned mba_id,
                                      unsigned *class_id);
 
+/**
+ * @brief Hardware interface to find unused COS for cores in \a core_array
+ *
+ * Cores need to belong to one resource entity of requested technologies,
+ * see \a pqos_alloc_assign. No association is changed.
+ *
+ * @param [in] technology bit mask selecting technologies
+ *             (1 << enum pqos_cap_type)
+ * @param [in] core_array list of core ids
+ * @param [in] core_num number of core ids in the \a core_array
+ * @param [out] class_id unused COS
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if cores belong to different resource entities
+ * @retval PQOS_RETVAL_RESOURCE if no class of service is available
+ */
+PQOS_LOCAL int hw_alloc_cos_unused(const unsigned technology,
+                                   const unsigned *core_array,
+                                   const unsigned core_num,
+                                   unsigned *class_id);
+
 /**
  * @brief Hardware interface to associate \a lcore
  *        with given class of service
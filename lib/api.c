@@ -43,122 +43,15 @@
 #include "os_allocation.h"
 #include "os_monitoring.h"
 #include "pqos_internal.h"
+#include "state.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 /**
- * Value marking monitoring group structure as "valid".
- * Group becomes "valid" after successful pqos_mon_start() or
- * pqos_mon_start_pid() call.
+ * PQoS API functions of the selected interface
  */
-#define GROUP_VALID_MARKER (0x00DEAD00)
-
-/**
- * PQoS API functions
- */
-static struct pqos_api {
-        /** Resets monitoring */
-        int (*mon_reset)(void);
-        /** Reads RMID association lcore */
-        int (*mon_assoc_get)(const unsigned lcore, pqos_rmid_t *rmid);
-        /** Starts resource monitoring on selected group of cores */
-        int (*mon_start_cores)(const unsigned num_cores,
-                               const unsigned *cores,
-                               const enum pqos_mon_event event,
-                               void *context,
-                               struct pqos_mon_data *group,
-                               const struct pqos_mon_options *opt);
-        /** Starts resource monitoring of selected pids */
-        int (*mon_start_pids)(const unsigned num_pids,
-                              const pid_t *pids,
-                              const enum pqos_mon_event event,
-                              void *context,
-                              struct pqos_mon_data *group);
-        /** Adds pids to the resource monitoring grpup */
-        int (*mon_add_pids)(const unsigned num_pids,
-                            const pid_t *pids,
-                            struct pqos_mon_data *group);
-        /** Remove pids from the resource monitoring group */
-        int (*mon_remove_pids)(const unsigned num_pids,
-                               const pid_t *pids,
-                               struct pqos_mon_data *group);
-        /** Starts uncore monitoring */
-        int (*mon_start_uncore)(const unsigned num_sockets,
-                                const unsigned *sockets,
-                                const enum pqos_mon_event event,
-                                void *context,
-                                struct pqos_mon_data *group);
-        /** Stops resource monitoring data for selected monitoring group */
-        int (*mon_stop)(struct pqos_mon_data *group);
-
-        /** Associates lcore with given class of service */
-        int (*alloc_assoc_set)(const unsigned lcore, const unsigned class_id);
-        /** Reads association of lcore with class of service */
-        int (*alloc_assoc_get)(const unsigned lcore, unsigned *class_id);
-        /** Associate task with given class of service */
-        int (*alloc_assoc_set_pid)(const pid_t task, const unsigned class_id);
-        /** Read association of task with class of service */
-        int (*alloc_assoc_get_pid)(const pid_t task, unsigned *class_id);
-        /** Assign first available COS */
-        int (*alloc_assign)(const unsigned technology,
-                            const unsigned *core_array,
-                            const unsigned core_num,
-                            unsigned *class_id);
-        /** Reassign cores to default COS */
-        int (*alloc_release)(const unsigned *core_array,
-                             const unsigned core_num);
-        /** Assign first available COS to tasks */
-        int (*alloc_assign_pid)(const unsigned technology,
-                                const pid_t *task_array,
-                                const unsigned task_num,
-                                unsigned *class_id);
-        /** Reassign tasks to default COS */
-        int (*alloc_release_pid)(const pid_t *task_array,
-                                 const unsigned task_num);
-        /** Resets configuration of allocation technologies */
-        int (*alloc_reset)(const struct pqos_alloc_config *cfg);
-
-        /** Sets L3 classes of service */
-        int (*l3ca_set)(const unsigned l3cat_id,
-                        const unsigned num_cos,
-                        const struct pqos_l3ca *ca);
-        /** Reads L3 classes of service */
-        int (*l3ca_get)(const unsigned l3cat_id,
-                        const unsigned max_num_ca,
-                        unsigned *num_ca,
-                        struct pqos_l3ca *ca);
-        /** Get minimum L3 CBM bits */
-        int (*l3ca_get_min_cbm_bits)(unsigned *min_cbm_bits);
-
-        /** Sets L2 classes of service */
-        int (*l2ca_set)(const unsigned l2id,
-                        const unsigned num_cos,
-                        const struct pqos_l2ca *ca);
-        /** Reads L2 classes of service */
-        int (*l2ca_get)(const unsigned l2id,
-                        const unsigned max_num_ca,
-                        unsigned *num_ca,
-                        struct pqos_l2ca *ca);
-        /** Get minimum L2 CBM bits */
-        int (*l2ca_get_min_cbm_bits)(unsigned *min_cbm_bits);
-
-        /** Set MBA */
-        int (*mba_get)(const unsigned mba_id,
-                       const unsigned max_num_cos,
-                       unsigned *num_cos,
-                       struct pqos_mba *mba_tab);
-        /** Get MBA mask */
-        int (*mba_set)(const unsigned mba_id,
-                       const unsigned num_cos,
-                       const struct pqos_mba *requested,
-                       struct pqos_mba *actual);
-
-        /** Retrieves tasks associated with COS */
-        unsigned *(*pid_get_pid_assoc)(const unsigned class_id,
-                                       unsigned *count);
-
-} api;
+static struct pqos_api api;
 
 /*
  * =======================================
@@ -176,6 +69,7 @@ api_init(int interface, enum pqos_vendor vendor)
 
         if (interface == PQOS_INTER_MSR) {
                 api.mon_reset = hw_mon_reset;
+                api.mon_reclaim = hw_mon_reclaim;
                 api.mon_assoc_get = hw_mon_assoc_get;
                 api.mon_start_cores = hw_mon_start_cores;
                 api.mon_stop = hw_mon_stop;
@@ -183,6 +77,7 @@ api_init(int interface, enum pqos_vendor vendor)
                 api.alloc_assoc_get = hw_alloc_assoc_get;
                 api.alloc_assign = hw_alloc_assign;
                 api.alloc_release = hw_alloc_release;
+                api.alloc_cos_unused = hw_alloc_cos_unused;
                 api.alloc_reset = hw_alloc_reset;
                 api.l3ca_set = hw_l3ca_set;
                 api.l3ca_get = hw_l3ca_get;
@@ -203,6 +98,7 @@ api_init(int interface, enum pqos_vendor vendor)
         } else if (interface == PQOS_INTER_OS ||
                    interface == PQOS_INTER_OS_RESCTRL_MON) {
                 api.mon_reset = os_mon_reset;
+                api.mon_reclaim = os_mon_reclaim;
                 api.mon_start_cores = os_mon_start_cores;
                 api.mon_start_pids = os_mon_start_pids;
                 api.mon_add_pids = os_mon_add_pids;
@@ -216,6 +112,7 @@ api_init(int interface, enum pqos_vendor vendor)
                 api.alloc_release = os_alloc_release;
                 api.alloc_assign_pid = os_alloc_assign_pid;
                 api.alloc_release_pid = os_alloc_release_pid;
+                api.alloc_cos_unused = os_alloc_cos_unused;
                 api.alloc_reset = os_alloc_reset;
                 api.l3ca_set = os_l3ca_set;
                 api.l3ca_get = os_l3ca_get;
@@ -261,6 +158,35 @@ api_init(int interface, enum pqos_vendor vendor)
                 ret;                                                           \
         })
 
+/**
+ * Same as API_CALL, monitoring backend is initialized on first use
+ */
+#define API_MON_CALL(API, PARAMS...)                                           \
+        ({                                                                     \
+                int ret;                                                       \
+                                                                               \
+                lock_get();                                                    \
+                do {                                                           \
+                        ret = _pqos_check_init(1);                             \
+                        if (ret != PQOS_RETVAL_OK)                             \
+                                break;                                         \
+                                                                               \
+                        ret = pqos_mon_lazy_init();                            \
+                        if (ret != PQOS_RETVAL_OK)                             \
+                                break;                                         \
+                                                                               \
+                        if (api.API != NULL)                                   \
+                                ret = api.API(PARAMS);                         \
+                        else {                                                 \
+                                LOG_INFO(UNSUPPORTED_INTERFACE);               \
+                                ret = PQOS_RETVAL_RESOURCE;                    \
+                        }                                                      \
+                } while (0);                                                   \
+                lock_release();                                                \
+                                                                               \
+                ret;                                                           \
+        })
+
 /*
  * =======================================
  * Allocation Technology
@@ -396,6 +322,439 @@ pqos_alloc_reset_config(const struct pqos_alloc_config *cfg)
         return API_CALL(alloc_reset, cfg);
 }
 
+/**
+ * @brief Retrieves ids of resource entities of \a type used by cores in
+ *        \a core_array, all entities if \a core_array is NULL
+ *
+ * @param [in] type allocation technology
+ * @param [in] core_array list of core ids
+ * @param [in] core_num number of core ids in the \a core_array
+ * @param [out] count number of ids
+ *
+ * @return Allocated array of ids, NULL on error
+ */
+static unsigned *
+alloc_swap_ids(const enum pqos_cap_type type,
+               const unsigned *core_array,
+               const unsigned core_num,
+               unsigned *count)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+        unsigned *ids;
+        unsigned i, j, num = 0;
+
+        if (core_array == NULL) {
+                if (type == PQOS_CAP_TYPE_L3CA)
+                        return pqos_cpu_get_l3cat_ids(cpu, count);
+                if (type == PQOS_CAP_TYPE_L2CA)
+                        return pqos_cpu_get_l2ids(cpu, count);
+                return pqos_cpu_get_mba_ids(cpu, count);
+        }
+
+        ids = malloc(core_num * sizeof(ids[0]));
+        if (ids == NULL)
+                return NULL;
+
+        for (i = 0; i < core_num; i++) {
+                const struct pqos_coreinfo *info;
+                unsigned id;
+
+                info = pqos_cpu_get_core_info(cpu, core_array[i]);
+                if (info == NULL) {
+                        free(ids);
+                        return NULL;
+                }
+
+                if (type == PQOS_CAP_TYPE_L3CA)
+                        id = info->l3cat_id;
+                else if (type == PQOS_CAP_TYPE_L2CA)
+                        id = info->l2_id;
+                else
+                        id = info->mba_id;
+
+                for (j = 0; j < num; j++)
+                        if (ids[j] == id)
+                                break;
+                if (j == num)
+                        ids[num++] = id;
+        }
+
+        *count = num;
+
+        return ids;
+}
+
+/**
+ * @brief Programs L3 CAT setting of \a class_id on all \a ids
+ *
+ * @param [in] ca requested setting, NULL to copy setting of \a old_class_id
+ * @param [in] old_class_id COS currently in use
+ * @param [in] class_id COS to program
+ * @param [in] ids L3 CAT resource ids
+ * @param [in] num number of ids
+ *
+ * @return Operation status
+ */
+static int
+alloc_swap_l3ca(const struct pqos_l3ca *ca,
+                const unsigned old_class_id,
+                const unsigned class_id,
+                const unsigned *ids,
+                const unsigned num)
+{
+        unsigned i, j;
+        int ret;
+
+        for (i = 0; i < num; i++) {
+                struct pqos_l3ca tab[PQOS_MAX_L3CA_COS];
+                struct pqos_l3ca l3ca;
+                unsigned num_ca;
+
+                if (ca == NULL) {
+                        ret = api.l3ca_get(ids[i], DIM(tab), &num_ca, tab);
+                        if (ret != PQOS_RETVAL_OK)
+                                return ret;
+
+                        for (j = 0; j < num_ca; j++)
+                                if (tab[j].class_id == old_class_id)
+                                        break;
+                        if (j == num_ca)
+                                return PQOS_RETVAL_ERROR;
+                        l3ca = tab[j];
+                } else
+                        l3ca = *ca;
+
+                l3ca.class_id = class_id;
+                ret = api.l3ca_set(ids[i], 1, &l3ca);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Programs L2 CAT setting of \a class_id on all \a ids
+ *
+ * @param [in] ca requested setting, NULL to copy setting of \a old_class_id
+ * @param [in] old_class_id COS currently in use
+ * @param [in] class_id COS to program
+ * @param [in] ids L2 CAT resource ids
+ * @param [in] num number of ids
+ *
+ * @return Operation status
+ */
+static int
+alloc_swap_l2ca(const struct pqos_l2ca *ca,
+                const unsigned old_class_id,
+                const unsigned class_id,
+                const unsigned *ids,
+                const unsigned num)
+{
+        unsigned i, j;
+        int ret;
+
+        for (i = 0; i < num; i++) {
+                struct pqos_l2ca tab[PQOS_MAX_L2CA_COS];
+                struct pqos_l2ca l2ca;
+                unsigned num_ca;
+
+                if (ca == NULL) {
+                        ret = api.l2ca_get(ids[i], DIM(tab), &num_ca, tab);
+                        if (ret != PQOS_RETVAL_OK)
+                                return ret;
+
+                        for (j = 0; j < num_ca; j++)
+                                if (tab[j].class_id == old_class_id)
+                                        break;
+                        if (j == num_ca)
+                                return PQOS_RETVAL_ERROR;
+                        l2ca = tab[j];
+                } else
+                        l2ca = *ca;
+
+                l2ca.class_id = class_id;
+                ret = api.l2ca_set(ids[i], 1, &l2ca);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Programs MBA setting of \a class_id on all \a ids
+ *
+ * @param [in] mba requested setting, NULL to copy setting of \a old_class_id
+ * @param [in] old_class_id COS currently in use
+ * @param [in] class_id COS to program
+ * @param [in] ids MBA resource ids
+ * @param [in] num number of ids
+ *
+ * @return Operation status
+ */
+static int
+alloc_swap_mba(const struct pqos_mba *mba,
+               const unsigned old_class_id,
+               const unsigned class_id,
+               const unsigned *ids,
+               const unsigned num)
+{
+        unsigned i, j;
+        int ret;
+
+        for (i = 0; i < num; i++) {
+                struct pqos_mba tab[PQOS_MAX_COS];
+                struct pqos_mba requested;
+                unsigned num_cos;
+
+                if (mba == NULL) {
+                        ret = api.mba_get(ids[i], DIM(tab), &num_cos, tab);
+                        if (ret != PQOS_RETVAL_OK)
+                                return ret;
+
+                        for (j = 0; j < num_cos; j++)
+                                if (tab[j].class_id == old_class_id)
+                                        break;
+                        if (j == num_cos)
+                                return PQOS_RETVAL_ERROR;
+                        requested = tab[j];
+                } else
+                        requested = *mba;
+
+                requested.class_id = class_id;
+                ret = api.mba_set(ids[i], 1, &requested, NULL);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Moves cores or tasks to spare COS configured with \a cfg
+ *
+ * Must be called with API lock acquired.
+ *
+ * @param [in] cfg requested COS settings
+ * @param [in] core_array list of core ids, NULL when moving tasks
+ * @param [in] task_array list of task ids, NULL when moving cores
+ * @param [in] num number of cores or tasks
+ * @param [out] class_id COS cores or tasks were moved to
+ *
+ * @return Operation status
+ */
+static int
+alloc_swap(const struct pqos_alloc_cos *cfg,
+           const unsigned *core_array,
+           const pid_t *task_array,
+           const unsigned num,
+           unsigned *class_id)
+{
+        const struct pqos_cap *cap;
+        const struct pqos_capability *alloc_cap[PQOS_CAP_TYPE_NUMOF];
+        const enum pqos_cap_type types[] = {
+            PQOS_CAP_TYPE_L3CA, PQOS_CAP_TYPE_L2CA, PQOS_CAP_TYPE_MBA};
+        unsigned technology = 0;
+        unsigned old_class_id = 0;
+        unsigned i;
+        int ret;
+
+        if (api.alloc_cos_unused == NULL ||
+            (core_array == NULL && (api.alloc_assoc_get_pid == NULL ||
+                                    api.alloc_assoc_set_pid == NULL))) {
+                LOG_INFO(UNSUPPORTED_INTERFACE);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        cap = _pqos_get_cap();
+        for (i = 0; i < DIM(types); i++) {
+                alloc_cap[types[i]] = NULL;
+                ret = pqos_cap_get_type(cap, types[i], &alloc_cap[types[i]]);
+                if (ret == PQOS_RETVAL_OK)
+                        technology |= 1 << types[i];
+        }
+
+        if ((cfg->l3ca != NULL && alloc_cap[PQOS_CAP_TYPE_L3CA] == NULL) ||
+            (cfg->l2ca != NULL && alloc_cap[PQOS_CAP_TYPE_L2CA] == NULL) ||
+            (cfg->mba != NULL && alloc_cap[PQOS_CAP_TYPE_MBA] == NULL) ||
+            technology == 0)
+                return PQOS_RETVAL_RESOURCE;
+
+        if (cfg->mba != NULL && cfg->mba->ctrl == 0) {
+                const struct cpuinfo_config *vconfig;
+
+                cpuinfo_get_config(&vconfig);
+                if (cfg->mba->mb_max == 0 ||
+                    cfg->mba->mb_max > vconfig->mba_max) {
+                        LOG_ERROR("MBA rate out of range (from 1-%d)!\n",
+                                  vconfig->mba_max);
+                        return PQOS_RETVAL_PARAM;
+                }
+        }
+
+        /* all cores or tasks need to share class of service */
+        for (i = 0; i < num; i++) {
+                unsigned cos;
+
+                if (core_array != NULL)
+                        ret = api.alloc_assoc_get(core_array[i], &cos);
+                else
+                        ret = api.alloc_assoc_get_pid(task_array[i], &cos);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+
+                if (i != 0 && cos != old_class_id) {
+                        LOG_ERROR("Swapped cores or tasks need to share "
+                                  "class of service\n");
+                        return PQOS_RETVAL_PARAM;
+                }
+                old_class_id = cos;
+        }
+
+        ret = api.alloc_cos_unused(technology, core_array,
+                                   core_array != NULL ? num : 0, class_id);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        /* program complete configuration before moving anything */
+        for (i = 0; i < DIM(types); i++) {
+                unsigned *ids;
+                unsigned ids_num = 0;
+
+                if (alloc_cap[types[i]] == NULL)
+                        continue;
+
+                ids = alloc_swap_ids(types[i], core_array, num, &ids_num);
+                if (ids == NULL)
+                        return PQOS_RETVAL_ERROR;
+
+                if (types[i] == PQOS_CAP_TYPE_L3CA)
+                        ret = alloc_swap_l3ca(cfg->l3ca, old_class_id,
+                                              *class_id, ids, ids_num);
+                else if (types[i] == PQOS_CAP_TYPE_L2CA)
+                        ret = alloc_swap_l2ca(cfg->l2ca, old_class_id,
+                                              *class_id, ids, ids_num);
+                else
+                        ret = alloc_swap_mba(cfg->mba, old_class_id,
+                                             *class_id, ids, ids_num);
+                free(ids);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        LOG_INFO("Moving %u %s from COS%u to COS%u\n", num,
+                 core_array != NULL ? "cores" : "tasks", old_class_id,
+                 *class_id);
+
+        for (i = 0; i < num; i++) {
+                if (core_array != NULL)
+                        ret = api.alloc_assoc_set(core_array[i], *class_id);
+                else
+                        ret = api.alloc_assoc_set_pid(task_array[i],
+                                                      *class_id);
+                if (ret != PQOS_RETVAL_OK)
+                        break;
+        }
+
+        /* move back to previous class on error */
+        if (ret != PQOS_RETVAL_OK)
+                while (i-- > 0) {
+                        if (core_array != NULL)
+                                (void)api.alloc_assoc_set(core_array[i],
+                                                          old_class_id);
+                        else
+                                (void)api.alloc_assoc_set_pid(task_array[i],
+                                                              old_class_id);
+                }
+
+        return ret;
+}
+
+/**
+ * @brief Validates masks of requested COS settings
+ *
+ * @param [in] cfg requested COS settings
+ *
+ * @return Operation status
+ */
+static int
+alloc_swap_check(const struct pqos_alloc_cos *cfg)
+{
+        const struct pqos_l3ca *l3ca = cfg->l3ca;
+        const struct pqos_l2ca *l2ca = cfg->l2ca;
+
+        if (l3ca != NULL &&
+            !(l3ca->cdp ? l3ca->u.s.data_mask && l3ca->u.s.code_mask
+                        : l3ca->u.ways_mask)) {
+                LOG_ERROR("L3 bit mask is 0!\n");
+                return PQOS_RETVAL_PARAM;
+        }
+
+        if (l2ca != NULL &&
+            !(l2ca->cdp ? l2ca->u.s.data_mask && l2ca->u.s.code_mask
+                        : l2ca->u.ways_mask)) {
+                LOG_ERROR("L2 bit mask is 0!\n");
+                return PQOS_RETVAL_PARAM;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_alloc_swap(const struct pqos_alloc_cos *cfg,
+                const unsigned *core_array,
+                const unsigned core_num,
+                unsigned *class_id)
+{
+        int ret;
+
+        if (cfg == NULL || core_array == NULL || core_num == 0 ||
+            class_id == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        ret = alloc_swap_check(cfg);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = alloc_swap(cfg, core_array, NULL, core_num, class_id);
+
+        lock_release();
+
+        return ret;
+}
+
+int
+pqos_alloc_swap_pid(const struct pqos_alloc_cos *cfg,
+                    const pid_t *task_array,
+                    const unsigned task_num,
+                    unsigned *class_id)
+{
+        int ret;
+
+        if (cfg == NULL || task_array == NULL || task_num == 0 ||
+            class_id == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        ret = alloc_swap_check(cfg);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = alloc_swap(cfg, NULL, task_array, task_num, class_id);
+
+        lock_release();
+
+        return ret;
+}
+
 unsigned *
 pqos_pid_get_pid_assoc(const unsigned class_id, unsigned *count)
 {
@@ -608,6 +967,51 @@ pqos_mba_get(const unsigned mba_id,
         return API_CALL(mba_get, mba_id, max_num_cos, num_cos, mba_tab);
 }
 
+/*
+ * =======================================
+ * Allocation state snapshot
+ * =======================================
+ */
+
+int
+pqos_state_save(void **buf, size_t *size)
+{
+        int ret;
+
+        if (buf == NULL || size == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = state_save(&api, buf, size);
+
+        lock_release();
+
+        return ret;
+}
+
+int
+pqos_state_restore(const void *buf, const size_t size)
+{
+        int ret;
+
+        ret = state_check(buf, size);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = state_restore(&api, buf);
+
+        lock_release();
+
+        return ret;
+}
+
 /*
  * =======================================
  * Monitoring
@@ -617,7 +1021,13 @@ pqos_mba_get(const unsigned mba_id,
 int
 pqos_mon_reset(void)
 {
-        return API_CALL(mon_reset);
+        return API_MON_CALL(mon_reset);
+}
+
+int
+pqos_mon_reclaim(unsigned *num_groups)
+{
+        return API_MON_CALL(mon_reclaim, num_groups);
 }
 
 int
@@ -626,7 +1036,7 @@ pqos_mon_assoc_get(const unsigned lcore, pqos_rmid_t *rmid)
         if (rmid == NULL)
                 return PQOS_RETVAL_PARAM;
 
-        return API_CALL(mon_assoc_get, lcore, rmid);
+        return API_MON_CALL(mon_assoc_get, lcore, rmid);
 }
 
 int
@@ -672,6 +1082,8 @@ pqos_mon_start(const unsigned num_cores,
         lock_get();
 
         ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = pqos_mon_lazy_init();
         if (ret != PQOS_RETVAL_OK) {
                 lock_release();
                 free(mem);
@@ -757,8 +1169,8 @@ pqos_mon_start_cores_ext(const unsigned num_cores,
         data->intl = (struct pqos_mon_data_internal *)(&data[1]);
         data->intl->manage_memory = 1;
 
-        ret = API_CALL(mon_start_cores, num_cores, cores, event, context, data,
-                       opt);
+        ret = API_MON_CALL(mon_start_cores, num_cores, cores, event, context,
+                           data, opt);
 
         if (ret == PQOS_RETVAL_OK) {
                 data->valid = GROUP_VALID_MARKER;
@@ -807,8 +1219,19 @@ pqos_mon_stop(struct pqos_mon_data *group)
         return ret;
 }
 
-int
-pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups)
+/**
+ * @brief Polls selected events of monitoring groups
+ *
+ * @param [in] groups table of monitoring group pointers to be updated
+ * @param [in] num_groups number of monitoring groups in the table
+ * @param [in] events events to poll, all events of the group if 0
+ *
+ * @return Operations status
+ */
+static int
+mon_poll(struct pqos_mon_data **groups,
+         const unsigned num_groups,
+         const enum pqos_mon_event events)
 {
         int ret;
         unsigned i;
@@ -834,7 +1257,14 @@ pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups)
         }
 
         for (i = 0; i < num_groups; i++) {
-                int retval = pqos_mon_poll_events(groups[i]);
+                const enum pqos_mon_event poll =
+                    events != 0 ? events : groups[i]->event;
+                int retval;
+
+                if ((groups[i]->event & poll) == 0)
+                        continue;
+
+                retval = pqos_mon_poll_events(groups[i], poll);
 
                 if (retval != PQOS_RETVAL_OK) {
                         LOG_WARN("Failed to poll event on group number %u\n",
@@ -847,6 +1277,23 @@ pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups)
         return ret;
 }
 
+int
+pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups)
+{
+        return mon_poll(groups, num_groups, (enum pqos_mon_event)0);
+}
+
+int
+pqos_mon_poll_subset(struct pqos_mon_data **groups,
+                     const unsigned num_groups,
+                     const enum pqos_mon_event events)
+{
+        if (events == 0)
+                return PQOS_RETVAL_PARAM;
+
+        return mon_poll(groups, num_groups, events);
+}
+
 int
 pqos_mon_start_pid(const pid_t pid,
                    const enum pqos_mon_event event,
@@ -898,6 +1345,8 @@ pqos_mon_start_pids(const unsigned num_pids,
         lock_get();
 
         ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = pqos_mon_lazy_init();
         if (ret != PQOS_RETVAL_OK) {
                 lock_release();
                 free(mem);
@@ -964,7 +1413,8 @@ pqos_mon_start_pids2(const unsigned num_pids,
         data->intl = (struct pqos_mon_data_internal *)(&data[1]);
         data->intl->manage_memory = 1;
 
-        ret = API_CALL(mon_start_pids, num_pids, pids, event, context, data);
+        ret = API_MON_CALL(mon_start_pids, num_pids, pids, event, context,
+                           data);
 
         if (ret == PQOS_RETVAL_OK) {
                 data->valid = GROUP_VALID_MARKER;
@@ -1031,8 +1481,8 @@ pqos_mon_start_uncore(const unsigned num_sockets,
         data->intl = (struct pqos_mon_data_internal *)(&data[1]);
         data->intl->manage_memory = 1;
 
-        ret = API_CALL(mon_start_uncore, num_sockets, sockets, event, context,
-                       data);
+        ret = API_MON_CALL(mon_start_uncore, num_sockets, sockets, event,
+                           context, data);
 
         if (ret == PQOS_RETVAL_OK) {
                 data->valid = GROUP_VALID_MARKER;
@@ -1170,3 +1620,118 @@ pqos_mon_get_ipc(const struct pqos_mon_data *const group, double *value)
 
         return ret;
 }
+
+int
+pqos_mon_get_poll_time(const struct pqos_mon_data *const group,
+                       const enum pqos_mon_event event,
+                       uint64_t *timestamp,
+                       uint64_t *interval)
+{
+        int ret;
+
+        if (group == NULL || (timestamp == NULL && interval == NULL))
+                return PQOS_RETVAL_PARAM;
+
+        if (group->valid != GROUP_VALID_MARKER)
+                return PQOS_RETVAL_PARAM;
+
+        if ((group->event & event) == 0)
+                return PQOS_RETVAL_PARAM;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret == PQOS_RETVAL_OK)
+                ret = pqos_mon_poll_time(group, event, timestamp, interval);
+
+        lock_release();
+
+        return ret;
+}
+
+/**
+ * @brief Calculates bandwidth of monitoring group
+ *
+ * @param [in] group monitoring group
+ * @param [in] event memory bandwidth event
+ * @param [in] delta counter delta [B]
+ *
+ * @return bandwidth in bytes per second
+ */
+static inline double
+mon_get_rate(const struct pqos_mon_data *group,
+             const enum pqos_mon_event event,
+             const uint64_t delta)
+{
+        uint64_t interval = 0;
+
+        (void)pqos_mon_poll_time(group, event, NULL, &interval);
+        if (interval == 0)
+                return 0;
+
+        return (double)delta * 1000000000.0 / (double)interval;
+}
+
+int
+pqos_mon_get_values(struct pqos_mon_data *const *groups,
+                    const unsigned num_groups,
+                    const struct pqos_mon_values *values)
+{
+        int ret;
+        unsigned i;
+
+        if (groups == NULL || num_groups == 0 || values == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < num_groups; i++)
+                if (groups[i] == NULL ||
+                    groups[i]->valid != GROUP_VALID_MARKER)
+                        return PQOS_RETVAL_PARAM;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret != PQOS_RETVAL_OK) {
+                lock_release();
+                return ret;
+        }
+
+        /**
+         * Fill one array at a time. Values of events that are not
+         * monitored stay 0 in the group so no per event checks are needed.
+         */
+        if (values->llc != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->llc[i] = groups[i]->values.llc;
+
+        if (values->mbm_local_rate != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->mbm_local_rate[i] = mon_get_rate(
+                            groups[i], PQOS_MON_EVENT_LMEM_BW,
+                            groups[i]->values.mbm_local_delta);
+
+        if (values->mbm_total_rate != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->mbm_total_rate[i] = mon_get_rate(
+                            groups[i], PQOS_MON_EVENT_TMEM_BW,
+                            groups[i]->values.mbm_total_delta);
+
+        if (values->mbm_remote_rate != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->mbm_remote_rate[i] = mon_get_rate(
+                            groups[i], PQOS_MON_EVENT_RMEM_BW,
+                            groups[i]->values.mbm_remote_delta);
+
+        if (values->ipc != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->ipc[i] = groups[i]->values.ipc;
+
+        if (values->llc_misses != NULL)
+                for (i = 0; i < num_groups; i++)
+                        values->llc_misses[i] =
+                            groups[i]->values.llc_misses_delta;
+
+        lock_release();
+
+        return ret;
+}
@@ -39,8 +39,122 @@ extern "C" {
 #endif
 
 #include "pqos.h"
+#include "pqos_internal.h"
 #include "types.h"
 
+/**
+ * PQoS API functions
+ */
+struct pqos_api {
+        /** Resets monitoring */
+        int (*mon_reset)(void);
+        /** Removes monitoring groups of exited processes */
+        int (*mon_reclaim)(unsigned *num_groups);
+        /** Reads RMID association lcore */
+        int (*mon_assoc_get)(const unsigned lcore, pqos_rmid_t *rmid);
+        /** Starts resource monitoring on selected group of cores */
+        int (*mon_start_cores)(const unsigned num_cores,
+                               const unsigned *cores,
+                               const enum pqos_mon_event event,
+                               void *context,
+                               struct pqos_mon_data *group,
+                               const struct pqos_mon_options *opt);
+        /** Starts resource monitoring of selected pids */
+        int (*mon_start_pids)(const unsigned num_pids,
+                              const pid_t *pids,
+                              const enum pqos_mon_event event,
+                              void *context,
+                              struct pqos_mon_data *group);
+        /** Adds pids to the resource monitoring grpup */
+        int (*mon_add_pids)(const unsigned num_pids,
+                            const pid_t *pids,
+                            struct pqos_mon_data *group);
+        /** Remove pids from the resource monitoring group */
+        int (*mon_remove_pids)(const unsigned num_pids,
+                               const pid_t *pids,
+                               struct pqos_mon_data *group);
+        /** Starts uncore monitoring */
+        int (*mon_start_uncore)(const unsigned num_sockets,
+                                const unsigned *sockets,
+                                const enum pqos_mon_event event,
+                                void *context,
+                                struct pqos_mon_data *group);
+        /** Stops resource monitoring data for selected monitoring group */
+        int (*mon_stop)(struct pqos_mon_data *group);
+
+        /** Associates lcore with given class of service */
+        int (*alloc_assoc_set)(const unsigned lcore, const unsigned class_id);
+        /** Reads association of lcore with class of service */
+        int (*alloc_assoc_get)(const unsigned lcore, unsigned *class_id);
+        /** Associate task with given class of service */
+        int (*alloc_assoc_set_pid)(const pid_t task, const unsigned class_id);
+        /** Read association of task with class of service */
+        int (*alloc_assoc_get_pid)(const pid_t task, unsigned *class_id);
+        /** Assign first available COS */
+        int (*alloc_assign)(const unsigned technology,
+                            const unsigned *core_array,
+                            const unsigned core_num,
+                            unsigned *class_id);
+        /** Reassign cores to default COS */
+        int (*alloc_release)(const unsigned *core_array,
+                             const unsigned core_num);
+        /** Assign first available COS to tasks */
+        int (*alloc_assign_pid)(const unsigned technology,
+                                const pid_t *task_array,
+                                const unsigned task_num,
+                                unsigned *class_id);
+        /** Reassign tasks to default COS */
+        int (*alloc_release_pid)(const pid_t *task_array,
+                                 const unsigned task_num);
+        /** Find unused COS */
+        int (*alloc_cos_unused)(const unsigned technology,
+                                const unsigned *core_array,
+                                const unsigned core_num,
+                                unsigned *class_id);
+        /** Resets configuration of allocation technologies */
+        int (*alloc_reset)(const struct pqos_alloc_config *cfg);
+
+        /** Sets L3 classes of service */
+        int (*l3ca_set)(const unsigned l3cat_id,
+                        const unsigned num_cos,
+                        const struct pqos_l3ca *ca);
+        /** Reads L3 classes of service */
+        int (*l3ca_get)(const unsigned l3cat_id,
+                        const unsigned max_num_ca,
+                        unsigned *num_ca,
+                        struct pqos_l3ca *ca);
+        /** Get minimum L3 CBM bits */
+        int (*l3ca_get_min_cbm_bits)(unsigned *min_cbm_bits);
+
+        /** Sets L2 classes of service */
+        int (*l2ca_set)(const unsigned l2id,
+                        const unsigned num_cos,
+                        const struct pqos_l2ca *ca);
+        /** Reads L2 classes of service */
+        int (*l2ca_get)(const unsigned l2id,
+                        const unsigned max_num_ca,
+                        unsigned *num_ca,
+                        struct pqos_l2ca *ca);
+        /** Get minimum L2 CBM bits */
+        int (*l2ca_get_min_cbm_bits)(unsigned *min_cbm_bits);
+
+        /** Set MBA */
+        int (*mba_get)(const unsigned mba_id,
+                       const unsigned max_num_cos,
+                       unsigned *num_cos,
+                       struct pqos_mba *mba_tab);
+        /** Get MBA mask */
+        int (*mba_set)(const unsigned mba_id,
+                       const unsigned num_cos,
+                       const struct pqos_mba *requested,
+                       struct pqos_mba *actual);
+
+        /** Retrieves tasks associated with COS */
+        unsigned *(*pid_get_pid_assoc)(const unsigned class_id,
+                                       unsigned *count);
+
+};
+
 /**
  * @brief Initializes api module
  *
@@ -52,6 +52,7 @@
 
 #include "allocation.h"
 #include "api.h"
+#include "cap_cache.h"
 #include "cpu_registers.h"
 #include "cpuinfo.h"
 #include "hw_cap.h"
@@ -59,11 +60,13 @@
 #include "log.h"
 #include "machine.h"
 #include "monitoring.h"
+#include "os_allocation.h"
 #include "os_cap.h"
 #include "resctrl.h"
 #include "resctrl_alloc.h"
 #include "utils.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -81,6 +84,14 @@
  * ---------------------------------------
  */
 
+/**
+ * Library context handle
+ */
+struct pqos_ctx {
+        enum pqos_interface interface; /**< interface in use by the handle */
+        struct pqos_ctx *next;         /**< next live handle */
+};
+
 /**
  * ---------------------------------------
  * Local data structures
@@ -113,6 +124,22 @@ static int m_init_done = 0;
  */
 static enum pqos_interface m_interface = PQOS_INTER_MSR;
 
+/**
+ * Library lifetime and context handles
+ *   m_ctx_lock   serializes library init and shutdown with handle
+ *                reference changes, taken before the API lock which
+ *                only exists while the library is initialized
+ *   m_ctx_list   live context handles
+ *   m_ctx_num    number of live context handles
+ *   m_ctx_owner  library is shut down when the last handle is released,
+ *                set when a handle initialized the library or when
+ *                pqos_fini() was called while handles were live
+ */
+static pthread_mutex_t m_ctx_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pqos_ctx *m_ctx_list = NULL;
+static unsigned m_ctx_num = 0;
+static int m_ctx_owner = 0;
+
 /**
  * ---------------------------------------
  * Local functions
@@ -601,6 +628,45 @@ discover_interface(enum pqos_interface requested_interface,
         return PQOS_RETVAL_OK;
 }
 
+#ifdef __linux__
+/**
+ * @brief Checks if cached capabilities match current MSR state
+ *
+ * CDP state is kept in MSRs and can be changed without reboot.
+ *
+ * @param cap cached capabilities
+ * @param cpu detected cpu topology
+ *
+ * @return if cached capabilities are valid
+ */
+static int
+cap_cache_msr_valid(const struct pqos_cap *cap, const struct pqos_cpuinfo *cpu)
+{
+        unsigned i;
+
+        for (i = 0; i < cap->num_cap; i++) {
+                const struct pqos_capability *item = &cap->capabilities[i];
+                int enabled = 0;
+                int ret;
+
+                if (item->type == PQOS_CAP_TYPE_L3CA && item->u.l3ca->cdp) {
+                        ret = hw_cap_l3ca_cdp(cpu, &enabled);
+                        if (ret != PQOS_RETVAL_OK ||
+                            enabled != item->u.l3ca->cdp_on)
+                                return 0;
+                } else if (item->type == PQOS_CAP_TYPE_L2CA &&
+                           item->u.l2ca->cdp) {
+                        ret = hw_cap_l2ca_cdp(cpu, &enabled);
+                        if (ret != PQOS_RETVAL_OK ||
+                            enabled != item->u.l2ca->cdp_on)
+                                return 0;
+                }
+        }
+
+        return 1;
+}
+#endif
+
 /*
  * =======================================
  * =======================================
@@ -610,8 +676,18 @@ discover_interface(enum pqos_interface requested_interface,
  * =======================================
  * =======================================
  */
-int
-pqos_init(const struct pqos_config *config)
+/**
+ * @brief Initializes the library
+ *
+ * Must be called with m_ctx_lock held.
+ *
+ * @param [in] config initialization parameters structure
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+static int
+cap_init(const struct pqos_config *config)
 {
         int ret = PQOS_RETVAL_OK;
         unsigned i = 0, max_core = 0;
@@ -648,6 +724,10 @@ pqos_init(const struct pqos_config *config)
                 goto log_init_error;
         }
 
+#ifdef __linux__
+        (void)cap_cache_load(interface);
+#endif
+
         /**
          * Topology not provided through config.
          * CPU discovery done through internal mechanism.
@@ -686,10 +766,27 @@ pqos_init(const struct pqos_config *config)
                          "and cause unexpected behaviour\n");
 #endif
 
-        ret = discover_capabilities(&m_cap, m_cpu, interface);
-        if (ret != PQOS_RETVAL_OK) {
-                LOG_ERROR("discover_capabilities() error %d\n", ret);
-                goto machine_init_error;
+#ifdef __linux__
+        m_cap = cap_cache_cap_get();
+        if (m_cap != NULL && interface == PQOS_INTER_MSR &&
+            !cap_cache_msr_valid(m_cap, m_cpu)) {
+                LOG_INFO("CDP state changed, ignoring cached capabilities\n");
+                for (i = 0; i < m_cap->num_cap; i++)
+                        free(m_cap->capabilities[i].u.generic_ptr);
+                free(m_cap);
+                m_cap = NULL;
+        }
+#endif
+
+        if (m_cap == NULL) {
+                ret = discover_capabilities(&m_cap, m_cpu, interface);
+                if (ret != PQOS_RETVAL_OK) {
+                        LOG_ERROR("discover_capabilities() error %d\n", ret);
+                        goto machine_init_error;
+                }
+#ifdef __linux__
+                (void)cap_cache_store(interface, m_cpu, m_cap);
+#endif
         }
 
         ret = _pqos_utils_init(interface);
@@ -721,9 +818,8 @@ pqos_init(const struct pqos_config *config)
         }
 
         /**
-         * If monitoring capability has been discovered
-         * then get max RMID supported by a CPU socket
-         * and allocate memory for RMID table
+         * If monitoring capability has been discovered then monitoring
+         * backend is initialized on first use of monitoring API
          */
         ret = pqos_mon_init(m_cpu, m_cap, config);
         switch (ret) {
@@ -732,7 +828,7 @@ pqos_init(const struct pqos_config *config)
                 ret = PQOS_RETVAL_OK;
                 break;
         case PQOS_RETVAL_OK:
-                LOG_DEBUG("monitoring init OK\n");
+                LOG_DEBUG("monitoring init deferred\n");
                 mon_init = 1;
                 break;
         case PQOS_RETVAL_ERROR:
@@ -767,6 +863,10 @@ init_error:
                 m_cap = NULL;
         }
 
+#ifdef __linux__
+        cap_cache_fini();
+#endif
+
         if (ret == PQOS_RETVAL_OK)
                 m_init_done = 1;
 
@@ -779,7 +879,30 @@ init_error:
 }
 
 int
-pqos_fini(void)
+pqos_init(const struct pqos_config *config)
+{
+        int ret;
+
+        if (pthread_mutex_lock(&m_ctx_lock) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        ret = cap_init(config);
+
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        return ret;
+}
+
+/**
+ * @brief Shuts down the library
+ *
+ * Must be called with m_ctx_lock held.
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+static int
+cap_fini(void)
 {
         int ret = PQOS_RETVAL_OK;
         int retval = PQOS_RETVAL_OK;
@@ -832,6 +955,216 @@ pqos_fini(void)
         return retval;
 }
 
+int
+pqos_fini(void)
+{
+        int ret;
+
+        /* no handle can be created while the library goes down */
+        if (pthread_mutex_lock(&m_ctx_lock) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        if (m_ctx_num > 0 && m_init_done) {
+                /* last handle released shuts the library down */
+                LOG_INFO("Library is in use by %u context handle(s), "
+                         "shutdown deferred\n",
+                         m_ctx_num);
+                m_ctx_owner = 1;
+                ret = PQOS_RETVAL_OK;
+        } else
+                ret = cap_fini();
+
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        return ret;
+}
+
+/*
+ * =======================================
+ * =======================================
+ *
+ * context handles
+ *
+ * =======================================
+ * =======================================
+ */
+
+/**
+ * @brief Checks if the handle is live
+ *
+ * Must be called with m_ctx_lock held.
+ *
+ * @param [in] ctx library context handle
+ *
+ * @return 1 for a live handle, 0 otherwise
+ */
+static int
+ctx_valid(const struct pqos_ctx *ctx)
+{
+        const struct pqos_ctx *handle;
+
+        for (handle = m_ctx_list; handle != NULL; handle = handle->next)
+                if (handle == ctx)
+                        return 1;
+
+        return 0;
+}
+
+/**
+ * @brief Checks if the running library can serve requested interface
+ *
+ * @param [in] requested interface requested by the handle
+ * @param [in] running interface the library runs with
+ *
+ * @return 1 when compatible, 0 otherwise
+ */
+static int
+ctx_inter_compatible(const enum pqos_interface requested,
+                     const enum pqos_interface running)
+{
+        if (requested == PQOS_INTER_AUTO || requested == running)
+                return 1;
+
+        /* resctrl monitoring interface is a variant of the OS interface */
+        return requested == PQOS_INTER_OS &&
+               running == PQOS_INTER_OS_RESCTRL_MON;
+}
+
+int
+pqos_ctx_init(const struct pqos_config *config, struct pqos_ctx **ctx)
+{
+        int ret = PQOS_RETVAL_OK;
+        struct pqos_ctx *handle;
+        int initialized;
+
+        if (config == NULL || ctx == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        handle = (struct pqos_ctx *)calloc(1, sizeof(*handle));
+        if (handle == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        if (pthread_mutex_lock(&m_ctx_lock) != 0) {
+                free(handle);
+                return PQOS_RETVAL_ERROR;
+        }
+
+        /* API lock is not available before the library is initialized */
+        initialized = m_init_done;
+        handle->interface = m_interface;
+
+        if (!initialized) {
+                /* first handle brings the library up */
+                ret = cap_init(config);
+                if (ret != PQOS_RETVAL_OK)
+                        goto ctx_init_exit;
+                m_ctx_owner = 1;
+                handle->interface = m_interface;
+        } else if (!ctx_inter_compatible(config->interface,
+                                         handle->interface)) {
+                LOG_ERROR("Library already initialized with %s interface\n",
+                          _cap_interface_to_string(handle->interface));
+                ret = PQOS_RETVAL_INTER;
+                goto ctx_init_exit;
+        }
+
+        handle->next = m_ctx_list;
+        m_ctx_list = handle;
+        m_ctx_num++;
+        *ctx = handle;
+
+ctx_init_exit:
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        if (ret != PQOS_RETVAL_OK)
+                free(handle);
+
+        return ret;
+}
+
+int
+pqos_ctx_fini(struct pqos_ctx *ctx)
+{
+        int ret = PQOS_RETVAL_OK;
+        struct pqos_ctx **phandle;
+
+        if (ctx == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        if (pthread_mutex_lock(&m_ctx_lock) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        for (phandle = &m_ctx_list; *phandle != NULL;
+             phandle = &(*phandle)->next)
+                if (*phandle == ctx)
+                        break;
+        if (*phandle == NULL) {
+                pthread_mutex_unlock(&m_ctx_lock);
+                return PQOS_RETVAL_PARAM;
+        }
+
+        *phandle = ctx->next;
+        m_ctx_num--;
+        /* last handle shuts the library down if it brought it up or
+         * pqos_fini() was called meanwhile
+         */
+        if (m_ctx_num == 0 && m_ctx_owner) {
+                m_ctx_owner = 0;
+                ret = cap_fini();
+        }
+
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        free(ctx);
+
+        return ret;
+}
+
+int
+pqos_ctx_cap_get(const struct pqos_ctx *ctx,
+                 const struct pqos_cap **cap,
+                 const struct pqos_cpuinfo **cpu)
+{
+        int ret;
+
+        if (ctx == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        /* library stays up while the handle is validated and used */
+        if (pthread_mutex_lock(&m_ctx_lock) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        if (ctx_valid(ctx))
+                ret = pqos_cap_get(cap, cpu);
+        else
+                ret = PQOS_RETVAL_PARAM;
+
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        return ret;
+}
+
+int
+pqos_ctx_inter_get(const struct pqos_ctx *ctx, enum pqos_interface *interface)
+{
+        int ret = PQOS_RETVAL_OK;
+
+        if (ctx == NULL || interface == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        if (pthread_mutex_lock(&m_ctx_lock) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        if (ctx_valid(ctx))
+                *interface = ctx->interface;
+        else
+                ret = PQOS_RETVAL_PARAM;
+
+        pthread_mutex_unlock(&m_ctx_lock);
+
+        return ret;
+}
+
 /**
  * =======================================
  * =======================================
@@ -871,6 +1204,54 @@ pqos_cap_get(const struct pqos_cap **cap, const struct pqos_cpuinfo **cpu)
         return PQOS_RETVAL_OK;
 }
 
+int
+pqos_cpu_refresh(void)
+{
+        const struct pqos_cpuinfo *cpu = NULL;
+        unsigned i, max_core = 0;
+        int changed = 0;
+        int ret;
+
+        lock_get();
+
+        ret = _pqos_check_init(1);
+        if (ret != PQOS_RETVAL_OK) {
+                lock_release();
+                return ret;
+        }
+
+        ret = cpuinfo_refresh(&cpu, &changed);
+        if (ret != 0) {
+                LOG_ERROR("cpuinfo_refresh() error %d\n", ret);
+                lock_release();
+                return PQOS_RETVAL_ERROR;
+        }
+
+        m_cpu = cpu;
+
+        /**
+         * Cores could go offline and back online since last refresh
+         * so cached MSR file descriptors are dropped in any case
+         */
+        for (i = 0; i < m_cpu->num_cores; i++)
+                if (m_cpu->cores[i].lcore > max_core)
+                        max_core = m_cpu->cores[i].lcore;
+
+        ret = machine_refresh(max_core);
+        if (ret != MACHINE_RETVAL_OK) {
+                LOG_ERROR("machine_refresh() error %d\n", ret);
+                ret = PQOS_RETVAL_ERROR;
+        }
+
+#ifdef __linux__
+        if (changed)
+                os_alloc_schemata_release();
+#endif
+
+        lock_release();
+        return ret;
+}
+
 void
 _pqos_cap_l3cdp_change(const enum pqos_cdp_config cdp)
 {
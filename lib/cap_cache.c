@@ -0,0 +1,460 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Capability & topology snapshot cache
+ *
+ * File layout:
+ * - header with snapshot key
+ * - CPU topology structure
+ * - capability entries, each preceded with type and size
+ */
+
+#include "cap_cache.h"
+
+#include "common.h"
+#include "log.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#define CAP_CACHE_MAGIC   0x43505152 /**< "RQPC" */
+#define CAP_CACHE_FORMAT  1
+#define CAP_CACHE_KEY_LEN 1024
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Cache file header
+ */
+struct cap_cache_hdr {
+        uint32_t magic;              /**< CAP_CACHE_MAGIC */
+        uint32_t format;             /**< file format version */
+        uint32_t version;            /**< library version */
+        uint32_t inter;              /**< interface */
+        uint32_t cpu_size;           /**< size of topology structure */
+        uint32_t num_cap;            /**< number of capability entries */
+        char key[CAP_CACHE_KEY_LEN]; /**< platform state key */
+};
+
+/**
+ * Capability entry header
+ */
+struct cap_cache_entry {
+        uint32_t type; /**< capability type */
+        uint32_t size; /**< size of capability structure */
+};
+
+/**
+ * Loaded snapshot not yet taken by the library
+ */
+static struct pqos_cpuinfo *m_cpu = NULL;
+static struct pqos_cap *m_cap = NULL;
+
+/**
+ * @brief Frees capabilities structure
+ *
+ * @param [in] cap capabilities
+ */
+static void
+cap_free(struct pqos_cap *cap)
+{
+        unsigned i;
+
+        if (cap == NULL)
+                return;
+
+        for (i = 0; i < cap->num_cap; i++)
+                free(cap->capabilities[i].u.generic_ptr);
+        free(cap);
+}
+
+/**
+ * @brief Reads first line of \a path
+ *
+ * @param [in] path file path
+ * @param [out] buf buffer to store the line, "none" if not available
+ * @param [in] size size of \a buf
+ */
+static void
+read_line(const char *path, char *buf, const size_t size)
+{
+        FILE *fd = pqos_fopen(path, "r");
+        char *p;
+
+        if (fd == NULL || fgets(buf, size, fd) == NULL)
+                strncpy(buf, "none", size - 1);
+        buf[size - 1] = '\0';
+
+        p = strchr(buf, '\n');
+        if (p != NULL)
+                *p = '\0';
+
+        if (fd != NULL)
+                pqos_fclose(fd);
+}
+
+/**
+ * @brief Reads resctrl mount options from /proc/mounts
+ *
+ * @param [out] buf buffer to store options, "none" if not mounted
+ * @param [in] size size of \a buf
+ */
+static void
+read_resctrl_opts(char *buf, const size_t size)
+{
+        char line[512];
+        FILE *fd = pqos_fopen("/proc/mounts", "r");
+
+        strncpy(buf, "none", size - 1);
+        buf[size - 1] = '\0';
+
+        if (fd == NULL)
+                return;
+
+        while (fgets(line, sizeof(line), fd) != NULL) {
+                char *saveptr = NULL;
+                char *type;
+                char *opts;
+
+                if (strtok_r(line, " ", &saveptr) == NULL ||
+                    strtok_r(NULL, " ", &saveptr) == NULL)
+                        continue;
+                type = strtok_r(NULL, " ", &saveptr);
+                opts = strtok_r(NULL, " ", &saveptr);
+                if (type == NULL || opts == NULL ||
+                    strcmp(type, "resctrl") != 0)
+                        continue;
+
+                strncpy(buf, opts, size - 1);
+                buf[size - 1] = '\0';
+                break;
+        }
+
+        pqos_fclose(fd);
+}
+
+/**
+ * @brief Builds key describing current platform state
+ *
+ * @param [in] inter selected interface
+ * @param [out] key buffer of CAP_CACHE_KEY_LEN bytes
+ */
+static void
+cap_cache_key(const enum pqos_interface inter, char *key)
+{
+        char boot_id[64];
+        char ucode[32];
+        char online[128];
+        char resctrl[128];
+        struct utsname name;
+
+        read_line("/proc/sys/kernel/random/boot_id", boot_id, sizeof(boot_id));
+        read_line("/sys/devices/system/cpu/cpu0/microcode/version", ucode,
+                  sizeof(ucode));
+        read_line("/sys/devices/system/cpu/online", online, sizeof(online));
+        if (inter == PQOS_INTER_MSR)
+                strncpy(resctrl, "n/a", sizeof(resctrl));
+        else
+                read_resctrl_opts(resctrl, sizeof(resctrl));
+
+        if (uname(&name) != 0)
+                memset(&name, 0, sizeof(name));
+
+        memset(key, 0, CAP_CACHE_KEY_LEN);
+        snprintf(key, CAP_CACHE_KEY_LEN,
+                 "boot_id=%s;kernel=%s %s;ucode=%s;online=%s;resctrl=%s",
+                 boot_id, name.release, name.version, ucode, online, resctrl);
+}
+
+/**
+ * @brief Determines size of capability structure
+ *
+ * @param [in] type capability type
+ * @param [in] data capability structure
+ *
+ * @return size of the structure
+ * @retval 0 if type is not valid
+ */
+static size_t
+cap_entry_size(const uint32_t type, const void *data)
+{
+        const struct pqos_cap_mon *mon = (const struct pqos_cap_mon *)data;
+
+        switch (type) {
+        case PQOS_CAP_TYPE_MON:
+                return sizeof(*mon) +
+                       (size_t)mon->num_events * sizeof(struct pqos_monitor);
+        case PQOS_CAP_TYPE_L3CA:
+                return sizeof(struct pqos_cap_l3ca);
+        case PQOS_CAP_TYPE_L2CA:
+                return sizeof(struct pqos_cap_l2ca);
+        case PQOS_CAP_TYPE_MBA:
+                return sizeof(struct pqos_cap_mba);
+        default:
+                return 0;
+        }
+}
+
+/**
+ * @brief Reads snapshot data from \a fd
+ *
+ * @param [in] fd cache file
+ * @param [in] hdr validated cache file header
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+static int
+cap_cache_read(FILE *fd, const struct cap_cache_hdr *hdr)
+{
+        struct pqos_cpuinfo *cpu = NULL;
+        struct pqos_cap *cap = NULL;
+        size_t sz;
+        unsigned i;
+
+        if (hdr->cpu_size < sizeof(*cpu) || hdr->num_cap == 0 ||
+            hdr->num_cap > PQOS_CAP_TYPE_NUMOF)
+                return PQOS_RETVAL_ERROR;
+
+        cpu = (struct pqos_cpuinfo *)malloc(hdr->cpu_size);
+        if (cpu == NULL)
+                return PQOS_RETVAL_RESOURCE;
+        if (fread(cpu, hdr->cpu_size, 1, fd) != 1 ||
+            hdr->cpu_size != sizeof(*cpu) + (size_t)cpu->num_cores *
+                                                 sizeof(cpu->cores[0]))
+                goto cap_cache_read_error;
+        cpu->mem_size = hdr->cpu_size;
+
+        sz = sizeof(*cap) + hdr->num_cap * sizeof(struct pqos_capability);
+        cap = (struct pqos_cap *)calloc(1, sz);
+        if (cap == NULL)
+                goto cap_cache_read_error;
+        cap->mem_size = sz;
+        cap->version = PQOS_VERSION;
+
+        for (i = 0; i < hdr->num_cap; i++) {
+                struct cap_cache_entry entry;
+                void *data;
+
+                if (fread(&entry, sizeof(entry), 1, fd) != 1 ||
+                    entry.size < sizeof(unsigned) || entry.size > 4096)
+                        goto cap_cache_read_error;
+
+                /* make sure mon header is readable for size check */
+                data = calloc(1, entry.size > sizeof(struct pqos_cap_mon)
+                                     ? entry.size
+                                     : sizeof(struct pqos_cap_mon));
+                if (data == NULL)
+                        goto cap_cache_read_error;
+                cap->capabilities[cap->num_cap].type =
+                    (enum pqos_cap_type)entry.type;
+                cap->capabilities[cap->num_cap].u.generic_ptr = data;
+                cap->num_cap++;
+
+                if (fread(data, entry.size, 1, fd) != 1 ||
+                    cap_entry_size(entry.type, data) != entry.size)
+                        goto cap_cache_read_error;
+        }
+
+        m_cpu = cpu;
+        m_cap = cap;
+
+        return PQOS_RETVAL_OK;
+
+cap_cache_read_error:
+        free(cpu);
+        cap_free(cap);
+        return PQOS_RETVAL_ERROR;
+}
+
+int
+cap_cache_load(const enum pqos_interface inter)
+{
+        const char *path = getenv(CAP_CACHE_ENV);
+        struct cap_cache_hdr hdr;
+        char key[CAP_CACHE_KEY_LEN];
+        FILE *fd;
+        int ret;
+
+        cap_cache_fini();
+
+        if (path == NULL || *path == '\0')
+                return PQOS_RETVAL_RESOURCE;
+
+        fd = pqos_fopen(path, "r");
+        if (fd == NULL) {
+                LOG_INFO("Capability cache %s not found\n", path);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        cap_cache_key(inter, key);
+
+        if (fread(&hdr, sizeof(hdr), 1, fd) != 1 ||
+            hdr.magic != CAP_CACHE_MAGIC || hdr.format != CAP_CACHE_FORMAT ||
+            hdr.version != PQOS_VERSION || hdr.inter != (uint32_t)inter ||
+            memcmp(hdr.key, key, sizeof(key)) != 0) {
+                LOG_INFO("Capability cache %s is stale\n", path);
+                pqos_fclose(fd);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        ret = cap_cache_read(fd, &hdr);
+        pqos_fclose(fd);
+
+        if (ret != PQOS_RETVAL_OK) {
+                LOG_WARN("Capability cache %s is corrupted\n", path);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        LOG_INFO("Capabilities loaded from cache %s\n", path);
+
+        return PQOS_RETVAL_OK;
+}
+
+struct pqos_cpuinfo *
+cap_cache_cpu_get(void)
+{
+        struct pqos_cpuinfo *cpu = m_cpu;
+
+        m_cpu = NULL;
+        return cpu;
+}
+
+struct pqos_cap *
+cap_cache_cap_get(void)
+{
+        struct pqos_cap *cap = m_cap;
+
+        m_cap = NULL;
+        return cap;
+}
+
+int
+cap_cache_store(const enum pqos_interface inter,
+                const struct pqos_cpuinfo *cpu,
+                const struct pqos_cap *cap)
+{
+        const char *path = getenv(CAP_CACHE_ENV);
+        struct cap_cache_hdr hdr;
+        char tmp[PATH_MAX];
+        FILE *fd = NULL;
+        int fdi;
+        unsigned i;
+        int ret = PQOS_RETVAL_ERROR;
+
+        ASSERT(cpu != NULL);
+        ASSERT(cap != NULL);
+
+        if (path == NULL || *path == '\0')
+                return PQOS_RETVAL_OK;
+
+        if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp))
+                return PQOS_RETVAL_PARAM;
+
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic = CAP_CACHE_MAGIC;
+        hdr.format = CAP_CACHE_FORMAT;
+        hdr.version = PQOS_VERSION;
+        hdr.inter = inter;
+        hdr.cpu_size = sizeof(*cpu) + cpu->num_cores * sizeof(cpu->cores[0]);
+        hdr.num_cap = cap->num_cap;
+        cap_cache_key(inter, hdr.key);
+
+        fdi = mkstemp(tmp);
+        if (fdi < 0) {
+                LOG_WARN("Failed to create capability cache %s\n", tmp);
+                return PQOS_RETVAL_ERROR;
+        }
+
+        fd = fdopen(fdi, "w");
+        if (fd == NULL) {
+                close(fdi);
+                goto cap_cache_store_exit;
+        }
+
+        if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1 ||
+            fwrite(cpu, hdr.cpu_size, 1, fd) != 1)
+                goto cap_cache_store_exit;
+
+        for (i = 0; i < cap->num_cap; i++) {
+                const struct pqos_capability *item = &cap->capabilities[i];
+                struct cap_cache_entry entry;
+
+                entry.type = item->type;
+                entry.size = cap_entry_size(item->type, item->u.generic_ptr);
+                if (entry.size == 0)
+                        goto cap_cache_store_exit;
+
+                if (fwrite(&entry, sizeof(entry), 1, fd) != 1 ||
+                    fwrite(item->u.generic_ptr, entry.size, 1, fd) != 1)
+                        goto cap_cache_store_exit;
+        }
+
+        if (fchmod(fdi, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0)
+                goto cap_cache_store_exit;
+
+        ret = PQOS_RETVAL_OK;
+
+cap_cache_store_exit:
+        if (fd != NULL && fclose(fd) != 0)
+                ret = PQOS_RETVAL_ERROR;
+
+        if (ret == PQOS_RETVAL_OK && rename(tmp, path) != 0)
+                ret = PQOS_RETVAL_ERROR;
+
+        if (ret != PQOS_RETVAL_OK) {
+                LOG_WARN("Failed to store capability cache %s\n", path);
+                unlink(tmp);
+        } else
+                LOG_INFO("Capabilities stored in cache %s\n", path);
+
+        return ret;
+}
+
+void
+cap_cache_fini(void)
+{
+        free(m_cpu);
+        m_cpu = NULL;
+        cap_free(m_cap);
+        m_cap = NULL;
+}
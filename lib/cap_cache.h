@@ -0,0 +1,111 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file for capability & topology snapshot cache
+ *
+ * Discovered CPU topology and capabilities can be stored on disk and
+ * loaded by later library instances. Cache is enabled by setting the
+ * RDT_CAP_CACHE environment variable to the cache file path. Snapshot is
+ * keyed with boot id, kernel, microcode, online cpus and resctrl mount
+ * options, so it is discarded automatically when any of those change.
+ */
+
+#ifndef __PQOS_CAP_CACHE_H__
+#define __PQOS_CAP_CACHE_H__
+
+#include "pqos.h"
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Environment variable holding cache file path
+ */
+#define CAP_CACHE_ENV "RDT_CAP_CACHE"
+
+/**
+ * @brief Loads snapshot from the cache file
+ *
+ * @param [in] inter selected interface
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on cache hit
+ * @retval PQOS_RETVAL_RESOURCE if cache disabled or snapshot not valid
+ */
+PQOS_LOCAL int cap_cache_load(const enum pqos_interface inter);
+
+/**
+ * @brief Takes ownership of cached CPU topology
+ *
+ * @return CPU topology structure allocated with malloc()
+ * @retval NULL if not available
+ */
+PQOS_LOCAL struct pqos_cpuinfo *cap_cache_cpu_get(void);
+
+/**
+ * @brief Takes ownership of cached capabilities
+ *
+ * Each capability entry and the structure itself are allocated with
+ * malloc().
+ *
+ * @return Capabilities structure
+ * @retval NULL if not available
+ */
+PQOS_LOCAL struct pqos_cap *cap_cache_cap_get(void);
+
+/**
+ * @brief Stores snapshot in the cache file
+ *
+ * @param [in] inter selected interface
+ * @param [in] cpu CPU topology
+ * @param [in] cap capabilities
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success or when cache is disabled
+ */
+PQOS_LOCAL int cap_cache_store(const enum pqos_interface inter,
+                               const struct pqos_cpuinfo *cpu,
+                               const struct pqos_cap *cap);
+
+/**
+ * @brief Releases snapshot data not taken by the library
+ */
+PQOS_LOCAL void cap_cache_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_CAP_CACHE_H__ */
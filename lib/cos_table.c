@@ -0,0 +1,355 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Class of service occupancy table
+ *
+ * Reference counters are kept per domain in rows of PQOS_MAX_COS entries,
+ * domains are addressed through dense topology index. Finding a free class
+ * and updating association are independent of the number of cores.
+ */
+
+#include "cos_table.h"
+
+#include "allocation.h"
+#include "lock.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Reference counters of single domain type
+ */
+struct cos_table_refs {
+        enum topo_obj type; /**< domain type */
+        unsigned num;       /**< number of domains */
+        unsigned *cnt;      /**< cnt[idx * PQOS_MAX_COS + class_id] */
+};
+
+/**
+ * Domain types tracked by the table
+ */
+#define COS_TABLE_REFS_NUMOF 3
+
+static struct {
+        int enabled;    /**< table is enabled */
+        int valid;      /**< table reflects hardware state */
+        unsigned topo_gen; /**< topology generation table was built for */
+        uint64_t counter;  /**< lock file counter table is in sync with */
+        const struct pqos_cpuinfo *cpu; /**< CPU topology */
+        unsigned *assoc;   /**< class of service of cpu->cores[n] */
+        struct cos_table_refs refs[COS_TABLE_REFS_NUMOF];
+} m_cos;
+
+/**
+ * @brief Releases table memory and marks it invalid
+ */
+static void
+cos_table_clear(void)
+{
+        unsigned i;
+
+        free(m_cos.assoc);
+        m_cos.assoc = NULL;
+
+        for (i = 0; i < COS_TABLE_REFS_NUMOF; i++) {
+                free(m_cos.refs[i].cnt);
+                m_cos.refs[i].cnt = NULL;
+                m_cos.refs[i].num = 0;
+        }
+
+        m_cos.cpu = NULL;
+        m_cos.valid = 0;
+}
+
+/**
+ * @brief Adds \a delta to counters of all domains of \a core
+ *
+ * @param [in] core core information
+ * @param [in] class_id class of service
+ * @param [in] delta 1 or -1
+ */
+static void
+cos_table_ref(const struct pqos_coreinfo *core,
+              const unsigned class_id,
+              const int delta)
+{
+        unsigned i;
+
+        if (class_id >= PQOS_MAX_COS)
+                return;
+
+        for (i = 0; i < COS_TABLE_REFS_NUMOF; i++) {
+                struct cos_table_refs *refs = &m_cos.refs[i];
+                unsigned id, idx;
+
+                switch (refs->type) {
+                case TOPO_OBJ_L3CAT:
+                        id = core->l3cat_id;
+                        break;
+                case TOPO_OBJ_MBA:
+                        id = core->mba_id;
+                        break;
+                default:
+                        id = core->l2_id;
+                        break;
+                }
+
+                if (topo_obj_idx(m_cos.cpu, refs->type, id, &idx) !=
+                    PQOS_RETVAL_OK)
+                        continue;
+
+                if (delta > 0)
+                        refs->cnt[idx * PQOS_MAX_COS + class_id]++;
+                else if (refs->cnt[idx * PQOS_MAX_COS + class_id] > 0)
+                        refs->cnt[idx * PQOS_MAX_COS + class_id]--;
+        }
+}
+
+/**
+ * @brief Populates table with association of all cores
+ *
+ * @param [in] cpu CPU topology
+ *
+ * @return Operation status
+ */
+static int
+cos_table_build(const struct pqos_cpuinfo *cpu)
+{
+        unsigned i;
+        int ret = PQOS_RETVAL_OK;
+
+        cos_table_clear();
+
+        m_cos.cpu = cpu;
+        m_cos.assoc = calloc(cpu->num_cores, sizeof(m_cos.assoc[0]));
+        if (m_cos.assoc == NULL) {
+                ret = PQOS_RETVAL_RESOURCE;
+                goto cos_table_build_exit;
+        }
+
+        for (i = 0; i < COS_TABLE_REFS_NUMOF; i++) {
+                struct cos_table_refs *refs = &m_cos.refs[i];
+                const unsigned *ids;
+
+                ret = topo_obj_ids(cpu, refs->type, &ids, &refs->num);
+                if (ret != PQOS_RETVAL_OK)
+                        goto cos_table_build_exit;
+
+                refs->cnt = calloc((size_t)refs->num * PQOS_MAX_COS,
+                                   sizeof(refs->cnt[0]));
+                if (refs->cnt == NULL) {
+                        ret = PQOS_RETVAL_RESOURCE;
+                        goto cos_table_build_exit;
+                }
+        }
+
+        for (i = 0; i < cpu->num_cores; i++) {
+                ret = hw_alloc_assoc_read(cpu->cores[i].lcore,
+                                          &m_cos.assoc[i]);
+                if (ret != PQOS_RETVAL_OK)
+                        goto cos_table_build_exit;
+
+                cos_table_ref(&cpu->cores[i], m_cos.assoc[i], 1);
+        }
+
+        m_cos.topo_gen = topo_generation();
+        m_cos.valid = 1;
+
+cos_table_build_exit:
+        if (ret != PQOS_RETVAL_OK)
+                cos_table_clear();
+
+        return ret;
+}
+
+/**
+ * =======================================
+ * initialize and shutdown
+ * =======================================
+ */
+
+void
+cos_table_init(void)
+{
+        cos_table_clear();
+
+        m_cos.refs[0].type = TOPO_OBJ_L3CAT;
+        m_cos.refs[1].type = TOPO_OBJ_MBA;
+        m_cos.refs[2].type = TOPO_OBJ_L2_CLUSTER;
+        m_cos.enabled = 1;
+}
+
+void
+cos_table_fini(void)
+{
+        cos_table_clear();
+        m_cos.enabled = 0;
+}
+
+/**
+ * =======================================
+ * table access
+ * =======================================
+ */
+
+int
+cos_table_sync(const struct pqos_cpuinfo *cpu)
+{
+        uint64_t counter;
+
+        if (!m_cos.enabled || !topo_is_indexed(cpu))
+                return PQOS_RETVAL_RESOURCE;
+
+        if (lock_counter_get(&counter) != 0)
+                return PQOS_RETVAL_ERROR;
+
+        if (m_cos.valid && m_cos.cpu == cpu &&
+            m_cos.topo_gen == topo_generation() && m_cos.counter == counter)
+                return PQOS_RETVAL_OK;
+
+        LOG_DEBUG("Reading class of service association of all cores\n");
+
+        m_cos.counter = counter;
+
+        return cos_table_build(cpu);
+}
+
+unsigned
+cos_table_refcnt(const enum topo_obj type,
+                 const unsigned id,
+                 const unsigned class_id)
+{
+        unsigned i, idx;
+
+        if (!m_cos.valid || class_id >= PQOS_MAX_COS)
+                return 0;
+
+        for (i = 0; i < COS_TABLE_REFS_NUMOF; i++) {
+                const struct cos_table_refs *refs = &m_cos.refs[i];
+
+                if (refs->type != type)
+                        continue;
+
+                if (topo_obj_idx(m_cos.cpu, type, id, &idx) != PQOS_RETVAL_OK)
+                        return 0;
+
+                return refs->cnt[idx * PQOS_MAX_COS + class_id];
+        }
+
+        return 0;
+}
+
+int
+cos_table_verify(const enum topo_obj type, const unsigned id)
+{
+        const unsigned *lcores;
+        unsigned num, i;
+        int ret;
+
+        if (!m_cos.valid)
+                return PQOS_RETVAL_ERROR;
+
+        ret = topo_obj_cores(m_cos.cpu, type, id, &lcores, &num);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        for (i = 0; i < num; i++) {
+                const struct pqos_coreinfo *core;
+                unsigned class_id, idx;
+
+                ret = topo_core_info(m_cos.cpu, lcores[i], &core);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+
+                ret = hw_alloc_assoc_read(lcores[i], &class_id);
+                if (ret != PQOS_RETVAL_OK) {
+                        m_cos.valid = 0;
+                        return ret;
+                }
+
+                idx = (unsigned)(core - m_cos.cpu->cores);
+                if (m_cos.assoc[idx] == class_id)
+                        continue;
+
+                LOG_DEBUG("Core %u association changed outside of the "
+                          "library\n",
+                          lcores[i]);
+                cos_table_ref(core, m_cos.assoc[idx], -1);
+                m_cos.assoc[idx] = class_id;
+                cos_table_ref(core, class_id, 1);
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+void
+cos_table_update(const unsigned lcore, const unsigned class_id)
+{
+        const struct pqos_coreinfo *core;
+        uint64_t counter;
+        unsigned idx;
+
+        if (!m_cos.enabled)
+                return;
+
+        /* Let other library instances know association has changed */
+        if (lock_counter_inc(&counter) != 0) {
+                m_cos.valid = 0;
+                return;
+        }
+
+        if (!m_cos.valid)
+                return;
+
+        /* Changes made by others were not accounted, populate on next use */
+        if (counter != m_cos.counter + 1 ||
+            m_cos.topo_gen != topo_generation() ||
+            topo_core_info(m_cos.cpu, lcore, &core) != PQOS_RETVAL_OK) {
+                m_cos.valid = 0;
+                return;
+        }
+
+        m_cos.counter = counter;
+
+        idx = (unsigned)(core - m_cos.cpu->cores);
+        cos_table_ref(core, m_cos.assoc[idx], -1);
+        m_cos.assoc[idx] = class_id;
+        cos_table_ref(core, class_id, 1);
+}
@@ -0,0 +1,134 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file for class of service occupancy table
+ *
+ * Table keeps class of service associated with every core and number of
+ * cores using each class in every L3 CAT, MBA and L2 domain. It is used
+ * in MSR mode to find an unused class without reading association of all
+ * cores.
+ *
+ * Table is populated on first use and updated with every association
+ * change made by the library. Changes made by other library instances are
+ * detected through counter kept in the API lock file, in such case table
+ * is populated again.
+ *
+ * Only this library version bumps the counter. Association changes made
+ * by older library versions, OS interface users or direct MSR writes go
+ * unnoticed, so the table may be stale. Cores of a domain are read again
+ * with \a cos_table_verify before a class found unused is handed out.
+ */
+
+#ifndef __PQOS_COS_TABLE_H__
+#define __PQOS_COS_TABLE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pqos.h"
+#include "topology.h"
+#include "types.h"
+
+/**
+ * @brief Enables class of service table
+ *
+ * Table memory is allocated on first use.
+ */
+PQOS_LOCAL void cos_table_init(void);
+
+/**
+ * @brief Disables class of service table and releases its memory
+ */
+PQOS_LOCAL void cos_table_fini(void);
+
+/**
+ * @brief Brings table in sync with hardware
+ *
+ * Association of all cores is read if table was not populated yet,
+ * topology has changed or other library instance changed association.
+ *
+ * @param [in] cpu CPU topology
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if table is disabled or \a cpu is not indexed
+ */
+PQOS_LOCAL int cos_table_sync(const struct pqos_cpuinfo *cpu);
+
+/**
+ * @brief Retrieves number of cores of domain \a id using \a class_id
+ *
+ * Table needs to be synchronized with \a cos_table_sync first.
+ *
+ * @param [in] type domain type, one of TOPO_OBJ_L3CAT, TOPO_OBJ_MBA or
+ *             TOPO_OBJ_L2_CLUSTER
+ * @param [in] id domain id
+ * @param [in] class_id class of service
+ *
+ * @return number of cores, 0 for unknown domain or class
+ */
+PQOS_LOCAL unsigned cos_table_refcnt(const enum topo_obj type,
+                                     const unsigned id,
+                                     const unsigned class_id);
+
+/**
+ * @brief Reads association of all cores of domain \a id again
+ *
+ * Corrects table entries changed without the library noticing.
+ *
+ * @param [in] type domain type, one of TOPO_OBJ_L3CAT, TOPO_OBJ_MBA or
+ *             TOPO_OBJ_L2_CLUSTER
+ * @param [in] id domain id
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if table is not synchronized
+ */
+PQOS_LOCAL int cos_table_verify(const enum topo_obj type, const unsigned id);
+
+/**
+ * @brief Records association of \a lcore with \a class_id
+ *
+ * Called after association MSR of \a lcore was written.
+ *
+ * @param [in] lcore logical core id
+ * @param [in] class_id class of service
+ */
+PQOS_LOCAL void cos_table_update(const unsigned lcore, const unsigned class_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_COS_TABLE_H__ */
@@ -39,15 +39,18 @@
 
 #include "allocation.h"
 #include "cap.h"
+#include "cap_cache.h"
 #include "cpu_registers.h"
 #include "log.h"
 #include "machine.h"
 #include "os_allocation.h"
 #include "os_cpuinfo.h"
+#include "topology.h"
 
 #include <errno.h>
 #include <limits.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h> /* sysconf() */
 #ifdef __FreeBSD__
@@ -55,16 +58,34 @@
 #include <sys/param.h>  /* sched affinity */
 #endif
 #ifdef __linux__
+#include <pthread.h>
 #include <sched.h> /* sched affinity */
 #include <sys/syscall.h>
 #endif
 
+/**
+ * Marks APICID of logical core not discovered
+ */
+#define APICID_INVALID UINT32_MAX
+
+/**
+ * Max number of CPUID probe threads running in parallel
+ */
+#define PROBE_THREADS_MAX 64
+
 /**
  * This structure will be made externally available
  * If not NULL then module is initialized.
  */
 static struct pqos_cpuinfo *m_cpu = NULL;
 
+/**
+ * Topology replaced by the last refresh. Applications may still hold a
+ * pointer to it, and to its index, so it is released with the next
+ * topology change or on module shutdown.
+ */
+static struct pqos_cpuinfo *m_retired = NULL;
+
 /**
  * intel/amd vendor configuration
  */
@@ -90,6 +111,13 @@ struct apic_info {
         uint32_t l3_shift;      /**< bits to shift to get L3 ID */
 };
 
+/**
+ * APICID structure information and interface used to detect topology,
+ * kept for topology refresh
+ */
+static struct apic_info m_apic;
+static enum pqos_interface m_interface;
+
 /**
  * Own typedef to simplify dealing with cpu set differences.
  */
@@ -97,6 +125,7 @@ struct apic_info {
 typedef cpuset_t cpu_set_t; /* stick with Linux typedef */
 #endif
 
+#ifndef __linux__
 /**
  * @brief Sets current task CPU affinity as specified by \a p_set mask
  *
@@ -161,6 +190,7 @@ get_affinity(cpu_set_t *p_set)
                                   sizeof(*p_set), p_set);
 #endif
 }
+#endif /* __linux__ */
 
 /**
  * @brief Discovers APICID structure information
@@ -362,17 +392,162 @@ detect_apic_masks(struct apic_info *apic)
         return 0;
 }
 
+#ifdef __linux__
+/**
+ * Per core CPUID probe
+ */
+struct cpu_probe {
+        unsigned lcore;  /**< probed logical core */
+        uint32_t apicid; /**< discovered APICID */
+};
+
+/**
+ * @brief Probe thread body, runs CPUID leaf 0xB on the core it is pinned to
+ *
+ * @param [in,out] arg probe structure
+ *
+ * @return NULL
+ */
+static void *
+probe_thread(void *arg)
+{
+        struct cpu_probe *probe = (struct cpu_probe *)arg;
+        struct cpuid_out leafB;
+
+        lcpuid(0xb, 0, &leafB);
+        probe->apicid = leafB.edx; /* x2APIC ID */
+
+        return NULL;
+}
+
+/**
+ * @brief Discovers APICID of cores not resolved by the OS
+ *
+ * Runs CPUID in helper threads pinned to probed cores so the calling
+ * task keeps its affinity. Up to PROBE_THREADS_MAX cores are probed
+ * in parallel. Cores that can't be scheduled on (i.e. offline) are left
+ * unresolved.
+ *
+ * @param [in] num_cpus number of entries in \a apicid
+ * @param [in,out] apicid APICID table indexed by logical core id
+ */
+static void
+probe_apicid(const unsigned num_cpus, uint32_t *apicid)
+{
+        struct cpu_probe probe[PROBE_THREADS_MAX];
+        pthread_t thread[PROBE_THREADS_MAX];
+        unsigned cpu = 0;
+
+        while (cpu < num_cpus) {
+                unsigned num = 0;
+                unsigned i;
+
+                for (; cpu < num_cpus && num < PROBE_THREADS_MAX; cpu++) {
+                        pthread_attr_t attr;
+                        cpu_set_t cpuset;
+                        int ret;
+
+                        if (apicid[cpu] != APICID_INVALID)
+                                continue;
+
+                        if (pthread_attr_init(&attr) != 0)
+                                continue;
+
+                        CPU_ZERO(&cpuset);
+                        CPU_SET(cpu, &cpuset);
+                        probe[num].lcore = cpu;
+                        probe[num].apicid = APICID_INVALID;
+
+                        ret = pthread_attr_setaffinity_np(&attr, sizeof(cpuset),
+                                                          &cpuset);
+                        if (ret == 0)
+                                ret = pthread_create(&thread[num], &attr,
+                                                     probe_thread, &probe[num]);
+                        if (ret == 0)
+                                num++;
+                        else
+                                LOG_DEBUG("Could not probe core %u\n", cpu);
+
+                        pthread_attr_destroy(&attr);
+                }
+
+                for (i = 0; i < num; i++) {
+                        pthread_join(thread[i], NULL);
+                        apicid[probe[i].lcore] = probe[i].apicid;
+                }
+        }
+}
+#endif /* __linux__ */
+
+/**
+ * @brief Discovers APICID of all logical cores
+ *
+ * On Linux APICIDs are read from /proc/cpuinfo and CPUID is only run for
+ * cores missing there, from threads pinned to those cores. Otherwise
+ * current task is scheduled on every core in turn to run CPUID.
+ *
+ * @param [in] num_cpus number of entries in \a apicid
+ * @param [out] apicid APICID table indexed by logical core id,
+ *              APICID_INVALID for undetected cores
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+static int
+detect_apicid(const unsigned num_cpus, uint32_t *apicid)
+{
+        unsigned i;
+#ifdef __linux__
+        unsigned count = 0;
+#else
+        cpu_set_t current_mask;
+#endif
+
+        for (i = 0; i < num_cpus; i++)
+                apicid[i] = APICID_INVALID;
+
+#ifdef __linux__
+        if (os_cpuinfo_apicid(num_cpus, apicid, &count) != PQOS_RETVAL_OK)
+                LOG_DEBUG("APICID not available from OS\n");
+
+        if (count < num_cpus)
+                probe_apicid(num_cpus, apicid);
+#else
+        if (get_affinity(&current_mask) != 0) {
+                LOG_ERROR("Error retrieving CPU affinity mask!");
+                return -1;
+        }
+
+        for (i = 0; i < num_cpus; i++) {
+                struct cpuid_out leafB;
+
+                if (set_affinity(i) != 0)
+                        continue;
+
+                lcpuid(0xb, 0, &leafB);
+                apicid[i] = leafB.edx; /* x2APIC ID */
+        }
+
+        if (set_affinity_mask(&current_mask) != 0) {
+                LOG_ERROR("Couldn't restore original CPU affinity mask!");
+                return -1;
+        }
+#endif
+
+        return 0;
+}
+
 /**
  * @brief Detects CPU information
  *
- * - schedules current task to run on \a cpu
- * - runs CPUID leaf 0xB to get cpu's APICID
- * - uses \a apic & APICID information to:
- *   - retrieve socket id (physical package id)
- *   - retrieve L3/LLC cluster id
- *   - retrieve L2/MLC cluster id
+ * Uses \a apic & APICID information to:
+ * - retrieve socket id (physical package id)
+ * - retrieve L3/LLC cluster id
+ * - retrieve L2/MLC cluster id
  *
  * @param [in] cpu logical cpu id used by OS
+ * @param [in] apicid APICID of \a cpu
  * @param [in] apic information about APICID structure
  * @param [out] info CPU information structure to be filled by the function
  *
@@ -382,29 +557,21 @@ detect_apic_masks(struct apic_info *apic)
  */
 static int
 detect_cpu(const int cpu,
+           const uint32_t apicid,
            const struct apic_info *apic,
            struct pqos_coreinfo *info)
 {
-        struct cpuid_out leafB;
-        uint32_t apicid;
-
-        if (set_affinity(cpu) != 0)
-                return -1;
-
-        lcpuid(0xb, 0, &leafB);
-        apicid = leafB.edx; /* x2APIC ID */
-
         info->lcore = cpu;
         info->socket = (apicid & apic->pkg_mask) >> apic->pkg_shift;
         info->l3_id = apicid >> apic->l3_shift;
         info->l2_id = apicid >> apic->l2_shift;
 
 #if (PQOS_VERSION >= 50000 || defined PQOS_SNC)
-#if defined __linux__ && defined __NR_getcpu
-        syscall(__NR_getcpu, NULL, &info->numa, NULL);
-#else
-        if (getcpu(NULL, &info->numa) != 0)
+#ifdef __linux__
+        if (os_cpuinfo_cpu_node(cpu, &info->numa) != PQOS_RETVAL_OK)
                 return -1;
+#else
+        info->numa = 0; /* no OS NUMA information */
 #endif
 #endif
 
@@ -425,14 +592,9 @@ detect_cpu(const int cpu,
 /**
  * @brief Builds CPU topology structure
  *
- * - saves current task CPU affinity
  * - retrieves number of processors in the system
- * - detects information on APICID structure
- * - for each processor in the system:
- *      - change affinity to run only on the processor
- *      - read APICID of current processor with CPUID
- *      - retrieve package & cluster data from the APICID
- * - restores initial task CPU affinity
+ * - discovers APICID of every processor
+ * - retrieves package & cluster data from the APICIDs
  *
  * @param [in] apic information about APICID structure
  *
@@ -445,12 +607,7 @@ cpuinfo_build_topo(struct apic_info *apic)
         int i, max_core_count;
         unsigned core_count = 0;
         struct pqos_cpuinfo *l_cpu = NULL;
-        cpu_set_t current_mask;
-
-        if (get_affinity(&current_mask) != 0) {
-                LOG_ERROR("Error retrieving CPU affinity mask!");
-                return NULL;
-        }
+        uint32_t *apicid = NULL;
 
         max_core_count = sysconf(_SC_NPROCESSORS_CONF);
         if (max_core_count <= 0) {
@@ -469,16 +626,29 @@ cpuinfo_build_topo(struct apic_info *apic)
         l_cpu->mem_size = (unsigned)mem_sz;
         memset(l_cpu, 0, mem_sz);
 
-        for (i = 0; i < max_core_count; ++i)
-                if (detect_cpu(i, apic, &l_cpu->cores[core_count]) == 0)
-                        core_count++;
+        apicid = (uint32_t *)malloc(max_core_count * sizeof(*apicid));
+        if (apicid == NULL) {
+                LOG_ERROR("Couldn't allocate APICID table!");
+                free(l_cpu);
+                return NULL;
+        }
 
-        if (set_affinity_mask(&current_mask) != 0) {
-                LOG_ERROR("Couldn't restore original CPU affinity mask!");
+        if (detect_apicid(max_core_count, apicid) != 0) {
+                free(apicid);
                 free(l_cpu);
                 return NULL;
         }
 
+        for (i = 0; i < max_core_count; ++i) {
+                if (apicid[i] == APICID_INVALID)
+                        continue;
+                if (detect_cpu(i, apicid[i], apic,
+                               &l_cpu->cores[core_count]) == 0)
+                        core_count++;
+        }
+
+        free(apicid);
+
         l_cpu->num_cores = core_count;
         if (core_count == 0) {
                 free(l_cpu);
@@ -550,6 +720,64 @@ init_config(struct cpuinfo_config *config, enum pqos_vendor vendor)
         return 0;
 }
 
+/**
+ * @brief Detects CPU topology through selected interface
+ *
+ * @param [in] interface interface used to detect topology
+ * @param [in] apic information about APICID structure
+ *
+ * @return Pointer to CPU topology structure
+ * @retval NULL on error
+ */
+static struct pqos_cpuinfo *
+cpuinfo_detect_topo(const enum pqos_interface interface,
+                    struct apic_info *apic)
+{
+        if (interface == PQOS_INTER_MSR)
+                return cpuinfo_build_topo(apic);
+#ifdef __linux__
+        if (interface == PQOS_INTER_OS ||
+            interface == PQOS_INTER_OS_RESCTRL_MON)
+                return os_cpuinfo_topology();
+#endif
+
+        return NULL;
+}
+
+/**
+ * @brief Fills in vendor specific data of CPU topology
+ *
+ * @param [in,out] cpu CPU topology structure
+ * @param [in] vendor CPU vendor
+ */
+static void
+cpuinfo_complete_topo(struct pqos_cpuinfo *cpu, const enum pqos_vendor vendor)
+{
+        unsigned i;
+
+        cpu->vendor = vendor;
+        cpu->l2 = m_l2;
+        cpu->l3 = m_l3;
+
+        /*
+         * Update l3cat_id and mba_id. For Intel, CAT and MBA ids are
+         * initialized to socket id. AMD uses l3_id for both CAT and MBA
+         * ids. Right now, both these ids are same. This could change in
+         * the future.
+         */
+        for (i = 0; i < cpu->num_cores; ++i) {
+                struct pqos_coreinfo *info = &cpu->cores[i];
+
+                if (vendor == PQOS_VENDOR_AMD) {
+                        info->l3cat_id = info->l3_id;
+                        info->mba_id = info->l3_id;
+                } else {
+                        info->l3cat_id = info->socket;
+                        info->mba_id = info->socket;
+                }
+        }
+}
+
 /**
  * Detect number of logical processors on the machine
  * and their location.
@@ -560,8 +788,6 @@ cpuinfo_init(enum pqos_interface interface,
 {
         int ret;
         enum pqos_vendor vendor;
-        unsigned i;
-        struct apic_info apic;
 
         if (topology == NULL)
                 return -EINVAL;
@@ -569,53 +795,86 @@ cpuinfo_init(enum pqos_interface interface,
         if (m_cpu != NULL)
                 return -EPERM;
 
+        if (interface != PQOS_INTER_MSR && interface != PQOS_INTER_OS &&
+            interface != PQOS_INTER_OS_RESCTRL_MON)
+                return -EINVAL;
+
         vendor = detect_vendor();
 
         ret = init_config(&m_config, vendor);
         if (ret != 0)
                 return ret;
 
-        if (detect_apic_masks(&apic) != 0) {
+        if (detect_apic_masks(&m_apic) != 0) {
                 LOG_ERROR("Couldn't retrieve APICID structure information!\n");
                 return -EFAULT;
         }
 
-        if (interface == PQOS_INTER_MSR)
-                m_cpu = cpuinfo_build_topo(&apic);
 #ifdef __linux__
-        else if (interface == PQOS_INTER_OS ||
-                 interface == PQOS_INTER_OS_RESCTRL_MON)
-                m_cpu = os_cpuinfo_topology();
+        m_cpu = cap_cache_cpu_get();
 #endif
+        if (m_cpu != NULL)
+                LOG_INFO("CPU topology loaded from cache\n");
         else
-                return -EINVAL;
+                m_cpu = cpuinfo_detect_topo(interface, &m_apic);
         if (m_cpu == NULL) {
                 LOG_ERROR("CPU topology detection error!\n");
                 return -EFAULT;
         }
 
-        m_cpu->vendor = vendor;
-        m_cpu->l2 = m_l2;
-        m_cpu->l3 = m_l3;
+        cpuinfo_complete_topo(m_cpu, vendor);
 
-        /*
-         * Update l3cat_id and mba_id. For Intel, CAT and MBA ids are
-         * initialized to socket id. AMD uses l3_id for both CAT and MBA
-         * ids. Right now, both these ids are same. This could change in
-         * the future.
-         */
-        for (i = 0; i < m_cpu->num_cores; ++i) {
-                struct pqos_coreinfo *info = &m_cpu->cores[i];
+        if (topo_init(m_cpu) != PQOS_RETVAL_OK) {
+                free(m_cpu);
+                m_cpu = NULL;
+                return -ENOMEM;
+        }
 
-                if (vendor == PQOS_VENDOR_AMD) {
-                        info->l3cat_id = info->l3_id;
-                        info->mba_id = info->l3_id;
-                } else {
-                        info->l3cat_id = info->socket;
-                        info->mba_id = info->socket;
-                }
+        m_interface = interface;
+        *topology = m_cpu;
+        return 0;
+}
+
+int
+cpuinfo_refresh(const struct pqos_cpuinfo **topology, int *changed)
+{
+        struct pqos_cpuinfo *cpu;
+
+        if (topology == NULL || changed == NULL)
+                return -EINVAL;
+
+        if (m_cpu == NULL)
+                return -EPERM;
+
+        cpu = cpuinfo_detect_topo(m_interface, &m_apic);
+        if (cpu == NULL) {
+                LOG_ERROR("CPU topology detection error!\n");
+                return -EFAULT;
         }
 
+        cpuinfo_complete_topo(cpu, m_cpu->vendor);
+
+        if (cpu->num_cores == m_cpu->num_cores &&
+            memcmp(cpu->cores, m_cpu->cores,
+                   cpu->num_cores * sizeof(cpu->cores[0])) == 0) {
+                free(cpu);
+                *changed = 0;
+                *topology = m_cpu;
+                return 0;
+        }
+
+        /* releases index of the topology retired by the previous change */
+        if (topo_init(cpu) != PQOS_RETVAL_OK) {
+                free(cpu);
+                return -ENOMEM;
+        }
+
+        LOG_INFO("CPU topology changed, %u cores online\n", cpu->num_cores);
+
+        free(m_retired);
+        m_retired = m_cpu;
+        m_cpu = cpu;
+        *changed = 1;
         *topology = m_cpu;
         return 0;
 }
@@ -625,8 +884,11 @@ cpuinfo_fini(void)
 {
         if (m_cpu == NULL)
                 return -EPERM;
+        topo_fini();
         free(m_cpu);
         m_cpu = NULL;
+        free(m_retired);
+        m_retired = NULL;
         return 0;
 }
 
@@ -83,6 +83,27 @@ PQOS_LOCAL int cpuinfo_init(enum pqos_interface interface,
  */
 PQOS_LOCAL int cpuinfo_fini(void);
 
+/**
+ * @brief Detects CPU topology again
+ *
+ * New topology replaces the current one only if cores were added or
+ * removed. Previous topology structure stays valid until the next
+ * topology change or \a cpuinfo_fini, as applications may still be
+ * reading it. Older structures are freed.
+ *
+ * @param [out] topology place to store pointer to CPU topology data
+ * @param [out] changed set to 1 if topology changed, 0 otherwise
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval -EINVAL invalid argument
+ * @retval -EPERM cpuinfo not initialized
+ * @retval -EFAULT error discovering the topology
+ * @retval -ENOMEM error building topology index
+ */
+PQOS_LOCAL int cpuinfo_refresh(const struct pqos_cpuinfo **topology,
+                               int *changed);
+
 /**
  * @brief Internal API to retrieve PQoS vendor specific data
  *
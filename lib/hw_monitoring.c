@@ -46,6 +46,8 @@
 #include "machine.h"
 #include "monitoring.h"
 #include "perf_monitoring.h"
+#include "registry.h"
+#include "topology.h"
 #include "uncore_monitoring.h"
 
 #include <stdlib.h>
@@ -78,6 +80,11 @@
  */
 static unsigned m_rmid_max = 0; /**< max RMID */
 
+/** Events counted with IA32 performance counters */
+#define IA32_PERF_EVENTS                                                       \
+        (PQOS_PERF_EVENT_LLC_MISS | PQOS_PERF_EVENT_LLC_REF |                  \
+         PQOS_PERF_EVENT_CYCLES | PQOS_PERF_EVENT_INSTRUCTIONS)
+
 /** List of non-virtual perf events */
 static const enum pqos_mon_event perf_event[] = {
     PQOS_PERF_EVENT_LLC_MISS, PQOS_PERF_EVENT_LLC_REF,
@@ -124,6 +131,10 @@ hw_mon_init(const struct pqos_cpuinfo *cpu, const struct pqos_cap *cap)
         }
         LOG_DEBUG("Max RMID per monitoring cluster is %u\n", m_rmid_max);
 
+        /* without registry RMIDs are found by reading core associations */
+        if (registry_init() != PQOS_RETVAL_OK)
+                LOG_INFO("RMID registry not available\n");
+
 #ifdef __linux__
         ret = perf_mon_init(cpu, cap);
         if (ret != PQOS_RETVAL_RESOURCE && ret != PQOS_RETVAL_OK)
@@ -149,6 +160,8 @@ hw_mon_fini(void)
 {
         m_rmid_max = 0;
 
+        registry_fini();
+
         uncore_mon_fini();
 
 #ifdef __linux__
@@ -229,6 +242,93 @@ rmid_get_event_max(const struct pqos_cap *cap,
         return PQOS_RETVAL_OK;
 }
 
+/**
+ * @brief Releases RMID registry leases of poll contexts
+ *
+ * @param [in] ctxs poll contexts
+ * @param [in] num_ctxs number of poll contexts
+ */
+static void
+hw_mon_rmid_release(struct pqos_mon_poll_ctx *ctxs, const unsigned num_ctxs)
+{
+        unsigned i;
+
+        for (i = 0; i < num_ctxs; i++) {
+                registry_release(ctxs[i].lease);
+                ctxs[i].lease = 0;
+        }
+}
+
+/**
+ * @brief Reclaims RMIDs of exited processes in monitoring cluster
+ *
+ * Registry entries of exited owners are removed and cores of the cluster
+ * still associated with reclaimed RMIDs are moved back to RMID0.
+ *
+ * @param [in] cluster L3 monitoring cluster
+ * @param [in] min_rmid lowest RMID
+ * @param [in] max_rmid highest RMID
+ * @param [in,out] rmid_list RMIDs in use, reclaimed RMIDs are unmarked,
+ *                 can be NULL
+ * @param [out] num number of reclaimed RMIDs
+ *
+ * @return Operation status
+ */
+static int
+hw_mon_rmid_reclaim(const unsigned cluster,
+                    const pqos_rmid_t min_rmid,
+                    const pqos_rmid_t max_rmid,
+                    uint8_t *rmid_list,
+                    unsigned *num)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+        const unsigned *core_list = NULL;
+        unsigned i, core_count;
+        uint8_t *reclaimed;
+        int ret;
+
+        *num = 0;
+
+        ret = topo_obj_cores(cpu, TOPO_OBJ_L3_CLUSTER, cluster, &core_list,
+                             &core_count);
+        if (ret != PQOS_RETVAL_OK)
+                return PQOS_RETVAL_ERROR;
+
+        reclaimed = (uint8_t *)calloc(max_rmid - min_rmid + 1,
+                                      sizeof(*reclaimed));
+        if (reclaimed == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        *num = registry_reclaim(REGISTRY_TYPE_RMID, cluster, min_rmid,
+                                max_rmid, reclaimed);
+        if (*num == 0)
+                goto rmid_reclaim_exit;
+
+        for (i = 0; i < core_count; i++) {
+                pqos_rmid_t rmid;
+                int retval;
+
+                retval = hw_mon_assoc_read(core_list[i], &rmid);
+                if (retval == PQOS_RETVAL_OK && rmid >= min_rmid &&
+                    rmid <= max_rmid && reclaimed[rmid - min_rmid])
+                        retval = hw_mon_assoc_write(core_list[i], RMID0);
+                if (retval != PQOS_RETVAL_OK) {
+                        LOG_WARN("Failed to reset RMID of core %u\n",
+                                 core_list[i]);
+                        ret = retval;
+                }
+        }
+
+        if (rmid_list != NULL)
+                for (i = min_rmid; i <= max_rmid; i++)
+                        if (reclaimed[i - min_rmid])
+                                rmid_list[i] = 0;
+
+rmid_reclaim_exit:
+        free(reclaimed);
+        return ret;
+}
+
 int
 hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
                     const enum pqos_mon_event event,
@@ -240,16 +340,12 @@ hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
         const struct pqos_cap *cap = _pqos_get_cap();
         int ret = PQOS_RETVAL_OK;
         pqos_rmid_t rmid;
-        unsigned *core_list = NULL;
+        const unsigned *core_list = NULL;
         unsigned i, core_count;
         uint8_t *rmid_list = NULL;
 
         ASSERT(ctx != NULL);
 
-#ifndef PQOS_RMID_CUSTOM
-        UNUSED_PARAM(opt);
-#endif
-
         /* Getting max RMID for given event */
         ret = rmid_get_event_max(cap, &rmid, event);
         if (ret != PQOS_RETVAL_OK)
@@ -259,6 +355,24 @@ hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
         if (min_rmid < 1)
                 min_rmid = 1;
 
+#ifdef PQOS_RMID_CUSTOM
+        if (opt->rmid.type == PQOS_RMID_TYPE_MAP) {
+                if (opt->rmid.rmid < min_rmid || opt->rmid.rmid > max_rmid) {
+                        LOG_ERROR("Custom RMID %u not in range %u-%u\n",
+                                  opt->rmid.rmid, min_rmid, max_rmid);
+                        return PQOS_RETVAL_PARAM;
+                }
+                min_rmid = opt->rmid.rmid;
+                max_rmid = opt->rmid.rmid;
+        } else if (opt->rmid.type != PQOS_RMID_TYPE_DEFAULT) {
+                LOG_ERROR("RMID Custom: Unsupported rmid type: %u\n",
+                          opt->rmid.type);
+                return PQOS_RETVAL_ERROR;
+        }
+#else
+        UNUSED_PARAM(opt);
+#endif
+
         /* list of used RMIDs */
         rmid_list = (uint8_t *)calloc(max_rmid + 2, sizeof(*rmid_list));
         if (rmid_list == NULL)
@@ -267,8 +381,9 @@ hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
         /**
          * Check for free RMID in the cluster by reading current associations.
          */
-        core_list = pqos_cpu_get_cores_l3id(cpu, ctx->cluster, &core_count);
-        if (core_list == NULL) {
+        ret = topo_obj_cores(cpu, TOPO_OBJ_L3_CLUSTER, ctx->cluster,
+                             &core_list, &core_count);
+        if (ret != PQOS_RETVAL_OK) {
                 ret = PQOS_RETVAL_ERROR;
                 goto rmid_alloc_error;
         }
@@ -284,26 +399,33 @@ hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
                         rmid_list[rmid] = 1;
         }
 
-#ifdef PQOS_RMID_CUSTOM
-        if (opt->rmid.type == PQOS_RMID_TYPE_MAP) {
-                if (opt->rmid.rmid < min_rmid || opt->rmid.rmid > max_rmid) {
-                        LOG_ERROR("Custom RMID %u not in range %u-%u\n",
-                                  opt->rmid.rmid, min_rmid, max_rmid);
-                        ret = PQOS_RETVAL_PARAM;
-                        goto rmid_alloc_error;
+        /**
+         * Registry additionally filters out RMIDs claimed by other
+         * processes. Once all RMIDs are in use, RMIDs left behind by
+         * exited processes are reclaimed.
+         */
+        if (registry_is_active()) {
+                unsigned id, lease, num;
+
+                ret = registry_claim(REGISTRY_TYPE_RMID, ctx->cluster,
+                                     min_rmid, max_rmid, &rmid_list[min_rmid],
+                                     &id, &lease);
+                if (ret == PQOS_RETVAL_ERROR) {
+                        ret = hw_mon_rmid_reclaim(ctx->cluster, min_rmid,
+                                                  max_rmid, rmid_list, &num);
+                        if (ret == PQOS_RETVAL_OK && num == 0)
+                                ret = PQOS_RETVAL_ERROR;
+                        else if (ret == PQOS_RETVAL_OK)
+                                ret = registry_claim(
+                                    REGISTRY_TYPE_RMID, ctx->cluster, min_rmid,
+                                    max_rmid, &rmid_list[min_rmid], &id,
+                                    &lease);
                 }
-
-                if (opt->rmid.rmid > max_rmid ||
-                    rmid_list[opt->rmid.rmid] != 0) {
-                        LOG_ERROR("Custom RMID %u in use\n", opt->rmid.rmid);
-                        ret = PQOS_RETVAL_ERROR;
-                        goto rmid_alloc_error;
+                if (ret == PQOS_RETVAL_OK) {
+                        ctx->rmid = id;
+                        ctx->lease = lease;
                 }
-
-                ctx->rmid = opt->rmid.rmid;
-
-        } else if (opt->rmid.type == PQOS_RMID_TYPE_DEFAULT) {
-#endif
+        } else {
                 ret = PQOS_RETVAL_ERROR;
                 for (i = min_rmid; i <= max_rmid; i++)
                         if (rmid_list[i] == 0) {
@@ -311,18 +433,14 @@ hw_mon_assoc_unused(struct pqos_mon_poll_ctx *ctx,
                                 ctx->rmid = i;
                                 break;
                         }
-#ifdef PQOS_RMID_CUSTOM
-        } else {
-                LOG_ERROR("RMID Custom: Unsupported rmid type: %u\n",
-                          opt->rmid.type);
         }
-#endif
+
+        if (ret == PQOS_RETVAL_ERROR && min_rmid == max_rmid)
+                LOG_ERROR("RMID %u in use\n", min_rmid);
 
 rmid_alloc_error:
         if (rmid_list != NULL)
                 free(rmid_list);
-        if (core_list != NULL)
-                free(core_list);
         return ret;
 }
 
@@ -445,6 +563,43 @@ hw_mon_reset(void)
                         ret = retval;
         }
 
+        /* RMIDs of all processes are no longer in use */
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        return ret;
+}
+
+int
+hw_mon_reclaim(unsigned *num_groups)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+        const unsigned *clusters = NULL;
+        unsigned i, num_clusters, total = 0;
+        int ret;
+
+        if (!registry_is_active() || m_rmid_max < 2) {
+                LOG_INFO("RMID registry not available\n");
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        ret = topo_obj_ids(cpu, TOPO_OBJ_L3_CLUSTER, &clusters, &num_clusters);
+        if (ret != PQOS_RETVAL_OK)
+                return PQOS_RETVAL_ERROR;
+
+        for (i = 0; i < num_clusters; i++) {
+                unsigned num = 0;
+                int retval;
+
+                retval = hw_mon_rmid_reclaim(clusters[i], 1, m_rmid_max - 1,
+                                             NULL, &num);
+                if (retval != PQOS_RETVAL_OK)
+                        ret = retval;
+                total += num;
+        }
+
+        if (num_groups != NULL)
+                *num_groups = total;
+
         return ret;
 }
 
@@ -542,20 +697,20 @@ get_delta(const enum pqos_mon_event event,
 /**
  * @brief Sets up IA32 performance counters for IPC and LLC miss ratio events
  *
- * @param group monitoring data
+ * @param num_cores number of cores in \a cores table
+ * @param cores table with core id's
  * @param event mask of selected monitoring events
  *
  * @return Operation status
  * @retval PQOS_RETVAL_OK on success
  */
 static int
-ia32_perf_counter_start(const struct pqos_mon_data *group,
+ia32_perf_counter_start(const unsigned num_cores,
+                        const unsigned *cores,
                         const enum pqos_mon_event event)
 {
         uint64_t global_ctrl_mask = 0;
         unsigned i;
-        const unsigned *cores = group->cores;
-        const unsigned num_cores = group->num_cores;
 
         ASSERT(cores != NULL && num_cores > 0);
 
@@ -731,7 +886,8 @@ hw_mon_start_perf(struct pqos_mon_data *group, enum pqos_mon_event event)
 
         /* Start IA32 performance counters */
         if (hw_event) {
-                ret = ia32_perf_counter_start(group, hw_event);
+                ret = ia32_perf_counter_start(group->num_cores, group->cores,
+                                              hw_event);
                 if (ret == PQOS_RETVAL_OK)
                         group->intl->hw.event |= hw_event;
         }
@@ -808,8 +964,10 @@ hw_mon_start_counter(struct pqos_mon_data *group,
                 unsigned cluster = 0;
 
                 ret = pqos_cpu_get_clusterid(cpu, lcore, &cluster);
-                if (ret != PQOS_RETVAL_OK)
+                if (ret != PQOS_RETVAL_OK) {
+                        hw_mon_rmid_release(ctxs, num_ctxs);
                         return PQOS_RETVAL_PARAM;
+                }
                 core2cluster[i] = cluster;
 
                 for (j = 0; j < num_ctxs; j++)
@@ -828,8 +986,10 @@ hw_mon_start_counter(struct pqos_mon_data *group,
 
                         ret = hw_mon_assoc_unused(&ctxs[num_ctxs], ctx_event, 1,
                                                   UINT32_MAX, opt);
-                        if (ret != PQOS_RETVAL_OK)
+                        if (ret != PQOS_RETVAL_OK) {
+                                hw_mon_rmid_release(ctxs, num_ctxs);
                                 return ret;
+                        }
 
                         num_ctxs++;
                 }
@@ -837,8 +997,10 @@ hw_mon_start_counter(struct pqos_mon_data *group,
 
         group->intl->hw.ctx = (struct pqos_mon_poll_ctx *)calloc(
             num_ctxs, sizeof(group->intl->hw.ctx[0]));
-        if (group->intl->hw.ctx == NULL)
+        if (group->intl->hw.ctx == NULL) {
+                hw_mon_rmid_release(ctxs, num_ctxs);
                 return PQOS_RETVAL_RESOURCE;
+        }
 
         /**
          * Associate requested cores with
@@ -867,6 +1029,7 @@ hw_mon_start_counter(struct pqos_mon_data *group,
         group->intl->hw.num_ctx = num_ctxs;
         for (i = 0; i < num_ctxs; i++)
                 group->intl->hw.ctx[i] = ctxs[i];
+        group->intl->hw.topo_gen = topo_generation();
 
         group->intl->hw.event |= ctx_event;
 
@@ -875,6 +1038,8 @@ hw_mon_start_counter_exit:
                 for (i = 0; i < num_cores; i++)
                         (void)hw_mon_assoc_write(group->cores[i], RMID0);
 
+                hw_mon_rmid_release(ctxs, num_ctxs);
+
                 if (group->intl->hw.ctx != NULL)
                         free(group->intl->hw.ctx);
         }
@@ -1106,6 +1271,138 @@ hw_mon_start_uncore__exit:
         return ret;
 }
 
+/**
+ * @brief Moves poll contexts off cores that went offline
+ *
+ * RMID counters are shared by all cores of a cluster so reading them
+ * through another online core of the cluster keeps counter continuity.
+ *
+ * @param group monitoring group
+ * @param cpu CPU topology
+ */
+static void
+hw_mon_ctx_update(struct pqos_mon_data *group, const struct pqos_cpuinfo *cpu)
+{
+        unsigned i;
+
+        for (i = 0; i < group->intl->hw.num_ctx; i++) {
+                struct pqos_mon_poll_ctx *ctx = &group->intl->hw.ctx[i];
+                const unsigned *cores;
+                unsigned count;
+                int ret;
+
+                if (pqos_cpu_check_core(cpu, ctx->lcore) == PQOS_RETVAL_OK)
+                        continue;
+
+                ret = topo_obj_cores(cpu, TOPO_OBJ_L3_CLUSTER, ctx->cluster,
+                                     &cores, &count);
+                if (ret != PQOS_RETVAL_OK) {
+                        LOG_WARN("No online core left in cluster %u\n",
+                                 ctx->cluster);
+                        continue;
+                }
+
+                LOG_INFO("Core %u offline, polling RMID%u through core %u\n",
+                         ctx->lcore, (unsigned)ctx->rmid, cores[0]);
+                ctx->lcore = cores[0];
+        }
+}
+
+/**
+ * @brief Restores monitoring on group cores that came back online
+ *
+ * Core coming online is associated with RMID0, it is associated with
+ * RMID of its cluster again and its IA32 performance counters are
+ * reprogrammed.
+ *
+ * @param group monitoring group
+ * @param cpu CPU topology
+ */
+static void
+hw_mon_cores_update(struct pqos_mon_data *group,
+                    const struct pqos_cpuinfo *cpu)
+{
+        enum pqos_mon_event perf_event =
+            (enum pqos_mon_event)(group->intl->hw.event & IA32_PERF_EVENTS);
+        unsigned i;
+
+        if ((perf_event & PQOS_PERF_EVENT_CYCLES) &&
+            (perf_event & PQOS_PERF_EVENT_INSTRUCTIONS))
+                perf_event |= (enum pqos_mon_event)PQOS_PERF_EVENT_IPC;
+
+        for (i = 0; i < group->num_cores; i++) {
+                const unsigned lcore = group->cores[i];
+                pqos_rmid_t rmid = RMID0;
+                unsigned cluster;
+                unsigned j;
+                int ret;
+
+                if (pqos_cpu_check_core(cpu, lcore) != PQOS_RETVAL_OK)
+                        continue;
+
+                ret = hw_mon_assoc_read(lcore, &rmid);
+                if (ret != PQOS_RETVAL_OK || rmid != RMID0)
+                        continue;
+
+                ret = pqos_cpu_get_clusterid(cpu, lcore, &cluster);
+                if (ret != PQOS_RETVAL_OK)
+                        continue;
+                for (j = 0; j < group->intl->hw.num_ctx; j++)
+                        if (group->intl->hw.ctx[j].cluster == cluster)
+                                break;
+                if (j == group->intl->hw.num_ctx)
+                        continue;
+
+                LOG_INFO("Core %u online, restoring RMID%u association\n",
+                         lcore, (unsigned)group->intl->hw.ctx[j].rmid);
+                ret = hw_mon_assoc_write(lcore, group->intl->hw.ctx[j].rmid);
+                if (ret != PQOS_RETVAL_OK)
+                        LOG_WARN("Failed to associate core %u\n", lcore);
+
+                if (perf_event &&
+                    ia32_perf_counter_start(1, &lcore, perf_event) !=
+                        PQOS_RETVAL_OK)
+                        LOG_WARN("Failed to start perf counters on core %u\n",
+                                 lcore);
+        }
+}
+
+/**
+ * @brief Brings group up to date with current topology
+ *
+ * Poll contexts are moved off offline cores, cores that came back online
+ * are associated again and IA32 perf counters are re-based, as the set
+ * of cores they are summed over changed.
+ *
+ * @param group monitoring group
+ * @param cpu CPU topology
+ */
+static void
+hw_mon_topo_update(struct pqos_mon_data *group,
+                   const struct pqos_cpuinfo *cpu)
+{
+        hw_mon_ctx_update(group, cpu);
+        hw_mon_cores_update(group, cpu);
+
+        group->intl->hw.perf_rebase =
+            (enum pqos_mon_event)(group->intl->hw.event & IA32_PERF_EVENTS);
+        group->intl->hw.topo_gen = topo_generation();
+}
+
+/**
+ * @brief Checks if poll contexts were set up with current topology
+ *
+ * @param group monitoring group
+ *
+ * @return 1 if contexts need update, 0 otherwise
+ */
+static int
+hw_mon_ctx_stale(const struct pqos_mon_data *group)
+{
+        return group->intl->hw.topo_gen != 0 &&
+               group->intl->hw.topo_gen != topo_generation();
+}
+
 int
 hw_mon_stop(struct pqos_mon_data *group)
 {
@@ -1123,6 +1420,9 @@ hw_mon_stop(struct pqos_mon_data *group)
                     group->intl->hw.ctx == NULL))
                 return PQOS_RETVAL_PARAM;
 
+        if (hw_mon_ctx_stale(group))
+                hw_mon_topo_update(group, cpu);
+
         for (i = 0; i < group->intl->hw.num_ctx; i++) {
                 /**
                  * Validate core list in the group structure is correct
@@ -1144,8 +1444,12 @@ hw_mon_stop(struct pqos_mon_data *group)
 
         for (i = 0; i < group->num_cores; i++) {
                 /**
-                 * Associate cores from the group back with RMID0
+                 * Associate cores from the group back with RMID0,
+                 * cores that went offline are skipped
                  */
+                if (pqos_cpu_check_core(cpu, group->cores[i]) !=
+                    PQOS_RETVAL_OK)
+                        continue;
                 ret = hw_mon_assoc_write(group->cores[i], RMID0);
                 if (ret != PQOS_RETVAL_OK)
                         retval = PQOS_RETVAL_RESOURCE;
@@ -1161,6 +1465,8 @@ hw_mon_stop(struct pqos_mon_data *group)
         if (ret != PQOS_RETVAL_OK)
                 retval = ret;
 
+        hw_mon_rmid_release(group->intl->hw.ctx, group->intl->hw.num_ctx);
+
         /**
          * Free poll contexts, core list and clear the group structure
          */
@@ -1190,6 +1496,9 @@ hw_mon_read_counter(struct pqos_mon_data *group,
         if (ret == PQOS_RETVAL_OK)
                 max_value = 1LLU << pmon->counter_length;
 
+        if (hw_mon_ctx_stale(group))
+                hw_mon_topo_update(group, _pqos_get_cpu());
+
         for (i = 0; i < group->intl->hw.num_ctx; i++) {
                 uint64_t tmp = 0;
                 const unsigned lcore = group->intl->hw.ctx[i].lcore;
@@ -1265,6 +1574,7 @@ static int
 hw_mon_read_perf(struct pqos_mon_data *group, const enum pqos_mon_event event)
 {
         struct pqos_event_values *values = &group->values;
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
         uint64_t val = 0;
         unsigned n;
         uint64_t reg;
@@ -1301,20 +1611,34 @@ hw_mon_read_perf(struct pqos_mon_data *group, const enum pqos_mon_event event)
                 return PQOS_RETVAL_PARAM;
         }
 
+        if (hw_mon_ctx_stale(group))
+                hw_mon_topo_update(group, cpu);
+
         /**
          * If multiple cores monitored in one group
          * then we have to accumulate the values in the group.
+         * Cores that went offline are skipped.
          */
         for (n = 0; n < group->num_cores; n++) {
                 uint64_t tmp = 0;
-                int ret = msr_read(group->cores[n], reg, &tmp);
+                int ret;
+
+                if (pqos_cpu_check_core(cpu, group->cores[n]) !=
+                    PQOS_RETVAL_OK)
+                        continue;
 
+                ret = msr_read(group->cores[n], reg, &tmp);
                 if (ret != MACHINE_RETVAL_OK)
                         return PQOS_RETVAL_ERROR;
                 val += tmp;
         }
 
-        *delta = val - *value;
+        /* first read after topology change sets new baseline */
+        if (group->intl->hw.perf_rebase & event) {
+                group->intl->hw.perf_rebase &= ~event;
+                *delta = 0;
+        } else
+                *delta = val - *value;
         *value = val;
 
         return PQOS_RETVAL_OK;
@@ -74,6 +74,20 @@ PQOS_LOCAL int hw_mon_fini(void);
  */
 PQOS_LOCAL int hw_mon_reset(void);
 
+/**
+ * @brief Hardware interface to reclaim RMIDs of exited processes
+ *
+ * RMIDs registered by exited processes are released and cores still
+ * associated with them are bound with RMID0.
+ *
+ * @param [out] num_groups number of reclaimed RMIDs, can be NULL
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if RMID registry is not available
+ */
+PQOS_LOCAL int hw_mon_reclaim(unsigned *num_groups);
+
 /**
  * @brief Writes \a lcore to RMID association
  *
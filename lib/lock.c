@@ -44,7 +44,7 @@
 #include <fcntl.h> /* O_CREAT */
 #include <pthread.h>
 #include <sys/stat.h> /* S_Ixxx */
-#include <unistd.h>   /* usleep(), lockf() */
+#include <unistd.h>   /* usleep(), lockf(), pread(), pwrite() */
 
 /**
  * ---------------------------------------
@@ -67,7 +67,7 @@ lock_init(void)
         if (m_apilock != -1)
                 return -1;
 
-        m_apilock = open(lock_filename, O_WRONLY | O_CREAT,
+        m_apilock = open(lock_filename, O_RDWR | O_CREAT,
                          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         if (m_apilock == -1)
                 return -1;
@@ -126,3 +126,43 @@ lock_release(void)
         if (err)
                 LOG_ERROR("API unlock error!\n");
 }
+
+int
+lock_counter_get(uint64_t *value)
+{
+        uint64_t val = 0;
+        ssize_t ret;
+
+        if (value == NULL)
+                return -1;
+
+        ret = pread(m_apilock, &val, sizeof(val), 0);
+        if (ret < 0)
+                return -1;
+
+        /* counter was never incremented */
+        if (ret != (ssize_t)sizeof(val))
+                val = 0;
+
+        *value = val;
+
+        return 0;
+}
+
+int
+lock_counter_inc(uint64_t *value)
+{
+        uint64_t val;
+
+        if (lock_counter_get(&val) != 0)
+                return -1;
+
+        val++;
+        if (pwrite(m_apilock, &val, sizeof(val), 0) != (ssize_t)sizeof(val))
+                return -1;
+
+        if (value != NULL)
+                *value = val;
+
+        return 0;
+}
@@ -44,6 +44,8 @@ extern "C" {
 
 #include "types.h"
 
+#include <stdint.h>
+
 #ifndef LOCKFILE
 #ifdef __linux__
 #define LOCKFILE "/var/lock/libpqos"
@@ -84,6 +86,33 @@ PQOS_LOCAL void lock_get(void);
  */
 PQOS_LOCAL void lock_release(void);
 
+/**
+ * @brief Reads change counter shared by all library instances
+ *
+ * Counter is kept in the lock file, allowing processes to detect changes
+ * made by other processes. Must be called with the lock acquired.
+ *
+ * @param [out] value counter value
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval -1 error
+ */
+PQOS_LOCAL int lock_counter_get(uint64_t *value);
+
+/**
+ * @brief Increments change counter shared by all library instances
+ *
+ * Must be called with the lock acquired.
+ *
+ * @param [out] value new counter value, can be NULL
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval -1 error
+ */
+PQOS_LOCAL int lock_counter_inc(uint64_t *value);
+
 #ifdef __cplusplus
 }
 #endif
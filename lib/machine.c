@@ -112,6 +112,39 @@ machine_fini(void)
         return MACHINE_RETVAL_OK;
 }
 
+int
+machine_refresh(const unsigned max_core_id)
+{
+        unsigned i;
+
+        ASSERT(m_msr_fd != NULL);
+        if (m_msr_fd == NULL)
+                return MACHINE_RETVAL_ERROR;
+
+        for (i = 0; i < m_maxcores; i++)
+                if (m_msr_fd[i] != -1) {
+                        close(m_msr_fd[i]);
+                        m_msr_fd[i] = -1;
+                }
+
+        if (max_core_id >= m_maxcores) {
+                const size_t size = (max_core_id + 1) * sizeof(m_msr_fd[0]);
+                int *msr_fd;
+
+                msr_fd = (int *)realloc(m_msr_fd, size);
+                if (msr_fd == NULL)
+                        return MACHINE_RETVAL_ERROR;
+
+                for (i = m_maxcores; i <= max_core_id; i++)
+                        msr_fd[i] = -1;
+
+                m_msr_fd = msr_fd;
+                m_maxcores = max_core_id + 1;
+        }
+
+        return MACHINE_RETVAL_OK;
+}
+
 void
 lcpuid(const unsigned leaf, const unsigned subleaf, struct cpuid_out *out)
 {
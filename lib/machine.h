@@ -87,6 +87,20 @@ PQOS_LOCAL int machine_init(const unsigned max_core_id);
  */
 PQOS_LOCAL int machine_fini(void);
 
+/**
+ * @brief Updates machine module after CPU hotplug
+ *
+ * Closes all cached MSR driver file descriptors, as descriptors of cores
+ * that went offline are no longer usable, and extends file descriptor
+ * table if \a max_core_id grew. Descriptors are reopened on next access.
+ *
+ * @param [in] max_core_id maximum logical core id in the system
+ *
+ * @return Operation status
+ * @retval MACHINE_RETVAL_OK on success
+ */
+PQOS_LOCAL int machine_refresh(const unsigned max_core_id);
+
 /**
  * @brief Executes CPUID.leaf.sbuleaf on current core
  *
@@ -0,0 +1,647 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Streaming statistics of monitoring groups
+ *
+ * Each tracked event keeps an exponentially weighted moving average,
+ * minimum and maximum over a sliding window and a quantile sketch.
+ * Memory use is constant and independent of the number of samples.
+ *
+ * The sliding window is made of two halves. Samples go into the current
+ * half and the older half is dropped every window/2, so window values
+ * cover between half and the full window of most recent samples.
+ *
+ * Quantiles use a log-linear sketch in the spirit of DDSketch: every
+ * power of two is split into equal width bins, giving a bounded relative
+ * error without use of logarithms. When values spread over more bins
+ * than the sketch holds, the lowest bins are collapsed so high quantiles
+ * keep their accuracy.
+ */
+
+#include "log.h"
+#include "monitoring.h"
+#include "pqos.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * ---------------------------------------
+ * Local macros
+ * ---------------------------------------
+ */
+
+#define STATS_NUM_BINS    1024
+#define STATS_MIN_VALUE   1e-9 /**< smaller values are counted as zero */
+#define STATS_MAX_SUBBINS 512
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Tracked events
+ */
+static const enum pqos_mon_event stats_event[] = {
+    PQOS_MON_EVENT_L3_OCCUP, PQOS_MON_EVENT_LMEM_BW,  PQOS_MON_EVENT_TMEM_BW,
+    PQOS_MON_EVENT_RMEM_BW,  PQOS_PERF_EVENT_IPC,     PQOS_PERF_EVENT_LLC_MISS,
+    PQOS_PERF_EVENT_LLC_REF,
+};
+
+#define STATS_NUM_EVENTS DIM(stats_event)
+
+/**
+ * Quantile sketch with collapsing lowest bins
+ */
+struct stats_sketch {
+        uint64_t count;                /**< number of values */
+        uint64_t zero;                 /**< number of values near zero */
+        int offset;                    /**< bin index of bins[0] */
+        uint32_t bins[STATS_NUM_BINS]; /**< value counters */
+};
+
+/**
+ * Half of the sliding window
+ */
+struct stats_half {
+        uint64_t start; /**< time of the first sample [ns] */
+        double min;
+        double max;
+        struct stats_sketch sketch;
+};
+
+/**
+ * Statistics of single event
+ */
+struct stats_event {
+        uint64_t count; /**< number of samples */
+        double last;    /**< last sample */
+        double ewma;    /**< moving average */
+        uint64_t time;  /**< time of the last sample [ns] */
+        uint64_t poll;  /**< poll time of the last sample [ns] */
+        unsigned curr;  /**< index of the current half */
+        struct stats_half half[2];
+};
+
+struct pqos_mon_stats {
+        double half_life; /**< EWMA half-life [ns] */
+        uint64_t window;  /**< sliding window [ns] */
+        unsigned subbins; /**< sketch bins per power of two */
+        uint64_t time;    /**< time of the last update [ns] */
+        int valid;        /**< group was updated before */
+        struct stats_event event[STATS_NUM_EVENTS];
+};
+
+/**
+ * ---------------------------------------
+ * Local functions
+ * ---------------------------------------
+ */
+
+/**
+ * @brief Builds power of two
+ *
+ * @param [in] exp exponent within normal double range
+ *
+ * @return 2^exp
+ */
+static double
+stats_pow2(const int exp)
+{
+        uint64_t bits = (uint64_t)(exp + 1023) << 52;
+        double val;
+
+        memcpy(&val, &bits, sizeof(val));
+        return val;
+}
+
+/**
+ * @brief Computes 2^-x without libm
+ *
+ * @param [in] x non-negative exponent
+ *
+ * @return 2^-x
+ */
+static double
+stats_exp2_neg(const double x)
+{
+        const double ln2 = 0.69314718055994530942;
+        double frac, term, sum;
+        int n, i;
+
+        if (x > 1000.0)
+                return 0.0;
+
+        n = (int)x;
+        frac = (x - n) * ln2;
+
+        /* e^-frac from Taylor series, frac < ln2 */
+        term = 1.0;
+        sum = 1.0;
+        for (i = 1; i < 16; i++) {
+                term *= -frac / i;
+                sum += term;
+        }
+
+        return sum * stats_pow2(-n);
+}
+
+/**
+ * @brief Maps positive value to sketch bin index
+ *
+ * @param [in] val value, at least STATS_MIN_VALUE
+ * @param [in] subbins bins per power of two
+ *
+ * @return bin index
+ */
+static int
+stats_index(const double val, const unsigned subbins)
+{
+        uint64_t bits;
+        uint64_t mantissa;
+        int exp;
+
+        memcpy(&bits, &val, sizeof(bits));
+        exp = (int)((bits >> 52) & 0x7ff) - 1023;
+        mantissa = bits & ((1ULL << 52) - 1);
+
+        return exp * (int)subbins + (int)((mantissa * subbins) >> 52);
+}
+
+/**
+ * @brief Maps sketch bin index to representative value
+ *
+ * @param [in] idx bin index
+ * @param [in] subbins bins per power of two
+ *
+ * @return middle of the bin
+ */
+static double
+stats_value(const int idx, const unsigned subbins)
+{
+        int exp = idx / (int)subbins;
+        int sub = idx % (int)subbins;
+
+        if (sub < 0) {
+                sub += subbins;
+                exp--;
+        }
+
+        return stats_pow2(exp) * (1.0 + (sub + 0.5) / subbins);
+}
+
+/**
+ * @brief Adds value to the sketch
+ *
+ * @param [in,out] sketch quantile sketch
+ * @param [in] val value to add
+ * @param [in] subbins bins per power of two
+ */
+static void
+stats_sketch_add(struct stats_sketch *sketch,
+                 const double val,
+                 const unsigned subbins)
+{
+        int idx;
+
+        sketch->count++;
+        if (!(val >= STATS_MIN_VALUE)) {
+                sketch->zero++;
+                return;
+        }
+
+        idx = stats_index(val, subbins);
+        if (sketch->count == sketch->zero + 1)
+                /* first non-zero value, leave room below for smaller ones */
+                sketch->offset = idx - STATS_NUM_BINS / 2;
+
+        if (idx < sketch->offset)
+                idx = sketch->offset;
+        else if (idx >= sketch->offset + STATS_NUM_BINS) {
+                /* collapse lowest bins to make room at the top */
+                int shift = idx - (sketch->offset + STATS_NUM_BINS - 1);
+                uint64_t low = 0;
+                int i;
+
+                if (shift > STATS_NUM_BINS)
+                        shift = STATS_NUM_BINS;
+                for (i = 0; i < shift; i++)
+                        low += sketch->bins[i];
+                memmove(&sketch->bins[0], &sketch->bins[shift],
+                        (STATS_NUM_BINS - shift) * sizeof(sketch->bins[0]));
+                memset(&sketch->bins[STATS_NUM_BINS - shift], 0,
+                       shift * sizeof(sketch->bins[0]));
+                sketch->bins[0] += (uint32_t)low;
+                sketch->offset = idx - (STATS_NUM_BINS - 1);
+        }
+
+        sketch->bins[idx - sketch->offset]++;
+}
+
+/**
+ * @brief Retrieves count of bin \a idx in the sketch
+ */
+static uint64_t
+stats_sketch_bin(const struct stats_sketch *sketch, const int idx)
+{
+        if (sketch->count == sketch->zero || idx < sketch->offset ||
+            idx >= sketch->offset + STATS_NUM_BINS)
+                return 0;
+
+        return sketch->bins[idx - sketch->offset];
+}
+
+/**
+ * @brief Retrieves range of bin indexes used by the sketch
+ *
+ * @return 0 if sketch holds only zero values
+ */
+static int
+stats_sketch_range(const struct stats_sketch *sketch, int *first, int *last)
+{
+        if (sketch->count == sketch->zero)
+                return 0;
+
+        *first = sketch->offset;
+        *last = sketch->offset + STATS_NUM_BINS - 1;
+        return 1;
+}
+
+/**
+ * @brief Adds sample to the event statistics
+ *
+ * @param [in] stats group statistics
+ * @param [in,out] ev event statistics
+ * @param [in] val sample value
+ * @param [in] now sample time [ns]
+ */
+static void
+stats_event_add(const struct pqos_mon_stats *stats,
+                struct stats_event *ev,
+                const double val,
+                const uint64_t now)
+{
+        struct stats_half *half = &ev->half[ev->curr];
+
+        if (ev->count == 0)
+                ev->ewma = val;
+        else {
+                double weight = 1.0;
+
+                if (now > ev->time)
+                        weight = 1.0 - stats_exp2_neg((double)(now - ev->time) /
+                                                      stats->half_life);
+                ev->ewma += weight * (val - ev->ewma);
+        }
+        ev->count++;
+        ev->last = val;
+        ev->time = now;
+
+        if (half->sketch.count > 0 && now - half->start >= stats->window / 2) {
+                ev->curr ^= 1;
+                half = &ev->half[ev->curr];
+                memset(half, 0, sizeof(*half));
+        }
+
+        if (half->sketch.count == 0) {
+                half->start = now;
+                half->min = val;
+                half->max = val;
+        } else if (val < half->min)
+                half->min = val;
+        else if (val > half->max)
+                half->max = val;
+
+        stats_sketch_add(&half->sketch, val, stats->subbins);
+}
+
+/**
+ * @brief Finds statistics of the event
+ *
+ * @return event statistics or NULL if event is not tracked
+ */
+static const struct stats_event *
+stats_event_get(const struct pqos_mon_stats *stats,
+                const enum pqos_mon_event event)
+{
+        unsigned i;
+
+        for (i = 0; i < STATS_NUM_EVENTS; i++)
+                if (stats_event[i] == event)
+                        return &stats->event[i];
+
+        return NULL;
+}
+
+/**
+ * @brief Retrieves counter delta of the event
+ */
+static uint64_t
+stats_delta(const struct pqos_mon_data *group, const enum pqos_mon_event event)
+{
+        switch (event) {
+        case PQOS_MON_EVENT_LMEM_BW:
+                return group->values.mbm_local_delta;
+        case PQOS_MON_EVENT_TMEM_BW:
+                return group->values.mbm_total_delta;
+        case PQOS_MON_EVENT_RMEM_BW:
+                return group->values.mbm_remote_delta;
+        case PQOS_PERF_EVENT_LLC_MISS:
+                return group->values.llc_misses_delta;
+        case PQOS_PERF_EVENT_LLC_REF:
+#if PQOS_VERSION >= 50000
+                return group->values.llc_references_delta;
+#else
+                return group->intl != NULL
+                           ? group->intl->values.llc_references_delta
+                           : 0;
+#endif
+        default:
+                return 0;
+        }
+}
+
+/*
+ * =======================================
+ * =======================================
+ *
+ * Public API
+ *
+ * =======================================
+ * =======================================
+ */
+
+int
+pqos_mon_stats_create(const struct pqos_mon_stats_config *config,
+                      struct pqos_mon_stats **stats)
+{
+        double half_life = PQOS_MON_STATS_HALF_LIFE;
+        double window = PQOS_MON_STATS_WINDOW;
+        double accuracy = PQOS_MON_STATS_ACCURACY;
+        struct pqos_mon_stats *s;
+        unsigned subbins;
+
+        if (stats == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        if (config != NULL) {
+                if (config->half_life < 0 || config->window < 0 ||
+                    config->accuracy < 0 || config->accuracy >= 1)
+                        return PQOS_RETVAL_PARAM;
+                if (config->half_life > 0)
+                        half_life = config->half_life;
+                if (config->window > 0)
+                        window = config->window;
+                if (config->accuracy > 0)
+                        accuracy = config->accuracy;
+        }
+
+        /* bin width relative to its lower bound is at most 1/subbins */
+        subbins = (unsigned)(1.0 / (2.0 * accuracy)) + 1;
+        if (subbins > STATS_MAX_SUBBINS) {
+                LOG_ERROR("Quantile accuracy %f is not supported\n", accuracy);
+                return PQOS_RETVAL_PARAM;
+        }
+
+        s = calloc(1, sizeof(*s));
+        if (s == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        s->half_life = half_life * 1000000000.0;
+        s->window = (uint64_t)(window * 1000000000.0);
+        s->subbins = subbins;
+
+        *stats = s;
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_stats_destroy(struct pqos_mon_stats *stats)
+{
+        if (stats == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        free(stats);
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_stats_reset(struct pqos_mon_stats *stats)
+{
+        if (stats == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        stats->valid = 0;
+        stats->time = 0;
+        memset(stats->event, 0, sizeof(stats->event));
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_stats_update(struct pqos_mon_stats *stats,
+                      const struct pqos_mon_data *group,
+                      uint64_t timestamp)
+{
+        uint64_t elapsed = 0;
+        unsigned i;
+
+        if (stats == NULL || group == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        if (timestamp == 0) {
+                struct timespec ts;
+
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        }
+
+        if (stats->valid && timestamp > stats->time)
+                elapsed = timestamp - stats->time;
+
+        for (i = 0; i < STATS_NUM_EVENTS; i++) {
+                const enum pqos_mon_event event = stats_event[i];
+                uint64_t interval = elapsed;
+                double val;
+
+                if (!(group->event & event))
+                        continue;
+
+                /**
+                 * Events polled at their own rate are only sampled when
+                 * polled again, rates use time between their polls
+                 */
+                if (group->intl != NULL) {
+                        uint64_t polled = 0;
+
+                        (void)pqos_mon_poll_time(group, event, &polled,
+                                                 &interval);
+                        if (polled == 0 || polled == stats->event[i].poll)
+                                continue;
+                        stats->event[i].poll = polled;
+                }
+
+                if (event == PQOS_MON_EVENT_L3_OCCUP)
+                        val = (double)group->values.llc;
+                else if (event == PQOS_PERF_EVENT_IPC)
+                        val = group->values.ipc;
+                else if (interval > 0)
+                        val = (double)stats_delta(group, event) * 1000000000.0 /
+                              (double)interval;
+                else
+                        /* rates need two updates */
+                        continue;
+
+                stats_event_add(stats, &stats->event[i], val, timestamp);
+        }
+
+        stats->time = timestamp;
+        stats->valid = 1;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_stats_get(const struct pqos_mon_stats *stats,
+                   const enum pqos_mon_event event,
+                   struct pqos_mon_stat *stat)
+{
+        const struct stats_event *ev;
+        const struct stats_half *prev;
+        const struct stats_half *curr;
+
+        if (stats == NULL || stat == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        ev = stats_event_get(stats, event);
+        if (ev == NULL)
+                return PQOS_RETVAL_PARAM;
+        if (ev->count == 0)
+                return PQOS_RETVAL_RESOURCE;
+
+        curr = &ev->half[ev->curr];
+        prev = &ev->half[ev->curr ^ 1];
+
+        memset(stat, 0, sizeof(*stat));
+        stat->count = ev->count;
+        stat->last = ev->last;
+        stat->ewma = ev->ewma;
+        stat->min = curr->min;
+        stat->max = curr->max;
+        if (prev->sketch.count > 0) {
+                if (prev->min < stat->min)
+                        stat->min = prev->min;
+                if (prev->max > stat->max)
+                        stat->max = prev->max;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_stats_get_quantile(const struct pqos_mon_stats *stats,
+                            const enum pqos_mon_event event,
+                            const double quantile,
+                            double *value)
+{
+        const struct stats_event *ev;
+        const struct stats_sketch *sketch[2];
+        struct pqos_mon_stat stat;
+        uint64_t count, zero, rank, sum;
+        int first = 0, last = 0;
+        int found = 0;
+        int idx;
+        unsigned i;
+        int ret;
+
+        if (stats == NULL || value == NULL || !(quantile >= 0.0) ||
+            quantile > 1.0)
+                return PQOS_RETVAL_PARAM;
+
+        ret = pqos_mon_stats_get(stats, event, &stat);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+        ev = stats_event_get(stats, event);
+
+        sketch[0] = &ev->half[0].sketch;
+        sketch[1] = &ev->half[1].sketch;
+        count = sketch[0]->count + sketch[1]->count;
+        zero = sketch[0]->zero + sketch[1]->zero;
+
+        rank = (uint64_t)(quantile * (double)(count - 1));
+        if (rank == 0 || rank == count - 1) {
+                /* extremes are tracked exactly */
+                *value = rank == 0 ? stat.min : stat.max;
+                return PQOS_RETVAL_OK;
+        }
+        if (rank < zero || zero == count) {
+                *value = 0.0;
+                return PQOS_RETVAL_OK;
+        }
+
+        for (i = 0; i < 2; i++) {
+                int lo, hi;
+
+                if (!stats_sketch_range(sketch[i], &lo, &hi))
+                        continue;
+                if (!found || lo < first)
+                        first = lo;
+                if (!found || hi > last)
+                        last = hi;
+                found = 1;
+        }
+
+        sum = zero;
+        for (idx = first; idx <= last; idx++) {
+                sum += stats_sketch_bin(sketch[0], idx) +
+                       stats_sketch_bin(sketch[1], idx);
+                if (sum > rank)
+                        break;
+        }
+        if (idx > last)
+                idx = last;
+
+        *value = stats_value(idx, stats->subbins);
+
+        /* keep estimate within observed window range */
+        if (*value < stat.min)
+                *value = stat.min;
+        if (*value > stat.max)
+                *value = stat.max;
+
+        return PQOS_RETVAL_OK;
+}
@@ -43,6 +43,8 @@
 #include "resctrl_monitoring.h"
 #endif
 
+#include <time.h>
+
 /**
  * ---------------------------------------
  * Local macros
@@ -61,6 +63,21 @@
  * ---------------------------------------
  */
 
+/**
+ * Monitoring backend initialization state
+ */
+static enum {
+        MON_STATE_NONE = 0, /**< monitoring not available */
+        MON_STATE_DEFERRED, /**< backend initialized on first use */
+        MON_STATE_ACTIVE,   /**< backend initialized */
+        MON_STATE_FAILED    /**< backend initialization failed */
+} m_mon_state = MON_STATE_NONE;
+
+/**
+ * Backend initialization error, reported while in MON_STATE_FAILED
+ */
+static int m_mon_error = PQOS_RETVAL_OK;
+
 /**
  * ---------------------------------------
  * Local Functions
@@ -84,36 +101,63 @@ pqos_mon_init(const struct pqos_cpuinfo *cpu,
 {
         const struct pqos_capability *item = NULL;
         int ret;
-        enum pqos_interface interface = _pqos_get_inter();
 
+        UNUSED_PARAM(cpu);
         UNUSED_PARAM(cfg);
 
         ASSERT(cfg != NULL);
         /**
-         * If monitoring capability has been discovered
-         * then get max RMID supported by a CPU socket
-         * and allocate memory for RMID table
+         * If monitoring capability has been discovered then backend
+         * initialization (RMID table, perf and uncore event discovery) is
+         * deferred until monitoring is used for the first time
          */
         ret = pqos_cap_get_type(cap, PQOS_CAP_TYPE_MON, &item);
-        if (ret != PQOS_RETVAL_OK) {
-                ret = PQOS_RETVAL_RESOURCE;
-                goto pqos_mon_init_exit;
-        }
+        if (ret != PQOS_RETVAL_OK)
+                return PQOS_RETVAL_RESOURCE;
 
         ASSERT(item != NULL);
 
+        m_mon_state = MON_STATE_DEFERRED;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_lazy_init(void)
+{
+        const struct pqos_cpuinfo *cpu;
+        const struct pqos_cap *cap;
+        enum pqos_interface interface;
+        int ret = PQOS_RETVAL_OK;
+
+        if (m_mon_state == MON_STATE_FAILED)
+                return m_mon_error;
+        if (m_mon_state != MON_STATE_DEFERRED)
+                return PQOS_RETVAL_OK;
+
+        cpu = _pqos_get_cpu();
+        cap = _pqos_get_cap();
+        interface = _pqos_get_inter();
+
 #ifdef __linux__
         if (interface == PQOS_INTER_OS ||
             interface == PQOS_INTER_OS_RESCTRL_MON)
                 ret = os_mon_init(cpu, cap);
-        if (ret != PQOS_RETVAL_OK)
-                return ret;
 #endif
         if (interface == PQOS_INTER_MSR)
                 ret = hw_mon_init(cpu, cap);
 
-pqos_mon_init_exit:
-        return ret;
+        if (ret != PQOS_RETVAL_OK) {
+                LOG_ERROR("monitoring init error %d\n", ret);
+                m_mon_state = MON_STATE_FAILED;
+                m_mon_error = ret;
+                return ret;
+        }
+
+        LOG_DEBUG("monitoring init OK\n");
+        m_mon_state = MON_STATE_ACTIVE;
+
+        return PQOS_RETVAL_OK;
 }
 
 int
@@ -121,8 +165,18 @@ pqos_mon_fini(void)
 {
         int ret = PQOS_RETVAL_OK;
 #ifdef __linux__
-        enum pqos_interface interface = _pqos_get_inter();
+        enum pqos_interface interface;
+#endif
+
+        if (m_mon_state != MON_STATE_ACTIVE) {
+                m_mon_state = MON_STATE_NONE;
+                m_mon_error = PQOS_RETVAL_OK;
+                return PQOS_RETVAL_OK;
+        }
+        m_mon_state = MON_STATE_NONE;
 
+#ifdef __linux__
+        interface = _pqos_get_inter();
         if (interface == PQOS_INTER_OS ||
             interface == PQOS_INTER_OS_RESCTRL_MON)
                 ret = os_mon_fini();
@@ -135,25 +189,89 @@ pqos_mon_fini(void)
         return ret;
 }
 
+/**
+ * Events polled from hardware
+ */
+static const enum pqos_mon_event mon_poll_event[MON_POLL_EVENT_NUM] = {
+    PQOS_MON_EVENT_L3_OCCUP,
+    PQOS_MON_EVENT_LMEM_BW,
+    PQOS_MON_EVENT_TMEM_BW,
+    PQOS_PERF_EVENT_LLC_MISS,
+    PQOS_PERF_EVENT_LLC_REF,
+    (enum pqos_mon_event)PQOS_PERF_EVENT_CYCLES,
+    (enum pqos_mon_event)PQOS_PERF_EVENT_INSTRUCTIONS,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE};
+
+/**
+ * @brief Finds poll timing index of the event
+ *
+ * @param event monitoring event
+ *
+ * @return index or MON_POLL_EVENT_NUM if event is not polled
+ */
+static unsigned
+mon_poll_idx(enum pqos_mon_event event)
+{
+        unsigned i;
+
+        if (event == PQOS_MON_EVENT_RMEM_BW)
+                event = PQOS_MON_EVENT_TMEM_BW;
+        else if (event == PQOS_PERF_EVENT_IPC)
+                event = (enum pqos_mon_event)PQOS_PERF_EVENT_CYCLES;
+
+        for (i = 0; i < DIM(mon_poll_event); i++)
+                if (mon_poll_event[i] == event)
+                        break;
+
+        return i;
+}
+
 int
-pqos_mon_poll_events(struct pqos_mon_data *group)
+pqos_mon_poll_time(const struct pqos_mon_data *group,
+                   const enum pqos_mon_event event,
+                   uint64_t *timestamp,
+                   uint64_t *interval)
 {
+        const unsigned idx = mon_poll_idx(event);
+
+        if (idx >= MON_POLL_EVENT_NUM)
+                return PQOS_RETVAL_PARAM;
+
+        if (timestamp != NULL)
+                *timestamp = group->intl->poll.timestamp[idx];
+        if (interval != NULL)
+                *interval = group->intl->poll.interval[idx];
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_mon_poll_events(struct pqos_mon_data *group,
+                     const enum pqos_mon_event events)
+{
+        const enum pqos_mon_event mbm_events =
+            (enum pqos_mon_event)(PQOS_MON_EVENT_LMEM_BW |
+                                  PQOS_MON_EVENT_TMEM_BW |
+                                  PQOS_MON_EVENT_RMEM_BW);
+        enum pqos_mon_event poll = events & group->event;
         unsigned i;
         int ret = PQOS_RETVAL_OK;
+        struct timespec ts;
+        uint64_t timestamp;
 
-        /** List of non virtual events */
-        const enum pqos_mon_event mon_event[] = {
-            PQOS_MON_EVENT_L3_OCCUP,
-            PQOS_MON_EVENT_LMEM_BW,
-            PQOS_MON_EVENT_TMEM_BW,
-            PQOS_PERF_EVENT_LLC_MISS,
-            PQOS_PERF_EVENT_LLC_REF,
-            (enum pqos_mon_event)PQOS_PERF_EVENT_CYCLES,
-            (enum pqos_mon_event)PQOS_PERF_EVENT_INSTRUCTIONS,
-            PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
-            PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE,
-            PQOS_PERF_EVENT_LLC_REF_PCIE_READ,
-            PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE};
+        /**
+         * Add events that virtual events are calculated from
+         */
+        if (poll & mbm_events)
+                poll |= (enum pqos_mon_event)(PQOS_MON_EVENT_LMEM_BW |
+                                              PQOS_MON_EVENT_TMEM_BW) |
+                        (group->event & mbm_events);
+        if (poll & PQOS_PERF_EVENT_IPC)
+                poll |= (enum pqos_mon_event)(PQOS_PERF_EVENT_CYCLES |
+                                              PQOS_PERF_EVENT_INSTRUCTIONS);
 
 #ifdef __linux__
         if (group->intl->resctrl.event != 0) {
@@ -163,8 +281,14 @@ pqos_mon_poll_events(struct pqos_mon_data *group)
         }
 #endif
 
-        for (i = 0; i < DIM(mon_event); i++) {
-                enum pqos_mon_event evt = mon_event[i];
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+        for (i = 0; i < DIM(mon_poll_event); i++) {
+                enum pqos_mon_event evt = mon_poll_event[i];
+
+                if (!(poll & evt))
+                        continue;
 
                 /**
                  * poll hw event
@@ -199,7 +323,7 @@ pqos_mon_poll_events(struct pqos_mon_data *group)
         /**
          * Calculate values of virtual events
          */
-        if (group->event & PQOS_MON_EVENT_RMEM_BW) {
+        if (poll & PQOS_MON_EVENT_RMEM_BW) {
                 const struct pqos_cap *cap = _pqos_get_cap();
                 const struct pqos_monitor *pmon;
                 uint64_t max_value = 0;
@@ -224,7 +348,7 @@ pqos_mon_poll_events(struct pqos_mon_data *group)
                         group->values.mbm_remote =
                             group->values.mbm_total - group->values.mbm_local;
         }
-        if (group->event & PQOS_PERF_EVENT_IPC) {
+        if (poll & PQOS_PERF_EVENT_IPC) {
                 if (group->values.ipc_unhalted_delta > 0)
                         group->values.ipc =
                             (double)group->values.ipc_retired_delta /
@@ -233,8 +357,22 @@ pqos_mon_poll_events(struct pqos_mon_data *group)
                         group->values.ipc = 0;
         }
 
-        if (ret == PQOS_RETVAL_OK)
-                group->intl->valid_mbm_read = 1;
+        if (ret == PQOS_RETVAL_OK) {
+                /* first read of memory bandwidth only sets the baseline */
+                if (poll & mbm_events || !(group->event & mbm_events))
+                        group->intl->valid_mbm_read = 1;
+
+                for (i = 0; i < DIM(mon_poll_event); i++) {
+                        uint64_t *last = &group->intl->poll.timestamp[i];
+
+                        if (!(poll & mon_poll_event[i]))
+                                continue;
+                        if (*last != 0)
+                                group->intl->poll.interval[i] =
+                                    timestamp - *last;
+                        *last = timestamp;
+                }
+        }
 
 poll_events_exit:
 #ifdef __linux__
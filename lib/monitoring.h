@@ -44,6 +44,19 @@ extern "C" {
 
 #include "pqos.h"
 
+/**
+ * Value marking monitoring group structure as "valid".
+ * Group becomes "valid" after successful pqos_mon_start() or
+ * pqos_mon_start_pid() call.
+ */
+#define GROUP_VALID_MARKER (0x00DEAD00)
+
+/**
+ * Number of events polled from hardware, virtual events are calculated
+ * from them
+ */
+#define MON_POLL_EVENT_NUM 11
+
 /**
  * Core monitoring poll context
  */
@@ -51,6 +64,7 @@ struct pqos_mon_poll_ctx {
         unsigned lcore;
         unsigned cluster;
         pqos_rmid_t rmid;
+        unsigned lease; /**< RMID registry lease, 0 if not registered */
 };
 
 /**
@@ -125,6 +139,9 @@ struct pqos_mon_data_internal {
                 enum pqos_mon_event event;     /**< Started hw events */
                 struct pqos_mon_poll_ctx *ctx; /**< core, cluster & RMID */
                 unsigned num_ctx;              /**< number of poll contexts */
+                unsigned topo_gen; /**< topology generation of contexts */
+                enum pqos_mon_event perf_rebase; /**< perf events to re-base
+                                                    on next read */
         } hw;
 
         /* Uncore specific section */
@@ -133,6 +150,14 @@ struct pqos_mon_data_internal {
                 unsigned *sockets;
         } uncore;
 
+        /* Poll timing section, one entry per polled event */
+        struct {
+                /** time of the last poll [ns] */
+                uint64_t timestamp[MON_POLL_EVENT_NUM];
+                /** time between last two polls [ns] */
+                uint64_t interval[MON_POLL_EVENT_NUM];
+        } poll;
+
         int valid_mbm_read; /**< flag to discard 1st invalid read */
         int manage_memory;  /**< mon data memory is managed by lib */
 };
@@ -140,6 +165,9 @@ struct pqos_mon_data_internal {
 /**
  * @brief Initializes monitoring sub-module of the library (CMT)
  *
+ * Only checks monitoring capability, backend is initialized by
+ * \a pqos_mon_lazy_init.
+ *
  * @param cpu cpu topology structure
  * @param cap capabilities structure
  * @param cfg library configuration structure
@@ -151,6 +179,19 @@ int pqos_mon_init(const struct pqos_cpuinfo *cpu,
                   const struct pqos_cap *cap,
                   const struct pqos_config *cfg);
 
+/**
+ * @brief Initializes monitoring backend on first use
+ *
+ * Backend initialization is deferred by \a pqos_mon_init. Must be called
+ * with API lock held before monitoring or monitoring group associations
+ * are used. Subsequent calls do nothing. Failure is not retried, every
+ * subsequent call returns the original error until \a pqos_mon_fini.
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK success
+ */
+int pqos_mon_lazy_init(void);
+
 /**
  * @brief Shuts down monitoring sub-module of the library
  *
@@ -161,12 +202,35 @@ int pqos_mon_fini(void);
 /**
  * @brief Poll monitoring data from requested groups
  *
+ * Events the group does not monitor are ignored. Memory bandwidth events
+ * are always polled together so remote bandwidth stays consistent.
+ *
  * @param group monitoring group pointer to be updated
+ * @param events events to poll
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_poll_events(struct pqos_mon_data *group,
+                         const enum pqos_mon_event events);
+
+/**
+ * @brief Retrieves poll timing of the event
+ *
+ * Virtual events report timing of the events they are calculated from.
+ *
+ * @param [in] group monitoring group
+ * @param [in] event monitoring event
+ * @param [out] timestamp time of the last poll [ns], 0 if not polled yet
+ * @param [out] interval time between last two polls [ns], 0 if unknown
  *
  * @return Operations status
  * @retval PQOS_RETVAL_OK on success
  */
-int pqos_mon_poll_events(struct pqos_mon_data *group);
+int pqos_mon_poll_time(const struct pqos_mon_data *group,
+                       const enum pqos_mon_event event,
+                       uint64_t *timestamp,
+                       uint64_t *interval);
 
 #ifdef __cplusplus
 }
@@ -38,10 +38,12 @@
 #include "common.h"
 #include "cpuinfo.h"
 #include "log.h"
+#include "monitoring.h"
 #include "resctrl.h"
 #include "resctrl_alloc.h"
 #include "resctrl_monitoring.h"
 #include "resctrl_utils.h"
+#include "topology.h"
 
 #include <ctype.h>
 #include <dirent.h> /**< scandir() */
@@ -52,6 +54,60 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Schemata scratch reused by the allocation setters and getters.
+ * Keeps per-COS updates free of heap allocations.
+ */
+static struct {
+        struct resctrl_schemata *schmt;
+        const struct pqos_cap *cap;
+        const struct pqos_cpuinfo *cpu;
+} m_scratch = {NULL, NULL, NULL};
+
+/**
+ * @brief Retrieves schemata scratch matching current topology
+ *
+ * Scratch is allocated on first use and reused afterwards. Schemata
+ * read from resctrl covers every resource id, so no clearing is needed
+ * between uses.
+ *
+ * @param [in] cap platform QoS capabilities structure
+ * @param [in] cpu CPU information structure
+ *
+ * @return Schemata scratch or NULL on allocation error
+ */
+static struct resctrl_schemata *
+os_alloc_schemata_get(const struct pqos_cap *cap,
+                      const struct pqos_cpuinfo *cpu)
+{
+        if (m_scratch.schmt != NULL &&
+            (m_scratch.cap != cap || m_scratch.cpu != cpu))
+                os_alloc_schemata_release();
+
+        if (m_scratch.schmt == NULL) {
+                m_scratch.schmt = resctrl_schemata_alloc(cap, cpu);
+                m_scratch.cap = cap;
+                m_scratch.cpu = cpu;
+        }
+
+        return m_scratch.schmt;
+}
+
+void
+os_alloc_schemata_release(void)
+{
+        resctrl_schemata_free(m_scratch.schmt);
+        m_scratch.schmt = NULL;
+        m_scratch.cap = NULL;
+        m_scratch.cpu = NULL;
+}
+
 int
 os_alloc_mount(const enum pqos_cdp_config l3_cdp_cfg,
                const enum pqos_cdp_config l2_cdp_cfg,
@@ -284,6 +340,8 @@ os_alloc_init(const struct pqos_cpuinfo *cpu, const struct pqos_cap *cap)
 int
 os_alloc_fini(void)
 {
+        os_alloc_schemata_release();
+
         return resctrl_alloc_fini();
 }
 
@@ -315,8 +373,10 @@ os_alloc_assoc_set(const unsigned lcore, const unsigned class_id)
 
         /*
          * When core is moved to different COS we need to update monitoring
-         * groups. Obtain monitoring group name
+         * groups. Obtain monitoring group name, monitoring backend has to
+         * be initialized to discover them
          */
+        (void)pqos_mon_lazy_init();
         ret_mon = resctrl_mon_assoc_get(lcore, mon_group, sizeof(mon_group));
         if (ret_mon != PQOS_RETVAL_OK && ret_mon != PQOS_RETVAL_RESOURCE)
                 LOG_WARN("Failed to obtain monitoring group assignment for "
@@ -395,19 +455,19 @@ os_pid_get_pid_assoc(const unsigned class_id, unsigned *count)
 }
 
 int
-os_alloc_assign(const unsigned technology,
-                const unsigned *core_array,
-                const unsigned core_num,
-                unsigned *class_id)
+os_alloc_cos_unused(const unsigned technology,
+                    const unsigned *core_array,
+                    const unsigned core_num,
+                    unsigned *class_id)
 {
-        unsigned i, num_rctl_grps = 0;
+        unsigned num_rctl_grps = 0;
         int ret;
         const struct pqos_cap *cap = _pqos_get_cap();
 
-        ASSERT(core_num > 0);
-        ASSERT(core_array != NULL);
         ASSERT(class_id != NULL);
         UNUSED_PARAM(technology);
+        UNUSED_PARAM(core_array);
+        UNUSED_PARAM(core_num);
 
         /* obtain highest class id for all requested technologies */
         ret = resctrl_alloc_get_grps_num(cap, &num_rctl_grps);
@@ -418,7 +478,23 @@ os_alloc_assign(const unsigned technology,
                 return PQOS_RETVAL_ERROR;
 
         /* find an unused class from highest down */
-        ret = resctrl_alloc_get_unused_group(num_rctl_grps, class_id);
+        return resctrl_alloc_get_unused_group(num_rctl_grps, class_id);
+}
+
+int
+os_alloc_assign(const unsigned technology,
+                const unsigned *core_array,
+                const unsigned core_num,
+                unsigned *class_id)
+{
+        unsigned i;
+        int ret;
+
+        ASSERT(core_num > 0);
+        ASSERT(core_array != NULL);
+        ASSERT(class_id != NULL);
+
+        ret = os_alloc_cos_unused(technology, core_array, core_num, class_id);
         if (ret != PQOS_RETVAL_OK)
                 return ret;
 
@@ -963,10 +1039,14 @@ os_alloc_reset(const struct pqos_alloc_config *cfg)
         l2_cdp_changed = l2_cdp_update(l2_cdp_cfg, l2_cap, &l2_cdp);
         mba_changed = mba_cfg_update(mba_cfg, mba_cap, &mba_ctrl);
 
+        /* CDP and MBA CTRL changes alter schemata layout */
+        os_alloc_schemata_release();
+
         if (l3_cdp_changed || l2_cdp_changed || mba_changed) {
 
                 unsigned monitoring_active = 0;
 
+                (void)pqos_mon_lazy_init();
                 ret = resctrl_mon_active(&monitoring_active);
                 if (ret != PQOS_RETVAL_OK) {
                         LOG_ERROR("Failed to check resctrl "
@@ -1001,25 +1081,16 @@ os_alloc_reset_exit:
 static int
 verify_l3cat_id(const unsigned l3cat_id, const struct pqos_cpuinfo *cpu)
 {
-        int ret = PQOS_RETVAL_PARAM;
-        unsigned i;
-        unsigned l3cat_num;
-        unsigned *l3cat_ids;
+        unsigned idx;
+        int ret;
 
-        /* Get l3cat ids in the system */
-        l3cat_ids = pqos_cpu_get_l3cat_ids(cpu, &l3cat_num);
-        if (l3cat_ids == NULL)
+        ret = topo_obj_idx(cpu, TOPO_OBJ_L3CAT, l3cat_id, &idx);
+        if (ret == PQOS_RETVAL_ERROR)
+                return PQOS_RETVAL_PARAM;
+        if (ret != PQOS_RETVAL_OK)
                 return PQOS_RETVAL_ERROR;
 
-        for (i = 0; i < l3cat_num; ++i)
-                if (l3cat_id == l3cat_ids[i]) {
-                        ret = PQOS_RETVAL_OK;
-                        break;
-                }
-
-        free(l3cat_ids);
-
-        return ret;
+        return PQOS_RETVAL_OK;
 }
 
 /*
@@ -1034,25 +1105,16 @@ verify_l3cat_id(const unsigned l3cat_id, const struct pqos_cpuinfo *cpu)
 static int
 verify_mba_id(const unsigned mba_id, const struct pqos_cpuinfo *cpu)
 {
-        int ret = PQOS_RETVAL_PARAM;
-        unsigned i;
-        unsigned mba_id_num;
-        unsigned *mba_ids;
+        unsigned idx;
+        int ret;
 
-        /* Get mba ids in the system */
-        mba_ids = pqos_cpu_get_mba_ids(cpu, &mba_id_num);
-        if (mba_ids == NULL)
+        ret = topo_obj_idx(cpu, TOPO_OBJ_MBA, mba_id, &idx);
+        if (ret == PQOS_RETVAL_ERROR)
+                return PQOS_RETVAL_PARAM;
+        if (ret != PQOS_RETVAL_OK)
                 return PQOS_RETVAL_ERROR;
 
-        for (i = 0; i < mba_id_num; ++i)
-                if (mba_id == mba_ids[i]) {
-                        ret = PQOS_RETVAL_OK;
-                        break;
-                }
-
-        free(mba_ids);
-
-        return ret;
+        return PQOS_RETVAL_OK;
 }
 
 int
@@ -1117,7 +1179,7 @@ os_l3ca_set(const unsigned l3cat_id,
                         goto os_l3ca_set_unlock;
                 }
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1145,8 +1207,6 @@ os_l3ca_set(const unsigned l3cat_id,
                         ret = resctrl_alloc_schemata_write(
                             ca[i].class_id, PQOS_TECHNOLOGY_L3CA, schmt);
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_l3ca_set_unlock;
         }
@@ -1196,7 +1256,7 @@ os_l3ca_get(const unsigned l3cat_id,
         for (class_id = 0; class_id < count; class_id++) {
                 struct resctrl_schemata *schmt;
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1209,8 +1269,6 @@ os_l3ca_get(const unsigned l3cat_id,
 
                 ca[class_id].class_id = class_id;
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_l3ca_get_unlock;
         }
@@ -1263,25 +1321,16 @@ os_l3ca_get_min_cbm_bits(unsigned *min_cbm_bits)
 static int
 verify_l2_id(const unsigned l2id, const struct pqos_cpuinfo *cpu)
 {
-        int ret = PQOS_RETVAL_PARAM;
-        unsigned i;
-        unsigned l2ids_num;
-        unsigned *l2ids;
+        unsigned idx;
+        int ret;
 
-        /* Get L2 ids in the system */
-        l2ids = pqos_cpu_get_l2ids(cpu, &l2ids_num);
-        if (l2ids == NULL)
+        ret = topo_obj_idx(cpu, TOPO_OBJ_L2_CLUSTER, l2id, &idx);
+        if (ret == PQOS_RETVAL_ERROR)
+                return PQOS_RETVAL_PARAM;
+        if (ret != PQOS_RETVAL_OK)
                 return PQOS_RETVAL_ERROR;
 
-        for (i = 0; i < l2ids_num; ++i)
-                if (l2id == l2ids[i]) {
-                        ret = PQOS_RETVAL_OK;
-                        break;
-                }
-
-        free(l2ids);
-
-        return ret;
+        return PQOS_RETVAL_OK;
 }
 
 int
@@ -1357,7 +1406,7 @@ os_l2ca_set(const unsigned l2id,
                         goto os_l2ca_set_unlock;
                 }
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1384,8 +1433,6 @@ os_l2ca_set(const unsigned l2id,
                         ret = resctrl_alloc_schemata_write(
                             ca[i].class_id, PQOS_TECHNOLOGY_L2CA, schmt);
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_l2ca_set_unlock;
         }
@@ -1436,7 +1483,7 @@ os_l2ca_get(const unsigned l2id,
         for (class_id = 0; class_id < count; class_id++) {
                 struct resctrl_schemata *schmt;
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1449,8 +1496,6 @@ os_l2ca_get(const unsigned l2id,
 
                 ca[class_id].class_id = class_id;
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_l2ca_get_unlock;
         }
@@ -1558,7 +1603,7 @@ os_mba_set(const unsigned mba_id,
                         goto os_mba_set_unlock;
                 }
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1604,8 +1649,6 @@ os_mba_set(const unsigned mba_id,
                                 actual[i].class_id = requested[i].class_id;
                         }
                 }
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_mba_set_unlock;
         }
@@ -1682,7 +1725,7 @@ os_mba_set_amd(const unsigned mba_id,
                         goto os_mba_set_unlock;
                 }
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1716,8 +1759,6 @@ os_mba_set_amd(const unsigned mba_id,
                                 actual[i].class_id = requested[i].class_id;
                         }
                 }
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_mba_set_unlock;
         }
@@ -1771,7 +1812,7 @@ os_mba_get(const unsigned mba_id,
         for (class_id = 0; class_id < count; class_id++) {
                 struct resctrl_schemata *schmt;
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1784,8 +1825,6 @@ os_mba_get(const unsigned mba_id,
 
                 mba_tab[class_id].class_id = class_id;
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_mba_get_unlock;
         }
@@ -1840,7 +1879,7 @@ os_mba_get_amd(const unsigned mba_id,
         for (class_id = 0; class_id < count; class_id++) {
                 struct resctrl_schemata *schmt;
 
-                schmt = resctrl_schemata_alloc(cap, cpu);
+                schmt = os_alloc_schemata_get(cap, cpu);
                 if (schmt == NULL)
                         ret = PQOS_RETVAL_ERROR;
 
@@ -1853,8 +1892,6 @@ os_mba_get_amd(const unsigned mba_id,
 
                 mba_tab[class_id].class_id = class_id;
 
-                resctrl_schemata_free(schmt);
-
                 if (ret != PQOS_RETVAL_OK)
                         goto os_mba_get_unlock;
         }
@@ -1892,8 +1929,10 @@ os_alloc_assoc_set_pid(const pid_t task, const unsigned class_id)
 
         /*
          * When task is moved to different COS we need to update monitoring
-         * groups. Obtain monitoring group name
+         * groups. Obtain monitoring group name, monitoring backend has to
+         * be initialized to discover them
          */
+        (void)pqos_mon_lazy_init();
         ret_mon = resctrl_mon_assoc_get_pid(task, mon_group, sizeof(mon_group));
         if (ret_mon != PQOS_RETVAL_OK && ret_mon != PQOS_RETVAL_RESOURCE)
                 LOG_WARN("Failed to obtain monitoring group assignment for "
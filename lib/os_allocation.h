@@ -65,6 +65,14 @@ PQOS_LOCAL int os_alloc_init(const struct pqos_cpuinfo *cpu,
  */
 PQOS_LOCAL int os_alloc_fini(void);
 
+/**
+ * @brief Releases schemata scratch kept for allocation updates
+ *
+ * Scratch is re-created on next use. Needs to be called whenever
+ * topology or schemata layout changes.
+ */
+PQOS_LOCAL void os_alloc_schemata_release(void);
+
 /**
  * @brief Function to mount the resctrl file system with CDP or MBps options
  *
@@ -79,6 +87,27 @@ PQOS_LOCAL int os_alloc_mount(const enum pqos_cdp_config l3_cdp_cfg,
                               const enum pqos_cdp_config l2_cdp_cfg,
                               const enum pqos_mba_config mba_cfg);
 
+/**
+ * @brief OS interface to find unused COS
+ *
+ * Resctrl groups span all resource entities, \a core_array is not
+ * restricted. No association is changed.
+ *
+ * @param [in] technology bit mask selecting technologies
+ *             (1 << enum pqos_cap_type)
+ * @param [in] core_array list of core ids, can be NULL
+ * @param [in] core_num number of core ids in the \a core_array
+ * @param [out] class_id unused COS
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if no class of service is available
+ */
+PQOS_LOCAL int os_alloc_cos_unused(const unsigned technology,
+                                   const unsigned *core_array,
+                                   const unsigned core_num,
+                                   unsigned *class_id);
+
 /**
  * @brief OS interface to assign first available
  *        COS to cores in \a core_array
@@ -44,6 +44,7 @@
 #include <string.h>
 
 #define SYSTEM_CPU "/sys/devices/system/cpu"
+#define PROC_CPUINFO "/proc/cpuinfo"
 
 /**
  * @brief Filter directory filenames
@@ -152,7 +153,7 @@ os_cpuinfo_cpu_online(unsigned lcore)
  * @return Operations status
  * @retval PQOS_RETVAL_OK on success
  */
-PQOS_STATIC int
+int
 os_cpuinfo_cpu_node(unsigned lcore, unsigned *node)
 {
         char buf[256];
@@ -244,6 +245,70 @@ os_cpuinfo_cpu_cache(unsigned lcore, unsigned *l3, unsigned *l2)
         return ret;
 }
 
+/**
+ * @brief Reads APICID of online logical cores from /proc/cpuinfo
+ *
+ * Entries of \a apicid for cores not listed in /proc/cpuinfo are left
+ * untouched.
+ *
+ * @param [in] num_cpus number of entries in \a apicid
+ * @param [out] apicid APICID table indexed by logical core id
+ * @param [out] count number of APICIDs found
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if /proc/cpuinfo is not available
+ */
+int
+os_cpuinfo_apicid(const unsigned num_cpus, uint32_t *apicid, unsigned *count)
+{
+        char buf[256];
+        FILE *fd;
+        unsigned lcore = UINT_MAX;
+        int partial = 0;
+
+        ASSERT(apicid != NULL);
+        ASSERT(count != NULL);
+
+        *count = 0;
+
+        fd = pqos_fopen(PROC_CPUINFO, "r");
+        if (fd == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        while (fgets(buf, sizeof(buf), fd) != NULL) {
+                const char *value = strchr(buf, ':');
+                const int line_start = !partial;
+                unsigned id;
+
+                /* skip remainder of long lines i.e. flags */
+                partial = (strchr(buf, '\n') == NULL);
+                if (!line_start || value == NULL)
+                        continue;
+                value++;
+                while (*value == ' ')
+                        value++;
+
+                if (strncmp(buf, "processor", 9) == 0) {
+                        if (parse_uint(value, &lcore) != PQOS_RETVAL_OK)
+                                lcore = UINT_MAX;
+                } else if (strncmp(buf, "apicid", 6) == 0) {
+                        if (lcore >= num_cpus)
+                                continue;
+                        if (parse_uint(value, &id) != PQOS_RETVAL_OK)
+                                continue;
+
+                        apicid[lcore] = id;
+                        (*count)++;
+                        lcore = UINT_MAX;
+                }
+        }
+
+        pqos_fclose(fd);
+
+        return PQOS_RETVAL_OK;
+}
+
 /**
  * @brief Builds CPU topology structure
  *
@@ -49,6 +49,38 @@ extern "C" {
  */
 PQOS_LOCAL struct pqos_cpuinfo *os_cpuinfo_topology(void);
 
+/**
+ * @brief Reads APICID of online logical cores from /proc/cpuinfo
+ *
+ * Entries of \a apicid for cores not listed in /proc/cpuinfo are left
+ * untouched, so the caller can probe them with CPUID.
+ *
+ * @param [in] num_cpus number of entries in \a apicid
+ * @param [out] apicid APICID table indexed by logical core id
+ * @param [out] count number of APICIDs found
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if /proc/cpuinfo is not available
+ */
+PQOS_LOCAL int
+os_cpuinfo_apicid(const unsigned num_cpus, uint32_t *apicid, unsigned *count);
+
+#if (PQOS_VERSION >= 50000 || defined PQOS_SNC)
+/**
+ * @brief Detects NUMA node of \a lcore from sysfs
+ *
+ * The calling task does not need to run on \a lcore.
+ *
+ * @param [in] lcore Logical core id
+ * @param [out] node Detected node
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+PQOS_LOCAL int os_cpuinfo_cpu_node(unsigned lcore, unsigned *node);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
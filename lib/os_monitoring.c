@@ -301,6 +301,22 @@ os_mon_reset(void)
         return resctrl_mon_reset();
 }
 
+int
+os_mon_reclaim(unsigned *num_groups)
+{
+        int ret;
+
+        ret = resctrl_lock_exclusive();
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        ret = resctrl_mon_reclaim(num_groups);
+
+        resctrl_lock_release();
+
+        return ret;
+}
+
 int
 os_mon_stop(struct pqos_mon_data *group)
 {
@@ -73,6 +73,16 @@ PQOS_LOCAL int os_mon_fini(void);
  */
 PQOS_LOCAL int os_mon_reset(void);
 
+/**
+ * @brief OS interface to remove monitoring groups of exited processes
+ *
+ * @param [out] num_groups number of removed groups, can be NULL
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+PQOS_LOCAL int os_mon_reclaim(unsigned *num_groups);
+
 /*
  * @brief This function stops all perf counters
  *
@@ -168,17 +168,66 @@ struct pqos_config {
  * @retval PQOS_RETVAL_OK on success
  * @note   If you require system wide interface enforcement you can do so by
  *         setting the "RDT_IFACE" environment variable.
+ * @note   Discovered capabilities and CPU topology are cached in the file
+ *         named by the "RDT_CAP_CACHE" environment variable, if set.
+ *         The cache is rebuilt automatically after reboot, kernel,
+ *         microcode, online CPU or resctrl mount option changes.
+ * @note   Monitoring (RMID, perf and uncore event setup) is initialized on
+ *         first use of the monitoring API, allocation only users do not
+ *         pay for it.
  */
 int pqos_init(const struct pqos_config *config);
 
 /**
  * @brief Shuts down PQoS module
  *
+ * If context handles created with pqos_ctx_init() are still live, the
+ * shutdown is deferred until the last handle is released.
+ *
  * @return Operations status
  * @retval PQOS_RETVAL_OK on success
  */
 int pqos_fini(void);
 
+/**
+ * Library context handle
+ */
+struct pqos_ctx;
+
+/**
+ * @brief Creates library context handle
+ *
+ * Handles allow independent parts of an application to manage library
+ * lifetime without coordinating pqos_init() and pqos_fini() calls.
+ * Platform QoS state is machine wide, so all handles share one library
+ * instance. The first handle initializes the library using \a config
+ * unless it has already been initialized through pqos_init(). Other
+ * handles attach to the running instance. The library is shut down when
+ * the last handle is released, if a handle brought it up or pqos_fini()
+ * was called while handles were live.
+ *
+ * @param [in] config initialization parameters structure
+ * @param [out] ctx place to store the handle
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_INTER if the library runs with interface that is not
+ *         compatible with \a config. PQOS_INTER_AUTO is compatible with any
+ *         interface and PQOS_INTER_OS is served by PQOS_INTER_OS_RESCTRL_MON.
+ */
+int pqos_ctx_init(const struct pqos_config *config, struct pqos_ctx **ctx);
+
+/**
+ * @brief Releases library context handle
+ *
+ * @param [in] ctx handle obtained with pqos_ctx_init()
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if \a ctx is not a live handle
+ */
+int pqos_ctx_fini(struct pqos_ctx *ctx);
+
 /*
  * =======================================
  * Query capabilities
@@ -396,6 +445,33 @@ struct pqos_cpuinfo {
  */
 int pqos_cap_get(const struct pqos_cap **cap, const struct pqos_cpuinfo **cpu);
 
+/**
+ * @brief Updates CPU topology after CPU hotplug
+ *
+ * Detects online cores again and updates library state in place,
+ * without re-initialization:
+ * - CPU topology and topology lookup tables
+ * - cached MSR driver file descriptors
+ * - monitoring groups, whose counters are then read through cores
+ *   still online in the same cluster; group cores that came back online
+ *   are monitored again
+ *
+ * Monitoring group values stay continuous across the call, deltas of
+ * events summed over group cores (IPC, LLC misses) are reported as zero
+ * with the first poll after the topology changed.
+ *
+ * @note If topology changed then CPU information retrieved with
+ *       \a pqos_cap_get before the call is outdated and has to be
+ *       retrieved again. Outdated structure stays valid until the next
+ *       topology change, so threads still using it with
+ *       \a pqos_cpu_get_* helpers are safe in the meantime. It is freed
+ *       by the following refresh that changes the topology.
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_cpu_refresh(void);
+
 /**
  * @brief Retrieves PQoS interface
  *
@@ -406,6 +482,34 @@ int pqos_cap_get(const struct pqos_cap **cap, const struct pqos_cpuinfo **cpu);
  */
 int pqos_inter_get(enum pqos_interface *interface);
 
+/**
+ * @brief Retrieves PQoS capabilities data through context handle
+ *
+ * @param [in] ctx library context handle
+ * @param [out] cap location to store PQoS capabilities information at
+ * @param [out] cpu location to store CPU information at
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if \a ctx is not a live handle
+ */
+int pqos_ctx_cap_get(const struct pqos_ctx *ctx,
+                     const struct pqos_cap **cap,
+                     const struct pqos_cpuinfo **cpu);
+
+/**
+ * @brief Retrieves PQoS interface used by context handle
+ *
+ * @param [in] ctx library context handle
+ * @param [out] interface PQoS interface
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if \a ctx is not a live handle
+ */
+int pqos_ctx_inter_get(const struct pqos_ctx *ctx,
+                       enum pqos_interface *interface);
+
 /*
  * =======================================
  * Monitoring
@@ -476,6 +580,34 @@ struct pqos_mon_data {
  */
 int pqos_mon_reset(void);
 
+/**
+ * @brief Removes monitoring groups left behind by exited processes
+ *
+ * Unlike \a pqos_mon_reset, monitoring groups of running processes are
+ * not affected.
+ *
+ * OS interface: group owners are looked up in /proc of the caller, so
+ * this must be called from a PID namespace that sees all processes using
+ * resctrl monitoring (e.g. not from inside a container), otherwise groups
+ * of running processes in other namespaces are removed. Stale groups are
+ * never removed implicitly.
+ *
+ * MSR interface: RMIDs registered by exited processes of the caller's PID
+ * namespace are released and cores still associated with them are bound
+ * with RMID0. RMIDs of processes from other PID namespaces, or of
+ * processes that ran without the RMID registry, are not affected. The
+ * same is done implicitly once a monitoring cluster runs out of RMIDs.
+ *
+ * @param [out] num_groups number of removed groups (OS interface) or
+ *              reclaimed RMIDs (MSR interface), can be NULL
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if not supported or, in MSR mode, RMID
+ *         registry is not available
+ */
+int pqos_mon_reclaim(unsigned *num_groups);
+
 /**
  * @brief Reads RMID association of the \a lcore
  *
@@ -685,6 +817,437 @@ int pqos_mon_stop(struct pqos_mon_data *group);
  */
 int pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups);
 
+/**
+ * @brief Polls selected events of monitoring groups
+ *
+ * Allows to poll slowly changing events less often than the others.
+ * Values, deltas and rates of events that are not polled are kept from
+ * their previous poll. Counter deltas cover the time between the last
+ * two polls of the event, see \a pqos_mon_get_poll_time. Events the group
+ * does not monitor are ignored, so are groups that monitor none of
+ * \a events. Memory bandwidth events are always polled together.
+ *
+ * @param [in] groups table of monitoring group pointers to be updated
+ * @param [in] num_groups number of monitoring groups in the table
+ * @param [in] events events to poll
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OVERFLOW MBM counter overflow
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_poll_subset(struct pqos_mon_data **groups,
+                         const unsigned num_groups,
+                         const enum pqos_mon_event events);
+
+/*
+ * =======================================
+ * Asynchronous sampler
+ * =======================================
+ */
+
+/**
+ * Sampler handle
+ */
+struct pqos_sampler;
+
+/**
+ * Sampler reader handle
+ */
+struct pqos_sampler_reader;
+
+/**
+ * Default number of samples kept by the sampler
+ */
+#define PQOS_SAMPLER_DEPTH_DEFAULT 64
+
+/**
+ * Sampler configuration
+ */
+struct pqos_sampler_config {
+        unsigned interval_us; /**< sampling interval in microseconds */
+        unsigned depth;       /**< number of samples kept in the ring,
+                                 0 selects PQOS_SAMPLER_DEPTH_DEFAULT */
+};
+
+/**
+ * Sample information
+ */
+struct pqos_sample_info {
+        uint64_t seq;       /**< sample sequence number */
+        uint64_t timestamp; /**< CLOCK_MONOTONIC time of the sample [ns] */
+        uint64_t lost;      /**< samples overwritten since previous read */
+        int status;         /**< pqos_mon_poll() status of the sample */
+};
+
+/**
+ * @brief Starts sampler thread polling monitoring groups
+ *
+ * The sampler thread polls \a groups every \a config->interval_us and
+ * stores values of all groups as one sample in a ring. Samples are
+ * retrieved through reader handles, see pqos_sampler_reader_open().
+ *
+ * Groups are owned by the sampler until it is stopped. Application
+ * must not poll, modify or stop them in the meantime.
+ *
+ * @param [in] config sampler configuration
+ * @param [in] groups table of monitoring group pointers to be sampled
+ * @param [in] num_groups number of monitoring groups in the table
+ * @param [out] sampler place to store sampler handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_sampler_start(const struct pqos_sampler_config *config,
+                       struct pqos_mon_data **groups,
+                       const unsigned num_groups,
+                       struct pqos_sampler **sampler);
+
+/**
+ * @brief Stops sampler thread
+ *
+ * @param [in] sampler sampler handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_BUSY sampler has open readers
+ */
+int pqos_sampler_stop(struct pqos_sampler *sampler);
+
+/**
+ * @brief Opens sampler reader
+ *
+ * Each reader keeps its own position in the ring and owns an eventfd
+ * that is signalled when a new sample is available. Reader starts with
+ * the first sample taken after it was opened.
+ *
+ * @param [in] sampler sampler handle
+ * @param [out] reader place to store reader handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_sampler_reader_open(struct pqos_sampler *sampler,
+                             struct pqos_sampler_reader **reader);
+
+/**
+ * @brief Closes sampler reader
+ *
+ * @param [in] reader reader handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_sampler_reader_close(struct pqos_sampler_reader *reader);
+
+/**
+ * @brief Retrieves reader notification file descriptor
+ *
+ * The descriptor is a non-blocking eventfd suitable for poll/epoll.
+ * Application should read the descriptor to clear the notification and
+ * then call pqos_sampler_read() until no more samples are available.
+ *
+ * @param [in] reader reader handle
+ *
+ * @return file descriptor or -1 on error
+ */
+int pqos_sampler_reader_fd(const struct pqos_sampler_reader *reader);
+
+/**
+ * @brief Reads next sample
+ *
+ * The function does not block nor access the hardware. If the reader
+ * falls behind the sampler, overwritten samples are skipped and their
+ * number is reported in \a info->lost.
+ *
+ * @param [in] reader reader handle
+ * @param [out] info sample information
+ * @param [out] values table to store values of monitoring groups in,
+ *              in order the groups were passed to pqos_sampler_start()
+ * @param [in] num_values number of entries in \a values table
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE no new sample available
+ */
+int pqos_sampler_read(struct pqos_sampler_reader *reader,
+                      struct pqos_sample_info *info,
+                      struct pqos_event_values *values,
+                      const unsigned num_values);
+
+/*
+ * =======================================
+ * Telemetry segment
+ * =======================================
+ */
+
+/**
+ * Telemetry segment layout version
+ */
+#define PQOS_TELEMETRY_VERSION 1
+
+/**
+ * Maximum length of telemetry record description
+ */
+#define PQOS_TELEMETRY_DESC_LEN 64
+
+/**
+ * Telemetry publisher handle
+ */
+struct pqos_telemetry;
+
+/**
+ * Telemetry reader handle
+ */
+struct pqos_telemetry_reader;
+
+/**
+ * Telemetry record
+ */
+struct pqos_telemetry_record {
+        uint64_t timestamp;                 /**< CLOCK_MONOTONIC time [ns] */
+        uint64_t interval;                  /**< time since last update */
+        uint32_t event;                     /**< monitored events */
+        char desc[PQOS_TELEMETRY_DESC_LEN]; /**< group description */
+        struct pqos_event_values values;    /**< event values */
+        double mbm_local_rate;              /**< local bandwidth [B/s] */
+        double mbm_total_rate;              /**< total bandwidth [B/s] */
+        double mbm_remote_rate;             /**< remote bandwidth [B/s] */
+};
+
+/**
+ * @brief Creates telemetry segment
+ *
+ * Segment is created in /dev/shm and is readable by all users.
+ * Existing segment with the same name is replaced.
+ *
+ * @param [in] name segment name
+ * @param [in] num_records number of records in the segment
+ * @param [out] telemetry place to store publisher handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_telemetry_create(const char *name,
+                          const unsigned num_records,
+                          struct pqos_telemetry **telemetry);
+
+/**
+ * @brief Publishes monitoring group values in telemetry record
+ *
+ * @param [in] telemetry publisher handle
+ * @param [in] index record index
+ * @param [in] desc group description, may be NULL
+ * @param [in] group polled monitoring group
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_telemetry_update(struct pqos_telemetry *telemetry,
+                          const unsigned index,
+                          const char *desc,
+                          const struct pqos_mon_data *group);
+
+/**
+ * @brief Removes telemetry segment
+ *
+ * @param [in] telemetry publisher handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_telemetry_destroy(struct pqos_telemetry *telemetry);
+
+/**
+ * @brief Opens telemetry segment for reading
+ *
+ * Reader API does not require library initialization nor privileges.
+ *
+ * @param [in] name segment name
+ * @param [out] reader place to store reader handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE segment does not exist or is not compatible
+ */
+int pqos_telemetry_open(const char *name,
+                        struct pqos_telemetry_reader **reader);
+
+/**
+ * @brief Retrieves number of records in telemetry segment
+ *
+ * @param [in] reader reader handle
+ * @param [out] num_records number of records
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_telemetry_get_num(const struct pqos_telemetry_reader *reader,
+                           unsigned *num_records);
+
+/**
+ * @brief Reads consistent snapshot of telemetry record
+ *
+ * @param [in] reader reader handle
+ * @param [in] index record index
+ * @param [out] record place to store the record
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE record has not been published yet
+ * @retval PQOS_RETVAL_INIT publisher removed the segment
+ */
+int pqos_telemetry_read(const struct pqos_telemetry_reader *reader,
+                        const unsigned index,
+                        struct pqos_telemetry_record *record);
+
+/**
+ * @brief Closes telemetry segment
+ *
+ * @param [in] reader reader handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_telemetry_close(struct pqos_telemetry_reader *reader);
+
+/*
+ * =======================================
+ * Streaming statistics
+ * =======================================
+ */
+
+/**
+ * Default EWMA half-life [s]
+ */
+#define PQOS_MON_STATS_HALF_LIFE 10.0
+
+/**
+ * Default min/max and quantile window [s]
+ */
+#define PQOS_MON_STATS_WINDOW 60.0
+
+/**
+ * Default relative accuracy of quantiles
+ */
+#define PQOS_MON_STATS_ACCURACY 0.01
+
+/**
+ * Streaming statistics handle
+ */
+struct pqos_mon_stats;
+
+/**
+ * Streaming statistics configuration, zero fields select defaults
+ */
+struct pqos_mon_stats_config {
+        double half_life; /**< EWMA half-life [s] */
+        double window;    /**< min/max and quantile window [s] */
+        double accuracy;  /**< relative accuracy of quantiles */
+};
+
+/**
+ * Statistics of single event
+ *
+ * LLC occupancy is in bytes, memory bandwidth in bytes per second,
+ * LLC misses and references in events per second.
+ */
+struct pqos_mon_stat {
+        uint64_t count; /**< number of samples */
+        double last;    /**< last sample */
+        double ewma;    /**< exponentially weighted moving average */
+        double min;     /**< minimum within the window */
+        double max;     /**< maximum within the window */
+};
+
+/**
+ * @brief Creates streaming statistics of a monitoring group
+ *
+ * Statistics use constant memory regardless of the number of samples.
+ * Tracked events are LLC occupancy, local, total and remote memory
+ * bandwidth, IPC, LLC misses and LLC references. Window values cover
+ * between half and the full window of the most recent samples.
+ *
+ * @param [in] config statistics configuration, NULL for defaults
+ * @param [out] stats place to store statistics handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_stats_create(const struct pqos_mon_stats_config *config,
+                          struct pqos_mon_stats **stats);
+
+/**
+ * @brief Updates statistics with values of polled monitoring group
+ *
+ * Rates are computed from counter deltas and time between polls of each
+ * event. Events that have not been polled since the previous update are
+ * skipped, so the function can be called after every poll, including
+ * polls of event subsets by \a pqos_mon_poll_subset.
+ * Handle is not thread safe.
+ *
+ * @param [in] stats statistics handle
+ * @param [in] group polled monitoring group
+ * @param [in] timestamp CLOCK_MONOTONIC poll time [ns], 0 for current time
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_stats_update(struct pqos_mon_stats *stats,
+                          const struct pqos_mon_data *group,
+                          uint64_t timestamp);
+
+/**
+ * @brief Retrieves statistics of the event
+ *
+ * @param [in] stats statistics handle
+ * @param [in] event monitored event
+ * @param [out] stat place to store event statistics
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE no samples of the event yet
+ */
+int pqos_mon_stats_get(const struct pqos_mon_stats *stats,
+                       const enum pqos_mon_event event,
+                       struct pqos_mon_stat *stat);
+
+/**
+ * @brief Estimates quantile of the event within the window
+ *
+ * @param [in] stats statistics handle
+ * @param [in] event monitored event
+ * @param [in] quantile quantile in 0-1 range, e.g. 0.99
+ * @param [out] value place to store estimated value
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE no samples of the event yet
+ */
+int pqos_mon_stats_get_quantile(const struct pqos_mon_stats *stats,
+                                const enum pqos_mon_event event,
+                                const double quantile,
+                                double *value);
+
+/**
+ * @brief Drops all samples, e.g. when the group is retargeted
+ *
+ * @param [in] stats statistics handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_stats_reset(struct pqos_mon_stats *stats);
+
+/**
+ * @brief Releases statistics handle
+ *
+ * @param [in] stats statistics handle
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_stats_destroy(struct pqos_mon_stats *stats);
+
 /*
  * =======================================
  * Allocation Technology
@@ -806,6 +1369,103 @@ int pqos_alloc_assign_pid(const unsigned technology,
  */
 int pqos_alloc_release_pid(const pid_t *task_array, const unsigned task_num);
 
+/**
+ * Allocation settings of a class of service
+ *
+ * Settings set to NULL are copied from the class of service currently
+ * in use. Class id of the settings is ignored.
+ */
+struct pqos_alloc_cos {
+        const struct pqos_l3ca *l3ca; /**< L3 CAT setting */
+        const struct pqos_l2ca *l2ca; /**< L2 CAT setting */
+        const struct pqos_mba *mba;   /**< MBA setting */
+};
+
+/**
+ * @brief Moves cores in \a core_array to spare COS configured with \a cfg
+ *
+ * Spare COS is programmed with complete L3 CAT, L2 CAT and MBA settings on
+ * all resource entities of the cores before any core is moved, so cores
+ * run either with old or new settings. Previous COS is released for reuse
+ * once no core uses it.
+ *
+ * All cores need to use the same COS. In MSR mode cores need to belong to
+ * one resource entity, see \a pqos_alloc_assign.
+ *
+ * @param [in] cfg requested COS settings
+ * @param [in] core_array list of core ids
+ * @param [in] core_num number of core ids in the \a core_array
+ * @param [out] class_id COS the cores were moved to
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if no spare COS is available
+ */
+int pqos_alloc_swap(const struct pqos_alloc_cos *cfg,
+                    const unsigned *core_array,
+                    const unsigned core_num,
+                    unsigned *class_id);
+
+/**
+ * @brief Moves tasks in \a task_array to spare COS configured with \a cfg
+ *
+ * Same as \a pqos_alloc_swap, spare COS is programmed on all resource
+ * entities. Available with OS interface only.
+ *
+ * @param [in] cfg requested COS settings
+ * @param [in] task_array list of task ids
+ * @param [in] task_num number of task ids in the \a task_array
+ * @param [out] class_id COS the tasks were moved to
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if no spare COS is available
+ */
+int pqos_alloc_swap_pid(const struct pqos_alloc_cos *cfg,
+                        const pid_t *task_array,
+                        const unsigned task_num,
+                        unsigned *class_id);
+
+/**
+ * @brief Saves complete allocation state
+ *
+ * Snapshot holds L3 CAT and L2 CAT masks (including CDP), MBA settings,
+ * core associations and, with OS interface, task associations of all
+ * classes of service other than COS0. The snapshot is a compact binary
+ * blob to be stored by the application and passed to
+ * \a pqos_state_restore on the same platform.
+ *
+ * @param [out] buf allocated snapshot buffer, to be released with free()
+ * @param [out] size size of the snapshot in bytes
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_state_save(void **buf, size_t *size);
+
+/**
+ * @brief Restores allocation state saved with \a pqos_state_save
+ *
+ * Current state is compared with the snapshot and only settings that
+ * differ are programmed, all in one pass under the API lock. Classes of
+ * service are programmed before cores and tasks are associated with them.
+ * CDP or MBA controller change requires allocation reset. Tasks that no
+ * longer exist are skipped.
+ *
+ * The whole snapshot is validated before anything is programmed. If
+ * programming fails part way through, the state from before the call is
+ * programmed back.
+ *
+ * @param [in] buf snapshot buffer
+ * @param [in] size size of the snapshot in bytes
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if snapshot is invalid or does not match
+ *         the platform
+ */
+int pqos_state_restore(const void *buf, const size_t size);
+
 /**
  * @brief Resets configuration of allocation technologies
  *
@@ -1477,6 +2137,24 @@ int pqos_mon_get_value(const struct pqos_mon_data *const group,
                        uint64_t *value,
                        uint64_t *delta);
 
+/*
+ * @brief Retrieves poll timing of an event of a monitoring group
+ *
+ * @param [in] group monitoring group
+ * @param [in] event event being monitored
+ * @param [out] timestamp CLOCK_MONOTONIC time of the last poll of the
+ *              event [ns], 0 if the event has not been polled yet
+ * @param [out] interval time between the last two polls of the event [ns],
+ *              0 if the event has been polled less than twice
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_get_poll_time(const struct pqos_mon_data *const group,
+                           const enum pqos_mon_event event,
+                           uint64_t *timestamp,
+                           uint64_t *interval);
+
 /*
  * @brief Retrieves a IPC value from a monitoring group.
  *
@@ -1490,6 +2168,40 @@ int pqos_mon_get_value(const struct pqos_mon_data *const group,
  */
 int pqos_mon_get_ipc(const struct pqos_mon_data *const group, double *value);
 
+/**
+ * Arrays to store values of monitoring groups in
+ *
+ * Each array that is not NULL has to hold one entry per group.
+ * Values of events not monitored by a group are set to 0.
+ */
+struct pqos_mon_values {
+        uint64_t *llc;           /**< LLC occupancy [B] */
+        double *mbm_local_rate;  /**< local memory bandwidth [B/s] */
+        double *mbm_total_rate;  /**< total memory bandwidth [B/s] */
+        double *mbm_remote_rate; /**< remote memory bandwidth [B/s] */
+        double *ipc;             /**< instructions per cycle */
+        uint64_t *llc_misses;    /**< LLC misses since previous poll */
+};
+
+/*
+ * @brief Retrieves values of multiple monitoring groups
+ *
+ * Memory bandwidth rates are calculated using time between the last two
+ * polls of the event in each group.
+ *
+ * @note Update event values using \a pqos_mon_poll
+ *
+ * @param [in] groups table of monitoring group pointers
+ * @param [in] num_groups number of monitoring groups in the table
+ * @param [out] values arrays to store values in
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int pqos_mon_get_values(struct pqos_mon_data *const *groups,
+                        const unsigned num_groups,
+                        const struct pqos_mon_values *values);
+
 /**
  * @brief Frees memory previously allocated and returned by the library
  * functions.
@@ -0,0 +1,473 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Shared resource ownership registry
+ *
+ * Registry file holds a header followed by fixed size table of entries.
+ * File is mapped by every library instance, consistency is provided by
+ * the API lock held during every registry operation.
+ */
+
+#include "registry.h"
+
+#include "log.h"
+#include "pqos.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Registry file signature "PQRG"
+ */
+#define REGISTRY_MAGIC 0x47525150
+
+/**
+ * Registry layout version
+ */
+#define REGISTRY_VERSION 4
+
+/**
+ * Number of registry entries
+ */
+#define REGISTRY_ENTRIES 2048
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Registry entry
+ */
+struct registry_entry {
+        uint32_t type;   /**< resource type, REGISTRY_TYPE_NONE if unused */
+        uint32_t domain; /**< resource domain */
+        uint32_t id;     /**< resource id */
+        int32_t pid;     /**< owner process */
+        uint64_t pidns;  /**< owner PID namespace inode, 0 if unknown */
+        uint64_t start;  /**< owner start time, 0 if unknown */
+};
+
+/**
+ * Registry file layout
+ */
+struct registry {
+        uint32_t magic;       /**< REGISTRY_MAGIC */
+        uint32_t version;     /**< REGISTRY_VERSION */
+        uint32_t num_entries; /**< REGISTRY_ENTRIES */
+        uint32_t reserved;
+        struct registry_entry entries[REGISTRY_ENTRIES];
+};
+
+static struct registry *m_reg = NULL;
+
+/**
+ * Calling process as recorded in claimed entries, refreshed after fork
+ */
+static pid_t m_self_pid = 0;
+static uint64_t m_self_pidns = 0;
+static uint64_t m_self_start = 0;
+
+/**
+ * @brief Retrieves PID namespace and start time of process \a pid
+ *
+ * PID namespace is identified by inode of /proc/<pid>/ns/pid, start time
+ * is read from /proc/<pid>/stat in clock ticks since boot.
+ *
+ * @param [in] pid process id, 0 for the calling process
+ * @param [out] pidns PID namespace inode, 0 if not available
+ * @param [out] start process start time, 0 if not available
+ */
+#ifdef __linux__
+static void
+registry_proc_info(const pid_t pid, uint64_t *pidns, uint64_t *start)
+{
+        char path[64];
+        char buf[1024];
+        struct stat st;
+        const char *p;
+        unsigned long long val;
+        size_t len;
+        FILE *fd;
+        int i;
+
+        *pidns = 0;
+        *start = 0;
+
+        if (pid == 0)
+                snprintf(path, sizeof(path), "/proc/self/ns/pid");
+        else
+                snprintf(path, sizeof(path), "/proc/%d/ns/pid", (int)pid);
+        if (stat(path, &st) == 0)
+                *pidns = (uint64_t)st.st_ino;
+
+        if (pid == 0)
+                snprintf(path, sizeof(path), "/proc/self/stat");
+        else
+                snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+        fd = fopen(path, "r");
+        if (fd == NULL)
+                return;
+        len = fread(buf, 1, sizeof(buf) - 1, fd);
+        fclose(fd);
+        buf[len] = '\0';
+
+        /* process name may contain spaces, fields are counted after it */
+        p = strrchr(buf, ')');
+        if (p == NULL)
+                return;
+        /* start time is 22nd field, 20th after the process name */
+        for (i = 0; i < 19 && p != NULL; i++)
+                p = strchr(p + 1, ' ');
+        if (p != NULL && sscanf(p, " %llu", &val) == 1)
+                *start = (uint64_t)val;
+}
+#else
+static void
+registry_proc_info(const pid_t pid, uint64_t *pidns, uint64_t *start)
+{
+        UNUSED_PARAM(pid);
+
+        *pidns = 0;
+        *start = 0;
+}
+#endif
+
+/**
+ * @brief Retrieves PID namespace and start time of the calling process
+ *
+ * Values are read once per process.
+ */
+static void
+registry_self_info(void)
+{
+        const pid_t pid = getpid();
+
+        if (m_self_pid == pid)
+                return;
+
+        registry_proc_info(0, &m_self_pidns, &m_self_start);
+        m_self_pid = pid;
+}
+
+/**
+ * @brief Checks if entry owner is gone
+ *
+ * Owner is considered alive unless it is known to have exited. PIDs are
+ * not meaningful across PID namespaces, entries registered from another
+ * namespace are never reclaimed. PID reuse is detected by comparing
+ * process start time.
+ *
+ * @param [in] entry registry entry
+ * @param [in] pidns PID namespace of calling process
+ *
+ * @return 1 if entry can be reclaimed, 0 otherwise
+ */
+static int
+registry_stale(const struct registry_entry *entry, const uint64_t pidns)
+{
+        uint64_t owner_pidns, owner_start;
+
+        if (entry->pidns != pidns)
+                return 0;
+
+        if (entry->pid == (int32_t)m_self_pid)
+                return 0;
+
+        if (kill((pid_t)entry->pid, 0) != 0)
+                return errno == ESRCH;
+
+        if (entry->start == 0)
+                return 0;
+
+        registry_proc_info((pid_t)entry->pid, &owner_pidns, &owner_start);
+
+        /* PID reused by another process */
+        return owner_start != 0 && owner_start != entry->start;
+}
+
+/**
+ * @brief Retrieves entry of \a lease owned by this process
+ *
+ * @param [in] lease lease handle
+ *
+ * @return registry entry or NULL
+ */
+static struct registry_entry *
+registry_lease_entry(const unsigned lease)
+{
+        struct registry_entry *entry;
+
+        if (m_reg == NULL || lease == 0 || lease > REGISTRY_ENTRIES)
+                return NULL;
+
+        entry = &m_reg->entries[lease - 1];
+        if (entry->type == REGISTRY_TYPE_NONE ||
+            entry->pid != (int32_t)getpid())
+                return NULL;
+
+        return entry;
+}
+
+/**
+ * @brief Opens registry file created by another library instance
+ *
+ * File is accepted only if it is a regular file owned by the effective
+ * user, not writable by group or others and of the registry size.
+ *
+ * @return file descriptor or -1 on error
+ */
+static int
+registry_open_existing(void)
+{
+        struct stat st;
+        int fd;
+
+        fd = open(REGISTRY_FILE, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+                LOG_DEBUG("Unable to open registry %s\n", REGISTRY_FILE);
+                return -1;
+        }
+
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+            st.st_uid != geteuid() ||
+            (st.st_mode & (S_IWGRP | S_IWOTH)) != 0 ||
+            (size_t)st.st_size != sizeof(*m_reg)) {
+                LOG_WARN("Ignoring registry %s, unexpected file type, owner, "
+                         "permissions or size\n",
+                         REGISTRY_FILE);
+                close(fd);
+                return -1;
+        }
+
+        return fd;
+}
+
+int
+registry_init(void)
+{
+        const size_t size = sizeof(*m_reg);
+        struct registry *reg;
+        int created = 0;
+        void *addr;
+        int fd;
+
+        if (m_reg != NULL)
+                return PQOS_RETVAL_OK;
+
+        fd = open(REGISTRY_FILE,
+                  O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR);
+        if (fd >= 0) {
+                created = 1;
+                if (ftruncate(fd, size) != 0) {
+                        LOG_DEBUG("Unable to resize registry %s\n",
+                                  REGISTRY_FILE);
+                        close(fd);
+                        (void)unlink(REGISTRY_FILE);
+                        return PQOS_RETVAL_RESOURCE;
+                }
+        } else if (errno == EEXIST)
+                fd = registry_open_existing();
+        if (fd < 0)
+                return PQOS_RETVAL_RESOURCE;
+
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+                LOG_DEBUG("Unable to map registry %s\n", REGISTRY_FILE);
+                if (created)
+                        (void)unlink(REGISTRY_FILE);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        reg = (struct registry *)addr;
+        if (created) {
+                LOG_INFO("Initializing registry %s\n", REGISTRY_FILE);
+                reg->magic = REGISTRY_MAGIC;
+                reg->version = REGISTRY_VERSION;
+                reg->num_entries = REGISTRY_ENTRIES;
+        } else if (reg->magic != REGISTRY_MAGIC ||
+                   reg->version != REGISTRY_VERSION ||
+                   reg->num_entries != REGISTRY_ENTRIES) {
+                LOG_WARN("Ignoring registry %s, unsupported layout\n",
+                         REGISTRY_FILE);
+                (void)munmap(addr, size);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        m_reg = reg;
+        return PQOS_RETVAL_OK;
+}
+
+void
+registry_fini(void)
+{
+        if (m_reg == NULL)
+                return;
+
+        (void)munmap(m_reg, sizeof(*m_reg));
+        m_reg = NULL;
+}
+
+int
+registry_is_active(void)
+{
+        return m_reg != NULL;
+}
+
+int
+registry_claim(const enum registry_type type,
+               const unsigned domain,
+               const unsigned min_id,
+               const unsigned max_id,
+               uint8_t *used,
+               unsigned *id,
+               unsigned *lease)
+{
+        unsigned i, free_idx = REGISTRY_ENTRIES;
+
+        if (m_reg == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        if (used == NULL || id == NULL || lease == NULL || min_id > max_id)
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < REGISTRY_ENTRIES; i++) {
+                const struct registry_entry *entry = &m_reg->entries[i];
+
+                if (entry->type == REGISTRY_TYPE_NONE) {
+                        if (free_idx == REGISTRY_ENTRIES)
+                                free_idx = i;
+                        continue;
+                }
+
+                if (entry->type == (uint32_t)type && entry->domain == domain &&
+                    entry->id >= min_id && entry->id <= max_id)
+                        used[entry->id - min_id] = 1;
+        }
+
+        for (i = 0; i <= max_id - min_id; i++) {
+                struct registry_entry *entry;
+
+                if (used[i])
+                        continue;
+
+                if (free_idx == REGISTRY_ENTRIES) {
+                        LOG_ERROR("Registry %s is full\n", REGISTRY_FILE);
+                        return PQOS_RETVAL_RESOURCE;
+                }
+
+                registry_self_info();
+
+                entry = &m_reg->entries[free_idx];
+                entry->type = (uint32_t)type;
+                entry->domain = domain;
+                entry->id = min_id + i;
+                entry->pid = (int32_t)m_self_pid;
+                entry->pidns = m_self_pidns;
+                entry->start = m_self_start;
+
+                used[i] = 1;
+                *id = min_id + i;
+                *lease = free_idx + 1;
+                return PQOS_RETVAL_OK;
+        }
+
+        return PQOS_RETVAL_ERROR;
+}
+
+unsigned
+registry_reclaim(const enum registry_type type,
+                 const unsigned domain,
+                 const unsigned min_id,
+                 const unsigned max_id,
+                 uint8_t *reclaimed)
+{
+        unsigned i, num = 0;
+
+        if (m_reg == NULL || reclaimed == NULL || min_id > max_id)
+                return 0;
+
+        registry_self_info();
+
+        for (i = 0; i < REGISTRY_ENTRIES; i++) {
+                struct registry_entry *entry = &m_reg->entries[i];
+
+                if (entry->type != (uint32_t)type || entry->domain != domain ||
+                    entry->id < min_id || entry->id > max_id)
+                        continue;
+
+                if (!registry_stale(entry, m_self_pidns))
+                        continue;
+
+                LOG_INFO("Reclaiming resource %u:%u:%u of exited process %d\n",
+                         entry->type, entry->domain, entry->id, entry->pid);
+                reclaimed[entry->id - min_id] = 1;
+                memset(entry, 0, sizeof(*entry));
+                num++;
+        }
+
+        return num;
+}
+
+void
+registry_release(const unsigned lease)
+{
+        struct registry_entry *entry = registry_lease_entry(lease);
+
+        if (entry != NULL)
+                memset(entry, 0, sizeof(*entry));
+}
+
+void
+registry_release_all(const enum registry_type type)
+{
+        unsigned i;
+
+        if (m_reg == NULL)
+                return;
+
+        for (i = 0; i < REGISTRY_ENTRIES; i++)
+                if (m_reg->entries[i].type == (uint32_t)type)
+                        memset(&m_reg->entries[i], 0,
+                               sizeof(m_reg->entries[i]));
+}
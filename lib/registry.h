@@ -0,0 +1,170 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file for shared resource ownership registry
+ *
+ * Registry is a table kept in shared memory and used by all library
+ * instances of the same user in MSR mode. Each entry records resource
+ * (e.g. RMID of L3 cluster) and owner process with its PID namespace and
+ * start time. Resources of processes known to have exited are reclaimed
+ * on request, entries of processes from other PID namespaces are never
+ * reclaimed. The caller is responsible for returning reclaimed resources
+ * to the hardware default state.
+ *
+ * Registry only supplements hardware state, it does not know about
+ * resources used by processes running without it.
+ *
+ * Registry must be accessed with API lock acquired.
+ */
+
+#ifndef __PQOS_REGISTRY_H__
+#define __PQOS_REGISTRY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+#include <stdint.h>
+
+#ifndef REGISTRY_FILE
+#ifdef __linux__
+#define REGISTRY_FILE "/dev/shm/libpqos.registry"
+#endif
+#ifdef __FreeBSD__
+#define REGISTRY_FILE "/var/tmp/libpqos.registry"
+#endif
+#endif /*!REGISTRY_FILE*/
+
+/**
+ * Registered resource types
+ */
+enum registry_type {
+        REGISTRY_TYPE_NONE = 0, /**< unused entry */
+        REGISTRY_TYPE_RMID,     /**< RMID of L3 cluster */
+};
+
+/**
+ * @brief Maps shared registry, creates it if needed
+ *
+ * Existing registry is used only if it is a regular file owned by the
+ * effective user, not writable by others and of the expected layout.
+ * Registry file is never truncated or reinitialized once created.
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if registry is not available
+ */
+PQOS_LOCAL int registry_init(void);
+
+/**
+ * @brief Unmaps shared registry
+ *
+ * Entries owned by the process are left to be released or reclaimed once
+ * the process exits.
+ */
+PQOS_LOCAL void registry_fini(void);
+
+/**
+ * @brief Checks if registry is mapped
+ *
+ * @return 1 if registry is available, 0 otherwise
+ */
+PQOS_LOCAL int registry_is_active(void);
+
+/**
+ * @brief Claims lowest free resource id in range \a min_id - \a max_id
+ *
+ * Resources of exited owners are not reclaimed, see \a registry_reclaim.
+ *
+ * @param [in] type resource type
+ * @param [in] domain resource domain
+ * @param [in] min_id lowest acceptable id
+ * @param [in] max_id highest acceptable id
+ * @param [in,out] used ids in use, used[n] refers to id \a min_id + n.
+ *                 On return ids registered in the range and claimed id
+ *                 are marked as well.
+ * @param [out] id claimed resource id
+ * @param [out] lease lease handle, never 0
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if all ids in range are in use
+ * @retval PQOS_RETVAL_RESOURCE if registry is not available or full
+ */
+PQOS_LOCAL int registry_claim(const enum registry_type type,
+                              const unsigned domain,
+                              const unsigned min_id,
+                              const unsigned max_id,
+                              uint8_t *used,
+                              unsigned *id,
+                              unsigned *lease);
+
+/**
+ * @brief Reclaims resources of exited owners in range \a min_id - \a max_id
+ *
+ * @param [in] type resource type
+ * @param [in] domain resource domain
+ * @param [in] min_id lowest id
+ * @param [in] max_id highest id
+ * @param [out] reclaimed reclaimed[n] is set if id \a min_id + n was
+ *              reclaimed
+ *
+ * @return Number of reclaimed resources
+ */
+PQOS_LOCAL unsigned registry_reclaim(const enum registry_type type,
+                                     const unsigned domain,
+                                     const unsigned min_id,
+                                     const unsigned max_id,
+                                     uint8_t *reclaimed);
+
+/**
+ * @brief Releases resource
+ *
+ * @param [in] lease lease handle returned by \a registry_claim
+ */
+PQOS_LOCAL void registry_release(const unsigned lease);
+
+/**
+ * @brief Releases all resources of \a type regardless of the owner
+ *
+ * @param [in] type resource type
+ */
+PQOS_LOCAL void registry_release_all(const enum registry_type type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_REGISTRY_H__ */
@@ -39,9 +39,11 @@
 #include "monitoring.h"
 #include "resctrl.h"
 #include "resctrl_alloc.h"
+#include "topology.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -58,6 +60,11 @@ static int supported_events = 0;
 
 static unsigned resctrl_mon_counter = 0;
 
+/**
+ * Start time of this process, part of names of groups created by it
+ */
+static uint64_t resctrl_mon_starttime = 0;
+
 /**
  * @brief Filter directory filenames
  *
@@ -95,6 +102,112 @@ free_scandir(struct dirent **namelist, int count)
         free(namelist);
 }
 
+/**
+ * @brief Retrieves start time of the process
+ *
+ * @param [in] pid process id
+ * @param [out] starttime start time in clock ticks since boot
+ *
+ * @return Operational status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if process does not exist
+ */
+PQOS_STATIC int
+resctrl_mon_proc_starttime(const pid_t pid, uint64_t *starttime)
+{
+        char path[64];
+        char buf[1024];
+        const char *stat;
+        FILE *fd;
+
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+        fd = pqos_fopen(path, "r");
+        if (fd == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        stat = fgets(buf, sizeof(buf), fd);
+        pqos_fclose(fd);
+        if (stat == NULL)
+                return PQOS_RETVAL_ERROR;
+
+        /* skip comm, it can contain spaces; starttime is field 22 */
+        stat = strrchr(buf, ')');
+        if (stat == NULL ||
+            sscanf(stat + 1,
+                   " %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s"
+                   " %*s %*s %*s %*s %*s %*s %*s %*s %*s %" SCNu64,
+                   starttime) != 1)
+                return PQOS_RETVAL_ERROR;
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Retrieves start time of this process
+ *
+ * @return start time, 0 if not known
+ */
+static uint64_t
+resctrl_mon_self_starttime(void)
+{
+        if (resctrl_mon_starttime == 0 &&
+            resctrl_mon_proc_starttime(getpid(), &resctrl_mon_starttime) !=
+                PQOS_RETVAL_OK) {
+                LOG_WARN("Failed to obtain process start time\n");
+                resctrl_mon_starttime = 0;
+        }
+
+        return resctrl_mon_starttime;
+}
+
+/**
+ * @brief Determines owner of monitoring group
+ *
+ * Groups created by the library are named
+ * GROUP_NAME_PREFIX<pid>-<start time>-<counter>. Groups named with older
+ * GROUP_NAME_PREFIX<pid>-<counter> scheme are identified by pid only.
+ *
+ * @param [in] name mon group name
+ *
+ * @return Owner of the group
+ */
+PQOS_STATIC enum resctrl_mon_owner
+resctrl_mon_group_owner(const char *name)
+{
+        const size_t prefix_len = strlen(GROUP_NAME_PREFIX);
+        uint64_t starttime = 0;
+        uint64_t owner_starttime;
+        unsigned counter;
+        int pid;
+        int num;
+        int ret;
+
+        if (strncmp(name, GROUP_NAME_PREFIX, prefix_len) != 0)
+                return RESCTRL_MON_OWNER_NONE;
+
+        num = sscanf(name + prefix_len, "%d-%" SCNu64 "-%u", &pid, &starttime,
+                     &counter);
+        if (num < 2 || pid <= 0)
+                return RESCTRL_MON_OWNER_NONE;
+        /* start time not known */
+        if (num == 2)
+                starttime = 0;
+
+        if (pid == (int)getpid() &&
+            (starttime == 0 || starttime == resctrl_mon_self_starttime()))
+                return RESCTRL_MON_OWNER_SELF;
+
+        ret = resctrl_mon_proc_starttime((pid_t)pid, &owner_starttime);
+        if (ret == PQOS_RETVAL_RESOURCE)
+                return RESCTRL_MON_OWNER_DEAD;
+        /* pid reused by other process */
+        if (ret == PQOS_RETVAL_OK && starttime != 0 &&
+            starttime != owner_starttime)
+                return RESCTRL_MON_OWNER_DEAD;
+
+        return RESCTRL_MON_OWNER_OTHER;
+}
+
 int
 resctrl_mon_init(const struct pqos_cpuinfo *cpu, const struct pqos_cap *cap)
 {
@@ -419,10 +532,9 @@ resctrl_mon_read_counters(const unsigned class_id,
                           uint64_t *value)
 {
         int ret = PQOS_RETVAL_OK;
-        unsigned *l3cat_ids = NULL;
+        const unsigned *l3cat_ids = NULL;
         unsigned l3cat_id_num;
         unsigned l3cat_id;
-        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
 
         ASSERT(resctrl_group != NULL);
         ASSERT(value != NULL);
@@ -430,11 +542,10 @@ resctrl_mon_read_counters(const unsigned class_id,
         *value = 0;
 
         if (l3ids == NULL) {
-                l3cat_ids = pqos_cpu_get_l3cat_ids(cpu, &l3cat_id_num);
-                if (l3cat_ids == NULL) {
-                        ret = PQOS_RETVAL_ERROR;
-                        goto resctrl_mon_read_exit;
-                }
+                ret = topo_obj_ids(_pqos_get_cpu(), TOPO_OBJ_L3CAT,
+                                   &l3cat_ids, &l3cat_id_num);
+                if (ret != PQOS_RETVAL_OK)
+                        return PQOS_RETVAL_ERROR;
         } else {
                 l3cat_ids = l3ids;
                 l3cat_id_num = l3ids_num;
@@ -447,15 +558,11 @@ resctrl_mon_read_counters(const unsigned class_id,
                 ret = resctrl_mon_read_counter(class_id, resctrl_group, l3id,
                                                event, &counter);
                 if (ret != PQOS_RETVAL_OK)
-                        goto resctrl_mon_read_exit;
+                        break;
 
                 *value += counter;
         }
 
-resctrl_mon_read_exit:
-        if (l3ids == NULL && l3cat_ids != NULL)
-                free(l3cat_ids);
-
         return ret;
 }
 
@@ -743,18 +850,27 @@ resctrl_mon_assoc_restore(const unsigned lcore, const char *name)
         int ret;
         char buf[128];
         unsigned class_id;
+        struct resctrl_cpumask mask;
 
         ASSERT(name != NULL);
 
+        ret = alloc_assoc_get(lcore, &class_id);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        /*
+         * Fast path - core still associated with requested mon group.
+         * Avoids scanning all mon groups of the COS on every poll.
+         */
+        ret = resctrl_mon_cpumask_read(class_id, name, &mask);
+        if (ret == PQOS_RETVAL_OK && resctrl_cpumask_get(lcore, &mask))
+                return PQOS_RETVAL_OK;
+
         ret = resctrl_mon_assoc_get(lcore, buf, sizeof(buf));
         /* core already associated with mon group */
         if (ret == PQOS_RETVAL_OK)
                 return PQOS_RETVAL_OK;
 
-        ret = alloc_assoc_get(lcore, &class_id);
-        if (ret != PQOS_RETVAL_OK)
-                return ret;
-
         resctrl_mon_group_path(class_id, name, NULL, buf, sizeof(buf));
         if (!pqos_dir_exists(buf)) {
                 LOG_WARN("Could not restore core association with mon "
@@ -886,7 +1002,7 @@ resctrl_mon_assoc_set_pid(const pid_t task, const char *name)
 
 #define RESCTRL_CORE_MAX_L3ID 63
 struct resctrl_core_group {
-        char name[32];
+        char name[64];
         int valid;
         uint64_t llc;
         uint64_t l3ids;
@@ -953,8 +1069,12 @@ resctrl_mon_parse(struct resctrl_core_group **cgrp, unsigned *cgrp_num)
                         unsigned j;
                         int retval;
 
-                        /* group not managed by pqos library */
-                        if (strncmp(grp_name, GROUP_NAME_PREFIX, 5) != 0)
+                        /*
+                         * group not created by this process, it can be
+                         * removed when its owner exits
+                         */
+                        if (resctrl_mon_group_owner(grp_name) !=
+                            RESCTRL_MON_OWNER_SELF)
                                 continue;
 
                         /* Check if group already exists */
@@ -1037,9 +1157,10 @@ resctrl_mon_parse_exit:
 PQOS_STATIC char *
 resctrl_mon_new_group(void)
 {
-        char buf[32];
+        char buf[64];
 
-        snprintf(buf, sizeof(buf), GROUP_NAME_PREFIX "%d-%u", (int)getpid(),
+        snprintf(buf, sizeof(buf), GROUP_NAME_PREFIX "%d-%" PRIu64 "-%u",
+                 (int)getpid(), resctrl_mon_self_starttime(),
                  resctrl_mon_counter++);
 
         return strdup(buf);
@@ -1691,6 +1812,60 @@ resctrl_mon_reset(void)
         return ret;
 }
 
+int
+resctrl_mon_reclaim(unsigned *num_groups)
+{
+        int ret;
+        unsigned grps;
+        unsigned cos = 0;
+        unsigned removed = 0;
+        const struct pqos_cap *cap = _pqos_get_cap();
+
+        if (!resctrl_mon_is_supported())
+                return PQOS_RETVAL_RESOURCE;
+
+        ret = resctrl_alloc_get_grps_num(cap, &grps);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        do {
+                struct dirent **namelist = NULL;
+                int num;
+                char dir[256];
+                int i;
+
+                resctrl_mon_group_path(cos, "", NULL, dir, sizeof(dir));
+                num = scandir(dir, &namelist, filter, NULL);
+                if (num < 0) {
+                        LOG_ERROR("Failed to read monitoring groups for "
+                                  "COS %u\n",
+                                  cos);
+                        return PQOS_RETVAL_ERROR;
+                }
+
+                for (i = 0; i < num && ret == PQOS_RETVAL_OK; i++) {
+                        const char *name = namelist[i]->d_name;
+
+                        if (resctrl_mon_group_owner(name) !=
+                            RESCTRL_MON_OWNER_DEAD)
+                                continue;
+
+                        LOG_INFO("Removing stale monitoring group %s\n",
+                                 name);
+                        ret = resctrl_mon_rmdir(cos, name);
+                        if (ret == PQOS_RETVAL_OK)
+                                removed++;
+                }
+
+                free_scandir(namelist, num);
+        } while (ret == PQOS_RETVAL_OK && ++cos < grps);
+
+        if (num_groups != NULL)
+                *num_groups = removed;
+
+        return ret;
+}
+
 int
 resctrl_mon_is_supported(void)
 {
@@ -46,6 +46,16 @@ extern "C" {
 #include "resctrl.h"
 #include "types.h"
 
+/**
+ * Owner of resctrl monitoring group
+ */
+enum resctrl_mon_owner {
+        RESCTRL_MON_OWNER_NONE = 0, /**< group not created by the library */
+        RESCTRL_MON_OWNER_SELF,     /**< group created by this process */
+        RESCTRL_MON_OWNER_OTHER,    /**< group of other running process */
+        RESCTRL_MON_OWNER_DEAD      /**< owner process no longer exists */
+};
+
 /**
  * @brief Initializes resctrl structures used for OS monitoring interface
  *
@@ -110,6 +120,20 @@ PQOS_LOCAL int resctrl_mon_poll(struct pqos_mon_data *group,
  */
 PQOS_LOCAL int resctrl_mon_reset(void);
 
+/**
+ * @brief Removes monitoring groups of processes that no longer exist
+ *
+ * Frees RMIDs leaked by library users that exited without stopping
+ * monitoring. Groups of running processes are not affected.
+ *
+ * @param [out] num_groups number of removed groups, can be NULL
+ *
+ * @return Operations status
+ * @return PQOS_RETVAL_RESOURCE when resctrl monitoring is not supported
+ * @retval PQOS_RETVAL_OK on success
+ */
+PQOS_LOCAL int resctrl_mon_reclaim(unsigned *num_groups);
+
 /**
  * @brief Check if resctrl monitoring is supported
  *
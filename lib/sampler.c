@@ -0,0 +1,462 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Asynchronous monitoring sampler
+ *
+ * Sampler thread polls registered monitoring groups at a fixed interval
+ * and publishes timestamped values in a single producer, multiple
+ * consumer ring. Ring slots are protected with sequence locks so readers
+ * never block the sampler nor wait for hardware access.
+ */
+
+#include "cap.h"
+#include "lock.h"
+#include "log.h"
+#include "monitoring.h"
+#include "pqos.h"
+#include "seqlock.h"
+#include "types.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Ring slot
+ */
+struct sampler_slot {
+        uint32_t lock;                    /**< slot sequence lock */
+        uint64_t seq;                     /**< sample sequence number */
+        uint64_t timestamp;               /**< sample time [ns] */
+        int status;                       /**< poll status */
+        struct pqos_event_values *values; /**< values of all groups */
+};
+
+/**
+ * Sampler reader
+ */
+struct pqos_sampler_reader {
+        struct pqos_sampler *sampler;     /**< sampler being read */
+        uint64_t cursor;                  /**< next sample to read */
+        int event_fd;                     /**< notification descriptor */
+        struct pqos_sampler_reader *next; /**< next reader on the list */
+};
+
+/**
+ * Sampler
+ */
+struct pqos_sampler {
+        struct pqos_mon_data **groups;       /**< sampled groups */
+        unsigned num_groups;                 /**< number of sampled groups */
+        unsigned depth;                      /**< number of ring slots */
+        struct sampler_slot *slots;          /**< ring slots */
+        struct pqos_event_values *values;    /**< values storage for slots */
+        uint64_t head;                       /**< number of published samples */
+        int timer_fd;                        /**< sampling timer */
+        int stop_fd;                         /**< sampler thread stop request */
+        pthread_t thread;                    /**< sampler thread */
+        pthread_mutex_t lock;                /**< protects readers list */
+        struct pqos_sampler_reader *readers; /**< list of readers */
+};
+
+/**
+ * ---------------------------------------
+ * Local functions
+ * ---------------------------------------
+ */
+
+/**
+ * @brief Takes one sample and publishes it to the readers
+ *
+ * @param [in] sampler sampler handle
+ */
+static void
+sampler_sample(struct pqos_sampler *sampler)
+{
+        struct sampler_slot *slot;
+        struct pqos_sampler_reader *reader;
+        struct timespec ts;
+        uint64_t seq;
+        unsigned i;
+        int ret;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ret = pqos_mon_poll(sampler->groups, sampler->num_groups);
+
+        seq = __atomic_load_n(&sampler->head, __ATOMIC_RELAXED);
+        slot = &sampler->slots[seq % sampler->depth];
+
+        seqlock_write_begin(&slot->lock);
+        slot->seq = seq;
+        slot->timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        slot->status = ret;
+        for (i = 0; i < sampler->num_groups; i++)
+                slot->values[i] = sampler->groups[i]->values;
+        seqlock_write_end(&slot->lock);
+
+        __atomic_store_n(&sampler->head, seq + 1, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&sampler->lock);
+        for (reader = sampler->readers; reader != NULL; reader = reader->next) {
+                const uint64_t event = 1;
+
+                if (write(reader->event_fd, &event, sizeof(event)) < 0)
+                        LOG_DEBUG("Sampler notification failed\n");
+        }
+        pthread_mutex_unlock(&sampler->lock);
+}
+
+/**
+ * @brief Sampler thread
+ *
+ * @param [in] arg sampler handle
+ *
+ * @return NULL
+ */
+static void *
+sampler_thread(void *arg)
+{
+        struct pqos_sampler *sampler = (struct pqos_sampler *)arg;
+        struct pollfd fds[2];
+
+        fds[0].fd = sampler->timer_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = sampler->stop_fd;
+        fds[1].events = POLLIN;
+
+        for (;;) {
+                uint64_t expirations;
+
+                if (poll(fds, DIM(fds), -1) < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        LOG_ERROR("Sampler wait failed\n");
+                        break;
+                }
+
+                if (fds[1].revents & POLLIN)
+                        break;
+
+                if (!(fds[0].revents & POLLIN))
+                        continue;
+
+                if (read(sampler->timer_fd, &expirations,
+                         sizeof(expirations)) < 0)
+                        continue;
+
+                sampler_sample(sampler);
+        }
+
+        return NULL;
+}
+
+/**
+ * @brief Releases sampler resources
+ *
+ * @param [in] sampler sampler handle
+ */
+static void
+sampler_free(struct pqos_sampler *sampler)
+{
+        if (sampler->timer_fd >= 0)
+                close(sampler->timer_fd);
+        if (sampler->stop_fd >= 0)
+                close(sampler->stop_fd);
+        pthread_mutex_destroy(&sampler->lock);
+        free(sampler->groups);
+        free(sampler->slots);
+        free(sampler->values);
+        free(sampler);
+}
+
+/*
+ * =======================================
+ * =======================================
+ *
+ * Sampler API
+ *
+ * =======================================
+ * =======================================
+ */
+
+int
+pqos_sampler_start(const struct pqos_sampler_config *config,
+                   struct pqos_mon_data **groups,
+                   const unsigned num_groups,
+                   struct pqos_sampler **sampler)
+{
+        struct pqos_sampler *s;
+        struct itimerspec its;
+        sigset_t mask, old_mask;
+        unsigned i;
+        int ret;
+
+        if (config == NULL || groups == NULL || num_groups == 0 ||
+            sampler == NULL || config->interval_us == 0)
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < num_groups; i++)
+                if (groups[i] == NULL ||
+                    groups[i]->valid != GROUP_VALID_MARKER)
+                        return PQOS_RETVAL_PARAM;
+
+        lock_get();
+        ret = _pqos_check_init(1);
+        lock_release();
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        s = (struct pqos_sampler *)calloc(1, sizeof(*s));
+        if (s == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        s->timer_fd = -1;
+        s->stop_fd = -1;
+        s->num_groups = num_groups;
+        s->depth = config->depth;
+        if (s->depth == 0)
+                s->depth = PQOS_SAMPLER_DEPTH_DEFAULT;
+        if (pthread_mutex_init(&s->lock, NULL) != 0) {
+                free(s);
+                return PQOS_RETVAL_ERROR;
+        }
+
+        s->groups = (struct pqos_mon_data **)malloc(num_groups *
+                                                    sizeof(s->groups[0]));
+        s->slots = (struct sampler_slot *)calloc(s->depth, sizeof(s->slots[0]));
+        s->values = (struct pqos_event_values *)calloc(
+            (size_t)s->depth * num_groups, sizeof(s->values[0]));
+        if (s->groups == NULL || s->slots == NULL || s->values == NULL) {
+                ret = PQOS_RETVAL_RESOURCE;
+                goto sampler_start_error;
+        }
+
+        memcpy(s->groups, groups, num_groups * sizeof(s->groups[0]));
+        for (i = 0; i < s->depth; i++)
+                s->slots[i].values = &s->values[i * num_groups];
+
+        s->stop_fd = eventfd(0, EFD_CLOEXEC);
+        s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (s->stop_fd < 0 || s->timer_fd < 0) {
+                LOG_ERROR("Failed to create sampler descriptors\n");
+                ret = PQOS_RETVAL_ERROR;
+                goto sampler_start_error;
+        }
+
+        its.it_interval.tv_sec = config->interval_us / 1000000;
+        its.it_interval.tv_nsec = (config->interval_us % 1000000) * 1000;
+        its.it_value = its.it_interval;
+        if (timerfd_settime(s->timer_fd, 0, &its, NULL) != 0) {
+                LOG_ERROR("Failed to arm sampler timer\n");
+                ret = PQOS_RETVAL_ERROR;
+                goto sampler_start_error;
+        }
+
+        /* signals are handled by the application threads */
+        sigfillset(&mask);
+        pthread_sigmask(SIG_SETMASK, &mask, &old_mask);
+        ret = pthread_create(&s->thread, NULL, sampler_thread, s);
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+        if (ret != 0) {
+                LOG_ERROR("Failed to start sampler thread\n");
+                ret = PQOS_RETVAL_ERROR;
+                goto sampler_start_error;
+        }
+
+        *sampler = s;
+        return PQOS_RETVAL_OK;
+
+sampler_start_error:
+        sampler_free(s);
+        return ret;
+}
+
+int
+pqos_sampler_stop(struct pqos_sampler *sampler)
+{
+        const uint64_t event = 1;
+        int busy;
+
+        if (sampler == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        pthread_mutex_lock(&sampler->lock);
+        busy = sampler->readers != NULL;
+        pthread_mutex_unlock(&sampler->lock);
+        if (busy) {
+                LOG_ERROR("Sampler has open readers\n");
+                return PQOS_RETVAL_BUSY;
+        }
+
+        if (write(sampler->stop_fd, &event, sizeof(event)) < 0) {
+                LOG_ERROR("Failed to stop sampler thread\n");
+                return PQOS_RETVAL_ERROR;
+        }
+
+        pthread_join(sampler->thread, NULL);
+        sampler_free(sampler);
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_sampler_reader_open(struct pqos_sampler *sampler,
+                         struct pqos_sampler_reader **reader)
+{
+        struct pqos_sampler_reader *r;
+
+        if (sampler == NULL || reader == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        r = (struct pqos_sampler_reader *)calloc(1, sizeof(*r));
+        if (r == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        r->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (r->event_fd < 0) {
+                free(r);
+                return PQOS_RETVAL_ERROR;
+        }
+        r->sampler = sampler;
+
+        pthread_mutex_lock(&sampler->lock);
+        r->cursor = __atomic_load_n(&sampler->head, __ATOMIC_ACQUIRE);
+        r->next = sampler->readers;
+        sampler->readers = r;
+        pthread_mutex_unlock(&sampler->lock);
+
+        *reader = r;
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_sampler_reader_close(struct pqos_sampler_reader *reader)
+{
+        struct pqos_sampler *sampler;
+        struct pqos_sampler_reader **r;
+
+        if (reader == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        sampler = reader->sampler;
+
+        pthread_mutex_lock(&sampler->lock);
+        for (r = &sampler->readers; *r != NULL; r = &(*r)->next)
+                if (*r == reader) {
+                        *r = reader->next;
+                        break;
+                }
+        pthread_mutex_unlock(&sampler->lock);
+
+        close(reader->event_fd);
+        free(reader);
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_sampler_reader_fd(const struct pqos_sampler_reader *reader)
+{
+        if (reader == NULL)
+                return -1;
+
+        return reader->event_fd;
+}
+
+int
+pqos_sampler_read(struct pqos_sampler_reader *reader,
+                  struct pqos_sample_info *info,
+                  struct pqos_event_values *values,
+                  const unsigned num_values)
+{
+        const struct pqos_sampler *sampler;
+        const struct sampler_slot *slot;
+        uint64_t lost = 0;
+
+        if (reader == NULL || info == NULL || values == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        sampler = reader->sampler;
+        if (num_values < sampler->num_groups)
+                return PQOS_RETVAL_PARAM;
+
+        for (;;) {
+                uint64_t head = __atomic_load_n(&sampler->head,
+                                                __ATOMIC_ACQUIRE);
+                uint32_t start;
+                uint64_t seq;
+
+                if (reader->cursor >= head)
+                        return PQOS_RETVAL_RESOURCE;
+
+                /* slot of the oldest sample may be under update */
+                if (head - reader->cursor >= sampler->depth) {
+                        lost += head - sampler->depth + 1 - reader->cursor;
+                        reader->cursor = head - sampler->depth + 1;
+                }
+
+                slot = &sampler->slots[reader->cursor % sampler->depth];
+
+                start = seqlock_read_begin(&slot->lock);
+                seq = slot->seq;
+                info->timestamp = slot->timestamp;
+                info->status = slot->status;
+                memcpy(values, slot->values,
+                       sampler->num_groups * sizeof(values[0]));
+                if (seqlock_read_retry(&slot->lock, start))
+                        continue;
+
+                /* retry if the sample got overwritten in the meantime */
+                if (seq == reader->cursor)
+                        break;
+        }
+
+        info->seq = reader->cursor;
+        info->lost = lost;
+        reader->cursor++;
+
+        return PQOS_RETVAL_OK;
+}
@@ -0,0 +1,121 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file with sequence lock helpers
+ *
+ * Sequence locks let a single writer publish data to any number of
+ * readers without blocking. The writer makes the sequence odd while the
+ * data is being updated. Readers copy the data and retry if the sequence
+ * was odd or has changed in the meantime.
+ */
+
+#ifndef __PQOS_SEQLOCK_H__
+#define __PQOS_SEQLOCK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Marks start of data update
+ *
+ * @param [in,out] seq sequence lock
+ */
+static inline void
+seqlock_write_begin(uint32_t *seq)
+{
+        uint32_t val = __atomic_load_n(seq, __ATOMIC_RELAXED);
+
+        __atomic_store_n(seq, val + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Marks end of data update
+ *
+ * @param [in,out] seq sequence lock
+ */
+static inline void
+seqlock_write_end(uint32_t *seq)
+{
+        uint32_t val = __atomic_load_n(seq, __ATOMIC_RELAXED);
+
+        __atomic_store_n(seq, val + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Marks start of data read
+ *
+ * Waits for the writer to complete the update in progress.
+ *
+ * @param [in] seq sequence lock
+ *
+ * @return sequence value to be passed to seqlock_read_retry()
+ */
+static inline uint32_t
+seqlock_read_begin(const uint32_t *seq)
+{
+        uint32_t val;
+
+        do {
+                val = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        } while (val & 1);
+
+        return val;
+}
+
+/**
+ * @brief Checks if data read since seqlock_read_begin() is consistent
+ *
+ * @param [in] seq sequence lock
+ * @param [in] start value returned by seqlock_read_begin()
+ *
+ * @return Read status
+ * @retval 0 data is consistent
+ * @retval 1 data was modified, read has to be repeated
+ */
+static inline int
+seqlock_read_retry(const uint32_t *seq, const uint32_t start)
+{
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        return __atomic_load_n(seq, __ATOMIC_RELAXED) != start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_SEQLOCK_H__ */
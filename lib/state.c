@@ -0,0 +1,1098 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Allocation state snapshot
+ *
+ * Snapshot is a header followed by fixed size records describing classes
+ * of service, core associations and task associations. Snapshot is
+ * validated against the platform before anything is programmed, current
+ * state is saved beforehand and programmed back if restore fails.
+ */
+
+#include "state.h"
+
+#include "allocation.h"
+#include "cap.h"
+#include "cpuinfo.h"
+#include "log.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * State snapshot signature "PQST"
+ */
+#define STATE_MAGIC 0x54535150
+
+/**
+ * State snapshot layout version
+ */
+#define STATE_VERSION 1
+
+/**
+ * Types of state snapshot records
+ */
+enum state_rec_type {
+        STATE_REC_L3CA = 1, /**< L3 CAT class of service */
+        STATE_REC_L2CA,     /**< L2 CAT class of service */
+        STATE_REC_MBA,      /**< MBA class of service */
+        STATE_REC_CORE,     /**< core association */
+        STATE_REC_TASK      /**< task association */
+};
+
+/**
+ * State snapshot header
+ */
+struct state_hdr {
+        uint32_t magic;    /**< STATE_MAGIC */
+        uint32_t version;  /**< STATE_VERSION */
+        uint32_t num_recs; /**< number of records following the header */
+        uint32_t reserved;
+};
+
+/**
+ * State snapshot record
+ */
+struct state_rec {
+        uint32_t type;     /**< record type, enum state_rec_type */
+        uint32_t id;       /**< resource id, core id or task id */
+        uint32_t class_id; /**< class of service */
+        uint32_t flags;    /**< CDP or MBA controller enabled */
+        uint64_t val[2];   /**< ways or data and code mask, MBA rate */
+};
+
+/**
+ * Task association used to compare task states
+ */
+struct state_task {
+        unsigned pid;
+        unsigned class_id;
+};
+
+/**
+ * Buffer of state snapshot records
+ */
+struct state_buf {
+        struct state_hdr *hdr;
+        struct state_rec *recs;
+        unsigned max_recs;
+};
+
+/**
+ * @brief Appends record to the state snapshot buffer
+ *
+ * @param [in,out] st state snapshot buffer
+ * @param [in] rec record to append
+ *
+ * @return Operation status
+ */
+static int
+state_add(struct state_buf *st, const struct state_rec *rec)
+{
+        if (st->hdr == NULL || st->hdr->num_recs == st->max_recs) {
+                const unsigned max_recs = st->max_recs ? 2 * st->max_recs : 64;
+                struct state_hdr *hdr;
+
+                hdr = realloc(st->hdr,
+                              sizeof(*hdr) + max_recs * sizeof(st->recs[0]));
+                if (hdr == NULL)
+                        return PQOS_RETVAL_RESOURCE;
+                if (st->hdr == NULL)
+                        memset(hdr, 0, sizeof(*hdr));
+
+                st->hdr = hdr;
+                st->recs = (struct state_rec *)(hdr + 1);
+                st->max_recs = max_recs;
+        }
+
+        st->recs[st->hdr->num_recs++] = *rec;
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Retrieves ids of all resource entities of \a type
+ *
+ * @param [in] type allocation technology
+ * @param [out] count number of ids
+ *
+ * @return Allocated array of ids, NULL on error
+ */
+static unsigned *
+state_ids(const enum pqos_cap_type type, unsigned *count)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+
+        if (type == PQOS_CAP_TYPE_L3CA)
+                return pqos_cpu_get_l3cat_ids(cpu, count);
+        if (type == PQOS_CAP_TYPE_L2CA)
+                return pqos_cpu_get_l2ids(cpu, count);
+        return pqos_cpu_get_mba_ids(cpu, count);
+}
+
+/**
+ * @brief Saves classes of service of \a type on all resource entities
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in,out] st state snapshot buffer
+ * @param [in] type allocation technology
+ *
+ * @return Operation status
+ */
+static int
+state_save_cos(const struct pqos_api *api,
+               struct state_buf *st,
+               const enum pqos_cap_type type)
+{
+        const struct pqos_capability *alloc_cap = NULL;
+        unsigned *ids;
+        unsigned ids_num = 0;
+        unsigned i, j;
+        int ret;
+
+        ret = pqos_cap_get_type(_pqos_get_cap(), type, &alloc_cap);
+        if (ret != PQOS_RETVAL_OK)
+                return PQOS_RETVAL_OK;
+
+        ids = state_ids(type, &ids_num);
+        if (ids == NULL)
+                return PQOS_RETVAL_ERROR;
+
+        for (i = 0; i < ids_num && ret == PQOS_RETVAL_OK; i++) {
+                struct pqos_l3ca l3ca[PQOS_MAX_L3CA_COS];
+                struct pqos_l2ca l2ca[PQOS_MAX_L2CA_COS];
+                struct pqos_mba mba[PQOS_MAX_COS];
+                unsigned num = 0;
+
+                if (type == PQOS_CAP_TYPE_L3CA)
+                        ret = api->l3ca_get(ids[i], DIM(l3ca), &num, l3ca);
+                else if (type == PQOS_CAP_TYPE_L2CA)
+                        ret = api->l2ca_get(ids[i], DIM(l2ca), &num, l2ca);
+                else
+                        ret = api->mba_get(ids[i], DIM(mba), &num, mba);
+
+                for (j = 0; j < num && ret == PQOS_RETVAL_OK; j++) {
+                        struct state_rec rec;
+
+                        memset(&rec, 0, sizeof(rec));
+                        rec.id = ids[i];
+                        if (type == PQOS_CAP_TYPE_L3CA) {
+                                rec.type = STATE_REC_L3CA;
+                                rec.class_id = l3ca[j].class_id;
+                                rec.flags = l3ca[j].cdp;
+                                rec.val[0] = l3ca[j].u.s.data_mask;
+                                if (l3ca[j].cdp)
+                                        rec.val[1] = l3ca[j].u.s.code_mask;
+                        } else if (type == PQOS_CAP_TYPE_L2CA) {
+                                rec.type = STATE_REC_L2CA;
+                                rec.class_id = l2ca[j].class_id;
+                                rec.flags = l2ca[j].cdp;
+                                rec.val[0] = l2ca[j].u.s.data_mask;
+                                if (l2ca[j].cdp)
+                                        rec.val[1] = l2ca[j].u.s.code_mask;
+                        } else {
+                                rec.type = STATE_REC_MBA;
+                                rec.class_id = mba[j].class_id;
+                                rec.flags = mba[j].ctrl;
+                                rec.val[0] = mba[j].mb_max;
+                        }
+                        ret = state_add(st, &rec);
+                }
+        }
+
+        free(ids);
+
+        return ret;
+}
+
+/**
+ * @brief Retrieves number of classes of service shared by all technologies
+ *
+ * @param [out] cos_num number of classes of service
+ *
+ * @return Operation status
+ */
+static int
+state_cos_num(unsigned *cos_num)
+{
+        const struct pqos_cap *cap = _pqos_get_cap();
+        int (*get_cos_num[])(const struct pqos_cap *, unsigned *) = {
+            pqos_l3ca_get_cos_num, pqos_l2ca_get_cos_num,
+            pqos_mba_get_cos_num};
+        unsigned i;
+
+        *cos_num = 0;
+        for (i = 0; i < DIM(get_cos_num); i++) {
+                unsigned num;
+
+                if (get_cos_num[i](cap, &num) != PQOS_RETVAL_OK)
+                        continue;
+                if (*cos_num == 0 || num < *cos_num)
+                        *cos_num = num;
+        }
+
+        return *cos_num == 0 ? PQOS_RETVAL_RESOURCE : PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Compares task associations by task id
+ */
+static int
+state_task_cmp(const void *a, const void *b)
+{
+        const struct state_task *ta = (const struct state_task *)a;
+        const struct state_task *tb = (const struct state_task *)b;
+
+        return (ta->pid > tb->pid) - (ta->pid < tb->pid);
+}
+
+/**
+ * @brief Retrieves tasks associated with classes of service other than COS0
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [out] tasks allocated array of task associations sorted by task id
+ * @param [out] num number of task associations
+ *
+ * @return Operation status
+ */
+static int
+state_tasks_get(const struct pqos_api *api,
+                struct state_task **tasks,
+                unsigned *num)
+{
+        unsigned cos_num;
+        unsigned class_id;
+        int ret;
+
+        *tasks = NULL;
+        *num = 0;
+
+        ret = state_cos_num(&cos_num);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        for (class_id = 1; class_id < cos_num; class_id++) {
+                struct state_task *t;
+                unsigned *pids;
+                unsigned count = 0;
+                unsigned i;
+
+                pids = api->pid_get_pid_assoc(class_id, &count);
+                if (pids == NULL) {
+                        ret = PQOS_RETVAL_ERROR;
+                        break;
+                }
+
+                t = realloc(*tasks, (*num + count + 1) * sizeof(t[0]));
+                if (t == NULL) {
+                        free(pids);
+                        ret = PQOS_RETVAL_RESOURCE;
+                        break;
+                }
+                *tasks = t;
+
+                for (i = 0; i < count; i++) {
+                        t[*num].pid = pids[i];
+                        t[*num].class_id = class_id;
+                        (*num)++;
+                }
+                free(pids);
+        }
+
+        if (ret != PQOS_RETVAL_OK) {
+                free(*tasks);
+                *tasks = NULL;
+                *num = 0;
+                return ret;
+        }
+
+        if (*num > 0)
+                qsort(*tasks, *num, sizeof((*tasks)[0]), state_task_cmp);
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Saves complete allocation state
+ *
+ * Must be called with API lock acquired.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in,out] st state snapshot buffer
+ *
+ * @return Operation status
+ */
+static int
+state_collect(const struct pqos_api *api, struct state_buf *st)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+        const enum pqos_cap_type types[] = {
+            PQOS_CAP_TYPE_L3CA, PQOS_CAP_TYPE_L2CA, PQOS_CAP_TYPE_MBA};
+        struct state_task *tasks = NULL;
+        unsigned num_tasks = 0;
+        unsigned i;
+        int ret;
+
+        if (api->l3ca_get == NULL || api->l2ca_get == NULL ||
+            api->mba_get == NULL || api->alloc_assoc_get == NULL) {
+                LOG_INFO("Interface not supported!\n");
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        for (i = 0; i < DIM(types); i++) {
+                ret = state_save_cos(api, st, types[i]);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        for (i = 0; i < cpu->num_cores; i++) {
+                struct state_rec rec;
+                unsigned class_id;
+
+                ret = api->alloc_assoc_get(cpu->cores[i].lcore, &class_id);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+
+                memset(&rec, 0, sizeof(rec));
+                rec.type = STATE_REC_CORE;
+                rec.id = cpu->cores[i].lcore;
+                rec.class_id = class_id;
+                ret = state_add(st, &rec);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        /* tasks can be associated with OS interface only */
+        if (api->pid_get_pid_assoc == NULL)
+                return PQOS_RETVAL_OK;
+
+        ret = state_tasks_get(api, &tasks, &num_tasks);
+        for (i = 0; i < num_tasks && ret == PQOS_RETVAL_OK; i++) {
+                struct state_rec rec;
+
+                memset(&rec, 0, sizeof(rec));
+                rec.type = STATE_REC_TASK;
+                rec.id = tasks[i].pid;
+                rec.class_id = tasks[i].class_id;
+                ret = state_add(st, &rec);
+        }
+        free(tasks);
+
+        return ret;
+}
+
+int
+state_save(const struct pqos_api *api, void **buf, size_t *size)
+{
+        struct state_buf st;
+        int ret;
+
+        memset(&st, 0, sizeof(st));
+
+        ret = state_collect(api, &st);
+        /* empty snapshot */
+        if (ret == PQOS_RETVAL_OK && st.hdr == NULL) {
+                st.hdr = calloc(1, sizeof(*st.hdr));
+                if (st.hdr == NULL)
+                        ret = PQOS_RETVAL_RESOURCE;
+        }
+
+        if (ret != PQOS_RETVAL_OK) {
+                free(st.hdr);
+                return ret;
+        }
+
+        st.hdr->magic = STATE_MAGIC;
+        st.hdr->version = STATE_VERSION;
+        *buf = st.hdr;
+        *size = sizeof(*st.hdr) + st.hdr->num_recs * sizeof(st.recs[0]);
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Retrieves number of classes of service available once CDP or MBA
+ *        controller setting of the snapshot is applied
+ *
+ * @param [in] alloc_cap allocation capability
+ * @param [in] cfg requested CDP or MBA controller setting, -1 for current
+ * @param [out] cos_num number of classes of service
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_PARAM if requested setting is not supported
+ */
+static int
+state_cos_max(const struct pqos_capability *alloc_cap,
+              const int cfg,
+              unsigned *cos_num)
+{
+        int supported, enabled;
+
+        if (alloc_cap->type == PQOS_CAP_TYPE_L3CA) {
+                *cos_num = alloc_cap->u.l3ca->num_classes;
+                supported = alloc_cap->u.l3ca->cdp;
+                enabled = alloc_cap->u.l3ca->cdp_on;
+        } else if (alloc_cap->type == PQOS_CAP_TYPE_L2CA) {
+                *cos_num = alloc_cap->u.l2ca->num_classes;
+                supported = alloc_cap->u.l2ca->cdp;
+                enabled = alloc_cap->u.l2ca->cdp_on;
+        } else {
+                *cos_num = alloc_cap->u.mba->num_classes;
+                /* MBA controller does not change number of classes */
+                return cfg > 0 && !alloc_cap->u.mba->ctrl ? PQOS_RETVAL_PARAM
+                                                          : PQOS_RETVAL_OK;
+        }
+
+        if (cfg > 0 && !supported)
+                return PQOS_RETVAL_PARAM;
+
+        /* CDP takes two hardware classes for each class of service */
+        if (cfg > 0 && !enabled)
+                *cos_num /= 2;
+        else if (cfg == 0 && enabled)
+                *cos_num *= 2;
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Checks cache allocation mask of the snapshot
+ *
+ * @param [in] mask class of service bit mask
+ * @param [in] num_ways number of cache ways
+ * @param [in] non_contiguous non-contiguous masks supported
+ *
+ * @return 1 if mask can be programmed, 0 otherwise
+ */
+static int
+state_mask_valid(const uint64_t mask,
+                 const unsigned num_ways,
+                 const unsigned non_contiguous)
+{
+        if (mask == 0)
+                return 0;
+
+        if (num_ways < 64 && (mask >> num_ways) != 0)
+                return 0;
+
+        return non_contiguous || alloc_is_bitmask_contiguous(mask);
+}
+
+/**
+ * @brief Checks that snapshot records match the platform
+ *
+ * Checks record types, resource ids, cores, classes of service, masks,
+ * MBA rates and CDP/MBA controller consistency, so that nothing is
+ * programmed from an invalid snapshot.
+ *
+ * @param [in] recs snapshot records
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK if snapshot can be restored
+ * @retval PQOS_RETVAL_PARAM if snapshot is invalid
+ */
+static int
+state_validate(const struct state_rec *recs, const unsigned num)
+{
+        const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
+        const struct pqos_cap *cap = _pqos_get_cap();
+        const struct cpuinfo_config *vconfig;
+        const enum pqos_cap_type types[] = {
+            PQOS_CAP_TYPE_L3CA, PQOS_CAP_TYPE_L2CA, PQOS_CAP_TYPE_MBA};
+        /* following arrays are indexed by class of service record type */
+        const struct pqos_capability *caps[STATE_REC_MBA + 1];
+        int cfg[STATE_REC_MBA + 1];
+        unsigned cos_num[STATE_REC_MBA + 1];
+        unsigned *ids[STATE_REC_MBA + 1];
+        unsigned ids_num[STATE_REC_MBA + 1];
+        unsigned assoc_cos_num = 0;
+        unsigned i, j;
+        int ret = PQOS_RETVAL_OK;
+
+        for (i = 0; i <= STATE_REC_MBA; i++) {
+                caps[i] = NULL;
+                cfg[i] = -1;
+                cos_num[i] = 0;
+                ids[i] = NULL;
+                ids_num[i] = 0;
+        }
+
+        for (i = 0; i < num; i++) {
+                const uint32_t type = recs[i].type;
+
+                if (type < STATE_REC_L3CA || type > STATE_REC_TASK) {
+                        LOG_ERROR("Unknown state record type %u\n", type);
+                        return PQOS_RETVAL_PARAM;
+                }
+                if (type > STATE_REC_MBA)
+                        continue;
+
+                /* one CDP or MBA controller setting for all resources */
+                if (recs[i].flags > 1 ||
+                    (cfg[type] >= 0 && cfg[type] != (int)recs[i].flags)) {
+                        LOG_ERROR("Inconsistent CDP or MBA controller "
+                                  "setting in state snapshot\n");
+                        return PQOS_RETVAL_PARAM;
+                }
+                cfg[type] = (int)recs[i].flags;
+        }
+
+        for (i = 0; i < DIM(types); i++) {
+                const uint32_t type = STATE_REC_L3CA + i;
+
+                if (pqos_cap_get_type(cap, types[i], &caps[type]) !=
+                    PQOS_RETVAL_OK) {
+                        caps[type] = NULL;
+                        if (cfg[type] < 0)
+                                continue;
+                        LOG_ERROR("State snapshot requires unsupported "
+                                  "allocation technology\n");
+                        ret = PQOS_RETVAL_PARAM;
+                        goto state_validate_exit;
+                }
+
+                ret = state_cos_max(caps[type], cfg[type], &cos_num[type]);
+                if (ret != PQOS_RETVAL_OK) {
+                        LOG_ERROR("State snapshot requires unsupported CDP "
+                                  "or MBA controller setting\n");
+                        goto state_validate_exit;
+                }
+                if (assoc_cos_num == 0 || cos_num[type] < assoc_cos_num)
+                        assoc_cos_num = cos_num[type];
+
+                ids[type] = state_ids(types[i], &ids_num[type]);
+                if (ids[type] == NULL) {
+                        ret = PQOS_RETVAL_ERROR;
+                        goto state_validate_exit;
+                }
+        }
+
+        cpuinfo_get_config(&vconfig);
+
+        for (i = 0; i < num; i++) {
+                const struct state_rec *rec = &recs[i];
+                const uint32_t type = rec->type;
+                int valid;
+
+                if (type == STATE_REC_CORE &&
+                    pqos_cpu_check_core(cpu, rec->id) != PQOS_RETVAL_OK) {
+                        LOG_ERROR("Core %u not available\n", rec->id);
+                        ret = PQOS_RETVAL_PARAM;
+                        break;
+                }
+                if (type == STATE_REC_CORE || type == STATE_REC_TASK) {
+                        if (rec->class_id != 0 &&
+                            rec->class_id >= assoc_cos_num) {
+                                LOG_ERROR("COS%u not available\n",
+                                          rec->class_id);
+                                ret = PQOS_RETVAL_PARAM;
+                                break;
+                        }
+                        continue;
+                }
+
+                for (j = 0; j < ids_num[type]; j++)
+                        if (ids[type][j] == rec->id)
+                                break;
+                if (j == ids_num[type]) {
+                        LOG_ERROR("Resource id %u not available\n", rec->id);
+                        ret = PQOS_RETVAL_PARAM;
+                        break;
+                }
+                if (rec->class_id >= cos_num[type]) {
+                        LOG_ERROR("COS%u not available on resource id %u\n",
+                                  rec->class_id, rec->id);
+                        ret = PQOS_RETVAL_PARAM;
+                        break;
+                }
+                for (j = 0; j < i; j++)
+                        if (recs[j].type == type && recs[j].id == rec->id &&
+                            recs[j].class_id == rec->class_id)
+                                break;
+                if (j < i) {
+                        LOG_ERROR("Duplicate COS%u on resource id %u\n",
+                                  rec->class_id, rec->id);
+                        ret = PQOS_RETVAL_PARAM;
+                        break;
+                }
+
+                if (type == STATE_REC_MBA) {
+                        if (rec->flags)
+                                valid = rec->val[0] > 0 &&
+                                        rec->val[0] == (unsigned)rec->val[0];
+                        else
+                                valid = rec->val[0] > 0 &&
+                                        rec->val[0] <= vconfig->mba_max;
+                } else {
+                        unsigned num_ways, non_contiguous;
+
+                        if (type == STATE_REC_L3CA) {
+                                num_ways = caps[type]->u.l3ca->num_ways;
+                                non_contiguous =
+                                    caps[type]->u.l3ca->non_contiguous_cbm;
+                        } else {
+                                num_ways = caps[type]->u.l2ca->num_ways;
+                                non_contiguous =
+                                    caps[type]->u.l2ca->non_contiguous_cbm;
+                        }
+
+                        valid = state_mask_valid(rec->val[0], num_ways,
+                                                 non_contiguous);
+                        if (rec->flags)
+                                valid = valid &&
+                                        state_mask_valid(rec->val[1], num_ways,
+                                                         non_contiguous);
+                        else
+                                valid = valid && rec->val[1] == 0;
+                }
+                if (!valid) {
+                        LOG_ERROR("Invalid setting of COS%u on resource id "
+                                  "%u\n",
+                                  rec->class_id, rec->id);
+                        ret = PQOS_RETVAL_PARAM;
+                        break;
+                }
+        }
+
+state_validate_exit:
+        for (i = 0; i <= STATE_REC_MBA; i++)
+                free(ids[i]);
+
+        return ret;
+}
+
+/**
+ * @brief Reconfigures CDP and MBA controller when snapshot requires it
+ *
+ * Reconfiguration resets allocation, classes of service and associations
+ * are restored by subsequent steps.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] recs snapshot records
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ */
+static int
+state_restore_config(const struct pqos_api *api,
+                     const struct state_rec *recs,
+                     const unsigned num)
+{
+        const struct pqos_cap *cap = _pqos_get_cap();
+        struct pqos_alloc_config cfg;
+        int l3_cdp = -1, l2_cdp = -1, mba_ctrl = -1;
+        int enabled;
+        int reset = 0;
+        unsigned i;
+
+        for (i = 0; i < num; i++)
+                if (recs[i].type == STATE_REC_L3CA)
+                        l3_cdp = recs[i].flags != 0;
+                else if (recs[i].type == STATE_REC_L2CA)
+                        l2_cdp = recs[i].flags != 0;
+                else if (recs[i].type == STATE_REC_MBA)
+                        mba_ctrl = recs[i].flags != 0;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.l3_cdp = PQOS_REQUIRE_CDP_ANY;
+        cfg.l2_cdp = PQOS_REQUIRE_CDP_ANY;
+        cfg.mba = PQOS_MBA_ANY;
+
+        if (l3_cdp >= 0 &&
+            pqos_l3ca_cdp_enabled(cap, NULL, &enabled) == PQOS_RETVAL_OK &&
+            (enabled > 0) != l3_cdp) {
+                cfg.l3_cdp =
+                    l3_cdp ? PQOS_REQUIRE_CDP_ON : PQOS_REQUIRE_CDP_OFF;
+                reset = 1;
+        }
+        if (l2_cdp >= 0 &&
+            pqos_l2ca_cdp_enabled(cap, NULL, &enabled) == PQOS_RETVAL_OK &&
+            (enabled > 0) != l2_cdp) {
+                cfg.l2_cdp =
+                    l2_cdp ? PQOS_REQUIRE_CDP_ON : PQOS_REQUIRE_CDP_OFF;
+                reset = 1;
+        }
+        if (mba_ctrl >= 0 &&
+            pqos_mba_ctrl_enabled(cap, NULL, &enabled) == PQOS_RETVAL_OK &&
+            (enabled > 0) != mba_ctrl) {
+                cfg.mba = mba_ctrl ? PQOS_MBA_CTRL : PQOS_MBA_DEFAULT;
+                reset = 1;
+        }
+
+        if (!reset)
+                return PQOS_RETVAL_OK;
+
+        LOG_INFO("Restoring CDP and MBA configuration\n");
+
+        return api->alloc_reset(&cfg);
+}
+
+/**
+ * @brief Restores classes of service of one resource entity
+ *
+ * Only classes of service that differ from current setting are programmed.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] recs snapshot records of the same type and resource id
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ */
+static int
+state_restore_cos(const struct pqos_api *api,
+                  const struct state_rec *recs,
+                  const unsigned num)
+{
+        struct pqos_l3ca l3ca[PQOS_MAX_L3CA_COS], l3ca_set[PQOS_MAX_L3CA_COS];
+        struct pqos_l2ca l2ca[PQOS_MAX_L2CA_COS], l2ca_set[PQOS_MAX_L2CA_COS];
+        struct pqos_mba mba[PQOS_MAX_COS], mba_set[PQOS_MAX_COS];
+        const uint32_t type = recs[0].type;
+        const unsigned id = recs[0].id;
+        unsigned num_cur = 0;
+        unsigned num_set = 0;
+        unsigned i, j;
+        int ret;
+
+        if (type == STATE_REC_L3CA)
+                ret = api->l3ca_get(id, DIM(l3ca), &num_cur, l3ca);
+        else if (type == STATE_REC_L2CA)
+                ret = api->l2ca_get(id, DIM(l2ca), &num_cur, l2ca);
+        else
+                ret = api->mba_get(id, DIM(mba), &num_cur, mba);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        for (i = 0; i < num; i++) {
+                const struct state_rec *rec = &recs[i];
+
+                for (j = 0; j < num_cur; j++)
+                        if ((type == STATE_REC_L3CA &&
+                             l3ca[j].class_id == rec->class_id) ||
+                            (type == STATE_REC_L2CA &&
+                             l2ca[j].class_id == rec->class_id) ||
+                            (type == STATE_REC_MBA &&
+                             mba[j].class_id == rec->class_id))
+                                break;
+                if (j == num_cur) {
+                        LOG_ERROR("COS%u not available on resource id %u\n",
+                                  rec->class_id, id);
+                        return PQOS_RETVAL_PARAM;
+                }
+
+                if (type == STATE_REC_L3CA) {
+                        struct pqos_l3ca *ca = &l3ca_set[num_set];
+
+                        ca->class_id = rec->class_id;
+                        ca->cdp = rec->flags;
+                        ca->u.s.data_mask = rec->val[0];
+                        ca->u.s.code_mask = rec->val[1];
+                        if (ca->cdp != l3ca[j].cdp ||
+                            ca->u.s.data_mask != l3ca[j].u.s.data_mask ||
+                            (ca->cdp &&
+                             ca->u.s.code_mask != l3ca[j].u.s.code_mask))
+                                num_set++;
+                } else if (type == STATE_REC_L2CA) {
+                        struct pqos_l2ca *ca = &l2ca_set[num_set];
+
+                        ca->class_id = rec->class_id;
+                        ca->cdp = rec->flags;
+                        ca->u.s.data_mask = rec->val[0];
+                        ca->u.s.code_mask = rec->val[1];
+                        if (ca->cdp != l2ca[j].cdp ||
+                            ca->u.s.data_mask != l2ca[j].u.s.data_mask ||
+                            (ca->cdp &&
+                             ca->u.s.code_mask != l2ca[j].u.s.code_mask))
+                                num_set++;
+                } else {
+                        struct pqos_mba *m = &mba_set[num_set];
+
+                        memset(m, 0, sizeof(*m));
+                        m->class_id = rec->class_id;
+                        m->ctrl = rec->flags;
+                        m->mb_max = (unsigned)rec->val[0];
+                        if (m->ctrl != mba[j].ctrl ||
+                            m->mb_max != mba[j].mb_max)
+                                num_set++;
+                }
+        }
+
+        if (num_set == 0)
+                return PQOS_RETVAL_OK;
+
+        if (type == STATE_REC_L3CA)
+                return api->l3ca_set(id, num_set, l3ca_set);
+        if (type == STATE_REC_L2CA)
+                return api->l2ca_set(id, num_set, l2ca_set);
+        return api->mba_set(id, num_set, mba_set, NULL);
+}
+
+/**
+ * @brief Restores task associations
+ *
+ * Tasks that are no longer running are skipped. Tasks not present in the
+ * snapshot are moved back to COS0. Failure to associate a running task
+ * fails the restore.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] recs snapshot records
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ */
+static int
+state_restore_tasks(const struct pqos_api *api,
+                    const struct state_rec *recs,
+                    const unsigned num)
+{
+        struct state_task *cur = NULL;
+        struct state_task *req = NULL;
+        unsigned num_cur = 0;
+        unsigned num_req = 0;
+        unsigned i, j;
+        int ret;
+
+        if (api->pid_get_pid_assoc == NULL) {
+                for (i = 0; i < num; i++)
+                        if (recs[i].type == STATE_REC_TASK) {
+                                LOG_ERROR("Task association requires OS "
+                                          "interface\n");
+                                return PQOS_RETVAL_RESOURCE;
+                        }
+                return PQOS_RETVAL_OK;
+        }
+
+        req = malloc((num + 1) * sizeof(req[0]));
+        if (req == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        for (i = 0; i < num; i++)
+                if (recs[i].type == STATE_REC_TASK) {
+                        req[num_req].pid = recs[i].id;
+                        req[num_req].class_id = recs[i].class_id;
+                        num_req++;
+                }
+        if (num_req > 0)
+                qsort(req, num_req, sizeof(req[0]), state_task_cmp);
+
+        ret = state_tasks_get(api, &cur, &num_cur);
+        if (ret != PQOS_RETVAL_OK) {
+                free(req);
+                return ret;
+        }
+
+        /* both lists are sorted by task id */
+        for (i = 0, j = 0; i < num_req || j < num_cur;) {
+                unsigned pid, class_id;
+
+                if (j == num_cur ||
+                    (i < num_req && req[i].pid < cur[j].pid)) {
+                        pid = req[i].pid;
+                        class_id = req[i++].class_id;
+                        if (class_id == 0)
+                                continue;
+                } else if (i == num_req || cur[j].pid < req[i].pid) {
+                        pid = cur[j++].pid;
+                        class_id = 0;
+                } else {
+                        pid = req[i].pid;
+                        class_id = req[i++].class_id;
+                        if (class_id == cur[j++].class_id)
+                                continue;
+                }
+
+                ret = api->alloc_assoc_set_pid((pid_t)pid, class_id);
+                if (ret == PQOS_RETVAL_OK)
+                        continue;
+
+                if (kill((pid_t)pid, 0) != 0 && errno == ESRCH) {
+                        LOG_INFO("Task %u no longer exists\n", pid);
+                        ret = PQOS_RETVAL_OK;
+                        continue;
+                }
+
+                LOG_ERROR("Unable to associate task %u with COS%u\n", pid,
+                          class_id);
+                break;
+        }
+
+        free(cur);
+        free(req);
+
+        return ret;
+}
+
+/**
+ * @brief Applies snapshot records
+ *
+ * Classes of service are programmed before cores and tasks are associated
+ * with them. Records must be validated with \a state_validate.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] recs snapshot records
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ */
+static int
+state_apply(const struct pqos_api *api,
+            const struct state_rec *recs,
+            const unsigned num)
+{
+        unsigned i, j;
+        int ret;
+
+        ret = state_restore_config(api, recs, num);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        /* records of one resource entity are stored together */
+        for (i = 0; i < num; i = j) {
+                for (j = i + 1; j < num; j++)
+                        if (recs[j].type != recs[i].type ||
+                            recs[j].id != recs[i].id)
+                                break;
+
+                if (recs[i].type != STATE_REC_L3CA &&
+                    recs[i].type != STATE_REC_L2CA &&
+                    recs[i].type != STATE_REC_MBA)
+                        continue;
+
+                ret = state_restore_cos(api, &recs[i], j - i);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        for (i = 0; i < num; i++) {
+                unsigned class_id;
+
+                if (recs[i].type != STATE_REC_CORE)
+                        continue;
+
+                ret = api->alloc_assoc_get(recs[i].id, &class_id);
+                if (ret == PQOS_RETVAL_OK && class_id != recs[i].class_id)
+                        ret = api->alloc_assoc_set(recs[i].id,
+                                                  recs[i].class_id);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+        }
+
+        return state_restore_tasks(api, recs, num);
+}
+
+/**
+ * @brief Restores complete allocation state
+ *
+ * All records are validated before anything is programmed. Current state
+ * is saved beforehand and programmed back if the snapshot can not be
+ * applied completely. Must be called with API lock acquired.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] recs snapshot records
+ * @param [in] num number of snapshot records
+ *
+ * @return Operation status
+ */
+static int
+state_restore_recs(const struct pqos_api *api,
+                   const struct state_rec *recs,
+                   const unsigned num)
+{
+        struct state_buf backup;
+        int ret;
+
+        if (api->l3ca_get == NULL || api->l2ca_get == NULL ||
+            api->mba_get == NULL || api->alloc_assoc_get == NULL ||
+            api->alloc_reset == NULL) {
+                LOG_INFO("Interface not supported!\n");
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        ret = state_validate(recs, num);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        memset(&backup, 0, sizeof(backup));
+        ret = state_collect(api, &backup);
+        if (ret != PQOS_RETVAL_OK) {
+                free(backup.hdr);
+                return ret;
+        }
+
+        ret = state_apply(api, recs, num);
+        if (ret != PQOS_RETVAL_OK && backup.hdr != NULL) {
+                LOG_ERROR("Unable to restore allocation state, reverting "
+                          "previous state\n");
+                if (state_apply(api, backup.recs, backup.hdr->num_recs) !=
+                    PQOS_RETVAL_OK)
+                        LOG_ERROR("Unable to revert allocation state\n");
+        }
+
+        free(backup.hdr);
+
+        return ret;
+}
+
+int
+state_check(const void *buf, const size_t size)
+{
+        const struct state_hdr *hdr = (const struct state_hdr *)buf;
+
+        if (buf == NULL || size < sizeof(*hdr))
+                return PQOS_RETVAL_PARAM;
+
+        if (hdr->magic != STATE_MAGIC || hdr->version != STATE_VERSION) {
+                LOG_ERROR("Unrecognized state snapshot format\n");
+                return PQOS_RETVAL_PARAM;
+        }
+
+        if ((size - sizeof(*hdr)) / sizeof(struct state_rec) !=
+                hdr->num_recs ||
+            (size - sizeof(*hdr)) % sizeof(struct state_rec) != 0) {
+                LOG_ERROR("State snapshot size mismatch\n");
+                return PQOS_RETVAL_PARAM;
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+state_restore(const struct pqos_api *api, const void *buf)
+{
+        const struct state_hdr *hdr = (const struct state_hdr *)buf;
+
+        return state_restore_recs(api, (const struct state_rec *)(hdr + 1),
+                                  hdr->num_recs);
+}
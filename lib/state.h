@@ -0,0 +1,101 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file for allocation state snapshot
+ *
+ * Snapshot holds classes of service of all allocation technologies, core
+ * associations and, with OS interface, task associations. Functions must
+ * be called with API lock acquired.
+ */
+
+#ifndef __PQOS_STATE_H__
+#define __PQOS_STATE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+#include "pqos.h"
+#include "types.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Saves complete allocation state
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [out] buf allocated state snapshot
+ * @param [out] size size of the snapshot in bytes
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if not supported by the interface
+ */
+PQOS_LOCAL int
+state_save(const struct pqos_api *api, void **buf, size_t *size);
+
+/**
+ * @brief Checks state snapshot format
+ *
+ * @param [in] buf state snapshot
+ * @param [in] size size of the snapshot in bytes
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK if format is recognized
+ * @retval PQOS_RETVAL_PARAM otherwise
+ */
+PQOS_LOCAL int state_check(const void *buf, const size_t size);
+
+/**
+ * @brief Restores complete allocation state
+ *
+ * All records are validated against the platform before anything is
+ * programmed. If the snapshot can not be applied completely, state from
+ * before the call is programmed back.
+ *
+ * @param [in] api API functions of the selected interface
+ * @param [in] buf state snapshot checked with \a state_check
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_PARAM if snapshot does not match the platform
+ * @retval PQOS_RETVAL_RESOURCE if not supported by the interface
+ */
+PQOS_LOCAL int state_restore(const struct pqos_api *api, const void *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_STATE_H__ */
@@ -0,0 +1,449 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Cross-process telemetry segment
+ *
+ * Publisher writes monitoring group values into a memory mapped segment
+ * in /dev/shm. Each record is protected with a sequence lock so that any
+ * number of readers in other processes can take consistent snapshots
+ * without system calls, locks or privileges.
+ */
+
+#include "log.h"
+#include "monitoring.h"
+#include "pqos.h"
+#include "seqlock.h"
+#include "types.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * ---------------------------------------
+ * Local macros
+ * ---------------------------------------
+ */
+
+#define TELEMETRY_DIR   "/dev/shm"
+#define TELEMETRY_MAGIC 0x4d545150 /* "PQTM" */
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Segment header
+ */
+struct telemetry_hdr {
+        uint32_t magic;       /**< segment magic */
+        uint32_t version;     /**< layout version */
+        uint32_t hdr_size;    /**< size of the header */
+        uint32_t slot_size;   /**< size of the record slot */
+        uint32_t num_records; /**< number of records */
+        uint32_t active;      /**< publisher is active */
+};
+
+/**
+ * Record slot
+ */
+struct telemetry_slot {
+        uint32_t lock;                       /**< record sequence lock */
+        uint32_t valid;                      /**< record was published */
+        struct pqos_telemetry_record record; /**< record data */
+};
+
+/**
+ * Telemetry publisher
+ */
+struct pqos_telemetry {
+        char path[PATH_MAX];         /**< segment file path */
+        struct telemetry_hdr *hdr;   /**< mapped segment */
+        size_t size;                 /**< size of the segment */
+        struct telemetry_slot *slot; /**< record slots */
+};
+
+/**
+ * Telemetry reader
+ */
+struct pqos_telemetry_reader {
+        const struct telemetry_hdr *hdr; /**< mapped segment */
+        size_t size;                     /**< size of the segment */
+};
+
+/**
+ * ---------------------------------------
+ * Local functions
+ * ---------------------------------------
+ */
+
+/**
+ * @brief Builds segment file path
+ *
+ * @param [in] name segment name
+ * @param [out] path place to store the path
+ * @param [in] path_len size of \a path buffer
+ *
+ * @return Operations status
+ * @retval PQOS_RETVAL_OK on success
+ */
+static int
+telemetry_path(const char *name, char *path, const size_t path_len)
+{
+        int ret;
+
+        if (name == NULL || *name == '\0' || strchr(name, '/') != NULL)
+                return PQOS_RETVAL_PARAM;
+
+        ret = snprintf(path, path_len, TELEMETRY_DIR "/%s", name);
+        if (ret < 0 || (size_t)ret >= path_len)
+                return PQOS_RETVAL_PARAM;
+
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Calculates bandwidth from counter delta
+ *
+ * @param [in] delta counter delta [B]
+ * @param [in] interval time interval [ns]
+ *
+ * @return bandwidth in bytes per second
+ */
+static double
+telemetry_rate(const uint64_t delta, const uint64_t interval)
+{
+        if (interval == 0)
+                return 0;
+
+        return (double)delta * 1000000000.0 / (double)interval;
+}
+
+/**
+ * @brief Retrieves record slot
+ *
+ * @param [in] hdr segment header
+ * @param [in] index record index
+ *
+ * @return record slot
+ */
+static const struct telemetry_slot *
+telemetry_slot(const struct telemetry_hdr *hdr, const unsigned index)
+{
+        const char *base = (const char *)hdr + hdr->hdr_size;
+
+        base += (size_t)index * hdr->slot_size;
+        return (const struct telemetry_slot *)(const void *)base;
+}
+
+/*
+ * =======================================
+ * =======================================
+ *
+ * Publisher API
+ *
+ * =======================================
+ * =======================================
+ */
+
+int
+pqos_telemetry_create(const char *name,
+                      const unsigned num_records,
+                      struct pqos_telemetry **telemetry)
+{
+        struct pqos_telemetry *tm;
+        int ret;
+        int fd;
+
+        if (num_records == 0 || telemetry == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        tm = (struct pqos_telemetry *)calloc(1, sizeof(*tm));
+        if (tm == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        ret = telemetry_path(name, tm->path, sizeof(tm->path));
+        if (ret != PQOS_RETVAL_OK) {
+                free(tm);
+                return ret;
+        }
+
+        /**
+         * Readers of the previous segment keep their mapping and find it
+         * inactive, new readers get the new segment.
+         */
+        (void)unlink(tm->path);
+
+        tm->size = sizeof(struct telemetry_hdr) +
+                   (size_t)num_records * sizeof(struct telemetry_slot);
+
+        fd = open(tm->path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd < 0) {
+                LOG_ERROR("Failed to create telemetry segment %s\n", tm->path);
+                free(tm);
+                return PQOS_RETVAL_ERROR;
+        }
+
+        /* open() is subject to umask, readers need the access anyway */
+        if (fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0 ||
+            ftruncate(fd, (off_t)tm->size) != 0) {
+                LOG_ERROR("Failed to set up telemetry segment %s\n", tm->path);
+                goto create_error;
+        }
+
+        tm->hdr = (struct telemetry_hdr *)mmap(
+            NULL, tm->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (tm->hdr == MAP_FAILED) {
+                LOG_ERROR("Failed to map telemetry segment %s\n", tm->path);
+                goto create_error;
+        }
+        close(fd);
+
+        tm->slot = (struct telemetry_slot *)(tm->hdr + 1);
+        tm->hdr->version = PQOS_TELEMETRY_VERSION;
+        tm->hdr->hdr_size = sizeof(struct telemetry_hdr);
+        tm->hdr->slot_size = sizeof(struct telemetry_slot);
+        tm->hdr->num_records = num_records;
+        tm->hdr->active = 1;
+        /* magic goes last so readers never see partial header */
+        __atomic_store_n(&tm->hdr->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+
+        *telemetry = tm;
+        return PQOS_RETVAL_OK;
+
+create_error:
+        close(fd);
+        (void)unlink(tm->path);
+        free(tm);
+        return PQOS_RETVAL_ERROR;
+}
+
+int
+pqos_telemetry_update(struct pqos_telemetry *telemetry,
+                      const unsigned index,
+                      const char *desc,
+                      const struct pqos_mon_data *group)
+{
+        struct telemetry_slot *slot;
+        struct pqos_telemetry_record *rec;
+        struct timespec ts;
+        uint64_t mbm_interval;
+        uint64_t now;
+
+        if (telemetry == NULL || group == NULL ||
+            index >= telemetry->hdr->num_records)
+                return PQOS_RETVAL_PARAM;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        now = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+        slot = &telemetry->slot[index];
+        rec = &slot->record;
+
+        /* only the publisher writes the slot so it can read it unlocked */
+        seqlock_write_begin(&slot->lock);
+        rec->interval = slot->valid ? now - rec->timestamp : 0;
+        rec->timestamp = now;
+        rec->event = group->event;
+        if (desc != NULL)
+                strncpy(rec->desc, desc, sizeof(rec->desc) - 1);
+        rec->values = group->values;
+        /* memory bandwidth may be polled less often than published */
+        mbm_interval = rec->interval;
+        if (group->intl != NULL &&
+            (group->event &
+             (PQOS_MON_EVENT_LMEM_BW | PQOS_MON_EVENT_TMEM_BW)) != 0)
+                (void)pqos_mon_poll_time(group, PQOS_MON_EVENT_TMEM_BW, NULL,
+                                         &mbm_interval);
+        rec->mbm_local_rate =
+            telemetry_rate(group->values.mbm_local_delta, mbm_interval);
+        rec->mbm_total_rate =
+            telemetry_rate(group->values.mbm_total_delta, mbm_interval);
+        rec->mbm_remote_rate =
+            telemetry_rate(group->values.mbm_remote_delta, mbm_interval);
+        slot->valid = 1;
+        seqlock_write_end(&slot->lock);
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_telemetry_destroy(struct pqos_telemetry *telemetry)
+{
+        int ret = PQOS_RETVAL_OK;
+
+        if (telemetry == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        __atomic_store_n(&telemetry->hdr->active, 0, __ATOMIC_RELEASE);
+
+        if (unlink(telemetry->path) != 0)
+                ret = PQOS_RETVAL_ERROR;
+        if (munmap(telemetry->hdr, telemetry->size) != 0)
+                ret = PQOS_RETVAL_ERROR;
+        free(telemetry);
+
+        return ret;
+}
+
+/*
+ * =======================================
+ * =======================================
+ *
+ * Reader API
+ *
+ * =======================================
+ * =======================================
+ */
+
+int
+pqos_telemetry_open(const char *name, struct pqos_telemetry_reader **reader)
+{
+        struct pqos_telemetry_reader *rd;
+        const struct telemetry_hdr *hdr;
+        char path[PATH_MAX];
+        struct stat st;
+        void *addr;
+        int ret;
+        int fd;
+
+        if (reader == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        ret = telemetry_path(name, path, sizeof(path));
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+                return PQOS_RETVAL_RESOURCE;
+
+        if (fstat(fd, &st) != 0 ||
+            (size_t)st.st_size < sizeof(struct telemetry_hdr)) {
+                close(fd);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+                return PQOS_RETVAL_RESOURCE;
+
+        hdr = (const struct telemetry_hdr *)addr;
+        if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC ||
+            hdr->version != PQOS_TELEMETRY_VERSION ||
+            hdr->slot_size < sizeof(struct telemetry_slot) ||
+            hdr->hdr_size +
+                    (size_t)hdr->num_records * hdr->slot_size >
+                (size_t)st.st_size) {
+                munmap(addr, (size_t)st.st_size);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        rd = (struct pqos_telemetry_reader *)malloc(sizeof(*rd));
+        if (rd == NULL) {
+                munmap(addr, (size_t)st.st_size);
+                return PQOS_RETVAL_RESOURCE;
+        }
+
+        rd->hdr = hdr;
+        rd->size = (size_t)st.st_size;
+        *reader = rd;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_telemetry_get_num(const struct pqos_telemetry_reader *reader,
+                       unsigned *num_records)
+{
+        if (reader == NULL || num_records == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        *num_records = reader->hdr->num_records;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_telemetry_read(const struct pqos_telemetry_reader *reader,
+                    const unsigned index,
+                    struct pqos_telemetry_record *record)
+{
+        const struct telemetry_slot *slot;
+        uint32_t start;
+        uint32_t valid;
+
+        if (reader == NULL || record == NULL ||
+            index >= reader->hdr->num_records)
+                return PQOS_RETVAL_PARAM;
+
+        if (!__atomic_load_n(&reader->hdr->active, __ATOMIC_ACQUIRE))
+                return PQOS_RETVAL_INIT;
+
+        slot = telemetry_slot(reader->hdr, index);
+
+        do {
+                start = seqlock_read_begin(&slot->lock);
+                valid = slot->valid;
+                *record = slot->record;
+        } while (seqlock_read_retry(&slot->lock, start));
+
+        if (!valid)
+                return PQOS_RETVAL_RESOURCE;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+pqos_telemetry_close(struct pqos_telemetry_reader *reader)
+{
+        int ret = PQOS_RETVAL_OK;
+
+        if (reader == NULL)
+                return PQOS_RETVAL_PARAM;
+
+        if (munmap((void *)(uintptr_t)reader->hdr, reader->size) != 0)
+                ret = PQOS_RETVAL_ERROR;
+        free(reader);
+
+        return ret;
+}
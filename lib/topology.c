@@ -0,0 +1,516 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief CPU topology index
+ *
+ * For each topology object type the index keeps the list of object ids
+ * and a compressed sparse row table of cores (core list grouped by
+ * object with per object offsets). Object ids and logical core ids are
+ * mapped to dense indexes through direct lookup tables.
+ */
+
+#include "topology.h"
+
+#include "log.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Largest id resolved through direct lookup table, ids above fall back
+ * to linear search
+ */
+#define TOPO_MAP_MAX (1 << 16)
+
+/**
+ * Marks unused entry of lookup table
+ */
+#define TOPO_IDX_INVALID UINT_MAX
+
+/**
+ * ---------------------------------------
+ * Local data structures
+ * ---------------------------------------
+ */
+
+/**
+ * Index of single topology object type
+ */
+struct topo_obj_index {
+        unsigned num;    /**< number of objects */
+        unsigned *ids;   /**< object ids in order of first appearance */
+        unsigned *start; /**< cores of object n are cores[start[n]] to
+                              cores[start[n + 1] - 1] */
+        unsigned *cores; /**< logical cores grouped by object */
+        unsigned map_size; /**< number of entries in map */
+        unsigned *map;     /**< object id to dense index */
+};
+
+/**
+ * Index of single topology, immutable once published
+ */
+struct topo_index {
+        const struct pqos_cpuinfo *cpu;          /**< indexed topology */
+        struct topo_obj_index obj[TOPO_OBJ_NUMOF]; /**< object indexes */
+        unsigned lcore_map_size; /**< number of entries in lcore_map */
+        unsigned *lcore_map;     /**< logical core id to core index */
+        struct topo_index *prev; /**< index of previous topology or NULL */
+};
+
+/**
+ * Most recent index. Index of the previous topology is kept for one more
+ * topology change, so lookups running concurrently with a refresh never
+ * touch released memory. Older indexes are released.
+ */
+static struct topo_index *m_topo = NULL;
+
+/**
+ * Topology generation, incremented every time index is built
+ */
+static unsigned m_topo_gen = 0;
+
+/**
+ * @brief Retrieves object id of \a type for \a core
+ *
+ * @param [in] core core information
+ * @param [in] type object type
+ *
+ * @return object id
+ */
+static unsigned
+topo_core_obj_id(const struct pqos_coreinfo *core, const enum topo_obj type)
+{
+        switch (type) {
+        case TOPO_OBJ_SOCKET:
+                return core->socket;
+        case TOPO_OBJ_L2_CLUSTER:
+                return core->l2_id;
+        case TOPO_OBJ_L3_CLUSTER:
+                return core->l3_id;
+        case TOPO_OBJ_L3CAT:
+                return core->l3cat_id;
+        case TOPO_OBJ_MBA:
+                return core->mba_id;
+#if (PQOS_VERSION >= 50000 || defined PQOS_SNC)
+        case TOPO_OBJ_NUMA:
+                return core->numa;
+#endif
+        default:
+                break;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Builds direct lookup table
+ *
+ * @param [in] keys table keys
+ * @param [in] num number of keys
+ * @param [out] map_size number of entries in table
+ *
+ * @return lookup table mapping key to its position in \a keys
+ * @retval NULL if keys exceed TOPO_MAP_MAX or on allocation error
+ */
+static unsigned *
+topo_map_build(const unsigned *keys, const unsigned num, unsigned *map_size)
+{
+        unsigned *map;
+        unsigned max = 0;
+        unsigned i;
+
+        for (i = 0; i < num; i++)
+                if (keys[i] > max)
+                        max = keys[i];
+
+        *map_size = 0;
+        if (max >= TOPO_MAP_MAX)
+                return NULL;
+
+        map = malloc((max + 1) * sizeof(map[0]));
+        if (map == NULL)
+                return NULL;
+
+        for (i = 0; i <= max; i++)
+                map[i] = TOPO_IDX_INVALID;
+        for (i = 0; i < num; i++)
+                map[keys[i]] = i;
+
+        *map_size = max + 1;
+        return map;
+}
+
+/**
+ * @brief Builds index of single object type
+ *
+ * @param [in] cpu CPU topology
+ * @param [in] type object type
+ * @param [out] obj object index
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+static int
+topo_obj_build(const struct pqos_cpuinfo *cpu,
+               const enum topo_obj type,
+               struct topo_obj_index *obj)
+{
+        unsigned *core_obj;
+        unsigned i;
+        int ret = PQOS_RETVAL_RESOURCE;
+
+        core_obj = malloc(cpu->num_cores * sizeof(core_obj[0]));
+        obj->ids = malloc(cpu->num_cores * sizeof(obj->ids[0]));
+        obj->cores = malloc(cpu->num_cores * sizeof(obj->cores[0]));
+        obj->start = calloc(cpu->num_cores + 1, sizeof(obj->start[0]));
+        if (core_obj == NULL || obj->ids == NULL || obj->cores == NULL ||
+            obj->start == NULL)
+                goto topo_obj_build_exit;
+
+        /* dense object ids in order of first appearance */
+        obj->num = 0;
+        for (i = 0; i < cpu->num_cores; i++) {
+                const unsigned id = topo_core_obj_id(&cpu->cores[i], type);
+                unsigned j;
+
+                for (j = 0; j < obj->num; j++)
+                        if (obj->ids[j] == id)
+                                break;
+                if (j == obj->num)
+                        obj->ids[obj->num++] = id;
+                core_obj[i] = j;
+        }
+
+        /* row offsets */
+        for (i = 0; i < cpu->num_cores; i++)
+                obj->start[core_obj[i] + 1]++;
+        for (i = 0; i < obj->num; i++)
+                obj->start[i + 1] += obj->start[i];
+
+        /* core lists, preserving topology order within an object */
+        for (i = 0; i < cpu->num_cores; i++) {
+                const unsigned pos = obj->start[core_obj[i]]++;
+
+                obj->cores[pos] = cpu->cores[i].lcore;
+        }
+        for (i = obj->num; i > 0; i--)
+                obj->start[i] = obj->start[i - 1];
+        obj->start[0] = 0;
+
+        obj->map = topo_map_build(obj->ids, obj->num, &obj->map_size);
+
+        ret = PQOS_RETVAL_OK;
+
+topo_obj_build_exit:
+        free(core_obj);
+
+        return ret;
+}
+
+/**
+ * @brief Releases index of single object type
+ *
+ * @param [in] obj object index
+ */
+static void
+topo_obj_free(struct topo_obj_index *obj)
+{
+        free(obj->ids);
+        free(obj->start);
+        free(obj->cores);
+        free(obj->map);
+        memset(obj, 0, sizeof(*obj));
+}
+
+/**
+ * @brief Releases index of single topology
+ *
+ * @param [in] idx topology index
+ */
+static void
+topo_index_free(struct topo_index *idx)
+{
+        unsigned i;
+
+        for (i = 0; i < TOPO_OBJ_NUMOF; i++)
+                topo_obj_free(&idx->obj[i]);
+        free(idx->lcore_map);
+        free(idx);
+}
+
+void
+topo_fini(void)
+{
+        struct topo_index *idx = m_topo;
+
+        m_topo = NULL;
+        while (idx != NULL) {
+                struct topo_index *prev = idx->prev;
+
+                topo_index_free(idx);
+                idx = prev;
+        }
+}
+
+int
+topo_init(const struct pqos_cpuinfo *cpu)
+{
+        struct topo_index *idx;
+        unsigned *lcores;
+        unsigned i;
+        int ret = PQOS_RETVAL_OK;
+
+        if (cpu == NULL || cpu->num_cores == 0)
+                return PQOS_RETVAL_PARAM;
+
+        idx = calloc(1, sizeof(*idx));
+        if (idx == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        for (i = 0; i < TOPO_OBJ_NUMOF && ret == PQOS_RETVAL_OK; i++)
+                ret = topo_obj_build(cpu, (enum topo_obj)i, &idx->obj[i]);
+        if (ret != PQOS_RETVAL_OK) {
+                LOG_ERROR("Failed to build topology index\n");
+                topo_index_free(idx);
+                return ret;
+        }
+
+        lcores = malloc(cpu->num_cores * sizeof(lcores[0]));
+        if (lcores != NULL) {
+                for (i = 0; i < cpu->num_cores; i++)
+                        lcores[i] = cpu->cores[i].lcore;
+                idx->lcore_map = topo_map_build(lcores, cpu->num_cores,
+                                                &idx->lcore_map_size);
+                free(lcores);
+        }
+
+        idx->cpu = cpu;
+        idx->prev = m_topo;
+        __atomic_store_n(&m_topo, idx, __ATOMIC_RELEASE);
+
+        /* grace period is over for the index before the previous one */
+        if (idx->prev != NULL) {
+                struct topo_index *old = idx->prev->prev;
+
+                __atomic_store_n(&idx->prev->prev, NULL, __ATOMIC_RELEASE);
+                while (old != NULL) {
+                        struct topo_index *prev = old->prev;
+
+                        topo_index_free(old);
+                        old = prev;
+                }
+        }
+
+        m_topo_gen++;
+        if (m_topo_gen == 0)
+                m_topo_gen = 1;
+
+        return PQOS_RETVAL_OK;
+}
+
+unsigned
+topo_generation(void)
+{
+        return m_topo_gen;
+}
+
+/**
+ * @brief Finds index of \a cpu topology
+ *
+ * Index of the previous topology is still returned, topology pointer
+ * handed out before refresh stays usable until the next topology change.
+ *
+ * @param [in] cpu CPU topology
+ *
+ * @return topology index
+ * @retval NULL if \a cpu is not indexed
+ */
+static const struct topo_index *
+topo_index_get(const struct pqos_cpuinfo *cpu)
+{
+        const struct topo_index *idx;
+
+        if (cpu == NULL)
+                return NULL;
+
+        for (idx = __atomic_load_n(&m_topo, __ATOMIC_ACQUIRE); idx != NULL;
+             idx = idx->prev)
+                if (idx->cpu == cpu)
+                        return idx;
+
+        return NULL;
+}
+
+int
+topo_is_indexed(const struct pqos_cpuinfo *cpu)
+{
+        return topo_index_get(cpu) != NULL;
+}
+
+/**
+ * @brief Retrieves index of \a type
+ *
+ * @param [in] cpu CPU topology
+ * @param [in] type object type
+ *
+ * @return object index
+ * @retval NULL if \a cpu is not indexed
+ */
+static const struct topo_obj_index *
+topo_obj_get(const struct pqos_cpuinfo *cpu, const enum topo_obj type)
+{
+        const struct topo_index *idx;
+
+        if ((unsigned)type >= TOPO_OBJ_NUMOF)
+                return NULL;
+
+        idx = topo_index_get(cpu);
+        if (idx == NULL)
+                return NULL;
+
+        return &idx->obj[type];
+}
+
+/**
+ * @brief Looks up dense index of object \a id
+ *
+ * @param [in] obj object index
+ * @param [in] id object id
+ *
+ * @return dense object index
+ * @retval TOPO_IDX_INVALID if object does not exist
+ */
+static unsigned
+topo_obj_lookup(const struct topo_obj_index *obj, const unsigned id)
+{
+        unsigned i;
+
+        if (obj->map != NULL)
+                return id < obj->map_size ? obj->map[id] : TOPO_IDX_INVALID;
+
+        for (i = 0; i < obj->num; i++)
+                if (obj->ids[i] == id)
+                        return i;
+
+        return TOPO_IDX_INVALID;
+}
+
+int
+topo_obj_ids(const struct pqos_cpuinfo *cpu,
+             const enum topo_obj type,
+             const unsigned **ids,
+             unsigned *count)
+{
+        const struct topo_obj_index *obj = topo_obj_get(cpu, type);
+
+        if (obj == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        *ids = obj->ids;
+        *count = obj->num;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+topo_obj_idx(const struct pqos_cpuinfo *cpu,
+             const enum topo_obj type,
+             const unsigned id,
+             unsigned *idx)
+{
+        const struct topo_obj_index *obj = topo_obj_get(cpu, type);
+        unsigned n;
+
+        if (obj == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        n = topo_obj_lookup(obj, id);
+        if (n == TOPO_IDX_INVALID)
+                return PQOS_RETVAL_ERROR;
+
+        *idx = n;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+topo_obj_cores(const struct pqos_cpuinfo *cpu,
+               const enum topo_obj type,
+               const unsigned id,
+               const unsigned **cores,
+               unsigned *count)
+{
+        const struct topo_obj_index *obj = topo_obj_get(cpu, type);
+        unsigned n;
+
+        if (obj == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        n = topo_obj_lookup(obj, id);
+        if (n == TOPO_IDX_INVALID)
+                return PQOS_RETVAL_ERROR;
+
+        *cores = &obj->cores[obj->start[n]];
+        *count = obj->start[n + 1] - obj->start[n];
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+topo_core_info(const struct pqos_cpuinfo *cpu,
+               const unsigned lcore,
+               const struct pqos_coreinfo **info)
+{
+        const struct topo_index *idx = topo_index_get(cpu);
+        unsigned i;
+
+        if (idx == NULL)
+                return PQOS_RETVAL_RESOURCE;
+
+        if (idx->lcore_map != NULL) {
+                if (lcore >= idx->lcore_map_size ||
+                    idx->lcore_map[lcore] == TOPO_IDX_INVALID)
+                        return PQOS_RETVAL_ERROR;
+                *info = &cpu->cores[idx->lcore_map[lcore]];
+                return PQOS_RETVAL_OK;
+        }
+
+        for (i = 0; i < cpu->num_cores; i++)
+                if (cpu->cores[i].lcore == lcore) {
+                        *info = &cpu->cores[i];
+                        return PQOS_RETVAL_OK;
+                }
+
+        return PQOS_RETVAL_ERROR;
+}
@@ -0,0 +1,187 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Internal header file for CPU topology index
+ *
+ * Index is built once per topology and maps topology objects (sockets,
+ * cache clusters, CAT/MBA domains) to the cores they contain and logical
+ * core ids to core information. Lookups are constant time and return
+ * pointers into the index, so callers must not free them.
+ *
+ * Library topology is indexed by cpuinfo module. Index is keyed by
+ * topology pointer, structures not indexed are served by linear scans
+ * in utility functions.
+ */
+
+#ifndef __PQOS_TOPOLOGY_H__
+#define __PQOS_TOPOLOGY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pqos.h"
+#include "types.h"
+
+/**
+ * Topology object types
+ */
+enum topo_obj {
+        TOPO_OBJ_SOCKET = 0, /**< CPU socket */
+        TOPO_OBJ_L2_CLUSTER, /**< L2 cache cluster */
+        TOPO_OBJ_L3_CLUSTER, /**< L3 cache cluster */
+        TOPO_OBJ_L3CAT,      /**< L3 CAT domain */
+        TOPO_OBJ_MBA,        /**< MBA domain */
+#if (PQOS_VERSION >= 50000 || defined PQOS_SNC)
+        TOPO_OBJ_NUMA, /**< NUMA node */
+#endif
+        TOPO_OBJ_NUMOF
+};
+
+/**
+ * @brief Builds index for \a cpu topology
+ *
+ * Index of previous topology remains valid for lookups until the next
+ * call or \a topo_fini, older indexes are released. \a cpu must not be
+ * freed while it is indexed.
+ *
+ * @param [in] cpu CPU topology
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE on allocation error
+ */
+PQOS_LOCAL int topo_init(const struct pqos_cpuinfo *cpu);
+
+/**
+ * @brief Releases topology index
+ */
+PQOS_LOCAL void topo_fini(void);
+
+/**
+ * @brief Retrieves topology generation
+ *
+ * Generation changes every time index is built, allowing users to detect
+ * topology updates.
+ *
+ * @return topology generation, 0 if index was never built
+ */
+PQOS_LOCAL unsigned topo_generation(void);
+
+/**
+ * @brief Checks if index is built for \a cpu
+ *
+ * @param [in] cpu CPU topology
+ *
+ * @return 1 if \a cpu is indexed, 0 otherwise
+ */
+PQOS_LOCAL int topo_is_indexed(const struct pqos_cpuinfo *cpu);
+
+/**
+ * @brief Retrieves ids of all objects of \a type
+ *
+ * Ids are listed in order of first appearance in the topology.
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] type object type
+ * @param [out] ids object ids
+ * @param [out] count number of objects
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_RESOURCE if \a cpu is not indexed
+ */
+PQOS_LOCAL int topo_obj_ids(const struct pqos_cpuinfo *cpu,
+                            const enum topo_obj type,
+                            const unsigned **ids,
+                            unsigned *count);
+
+/**
+ * @brief Retrieves dense index of object \a id
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] type object type
+ * @param [in] id object id
+ * @param [out] idx position of \a id in list returned by \a topo_obj_ids
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if object does not exist
+ * @retval PQOS_RETVAL_RESOURCE if \a cpu is not indexed
+ */
+PQOS_LOCAL int topo_obj_idx(const struct pqos_cpuinfo *cpu,
+                            const enum topo_obj type,
+                            const unsigned id,
+                            unsigned *idx);
+
+/**
+ * @brief Retrieves logical cores of object \a id
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] type object type
+ * @param [in] id object id
+ * @param [out] cores logical core ids
+ * @param [out] count number of cores
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if object does not exist
+ * @retval PQOS_RETVAL_RESOURCE if \a cpu is not indexed
+ */
+PQOS_LOCAL int topo_obj_cores(const struct pqos_cpuinfo *cpu,
+                              const enum topo_obj type,
+                              const unsigned id,
+                              const unsigned **cores,
+                              unsigned *count);
+
+/**
+ * @brief Retrieves core information of \a lcore
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] lcore logical core id
+ * @param [out] info core information
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if core does not exist
+ * @retval PQOS_RETVAL_RESOURCE if \a cpu is not indexed
+ */
+PQOS_LOCAL int topo_core_info(const struct pqos_cpuinfo *cpu,
+                              const unsigned lcore,
+                              const struct pqos_coreinfo **info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PQOS_TOPOLOGY_H__ */
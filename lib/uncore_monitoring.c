@@ -41,6 +41,7 @@
 
 #include <dirent.h> /**< scandir() */
 #include <fnmatch.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define UNIT_CTRL_FREEZE_COUNTER   0x10100
@@ -517,6 +518,54 @@ _read_counter(unsigned lcore, enum pqos_mon_event event, uint64_t *val)
         return PQOS_RETVAL_OK;
 }
 
+/**
+ * @brief Read uncore monitoring counter of a socket
+ *
+ * Counters are socket wide. If first core of the socket fails the read,
+ * e.g. it went offline since last topology refresh, other cores of the
+ * socket are tried.
+ *
+ * @param [in] cpu CPU topology
+ * @param [in] socket socket id
+ * @param [in] event PQoS event ID
+ * @param [out] val counter value
+ *
+ * @return Operational status
+ * @retval PQOS_RETVAL_OK success
+ */
+static int
+_read_socket_counter(const struct pqos_cpuinfo *cpu,
+                     unsigned socket,
+                     enum pqos_mon_event event,
+                     uint64_t *val)
+{
+        unsigned *cores;
+        unsigned num_cores;
+        unsigned lcore;
+        unsigned i;
+        int ret;
+
+        ret = pqos_cpu_get_one_core(cpu, socket, &lcore);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        ret = _read_counter(lcore, event, val);
+        if (ret != PQOS_RETVAL_ERROR)
+                return ret;
+
+        cores = pqos_cpu_get_cores(cpu, socket, &num_cores);
+        if (cores == NULL)
+                return PQOS_RETVAL_ERROR;
+
+        for (i = 0; i < num_cores && ret == PQOS_RETVAL_ERROR; i++)
+                if (cores[i] != lcore)
+                        ret = _read_counter(cores[i], event, val);
+
+        free(cores);
+
+        return ret;
+}
+
 int
 uncore_mon_poll(struct pqos_mon_data *group, const enum pqos_mon_event event)
 {
@@ -527,15 +576,10 @@ uncore_mon_poll(struct pqos_mon_data *group, const enum pqos_mon_event event)
         const struct pqos_cpuinfo *cpu = _pqos_get_cpu();
 
         for (i = 0; i < group->intl->uncore.num_sockets; ++i) {
-                unsigned lcore;
                 unsigned socket = group->intl->uncore.sockets[i];
                 uint64_t val;
 
-                ret = pqos_cpu_get_one_core(cpu, socket, &lcore);
-                if (ret != PQOS_RETVAL_OK)
-                        return ret;
-
-                ret = _read_counter(lcore, event, &val);
+                ret = _read_socket_counter(cpu, socket, event, &val);
                 if (ret != PQOS_RETVAL_OK)
                         return ret;
 
@@ -43,14 +43,11 @@
 #include "cap.h"
 #include "cpuinfo.h"
 #include "pqos.h"
+#include "topology.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-#define TOPO_OBJ_SOCKET     0
-#define TOPO_OBJ_L2_CLUSTER 2
-#define TOPO_OBJ_L3_CLUSTER 3
-
 int
 _pqos_utils_init(int interface)
 {
@@ -59,6 +56,93 @@ _pqos_utils_init(int interface)
         return PQOS_RETVAL_OK;
 }
 
+/**
+ * @brief Creates list of topology object ids from topology index
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] type topology object type
+ * @param [out] count place to put number of objects found
+ *
+ * @return Allocated array of size \a count populated with object ids
+ * @retval NULL on error
+ */
+static unsigned *
+__get_ids_indexed(const struct pqos_cpuinfo *cpu,
+                  const enum topo_obj type,
+                  unsigned *count)
+{
+        const unsigned *ids;
+        unsigned *copy;
+        unsigned num;
+
+        if (topo_obj_ids(cpu, type, &ids, &num) != PQOS_RETVAL_OK)
+                return NULL;
+
+        copy = (unsigned *)malloc(sizeof(copy[0]) * num);
+        if (copy == NULL)
+                return NULL;
+
+        memcpy(copy, ids, sizeof(copy[0]) * num);
+        *count = num;
+        return copy;
+}
+
+/**
+ * @brief Retrieves first core of topology object from topology index
+ *
+ * @param [in] cpu indexed CPU topology
+ * @param [in] type topology object type
+ * @param [in] id topology object id
+ * @param [out] lcore place to store logical core id
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ * @retval PQOS_RETVAL_ERROR if object does not exist
+ */
+static int
+__get_one_indexed(const struct pqos_cpuinfo *cpu,
+                  const enum topo_obj type,
+                  const unsigned id,
+                  unsigned *lcore)
+{
+        const unsigned *cores;
+        unsigned num;
+
+        if (topo_obj_cores(cpu, type, id, &cores, &num) != PQOS_RETVAL_OK)
+                return PQOS_RETVAL_ERROR;
+
+        *lcore = cores[0];
+        return PQOS_RETVAL_OK;
+}
+
+/**
+ * @brief Finds core information of logical core
+ *
+ * @param [in] cpu CPU topology
+ * @param [in] lcore logical core id
+ *
+ * @return Core information
+ * @retval NULL if core does not exist
+ */
+static const struct pqos_coreinfo *
+__get_core(const struct pqos_cpuinfo *cpu, const unsigned lcore)
+{
+        const struct pqos_coreinfo *info = NULL;
+        unsigned i;
+
+        if (topo_is_indexed(cpu)) {
+                if (topo_core_info(cpu, lcore, &info) != PQOS_RETVAL_OK)
+                        return NULL;
+                return info;
+        }
+
+        for (i = 0; i < cpu->num_cores; i++)
+                if (cpu->cores[i].lcore == lcore)
+                        return &cpu->cores[i];
+
+        return NULL;
+}
+
 unsigned *
 pqos_cpu_get_mba_ids(const struct pqos_cpuinfo *cpu, unsigned *count)
 {
@@ -70,6 +154,9 @@ pqos_cpu_get_mba_ids(const struct pqos_cpuinfo *cpu, unsigned *count)
         if (cpu == NULL || count == NULL)
                 return NULL;
 
+        if (topo_is_indexed(cpu))
+                return __get_ids_indexed(cpu, TOPO_OBJ_MBA, count);
+
         mba_ids = (unsigned *)malloc(sizeof(mba_ids[0]) * cpu->num_cores);
         if (mba_ids == NULL)
                 return NULL;
@@ -107,6 +194,9 @@ pqos_cpu_get_l3cat_ids(const struct pqos_cpuinfo *cpu, unsigned *count)
         if (cpu == NULL || count == NULL)
                 return NULL;
 
+        if (topo_is_indexed(cpu))
+                return __get_ids_indexed(cpu, TOPO_OBJ_L3CAT, count);
+
         l3cat_ids = (unsigned *)malloc(sizeof(l3cat_ids[0]) * cpu->num_cores);
         if (l3cat_ids == NULL)
                 return NULL;
@@ -144,6 +234,9 @@ pqos_cpu_get_sockets(const struct pqos_cpuinfo *cpu, unsigned *count)
         if (cpu == NULL || count == NULL)
                 return NULL;
 
+        if (topo_is_indexed(cpu))
+                return __get_ids_indexed(cpu, TOPO_OBJ_SOCKET, count);
+
         sockets = (unsigned *)malloc(sizeof(sockets[0]) * cpu->num_cores);
         if (sockets == NULL)
                 return NULL;
@@ -179,6 +272,8 @@ pqos_cpu_get_numa(const struct pqos_cpuinfo *cpu, unsigned *count)
 
         if (cpu == NULL || count == NULL)
                 return NULL;
+        if (topo_is_indexed(cpu))
+                return __get_ids_indexed(cpu, TOPO_OBJ_NUMA, count);
         numa = (unsigned *)malloc(sizeof(numa[0]) * cpu->num_cores);
         if (numa == NULL)
                 return NULL;
@@ -215,6 +310,9 @@ pqos_cpu_get_l2ids(const struct pqos_cpuinfo *cpu, unsigned *count)
         if (cpu == NULL || count == NULL)
                 return NULL;
 
+        if (topo_is_indexed(cpu))
+                return __get_ids_indexed(cpu, TOPO_OBJ_L2_CLUSTER, count);
+
         l2ids = (unsigned *)malloc(sizeof(l2ids[0]) * cpu->num_cores);
         if (l2ids == NULL)
                 return NULL;
@@ -246,9 +344,6 @@ pqos_cpu_get_l2ids(const struct pqos_cpuinfo *cpu, unsigned *count)
  *
  * @param [in] cpu CPU topology
  * @param [in] type CPU topology object type to search cores for
- *             TOPO_OBJ_SOCKET - sockets
- *             TOPO_OBJ_L2_CLUSTER - L2 cache clusters
- *             TOPO_OBJ_L3_CLUSTER - L3 cache clusters
  * @param [in] id CPU topology object ID to search cores for
  * @param [out] count place to put number of objects found
  *
@@ -257,7 +352,7 @@ pqos_cpu_get_l2ids(const struct pqos_cpuinfo *cpu, unsigned *count)
  */
 static unsigned *
 __get_cores_per_topology_obj(const struct pqos_cpuinfo *cpu,
-                             const int type,
+                             const enum topo_obj type,
                              const unsigned id,
                              unsigned *count)
 {
@@ -269,6 +364,22 @@ __get_cores_per_topology_obj(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || count == NULL)
                 return NULL;
 
+        if (topo_is_indexed(cpu)) {
+                const unsigned *cores;
+
+                if (topo_obj_cores(cpu, type, id, &cores, &num) !=
+                    PQOS_RETVAL_OK)
+                        return NULL;
+
+                core_list = (unsigned *)malloc(num * sizeof(core_list[0]));
+                if (core_list == NULL)
+                        return NULL;
+
+                memcpy(core_list, cores, num * sizeof(core_list[0]));
+                *count = num;
+                return core_list;
+        }
+
         core_list = (unsigned *)malloc(cpu->num_cores * sizeof(core_list[0]));
         if (core_list == NULL)
                 return NULL;
@@ -311,18 +422,12 @@ pqos_cpu_get_cores(const struct pqos_cpuinfo *cpu,
 const struct pqos_coreinfo *
 pqos_cpu_get_core_info(const struct pqos_cpuinfo *cpu, unsigned lcore)
 {
-        unsigned i;
-
         ASSERT(cpu != NULL);
 
         if (cpu == NULL)
                 return NULL;
 
-        for (i = 0; i < cpu->num_cores; i++)
-                if (cpu->cores[i].lcore == lcore)
-                        return &cpu->cores[i];
-
-        return NULL;
+        return __get_core(cpu, lcore);
 }
 
 int
@@ -338,6 +443,9 @@ pqos_cpu_get_one_core(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || lcore == NULL)
                 return PQOS_RETVAL_PARAM;
 
+        if (topo_is_indexed(cpu))
+                return __get_one_indexed(cpu, TOPO_OBJ_SOCKET, socket, lcore);
+
         for (i = 0; i < cpu->num_cores; i++)
                 if (cpu->cores[i].socket == socket) {
                         *lcore = cpu->cores[i].lcore;
@@ -361,6 +469,9 @@ pqos_cpu_get_one_by_numaid(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || lcore == NULL)
                 return PQOS_RETVAL_PARAM;
 
+        if (topo_is_indexed(cpu))
+                return __get_one_indexed(cpu, TOPO_OBJ_NUMA, numaid, lcore);
+
         for (i = 0; i < cpu->num_cores; i++)
                 if (cpu->cores[i].numa == numaid) {
                         *lcore = cpu->cores[i].lcore;
@@ -384,6 +495,9 @@ pqos_cpu_get_one_by_l3cat_id(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || lcore == NULL)
                 return PQOS_RETVAL_PARAM;
 
+        if (topo_is_indexed(cpu))
+                return __get_one_indexed(cpu, TOPO_OBJ_L3CAT, l3cat_id, lcore);
+
         for (i = 0; i < cpu->num_cores; i++)
                 if (cpu->cores[i].l3cat_id == l3cat_id) {
                         *lcore = cpu->cores[i].lcore;
@@ -406,6 +520,9 @@ pqos_cpu_get_one_by_mba_id(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || lcore == NULL)
                 return PQOS_RETVAL_PARAM;
 
+        if (topo_is_indexed(cpu))
+                return __get_one_indexed(cpu, TOPO_OBJ_MBA, mba_id, lcore);
+
         for (i = 0; i < cpu->num_cores; i++)
                 if (cpu->cores[i].mba_id == mba_id) {
                         *lcore = cpu->cores[i].lcore;
@@ -428,6 +545,9 @@ pqos_cpu_get_one_by_l2id(const struct pqos_cpuinfo *cpu,
         if (cpu == NULL || lcore == NULL)
                 return PQOS_RETVAL_PARAM;
 
+        if (topo_is_indexed(cpu))
+                return __get_one_indexed(cpu, TOPO_OBJ_L2_CLUSTER, l2id, lcore);
+
         for (i = 0; i < cpu->num_cores; i++)
                 if (cpu->cores[i].l2_id == l2id) {
                         *lcore = cpu->cores[i].lcore;
@@ -440,17 +560,14 @@ pqos_cpu_get_one_by_l2id(const struct pqos_cpuinfo *cpu,
 int
 pqos_cpu_check_core(const struct pqos_cpuinfo *cpu, const unsigned lcore)
 {
-        unsigned i = 0;
-
         ASSERT(cpu != NULL);
         if (cpu == NULL)
                 return PQOS_RETVAL_PARAM;
 
-        for (i = 0; i < cpu->num_cores; i++)
-                if (cpu->cores[i].lcore == lcore)
-                        return PQOS_RETVAL_OK;
+        if (__get_core(cpu, lcore) == NULL)
+                return PQOS_RETVAL_ERROR;
 
-        return PQOS_RETVAL_ERROR;
+        return PQOS_RETVAL_OK;
 }
 
 int
@@ -458,18 +575,17 @@ pqos_cpu_get_socketid(const struct pqos_cpuinfo *cpu,
                       const unsigned lcore,
                       unsigned *socket)
 {
-        unsigned i = 0;
+        const struct pqos_coreinfo *info;
 
         if (cpu == NULL || socket == NULL)
                 return PQOS_RETVAL_PARAM;
 
-        for (i = 0; i < cpu->num_cores; i++)
-                if (cpu->cores[i].lcore == lcore) {
-                        *socket = cpu->cores[i].socket;
-                        return PQOS_RETVAL_OK;
-                }
+        info = __get_core(cpu, lcore);
+        if (info == NULL)
+                return PQOS_RETVAL_ERROR;
 
-        return PQOS_RETVAL_ERROR;
+        *socket = info->socket;
+        return PQOS_RETVAL_OK;
 }
 
 #if (PQOS_VERSION >= 50000 || defined PQOS_SNC)
@@ -478,18 +594,17 @@ pqos_cpu_get_numaid(const struct pqos_cpuinfo *cpu,
                     const unsigned lcore,
                     unsigned *numa)
 {
-        unsigned i = 0;
+        const struct pqos_coreinfo *info;
 
         if (cpu == NULL || numa == NULL)
                 return PQOS_RETVAL_PARAM;
 
-        for (i = 0; i < cpu->num_cores; i++)
-                if (cpu->cores[i].lcore == lcore) {
-                        *numa = cpu->cores[i].numa;
-                        return PQOS_RETVAL_OK;
-                }
+        info = __get_core(cpu, lcore);
+        if (info == NULL)
+                return PQOS_RETVAL_ERROR;
 
-        return PQOS_RETVAL_ERROR;
+        *numa = info->numa;
+        return PQOS_RETVAL_OK;
 }
 #endif /* PQOS_SNC */
 
@@ -498,18 +613,17 @@ pqos_cpu_get_clusterid(const struct pqos_cpuinfo *cpu,
                        const unsigned lcore,
                        unsigned *cluster)
 {
-        unsigned i = 0;
+        const struct pqos_coreinfo *info;
 
         if (cpu == NULL || cluster == NULL)
                 return PQOS_RETVAL_PARAM;
 
-        for (i = 0; i < cpu->num_cores; i++)
-                if (cpu->cores[i].lcore == lcore) {
-                        *cluster = cpu->cores[i].l3_id;
-                        return PQOS_RETVAL_OK;
-                }
+        info = __get_core(cpu, lcore);
+        if (info == NULL)
+                return PQOS_RETVAL_ERROR;
 
-        return PQOS_RETVAL_ERROR;
+        *cluster = info->l3_id;
+        return PQOS_RETVAL_OK;
 }
 
 int
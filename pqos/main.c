@@ -637,6 +637,13 @@ parse_config_file(const char *fname)
             {"monitor-interval:",   selfn_monitor_interval },  /**< -i */
             {"monitor-file:",       selfn_monitor_file },      /**< -o */
             {"monitor-file-type:",  selfn_monitor_file_type }, /**< -u */
+            {"monitor-publish:",    selfn_monitor_publish },
+            {"monitor-export:",     selfn_monitor_export },
+            {"monitor-stats:",      selfn_monitor_stats },
+            {"monitor-control:",    selfn_monitor_control },
+            {"monitor-rates:",      selfn_monitor_rates },
+            {"monitor-recorder:",   selfn_monitor_recorder },
+            {"monitor-proc-fds:",   selfn_monitor_proc_fds },
             {"monitor-top-like:",   selfn_monitor_top_like },  /**< -T */
             {"reset-cat:",          selfn_reset_alloc },       /**< -R */
             {"iface-os:",           selfn_iface_os },          /**< -I */
@@ -725,6 +732,10 @@ static const char help_printf_short[] =
     "          [-T] [--mon-top]\n"
     "          [-o FILE] [--mon-file=FILE]\n"
     "          [-u TYPE] [--mon-file-type=TYPE]\n"
+    "          [--mon-publish=NAME] [--mon-export=ADDR]\n"
+    "          [--mon-stats=STATS] [--mon-control=PATH]\n"
+    "          [--mon-rates=RATES] [--mon-recorder=FILE]\n"
+    "          [--mon-proc-fds=N]\n"
     "          [-r] [--mon-reset]\n"
     "          [-P] [--percent-llc]\n"
     "       %s [-e CLASSDEF] [--alloc-class=CLASSDEF]\n"
@@ -802,6 +813,11 @@ static const char help_printf_long[] =
     "          Process's IDs can be grouped by enclosing them in square "
     "brackets,\n"
     "          Examples: 'llc:[22,25673]' or 'all:892,[4588-4592]'\n"
+    "          PID_LIST can be a process selector, which forms one group\n"
+    "          that processes join and leave as they match, re-resolved\n"
+    "          every second: comm:NAME, cmdline~REGEX, user:NAME|UID,\n"
+    "          ppid:PID or ppid:PID+descendants. EVENT is optional.\n"
+    "          Examples: 'comm:nginx' or 'llc:ppid:4588+descendants'\n"
     "          Note:\n"
     "               Requires Linux and kernel versions 4.10 and newer.\n"
     "               The -I option must be used for PID monitoring.\n"
@@ -818,9 +834,40 @@ static const char help_printf_long[] =
     "  -o FILE, --mon-file=FILE    output monitored data in a FILE\n"
     "  -u TYPE, --mon-file-type=TYPE\n"
     "          select output file format type for monitored data.\n"
-    "          TYPE is one of: text (default), xml or csv.\n"
+    "          TYPE is one of: text (default), xml, csv, bin or raw.\n"
+    "  --mon-publish=NAME\n"
+    "          publish monitored data in /dev/shm/NAME telemetry segment.\n"
+    "  --mon-export=ADDR\n"
+    "          serve monitored data in Prometheus text format over HTTP.\n"
+    "          ADDR is [HOST:]PORT (default host 127.0.0.1) or unix:PATH.\n"
+    "  --mon-stats=STATS\n"
+    "          add streaming statistics of IPC, LLC and MBM to text, xml\n"
+    "          and csv output. STATS is a comma separated list of ewma,\n"
+    "          min, max and pN quantiles (e.g. p99) with optional\n"
+    "          half-life=SEC (default 10) and window=SEC (default 60).\n"
+    "  --mon-control=PATH\n"
+    "          accept commands on unix socket PATH to add, remove, grow\n"
+    "          or shrink monitoring groups, change events or interval and\n"
+    "          rotate the output file while monitoring.\n"
+    "  --mon-rates=RATES\n"
+    "          poll event classes at own intervals. RATES is a comma\n"
+    "          separated list of CLASS=INTERVAL, CLASS is llc, mbm, ipc,\n"
+    "          llc_miss, llc_ref or pcie and INTERVAL is Nx100ms, Nms or\n"
+    "          Ns, e.g. mbm=10ms,llc=1s. cold=INTERVAL polls groups below\n"
+    "          cold-mbps=N MB/s (default 1) at INTERVAL only.\n"
+    "  --mon-recorder=FILE[,SETTINGS]\n"
+    "          record every poll into a ring in memory mapped FILE and\n"
+    "          write the samples around a trigger to FILE.TIME.csv.\n"
+    "          SETTINGS are before=SEC (default 10), after=SEC (default\n"
+    "          5), ipc-below=IPC and mbm-above=MBPS triggers. Capture is\n"
+    "          also triggered by SIGUSR1 and the trigger control command.\n"
+    "  --mon-proc-fds=N\n"
+    "          keep at most N /proc stat files open to speed up process\n"
+    "          scans of top-pids and selector monitoring. Default is a\n"
+    "          quarter of the open files limit, at most 1024.\n"
     "  -i N, --mon-interval=N      set sampling interval to Nx100ms,\n"
     "                              default 10 = 10 x 100ms = 1s.\n"
+    "                              Use Nms to set the interval in ms.\n"
     "  -T, --mon-top               top like monitoring output\n"
     "  -t SECONDS, --mon-time=SECONDS\n"
     "          set monitoring time in seconds. Use 'inf' or 'infinite'\n"
@@ -900,6 +947,13 @@ print_lib_version(const struct pqos_cap *p_cap)
 #define OPTION_VERSION              1003
 #define OPTION_INTERFACE            1004
 #define OPTION_MON_UNCORE           1005
+#define OPTION_MON_PUBLISH          1006
+#define OPTION_MON_EXPORT           1007
+#define OPTION_MON_STATS            1008
+#define OPTION_MON_CONTROL          1009
+#define OPTION_MON_RATES            1010
+#define OPTION_MON_RECORDER         1011
+#define OPTION_MON_PROC_FDS         1012
 
 static struct option long_cmd_opts[] = {
     /* clang-format off */
@@ -919,6 +973,13 @@ static struct option long_cmd_opts[] = {
     {"mon-top",              no_argument,       0, 'T'},
     {"mon-file",             required_argument, 0, 'o'},
     {"mon-file-type",        required_argument, 0, 'u'},
+    {"mon-publish",          required_argument, 0, OPTION_MON_PUBLISH},
+    {"mon-export",           required_argument, 0, OPTION_MON_EXPORT},
+    {"mon-stats",            required_argument, 0, OPTION_MON_STATS},
+    {"mon-control",          required_argument, 0, OPTION_MON_CONTROL},
+    {"mon-rates",            required_argument, 0, OPTION_MON_RATES},
+    {"mon-recorder",         required_argument, 0, OPTION_MON_RECORDER},
+    {"mon-proc-fds",         required_argument, 0, OPTION_MON_PROC_FDS},
     {"mon-reset",            no_argument,       0, 'r'},
     {"disable-mon-ipc",      no_argument,       0, OPTION_DISABLE_MON_IPC},
     {"disable-mon-llc_miss", no_argument,       0, OPTION_DISABLE_MON_LLC_MISS},
@@ -1029,6 +1090,27 @@ main(int argc, char **argv)
                 case 'u':
                         selfn_monitor_file_type(optarg);
                         break;
+                case OPTION_MON_PUBLISH:
+                        selfn_monitor_publish(optarg);
+                        break;
+                case OPTION_MON_EXPORT:
+                        selfn_monitor_export(optarg);
+                        break;
+                case OPTION_MON_STATS:
+                        selfn_monitor_stats(optarg);
+                        break;
+                case OPTION_MON_CONTROL:
+                        selfn_monitor_control(optarg);
+                        break;
+                case OPTION_MON_RATES:
+                        selfn_monitor_rates(optarg);
+                        break;
+                case OPTION_MON_RECORDER:
+                        selfn_monitor_recorder(optarg);
+                        break;
+                case OPTION_MON_PROC_FDS:
+                        selfn_monitor_proc_fds(optarg);
+                        break;
                 case 'e':
                         selfn_allocation_class(optarg);
                         break;
@@ -38,11 +38,20 @@
 
 #include "common.h"
 #include "main.h"
+#include "monitor_bin.h"
+#include "monitor_control.h"
 #include "monitor_csv.h"
+#include "monitor_export.h"
+#include "monitor_raw.h"
+#include "monitor_rates.h"
+#include "monitor_recorder.h"
+#include "monitor_stats.h"
 #include "monitor_text.h"
 #include "monitor_utils.h"
 #include "monitor_xml.h"
 #include "pqos.h"
+#include "proc_scan.h"
+#include "proc_select.h"
 #ifdef PQOS_RMID_CUSTOM
 #include "pqos_internal.h"
 #endif
@@ -50,6 +59,8 @@
 #include <ctype.h>  /**< isspace() */
 #include <dirent.h> /**< for dir list*/
 #include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -76,9 +87,8 @@
 #define TOP_PROC_MAX (10)  /**< maximum number of top-pids to be handled */
 #define NUM_TIDS_MAX (128) /**< maximum number of TIDs */
 
-#define PID_COL_STATUS (3)  /**< col for process status letter */
-#define PID_COL_UTIME  (14) /**< col for cpu-user time in /proc/pid/stat */
-#define PID_COL_STIME  (15) /**< col for cpu-kernel time in /proc/pid/stat */
+#define TOP_PROC_REFRESH_MS    (2000) /**< top-pids refresh period */
+#define PROC_SELECT_REFRESH_MS (1000) /**< process selector refresh period */
 
 #define TIMEOUT_INFINITE ((unsigned)-1)
 
@@ -130,6 +140,8 @@ static struct mon_group {
         enum pqos_mon_event events;
         struct pqos_mon_data *data;
         unsigned started;
+        unsigned cold;           /**< polled at the cold group interval */
+        struct proc_select *sel; /**< selector resolving group PIDs */
 
         union {
                 unsigned *cores;
@@ -159,7 +171,7 @@ static int sel_monitor_type = 0;
  * Maintains monitoring interval that is selected in config string for
  * monitoring L3 occupancy
  */
-static int sel_mon_interval = 10; /**< 10 = 10x100ms = 1s */
+static unsigned sel_mon_interval = 1000; /**< interval in ms */
 
 /**
  * Maintains TOP like output that is selected in config string for
@@ -183,34 +195,70 @@ static char *sel_output_file = NULL;
  */
 static char *sel_output_type = NULL;
 
+/**
+ * Maintains selected telemetry segment name
+ */
+static char *sel_publish_name = NULL;
+
+/**
+ * Maintains selected metrics exporter address
+ */
+static char *sel_export_addr = NULL;
+
+/**
+ * Maintains selected streaming statistics
+ */
+static char *sel_stats_spec = NULL;
+
+/**
+ * Maintains selected control socket path
+ */
+static char *sel_control_path = NULL;
+
+/**
+ * Maintains selected polling rates
+ */
+static char *sel_rates_spec = NULL;
+
+/**
+ * Maintains selected flight recorder
+ */
+static char *sel_recorder_spec = NULL;
+
+/**
+ * Maintains selected number of cached /proc descriptors, -1 for default
+ */
+static int sel_proc_fds = -1;
+
+/**
+ * Monitoring capability used to set up groups added at run time
+ */
+static const struct pqos_capability *mon_cap = NULL;
+
 /**
  * Stop monitoring indicator for infinite monitoring loop
  */
 static int stop_monitoring_loop = 0;
 
+/**
+ * Flight recorder trigger requested by signal
+ */
+static volatile sig_atomic_t recorder_signal = 0;
+
 /**
  * File descriptor for writing monitored data into
  */
 static FILE *fp_monitor = NULL;
 
 /**
- * Maintains process statistics. It is used for getting N pids to be displayed
- * in top-pid monitoring mode.
+ * Process scanner for top-pids monitoring mode
  */
-struct proc_stats {
-        pid_t pid;                 /**< process pid */
-        unsigned long ticks_delta; /**< current cpu_time - previous ticks */
-        double cpu_avg_ratio;      /**< cpu usage/running time ratio*/
-        int valid; /**< marks if statistics are fully processed */
-};
+static struct proc_scan *top_scan = NULL;
 
 /**
- * Maintains single linked list implementation
+ * Process scanner for groups defined by process selectors
  */
-struct slist {
-        void *data;         /**< abstract data that is hold by a list element */
-        struct slist *next; /**< ptr to next list element */
-};
+static struct proc_scan *select_scan = NULL;
 
 /**
  * Stores display format for LLC (kilobytes/percent)
@@ -557,6 +605,7 @@ grp_cmp(const struct mon_group *grp_a, const struct mon_group *grp_b)
 static void
 grp_free(struct mon_group *grp)
 {
+        proc_select_destroy(grp->sel);
         free(grp->desc);
 #ifndef __clang_analyzer__
         free(grp->generic_res);
@@ -675,6 +724,44 @@ grp_add(enum mon_group_type type,
         return &sel_monitor_group[sel_monitor_num - 1];
 }
 
+/**
+ * @brief Translates event name into monitoring event
+ *
+ * @param name event name, not necessarily NUL terminated
+ * @param len length of \a name, empty name selects all events
+ * @param [out] evt monitoring event
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 unrecognized event name
+ */
+static int
+str_to_event(const char *name, const size_t len, enum pqos_mon_event *evt)
+{
+        static const struct {
+                const char *name;
+                enum pqos_mon_event event;
+        } names[] = {
+            {"llc", PQOS_MON_EVENT_L3_OCCUP},
+            {"mbr", PQOS_MON_EVENT_RMEM_BW},
+            {"mbl", PQOS_MON_EVENT_LMEM_BW},
+            {"mbt", PQOS_MON_EVENT_TMEM_BW},
+            {"all", (enum pqos_mon_event)PQOS_MON_EVENT_ALL},
+            {"", (enum pqos_mon_event)PQOS_MON_EVENT_ALL},
+            {"llc_ref", PQOS_PERF_EVENT_LLC_REF},
+        };
+        unsigned i;
+
+        for (i = 0; i < DIM(names); i++)
+                if (strlen(names[i].name) == len &&
+                    strncasecmp(name, names[i].name, len) == 0) {
+                        *evt = names[i].event;
+                        return 0;
+                }
+
+        return -1;
+}
+
 /**
  * @brief Common function to parse selected events
  *
@@ -685,31 +772,110 @@ grp_add(enum mon_group_type type,
 static void
 parse_event(const char *str, enum pqos_mon_event *evt)
 {
+        const char *colon;
+
         ASSERT(str != NULL);
         ASSERT(evt != NULL);
         /**
          * Set event value and sel_event_max which determines
          * what events to display (out of all possible)
          */
-        if (strncasecmp(str, "llc:", 4) == 0)
-                *evt = PQOS_MON_EVENT_L3_OCCUP;
-        else if (strncasecmp(str, "mbr:", 4) == 0)
-                *evt = PQOS_MON_EVENT_RMEM_BW;
-        else if (strncasecmp(str, "mbl:", 4) == 0)
-                *evt = PQOS_MON_EVENT_LMEM_BW;
-        else if (strncasecmp(str, "mbt:", 4) == 0)
-                *evt = PQOS_MON_EVENT_TMEM_BW;
-        else if (strncasecmp(str, "all:", 4) == 0 ||
-                 strncasecmp(str, ":", 1) == 0)
-                *evt = (enum pqos_mon_event)PQOS_MON_EVENT_ALL;
-        else if (strncasecmp(str, "llc_ref:", 8) == 0)
-                *evt = PQOS_PERF_EVENT_LLC_REF;
-        else
+        colon = strchr(str, ':');
+        if (colon == NULL || str_to_event(str, colon - str, evt) != 0)
                 parse_error(str, "Unrecognized monitoring event type");
 }
 
 #define PARSE_MON_GRP_BUFF_SIZE 1250
 
+/**
+ * @brief Checks if the PID is monitored by any group
+ *
+ * @param pid process id
+ *
+ * @return 1 when monitored, 0 otherwise
+ */
+static int
+grp_pid_used(const pid_t pid)
+{
+        unsigned i, j;
+
+        for (i = 0; i < sel_monitor_num; i++) {
+                const struct mon_group *grp = &sel_monitor_group[i];
+
+                if (grp->type != MON_GROUP_TYPE_PID)
+                        continue;
+                for (j = 0; j < grp->num_res; j++)
+                        if (grp->pids[j] == pid)
+                                return 1;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Adds PID monitoring group following a process selector
+ *
+ * Processes already monitored by other groups are skipped.
+ *
+ * @param expr process selector expression
+ * @param evt monitoring events
+ *
+ * @return number of added groups
+ * @retval -1 on error
+ */
+static int
+parse_monitor_select(const char *expr, const enum pqos_mon_event evt)
+{
+        uint64_t cbuf[PARSE_MON_GRP_BUFF_SIZE];
+        struct proc_select *sel;
+        struct mon_group *grp;
+        const pid_t *pids;
+        char *desc = NULL;
+        unsigned num_pids;
+        unsigned num = 0;
+        unsigned i;
+
+        if (select_scan == NULL) {
+                select_scan = proc_scan_create(proc_pids_dir);
+                if (select_scan == NULL) {
+                        printf("Process scanner allocation failed!\n");
+                        return -1;
+                }
+        }
+
+        sel = proc_select_create(expr, select_scan);
+        if (sel == NULL)
+                return -1;
+
+        if (proc_scan_update(select_scan) != 0 ||
+            proc_select_update(sel, select_scan) != 0) {
+                printf("Resolving process selector '%s' failed!\n", expr);
+                proc_select_destroy(sel);
+                return -1;
+        }
+
+        /* further matches join the group at run time */
+        pids = proc_select_pids(sel, &num_pids);
+        for (i = 0; i < num_pids && num < DIM(cbuf); i++)
+                if (!grp_pid_used(pids[i]))
+                        cbuf[num++] = (uint64_t)pids[i];
+        if (num == 0) {
+                printf("No process matches selector '%s'\n", expr);
+                proc_select_destroy(sel);
+                return 0;
+        }
+
+        selfn_strdup(&desc, expr);
+        grp = grp_add(MON_GROUP_TYPE_PID, evt, desc, cbuf, num);
+        if (grp == NULL) {
+                proc_select_destroy(sel);
+                return -1;
+        }
+        grp->sel = sel;
+
+        return 1;
+}
+
 /**
  * @brief Function to set the descriptions and cores/pids for each monitoring
  * group
@@ -728,10 +894,18 @@ parse_monitor_group(char *str, enum mon_group_type type)
         uint64_t cbuf[PARSE_MON_GRP_BUFF_SIZE];
         char *non_grp = NULL;
 
+        /* event type is optional in front of a process selector */
+        if (type == MON_GROUP_TYPE_PID && proc_select_is_expr(str))
+                return parse_monitor_select(
+                    str, (enum pqos_mon_event)PQOS_MON_EVENT_ALL);
+
         parse_event(str, &evt);
 
         str = strchr(str, ':') + 1;
 
+        if (type == MON_GROUP_TYPE_PID && proc_select_is_expr(str))
+                return parse_monitor_select(str, evt);
+
         while ((non_grp = strsep(&str, "[")) != NULL) {
                 /**
                  * Ungrouped cores/pids
@@ -812,6 +986,52 @@ selfn_monitor_file(const char *arg)
         selfn_strdup(&sel_output_file, arg);
 }
 
+void
+selfn_monitor_publish(const char *arg)
+{
+        selfn_strdup(&sel_publish_name, arg);
+}
+
+void
+selfn_monitor_export(const char *arg)
+{
+        selfn_strdup(&sel_export_addr, arg);
+}
+
+void
+selfn_monitor_stats(const char *arg)
+{
+        selfn_strdup(&sel_stats_spec, arg);
+}
+
+void
+selfn_monitor_control(const char *arg)
+{
+        selfn_strdup(&sel_control_path, arg);
+}
+
+void
+selfn_monitor_rates(const char *arg)
+{
+        selfn_strdup(&sel_rates_spec, arg);
+}
+
+void
+selfn_monitor_recorder(const char *arg)
+{
+        selfn_strdup(&sel_recorder_spec, arg);
+}
+
+void
+selfn_monitor_proc_fds(const char *arg)
+{
+        const uint64_t num = strtouint64(arg);
+
+        if (num > INT_MAX)
+                parse_error(arg, "Invalid number of descriptors!\n");
+        sel_proc_fds = (int)num;
+}
+
 void
 selfn_monitor_set_llc_percent(void)
 {
@@ -956,6 +1176,28 @@ selfn_monitor_uncore(const char *arg)
         free(cp);
 }
 
+/**
+ * @brief Opens monitoring output file
+ *
+ * Text output is appended to an existing file, other formats start
+ * a new file.
+ *
+ * @param file file name
+ *
+ * @return file stream or NULL on error
+ */
+static FILE *
+mon_output_open(const char *file)
+{
+        if (strcasecmp(sel_output_type, "xml") == 0 ||
+            strcasecmp(sel_output_type, "csv") == 0 ||
+            strcasecmp(sel_output_type, "bin") == 0 ||
+            strcasecmp(sel_output_type, "raw") == 0)
+                return safe_fopen(file, "w+");
+
+        return safe_fopen(file, "a");
+}
+
 /**
  * Update list of events to be monitored
  *
@@ -1006,6 +1248,81 @@ monitor_setup_events(enum mon_group_type type,
         sel_events_max |= *events;
 }
 
+/**
+ * @brief Starts monitoring of the group
+ *
+ * @param grp monitoring group
+ *
+ * @return PQoS library status
+ */
+static int
+grp_start(struct mon_group *grp)
+{
+        int ret = PQOS_RETVAL_PARAM;
+
+        if (grp->type == MON_GROUP_TYPE_CORE) {
+                /**
+                 * Make calls to pqos_mon_start - track cores
+                 */
+#ifdef PQOS_RMID_CUSTOM
+                ret = pqos_mon_start_cores_ext(
+                    grp->num_res, grp->cores, grp->events,
+                    (void *)grp->desc, &grp->data, &grp->opt);
+#else
+                ret = pqos_mon_start_cores(
+                    grp->num_res, grp->cores, grp->events,
+                    (void *)grp->desc, &grp->data);
+#endif
+
+                if (ret == PQOS_RETVAL_PERF_CTR)
+                        fprintf(stderr, "Use -r option to start monitoring "
+                                        "anyway.\n");
+                /**
+                 * The error raised also if two instances of PQoS
+                 * attempt to use the same core id.
+                 */
+                if (ret != PQOS_RETVAL_OK) {
+                        fprintf(stderr,
+                                "Monitoring start error on core(s) "
+                                "%s, status %d\n",
+                                grp->desc, ret);
+                } else
+                        grp->started = 1;
+
+        } else if (grp->type == MON_GROUP_TYPE_PID) {
+                /**
+                 * Make calls to pqos_mon_start_pid - track PIDs
+                 */
+                ret = pqos_mon_start_pids2(
+                    grp->num_res, grp->pids, grp->events,
+                    (void *)grp->desc, &grp->data);
+                /**
+                 * Any problem with monitoring the process?
+                 */
+                if (ret != PQOS_RETVAL_OK) {
+                        fprintf(stderr,
+                                "PID %s monitoring start error, "
+                                "status %d\n",
+                                grp->desc, ret);
+                } else
+                        grp->started = 1;
+
+        } else if (grp->type == MON_GROUP_TYPE_UNCORE) {
+                ret = pqos_mon_start_uncore(
+                    grp->num_res, grp->sockets, grp->events,
+                    (void *)grp->desc, &grp->data);
+                if (ret != PQOS_RETVAL_OK) {
+                        fprintf(stderr,
+                                "Uncore monitoring start error on socket"
+                                " %s, status %d\n",
+                                grp->desc, ret);
+                } else
+                        grp->started = 1;
+        }
+
+        return ret;
+}
+
 int
 monitor_setup(const struct pqos_cpuinfo *cpu_info,
               const struct pqos_capability *const cap_mon)
@@ -1013,6 +1330,8 @@ monitor_setup(const struct pqos_cpuinfo *cpu_info,
         unsigned i;
         int ret = PQOS_RETVAL_OK;
 
+        mon_cap = cap_mon;
+
         /**
          * Check output file type
          */
@@ -1026,7 +1345,9 @@ monitor_setup(const struct pqos_cpuinfo *cpu_info,
 
         if (strcasecmp(sel_output_type, "text") != 0 &&
             strcasecmp(sel_output_type, "xml") != 0 &&
-            strcasecmp(sel_output_type, "csv") != 0) {
+            strcasecmp(sel_output_type, "csv") != 0 &&
+            strcasecmp(sel_output_type, "bin") != 0 &&
+            strcasecmp(sel_output_type, "raw") != 0) {
                 printf("Invalid selection of file output type '%s'!\n",
                        sel_output_type);
                 return -1;
@@ -1038,11 +1359,7 @@ monitor_setup(const struct pqos_cpuinfo *cpu_info,
         if (sel_output_file == NULL) {
                 fp_monitor = stdout;
         } else {
-                if (strcasecmp(sel_output_type, "xml") == 0 ||
-                    strcasecmp(sel_output_type, "csv") == 0)
-                        fp_monitor = safe_fopen(sel_output_file, "w+");
-                else
-                        fp_monitor = safe_fopen(sel_output_file, "a");
+                fp_monitor = mon_output_open(sel_output_file);
                 if (fp_monitor == NULL) {
                         perror("Monitoring output file open error:");
                         printf("Error opening '%s' output file!\n",
@@ -1097,65 +1414,9 @@ monitor_setup(const struct pqos_cpuinfo *cpu_info,
 
                 monitor_setup_events(grp->type, &grp->events, cap_mon);
 
-                if (grp->type == MON_GROUP_TYPE_CORE) {
-                        /**
-                         * Make calls to pqos_mon_start - track cores
-                         */
-#ifdef PQOS_RMID_CUSTOM
-                        ret = pqos_mon_start_cores_ext(
-                            grp->num_res, grp->cores, grp->events,
-                            (void *)grp->desc, &grp->data, &grp->opt);
-#else
-                        ret = pqos_mon_start_cores(
-                            grp->num_res, grp->cores, grp->events,
-                            (void *)grp->desc, &grp->data);
-#endif
-
-                        if (ret == PQOS_RETVAL_PERF_CTR)
-                                printf("Use -r option to start monitoring "
-                                       "anyway.\n");
-                        /**
-                         * The error raised also if two instances of PQoS
-                         * attempt to use the same core id.
-                         */
-                        if (ret != PQOS_RETVAL_OK) {
-                                printf("Monitoring start error on core(s) "
-                                       "%s, status %d\n",
-                                       grp->desc, ret);
-                                break;
-                        } else
-                                grp->started = 1;
-
-                } else if (grp->type == MON_GROUP_TYPE_PID) {
-                        /**
-                         * Make calls to pqos_mon_start_pid - track PIDs
-                         */
-                        ret = pqos_mon_start_pids2(
-                            grp->num_res, grp->pids, grp->events,
-                            (void *)grp->desc, &grp->data);
-                        /**
-                         * Any problem with monitoring the process?
-                         */
-                        if (ret != PQOS_RETVAL_OK) {
-                                printf("PID %s monitoring start error,"
-                                       "status %d\n",
-                                       grp->desc, ret);
-                                break;
-                        } else
-                                grp->started = 1;
-
-                } else if (grp->type == MON_GROUP_TYPE_UNCORE) {
-                        ret = pqos_mon_start_uncore(
-                            grp->num_res, grp->sockets, grp->events,
-                            (void *)grp->desc, &grp->data);
-                        if (ret != PQOS_RETVAL_OK) {
-                                printf("Uncore monitoring start error on socket"
-                                       " %s, status %d\n",
-                                       grp->desc, ret);
-                                break;
-                        } else
-                                grp->started = 1;
-                }
+                ret = grp_start(grp);
+                if (ret != PQOS_RETVAL_OK)
+                        break;
         }
         if (ret != PQOS_RETVAL_OK) {
                 /**
@@ -1208,9 +1469,24 @@ selfn_monitor_time(const char *arg)
 void
 selfn_monitor_interval(const char *arg)
 {
-        sel_mon_interval = (int)strtouint64(arg);
-        if (sel_mon_interval < 1)
+        const size_t len = strlen(arg);
+        uint64_t interval;
+
+        /* interval is given in 100ms units unless "ms" suffix is used */
+        if (len > 2 && strcasecmp(arg + len - 2, "ms") == 0) {
+                char buf[32];
+
+                if (len - 2 >= sizeof(buf))
+                        parse_error(arg, "Invalid interval value!\n");
+                memcpy(buf, arg, len - 2);
+                buf[len - 2] = '\0';
+                interval = strtouint64(buf);
+        } else
+                interval = strtouint64(arg) * 100;
+
+        if (interval < 1 || interval > INT_MAX)
                 parse_error(arg, "Invalid interval value!\n");
+        sel_mon_interval = (unsigned)interval;
 }
 
 void
@@ -1273,727 +1549,1655 @@ selfn_monitor_pids(const char *arg)
 }
 
 /**
- * @brief Helper function for checking remainder-string filled out by
- *        strtoul function - checks if conversion succeeded or failed
- *
- * @param str_remainder remainder string from strtoul function
+ * @brief Adds monitoring groups for processes with highest CPU usage
  *
- * @return boolean status of conversion
- * @retval 0 conversion failed
- * @retval 1 conversion succeeded
+ * @return number of added groups
  */
-static int
-is_str_conversion_ok(const char *str_remainder)
+static unsigned
+fill_top_procs(void)
 {
-        if (str_remainder == NULL)
-                /* invalid remainder, cannot tell if content is OK or not*/
-                return 0;
+        struct proc_scan_entry top[TOP_PROC_MAX];
+        unsigned num;
+        unsigned i;
 
-        if (*str_remainder == '\0')
-                /* if nothing left for parsing, conversion succeeded*/
-                return 1;
-        else
-                /* conversion failed*/
-                return 0;
+        num = proc_scan_top(top_scan, proc_stat_whitelist, top, TOP_PROC_MAX);
+
+        for (i = 0; i < num; i++) {
+                char *desc = uinttostr((unsigned)top[i].pid);
+                uint64_t pid = (uint64_t)top[i].pid;
+                const struct mon_group *grp;
+
+                grp = grp_add(MON_GROUP_TYPE_PID,
+                              (enum pqos_mon_event)PQOS_MON_EVENT_ALL, desc,
+                              &pid, 1);
+                if (grp == NULL)
+                        exit(EXIT_FAILURE);
+        }
+
+        return num;
 }
 
 /**
- * @brief Returns combined ticks that process spent by using cpu both in
- *        user mode and kernel mode
- *
- * @param proc_pid_dir_name name of target PID directory e.g, "1234"
- * @param cputicks[out] cputicks value for given PID, it is filled as 'out'
- *                      value and has to be != NULL
- *
- * @return operation status
- * @retval 0 in case of success
- * @retval -1 in case of error
+ * @brief Looks for processes with highest CPU usage on the system and
+ *        starts monitoring for them. Processes are displayed and sorted
+ *        afterwards by LLC occupancy
  */
-static int
-get_pid_cputicks(const char *proc_pid_dir_name, uint64_t *cputicks)
+void
+selfn_monitor_top_pids(void)
 {
-        unsigned i;
-        const int col_val[3] = {PID_COL_STATUS, PID_COL_UTIME, PID_COL_STIME};
+        printf("Monitoring top-pids enabled\n");
+        sel_mon_top_like = 1;
 
-        if (proc_pid_dir_name == NULL || cputicks == NULL)
-                return -1;
+        top_scan = proc_scan_create(proc_pids_dir);
+        if (top_scan == NULL) {
+                printf("Process scanner allocation failed!\n");
+                return;
+        }
 
-        /* Loops through the /proc/<pid>/stat file three times to get values
-         * for pid status, user time, and kernel time
-         */
-        for (i = 0; i < DIM(col_val); i++) {
-                char time_str[64];
-                char *tmp;
-                unsigned long long time;
-                uint64_t time_int = 0;
-                int time_success = 0;
-
-                memset(time_str, 0, sizeof(time_str)); /*set time buffer to 0*/
-
-                time_success = monitor_utils_get_pid_stat(
-                    proc_pid_dir_name, col_val[i], sizeof(time_str), time_str);
-                if (time_success != 0)
-                        return -1;
+        /* getting initial values for CPU usage for processes */
+        if (proc_scan_update(top_scan) != 0) {
+                printf("Getting processor usage statistic failed!\n");
+                return;
+        }
 
-                if (col_val[i] == PID_COL_STATUS) {
-                        /* Checking status column in order to find valid
-                         * status for top-pid mode processes and eliminate
-                         * processes that are zombies, stopped etc.
-                         */
-                        if (strpbrk(time_str, proc_stat_whitelist) == NULL)
-                                /* Not valid status,ignoring entry*/
-                                return -1;
-                        else
-                                continue;
-                }
+        /* Giving here some time for processes for generating cpu activity.
+         * In general, there are two ways of calculating CPU usage:
+         * -the instantaneous one (checking ticks during last interval)
+         * -average one (reported ps)
+         *
+         * We are using a hybrid approach, at first looking for processes that
+         * did some work in last interval (and this is the reason for sleep
+         * here) but in case that there is not enough processes which reported
+         * cpu ticks, we are checking average ticks ratio for process lifetime.
+         * So the more time time we are sleeping here, the more processes will
+         * report ticks during this sleep interval and less processes will be
+         * found by checking average ticks ratio(it is less accurate method)
+         */
+        usleep(PID_CPU_TIME_DELAY_USEC);
 
-                time = strtoull(time_str, &tmp, 10);
-                if (time > UINT64_MAX)
-                        return -1;
-                time_int = (uint64_t)time;
-                /* Check to make sure string converted
-                 * to int correctly
-                 */
-                if (is_str_conversion_ok(tmp))
-                        *cputicks += time_int;
-                else
-                        return -1;
+        /* Getting updated CPU usage statistics*/
+        if (proc_scan_update(top_scan) != 0) {
+                printf("Getting updated processor usage statistic failed!\n");
+                return;
         }
 
-        /* Value for cputicks can be read from *cputicks param*/
-        return 0;
+        fill_top_procs();
 }
 
 /**
- * @brief Allocates memory and initializes new list element and returns ptr
- *        to newly created list-element with given data
+ * @brief Adds PIDs to or removes PIDs from a started PID monitoring group
  *
- * @param data pointer to data that will be stored in list element
+ * @param grp PID monitoring group
+ * @param pids PIDs to add that are not members of the group or PIDs to
+ *        remove that are members of the group
+ * @param num_pids number of PIDs
+ * @param grow add PIDs when set, remove otherwise
  *
- * @return pointer to allocated and initialized struct slist element. It has to
- *         be freed when no longer needed
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
  */
-static struct slist *
-slist_create_elem(void *data)
+static int
+grp_resize(struct mon_group *grp,
+           const pid_t *pids,
+           const unsigned num_pids,
+           const int grow)
 {
-        struct slist *node = (struct slist *)malloc(sizeof(struct slist));
+        unsigned i, j;
+        int ret;
 
-        if (node == NULL) {
-                printf("Error with memory allocation for slist element!");
-                exit(EXIT_FAILURE);
-        }
+        if (grow) {
+                pid_t *res = realloc(grp->pids, sizeof(*res) *
+                                                    (grp->num_res + num_pids));
+
+                if (res == NULL)
+                        return PQOS_RETVAL_RESOURCE;
+                grp->pids = res;
+
+                ret = pqos_mon_add_pids(num_pids, pids, grp->data);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
 
-        node->data = data;
-        node->next = NULL;
+                memcpy(&grp->pids[grp->num_res], pids,
+                       sizeof(*pids) * num_pids);
+                grp->num_res += num_pids;
+        } else {
+                unsigned num_left = 0;
+
+                ret = pqos_mon_remove_pids(num_pids, pids, grp->data);
+                if (ret != PQOS_RETVAL_OK)
+                        return ret;
+
+                for (j = 0; j < grp->num_res; j++) {
+                        for (i = 0; i < num_pids; i++)
+                                if (grp->pids[j] == pids[i])
+                                        break;
+                        if (i == num_pids)
+                                grp->pids[num_left++] = grp->pids[j];
+                }
+                grp->num_res = num_left;
+        }
 
-        return node;
+        return PQOS_RETVAL_OK;
 }
 
 /**
- * @brief Looks for an element with given pid in slist of proc_stats elements
+ * @brief Moves monitoring group to another process
+ *
+ * Group is polled once after the move, so counters and deltas of the
+ * previous process do not leak into the first sample of the new one.
  *
- * @param pslist pointer to beginning of a slist
- * @param pid pid to be searched in the slist
+ * @param grp top-pids monitoring group
+ * @param pid process to be monitored
  *
- * @return ptr to found struct proc_stats or NULL in case element with given PID
- *         has not been found in the slist
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
-static struct proc_stats *
-find_proc_stats_by_pid(const struct slist *pslist, const pid_t pid)
+static int
+top_proc_retarget(struct mon_group *grp, pid_t pid)
 {
-        const struct slist *it = NULL;
+        const pid_t old = grp->pids[0];
+        char *desc;
 
-        for (it = pslist; it != NULL; it = it->next) {
-                ASSERT(it->data != NULL);
-                struct proc_stats *pstats = (struct proc_stats *)it->data;
+        if (!grp->started || grp->data == NULL)
+                return -1;
 
-                if (pstats->pid == pid)
-                        return pstats;
-        }
+        if (pqos_mon_add_pids(1, &pid, grp->data) != PQOS_RETVAL_OK)
+                return -1;
+        /* previous process may have already exited */
+        (void)pqos_mon_remove_pids(1, &old, grp->data);
 
-        return NULL;
+        desc = uinttostr((unsigned)pid);
+        grp->pids[0] = pid;
+
+        /* new baseline, the next poll reports the new process only */
+        (void)pqos_mon_poll(&grp->data, 1);
+        grp->cold = 0;
+        monitor_stats_reset((unsigned)(grp - sel_monitor_group));
+        grp->data->context = desc;
+        free(grp->desc);
+        grp->desc = desc;
+
+        return 0;
+}
+
+/**
+ * @brief Refreshes CPU usage statistics and moves top-pids monitoring
+ *        groups to processes that became the heaviest CPU users
+ */
+static void
+top_procs_refresh(void)
+{
+        struct proc_scan_entry top[TOP_PROC_MAX];
+        unsigned num;
+        unsigned i, j, k;
+
+        if (proc_scan_update(top_scan) != 0)
+                return;
+
+        num = proc_scan_top(top_scan, proc_stat_whitelist, top, TOP_PROC_MAX);
+
+        for (i = 0; i < num; i++) {
+                struct mon_group *grp = NULL;
+
+                for (j = 0; j < sel_monitor_num; j++)
+                        if (sel_monitor_group[j].pids[0] == top[i].pid)
+                                break;
+                if (j < sel_monitor_num)
+                        continue; /* already monitored */
+
+                /* reuse group of a process that dropped out of the top */
+                for (j = 0; j < sel_monitor_num && grp == NULL; j++) {
+                        for (k = 0; k < num; k++)
+                                if (sel_monitor_group[j].pids[0] == top[k].pid)
+                                        break;
+                        if (k == num)
+                                grp = &sel_monitor_group[j];
+                }
+                if (grp == NULL)
+                        break;
+
+                (void)top_proc_retarget(grp, top[i].pid);
+        }
+}
+
+/**
+ * @brief Compares two PIDs
+ *
+ * @param a PID A
+ * @param b PID B
+ *
+ * @return PID compare status for ascending order
+ */
+static int
+pid_cmp(const void *a, const void *b)
+{
+        const pid_t pa = *(const pid_t *)a;
+        const pid_t pb = *(const pid_t *)b;
+
+        return (pa > pb) - (pa < pb);
+}
+
+/**
+ * @brief Makes processes join and leave the group as its selector resolves
+ *
+ * Processes join one by one, so a process exiting meanwhile does not stop
+ * others from joining. Group keeps at least one PID, failed changes are
+ * retried on the next refresh.
+ *
+ * @param grp PID monitoring group with a process selector
+ */
+static void
+grp_select_sync(struct mon_group *grp)
+{
+        const pid_t *pids;
+        pid_t *leave;
+        unsigned num_pids;
+        unsigned num_leave = 0;
+        unsigned i;
+
+        pids = proc_select_pids(grp->sel, &num_pids);
+
+        for (i = 0; i < num_pids; i++)
+                if (!grp_pid_used(pids[i]))
+                        (void)grp_resize(grp, &pids[i], 1, 1);
+
+        leave = malloc(sizeof(*leave) * grp->num_res);
+        if (leave == NULL)
+                return;
+
+        /* exited processes leave together, removal checks the others */
+        for (i = 0; i < grp->num_res; i++)
+                if (bsearch(&grp->pids[i], pids, num_pids, sizeof(*pids),
+                            pid_cmp) == NULL)
+                        leave[num_leave++] = grp->pids[i];
+        if (num_leave == grp->num_res)
+                num_leave--;
+        if (num_leave > 0)
+                (void)grp_resize(grp, leave, num_leave, 0);
+
+        free(leave);
+}
+
+/**
+ * @brief Re-resolves process selectors and updates their groups
+ */
+static void
+select_procs_refresh(void)
+{
+        unsigned i;
+
+        if (proc_scan_update(select_scan) != 0)
+                return;
+
+        for (i = 0; i < sel_monitor_num; i++) {
+                struct mon_group *grp = &sel_monitor_group[i];
+
+                if (grp->sel == NULL || !grp->started)
+                        continue;
+                if (proc_select_update(grp->sel, select_scan) != 0)
+                        continue;
+                grp_select_sync(grp);
+        }
+}
+
+/**
+ * @brief Compare LLC occupancy in two monitoring data sets
+ *
+ * @param a monitoring data A
+ * @param b monitoring data B
+ *
+ * @return LLC monitoring data compare status for descending order
+ * @retval 0 if \a  = \b
+ * @retval >0 if \b > \a
+ * @retval <0 if \b < \a
+ */
+static int
+mon_qsort_llc_cmp_desc(const void *a, const void *b)
+{
+        const struct pqos_mon_data *const *app =
+            (const struct pqos_mon_data *const *)a;
+        const struct pqos_mon_data *const *bpp =
+            (const struct pqos_mon_data *const *)b;
+        const struct pqos_mon_data *ap = *app;
+        const struct pqos_mon_data *bp = *bpp;
+        /**
+         * This (b-a) is to get descending order
+         * otherwise it would be (a-b)
+         */
+        return (int)(((int64_t)bp->values.llc) - ((int64_t)ap->values.llc));
+}
+
+/**
+ * @brief Compare core id in two monitoring data sets
+ *
+ * @param a monitoring data A
+ * @param b monitoring data B
+ *
+ * @return Core id compare status for ascending order
+ * @retval 0 if \a  = \b
+ * @retval >0 if \b > \a
+ * @retval <0 if \b < \a
+ */
+static int
+mon_qsort_coreid_cmp_asc(const void *a, const void *b)
+{
+        const struct pqos_mon_data *const *app =
+            (const struct pqos_mon_data *const *)a;
+        const struct pqos_mon_data *const *bpp =
+            (const struct pqos_mon_data *const *)b;
+        const struct pqos_mon_data *ap = *app;
+        const struct pqos_mon_data *bp = *bpp;
+        /**
+         * This (a-b) is to get ascending order
+         * otherwise it would be (b-a)
+         */
+        return (int)(((unsigned)ap->cores[0]) - ((unsigned)bp->cores[0]));
+}
+
+/**
+ * @brief CTRL-C handler for infinite monitoring loop
+ *
+ * @param signo signal number
+ */
+static void
+monitoring_ctrlc(int signo)
+{
+        UNUSED_ARG(signo);
+        stop_monitoring_loop = 1;
+}
+
+#ifdef __linux__
+/**
+ * @brief SIGUSR1 handler triggering flight recorder capture
+ *
+ * @param signo signal number
+ */
+static void
+monitoring_recorder_trigger(int signo)
+{
+        UNUSED_ARG(signo);
+        recorder_signal = 1;
+}
+#endif
+
+/**
+ * @brief Initializes two arrays with pointers to PQoS monitoring structures
+ *
+ * Function does the following things:
+ * - figures size of the array to allocate
+ * - allocates memory for the two arrays
+ * - initializes allocated arrays with data from core or pid table
+ * - saves array pointers in \a parray1 and \a parray2
+ * - both arrays have identical content
+ *
+ * @param parray1 pointer to an array of pointers to PQoS monitoring structures
+ * @param parray2 pointer to an array of pointers to PQoS monitoring structures
+ *
+ * @return Number of elements in each of the tables
+ */
+static unsigned
+get_mon_arrays(struct pqos_mon_data ***parray1, struct pqos_mon_data ***parray2)
+{
+        unsigned i;
+        struct pqos_mon_data **p1, **p2;
+
+        ASSERT(parray1 != NULL && parray2 != NULL);
+        p1 = malloc(sizeof(p1[0]) * sel_monitor_num);
+        p2 = malloc(sizeof(p2[0]) * sel_monitor_num);
+        if (p1 == NULL || p2 == NULL) {
+                if (p1)
+                        free(p1);
+                if (p2)
+                        free(p2);
+                printf("Error with memory allocation");
+                exit(EXIT_FAILURE);
+        }
+
+        for (i = 0; i < sel_monitor_num; i++) {
+                p1[i] = sel_monitor_group[i].data;
+                p2[i] = p1[i];
+        }
+
+        *parray1 = p1;
+        *parray2 = p2;
+        return sel_monitor_num;
+}
+
+#define TERM_MIN_NUM_LINES 3
+
+/**
+ * Monitoring output functions
+ */
+struct mon_output {
+        void (*begin)(FILE *fp);
+        void (*header)(FILE *fp, const char *timestamp);
+        void (*row)(FILE *fp,
+                    const char *timestamp,
+                    const struct pqos_mon_data *data);
+        void (*footer)(FILE *fp);
+        void (*end)(FILE *fp);
+};
+
+/**
+ * Snapshot of monitoring data passed from the sampler to the writer
+ */
+struct mon_sample {
+        uint64_t monotonic;          /**< CLOCK_MONOTONIC poll time [ns] */
+        uint64_t realtime;           /**< CLOCK_REALTIME poll time [ns] */
+        struct pqos_mon_data *data;  /**< copies of the monitoring groups */
+        struct pqos_mon_data **rows; /**< rows in display order */
+        pid_t **tids;                /**< copies of the group TID maps */
+        size_t *tids_size;           /**< allocated size of TID map copies */
+        pid_t **pids;                /**< copies of the group PID lists */
+        size_t *pids_size;           /**< allocated size of PID list copies */
+        char **ctx;                  /**< copies of the group descriptions */
+        size_t *ctx_size;            /**< allocated size of ctx copies */
+        double *stats;               /**< statistics column values */
+        uint64_t *mbm_interval;      /**< MBM poll intervals [ns] */
+        uint64_t *values;            /**< values of mon_sample_events */
+};
+
+/**
+ * Events with values kept by the library outside of the monitoring group,
+ * copied into the sample as value and delta pairs
+ */
+static const enum pqos_mon_event mon_sample_events[] = {
+    PQOS_PERF_EVENT_LLC_REF, PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE, PQOS_PERF_EVENT_LLC_REF_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE};
+
+#define MON_RING_SIZE 16
+
+/**
+ * Ring of samples between the sampler and the writer thread
+ *
+ * Not built on pqos_sampler_*: samples carry variable sized copies of
+ * contexts, TID maps and PID lists that the library ring cannot hold,
+ * groups are polled in subsets and reconfigured while sampling, and
+ * control commands need the writer drained before groups change.
+ * A slot is owned by the writer until written out, so the newest sample
+ * is dropped when the ring is full instead of overwriting the oldest.
+ */
+static struct {
+        struct mon_sample slot[MON_RING_SIZE];
+        unsigned head;         /**< next slot to be filled by the sampler */
+        unsigned tail;         /**< next slot to be written out */
+        unsigned count;        /**< number of samples ready for writing */
+        unsigned num;          /**< number of groups in the sample */
+        unsigned long dropped; /**< samples dropped due to full ring */
+        int done;              /**< sampling finished */
+        pthread_mutex_t lock;
+        pthread_cond_t cond;
+} mon_ring;
+
+/**
+ * Sample being written out
+ */
+static const struct mon_sample *mon_sample_curr = NULL;
+
+/**
+ * @brief Frees memory allocated for the sample ring
+ */
+static void
+mon_ring_free(void)
+{
+        unsigned i, j;
+
+        for (i = 0; i < MON_RING_SIZE; i++) {
+                struct mon_sample *sample = &mon_ring.slot[i];
+
+                for (j = 0; j < mon_ring.num; j++) {
+                        if (sample->tids != NULL)
+                                free(sample->tids[j]);
+                        if (sample->pids != NULL)
+                                free(sample->pids[j]);
+                        if (sample->ctx != NULL)
+                                free(sample->ctx[j]);
+                }
+                free(sample->ctx);
+                free(sample->ctx_size);
+                free(sample->tids);
+                free(sample->tids_size);
+                free(sample->pids);
+                free(sample->pids_size);
+                free(sample->stats);
+                free(sample->mbm_interval);
+                free(sample->values);
+                free(sample->rows);
+                free(sample->data);
+        }
+        memset(mon_ring.slot, 0, sizeof(mon_ring.slot));
+}
+
+/**
+ * @brief Allocates ring samples for \a num monitoring groups
+ *
+ * @param num number of monitoring groups
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 memory allocation error
+ */
+static int
+mon_ring_alloc_slots(const unsigned num)
+{
+        const unsigned num_stats = monitor_stats_num_columns();
+        unsigned i;
+
+        mon_ring.num = num;
+
+        for (i = 0; i < MON_RING_SIZE; i++) {
+                struct mon_sample *sample = &mon_ring.slot[i];
+
+                sample->data = calloc(num, sizeof(sample->data[0]));
+                sample->rows = calloc(num, sizeof(sample->rows[0]));
+                sample->tids = calloc(num, sizeof(sample->tids[0]));
+                sample->tids_size = calloc(num, sizeof(sample->tids_size[0]));
+                sample->pids = calloc(num, sizeof(sample->pids[0]));
+                sample->pids_size = calloc(num, sizeof(sample->pids_size[0]));
+                sample->ctx = calloc(num, sizeof(sample->ctx[0]));
+                sample->ctx_size = calloc(num, sizeof(sample->ctx_size[0]));
+                sample->mbm_interval =
+                    calloc(num, sizeof(sample->mbm_interval[0]));
+                sample->values = calloc(num * DIM(mon_sample_events) * 2,
+                                        sizeof(sample->values[0]));
+                if (num_stats > 0)
+                        sample->stats =
+                            calloc(num * num_stats, sizeof(sample->stats[0]));
+                if ((num_stats > 0 && sample->stats == NULL) ||
+                    sample->data == NULL || sample->rows == NULL ||
+                    sample->tids == NULL || sample->tids_size == NULL ||
+                    sample->pids == NULL || sample->pids_size == NULL ||
+                    sample->ctx == NULL || sample->ctx_size == NULL ||
+                    sample->mbm_interval == NULL || sample->values == NULL) {
+                        mon_ring_free();
+                        mon_ring.num = 0;
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Allocates sample ring for \a num monitoring groups
+ *
+ * @param num number of monitoring groups
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 memory allocation error
+ */
+static int
+mon_ring_alloc(const unsigned num)
+{
+        memset(&mon_ring, 0, sizeof(mon_ring));
+        if (mon_ring_alloc_slots(num) != 0)
+                return -1;
+
+        pthread_mutex_init(&mon_ring.lock, NULL);
+        pthread_cond_init(&mon_ring.cond, NULL);
+
+        return 0;
+}
+
+/**
+ * @brief Reads clock value in nanoseconds
+ *
+ * @param clk_id clock to read
+ *
+ * @return clock value [ns]
+ */
+static uint64_t
+mon_clock_ns(const clockid_t clk_id)
+{
+        struct timespec ts;
+
+        if (clock_gettime(clk_id, &ts) != 0)
+                return 0;
+
+        return (uint64_t)ts.tv_sec * 1000000000llu + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Copies data into reusable buffer
+ *
+ * @param [in,out] buf buffer, reallocated when too small
+ * @param [in,out] size allocated size of \a buf
+ * @param src data to copy
+ * @param len length of \a src
+ *
+ * @return pointer to the copy or NULL on allocation error
+ */
+static void *
+mon_copy_buf(void **buf, size_t *size, const void *src, const size_t len)
+{
+        if (*size < len) {
+                void *ptr = realloc(*buf, len);
+
+                if (ptr == NULL)
+                        return NULL;
+                *buf = ptr;
+                *size = len;
+        }
+        memcpy(*buf, src, len);
+
+        return *buf;
+}
+
+/**
+ * @brief Copies polled monitoring data into the next free ring slot
+ *
+ * Called by the sampler only. The sample is dropped when the writer
+ * does not keep up, so the sampler is never blocked by the output.
+ *
+ * @param groups polled monitoring groups
+ * @param monotonic CLOCK_MONOTONIC time of the poll [ns]
+ * @param realtime CLOCK_REALTIME time of the poll [ns]
+ */
+static void
+mon_ring_push(struct pqos_mon_data *const *groups,
+              const uint64_t monotonic,
+              const uint64_t realtime)
+{
+        static char no_context[1] = "";
+        struct mon_sample *sample;
+        unsigned count;
+        unsigned i;
+
+        pthread_mutex_lock(&mon_ring.lock);
+        count = mon_ring.count;
+        pthread_mutex_unlock(&mon_ring.lock);
+
+        if (count == MON_RING_SIZE) {
+                mon_ring.dropped++;
+                return;
+        }
+
+        /* slot at head is not accessed by the writer until published */
+        sample = &mon_ring.slot[mon_ring.head];
+        sample->monotonic = monotonic;
+        sample->realtime = realtime;
+
+        for (i = 0; i < mon_ring.num; i++) {
+                struct pqos_mon_data *data = &sample->data[i];
+                uint64_t *values =
+                    &sample->values[i * DIM(mon_sample_events) * 2];
+                unsigned j;
+
+                *data = *groups[i];
+                sample->rows[i] = data;
+
+                /* library state is updated by the next poll */
+                data->intl = NULL;
+                for (j = 0; j < DIM(mon_sample_events); j++) {
+                        values[2 * j] = 0;
+                        values[2 * j + 1] = 0;
+                        if (data->event & mon_sample_events[j])
+                                (void)pqos_mon_get_value(
+                                    groups[i], mon_sample_events[j],
+                                    &values[2 * j], &values[2 * j + 1]);
+                }
+
+                /* top-pids groups are renamed when moved to another PID */
+                if (data->context != NULL)
+                        data->context = mon_copy_buf(
+                            (void **)&sample->ctx[i], &sample->ctx_size[i],
+                            groups[i]->context,
+                            strlen(groups[i]->context) + 1);
+                if (data->context == NULL)
+                        data->context = no_context;
+
+                /* TID map can be reallocated by the next poll */
+                if (data->tid_map != NULL)
+                        data->tid_map = mon_copy_buf(
+                            (void **)&sample->tids[i], &sample->tids_size[i],
+                            groups[i]->tid_map,
+                            data->tid_nr * sizeof(data->tid_map[0]));
+
+                /* PID list of top-pids groups changes on retarget */
+                if (data->pids != NULL && data->num_pids > 0)
+                        data->pids = mon_copy_buf(
+                            (void **)&sample->pids[i], &sample->pids_size[i],
+                            groups[i]->pids,
+                            data->num_pids * sizeof(data->pids[0]));
+
+                /* MBM rates cover the time between the MBM polls */
+                sample->mbm_interval[i] = 0;
+                if (monitor_rates_enabled()) {
+                        if (data->event & PQOS_MON_EVENT_TMEM_BW)
+                                (void)pqos_mon_get_poll_time(
+                                    groups[i], PQOS_MON_EVENT_TMEM_BW, NULL,
+                                    &sample->mbm_interval[i]);
+                        else if (data->event & PQOS_MON_EVENT_LMEM_BW)
+                                (void)pqos_mon_get_poll_time(
+                                    groups[i], PQOS_MON_EVENT_LMEM_BW, NULL,
+                                    &sample->mbm_interval[i]);
+                }
+
+                if (sample->stats != NULL)
+                        monitor_stats_snapshot(
+                            i, &sample->stats[i * monitor_stats_num_columns()]);
+        }
+
+        pthread_mutex_lock(&mon_ring.lock);
+        mon_ring.head = (mon_ring.head + 1) % MON_RING_SIZE;
+        mon_ring.count++;
+        pthread_cond_signal(&mon_ring.cond);
+        pthread_mutex_unlock(&mon_ring.lock);
+}
+
+/**
+ * @brief Notifies the writer that no more samples will be produced
+ */
+static void
+mon_ring_close(void)
+{
+        pthread_mutex_lock(&mon_ring.lock);
+        mon_ring.done = 1;
+        pthread_cond_signal(&mon_ring.cond);
+        pthread_mutex_unlock(&mon_ring.lock);
 }
 
 /**
- * @brief Counts cpu_avg_ratio for PID and fills it into proc_stats
+ * @brief Formats sample time string
  *
- * @param pstat[out] proc_stats structure representing stats for process, it
- *                   will be filled with processed cpu_avg_ratio
- *                   and has to be != NULL
- * @param proc_start_time time when process has been started (time from
- *                        beginning of epoch in seconds)
+ * Milliseconds are only added for intervals that are not whole seconds
+ * to keep the established output format.
+ *
+ * @param realtime CLOCK_REALTIME time [ns]
+ * @param [out] buf time string
+ * @param size size of \a buf
  */
 static void
-fill_cpu_avg_ratio(struct proc_stats *pstat, const time_t proc_start_time)
+mon_time_str(const uint64_t realtime, char *buf, const size_t size)
 {
-        time_t curr_time, run_time;
+        const time_t sec = (time_t)(realtime / 1000000000llu);
+        struct tm tm;
+        size_t len;
 
-        ASSERT(pstat != NULL);
+        if (localtime_r(&sec, &tm) == NULL) {
+                snprintf(buf, size, "error");
+                return;
+        }
 
-        curr_time = time(0);
-        run_time = curr_time - proc_start_time;
-        if (run_time != 0)
-                pstat->cpu_avg_ratio = (double)pstat->ticks_delta / run_time;
-        else
-                pstat->cpu_avg_ratio = 0.0;
+        len = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+        if (sel_mon_interval % 1000 != 0)
+                snprintf(buf + len, size - len, ".%03u",
+                         (unsigned)(realtime / 1000000llu % 1000));
 }
 
 /**
- * @brief Add statistics for given pid in form of proc_stats struct to slist.
- *        New element-node is allocated and added on beginning of the list.
+ * @brief Waits until the writer has written out all samples
  *
- * @param pslist pointer to single linked list of proc_stats. It will be
- *               filled with new proc_stats entry. If it equals NULL,
- *               new list will be started with given element
- * @param pid process pid to be added
- * @param cputicks cputicks spent by this process
- * @param proc_start_time time of process creation(seconds since the Epoch)
- *
- * @return pointer to beginning of process statistics slist
+ * Ring lock is held on return, so the writer stays idle and monitoring
+ * groups, ring and output can be changed until mon_ring_unlock().
  */
-static struct slist *
-add_proc_cpu_stat(struct slist *pslist,
-                  const pid_t pid,
-                  const unsigned long cputicks,
-                  const time_t proc_start_time)
+static void
+mon_ring_lock_idle(void)
 {
-        /* have to allocate new proc_stats struct */
-        struct proc_stats *pstat = malloc(sizeof(struct proc_stats));
+        pthread_mutex_lock(&mon_ring.lock);
+        while (mon_ring.count > 0)
+                pthread_cond_wait(&mon_ring.cond, &mon_ring.lock);
+}
 
-        if (pstat == NULL) {
-                printf("Error with memory allocation for pstat!");
-                exit(EXIT_FAILURE);
-        }
+/**
+ * @brief Lets the writer continue after mon_ring_lock_idle()
+ */
+static void
+mon_ring_unlock(void)
+{
+        pthread_mutex_unlock(&mon_ring.lock);
+}
 
-        pstat->pid = pid;
-        pstat->ticks_delta = cputicks;
-        pstat->valid = 0;
-        fill_cpu_avg_ratio(pstat, proc_start_time);
-        struct slist *elem = slist_create_elem(pstat);
+/**
+ * @brief Calculates number of rows to display
+ *
+ * Terminal output is limited to the terminal height.
+ *
+ * @param istty output is a terminal
+ *
+ * @return number of rows
+ */
+static unsigned
+mon_display_num(const int istty)
+{
+        unsigned display_num = mon_ring.num;
+
+        if (istty) {
+                struct winsize w;
+                unsigned max_lines = 0;
 
-        if (pslist == NULL)
-                /* starting new list of proc_stats elements*/
-                pslist = elem;
-        else {
-                /* prepending */
-                elem->next = pslist;
-                pslist = elem;
+                if (ioctl(fileno(fp_monitor), TIOCGWINSZ, &w) != -1) {
+                        max_lines = w.ws_row;
+                        if (max_lines < TERM_MIN_NUM_LINES)
+                                max_lines = TERM_MIN_NUM_LINES;
+                }
+                if ((display_num + TERM_MIN_NUM_LINES - 1) > max_lines)
+                        display_num = max_lines - TERM_MIN_NUM_LINES + 1;
         }
 
-        return pslist;
+        return display_num;
 }
 
 /**
- * @brief Updates statistics for given pid in in slist
+ * @brief Writer thread, sorts and writes out samples from the ring
  *
- * @param pslist pointer to slist of proc_stats. Only internal data
- *               will be updated, no new list entries will be created
- *               or removed.
- * @param pid pid number of a process to be updated
- * @param cputicks cputicks spent by this process
+ * @param arg output functions
+ *
+ * @return NULL
  */
-static void
-update_proc_cpu_stat(const struct slist *pslist,
-                     const pid_t pid,
-                     const unsigned long cputicks)
+static void *
+mon_writer(void *arg)
 {
-        /* at first we have to look for previous stats for a given PID*/
-        struct proc_stats *ps_updt = find_proc_stats_by_pid(pslist, pid);
+        const struct mon_output *output = (const struct mon_output *)arg;
+        const int istty = isatty(fileno(fp_monitor));
 
-        if (ps_updt == NULL)
-                /* PID not found, probably new process, can't to fill
-                 * ticks_delta so silently returning unmodified list
-                 */
-                return;
+        output->begin(fp_monitor);
+        for (;;) {
+                struct mon_sample *sample;
+                unsigned display_num;
+                char cb_time[64];
+                unsigned i;
 
-        /* checking if cputicks diff will be valid e.g. won't generate
-         * negative diff number in a result
-         */
-        if (cputicks >= ps_updt->ticks_delta) {
-                ps_updt->ticks_delta = cputicks - ps_updt->ticks_delta;
-
-                /* Marking PID statistics as valid - ticks_delta and
-                 * cpu_avg_ratio can be used safely during top-pids
-                 * selection. This kind of checking is needed to get
-                 * rid of dead-pids - processes that existed during
-                 * getting first part of statistics and before updated
-                 * ticks delta was computed.
-                 */
-                ps_updt->valid = 1;
-        } else {
-                /* Probably different process went into previously used PID
-                 * number. Zeroing fields for safety and leaving marked as
-                 * invalid.
-                 */
-                ps_updt->ticks_delta = 0;
-                ps_updt->cpu_avg_ratio = 0;
-                ps_updt->valid = 0;
+                pthread_mutex_lock(&mon_ring.lock);
+                while (mon_ring.count == 0 && !mon_ring.done)
+                        pthread_cond_wait(&mon_ring.cond, &mon_ring.lock);
+                if (mon_ring.count == 0) {
+                        pthread_mutex_unlock(&mon_ring.lock);
+                        break;
+                }
+                sample = &mon_ring.slot[mon_ring.tail];
+                pthread_mutex_unlock(&mon_ring.lock);
+
+                if (sel_mon_top_like)
+                        qsort(sample->rows, mon_ring.num,
+                              sizeof(sample->rows[0]), mon_qsort_llc_cmp_desc);
+                else if (sel_monitor_type == MON_GROUP_TYPE_CORE)
+                        qsort(sample->rows, mon_ring.num,
+                              sizeof(sample->rows[0]),
+                              mon_qsort_coreid_cmp_asc);
+
+                /* number of groups changes with live reconfiguration */
+                display_num = mon_display_num(istty);
+                mon_time_str(sample->realtime, cb_time, sizeof(cb_time));
+                mon_sample_curr = sample;
+
+                output->header(fp_monitor, cb_time);
+                for (i = 0; i < display_num; i++)
+                        output->row(fp_monitor, cb_time, sample->rows[i]);
+                output->footer(fp_monitor);
+
+                fflush(fp_monitor);
+
+                mon_sample_curr = NULL;
+
+                pthread_mutex_lock(&mon_ring.lock);
+                mon_ring.tail = (mon_ring.tail + 1) % MON_RING_SIZE;
+                mon_ring.count--;
+                pthread_cond_signal(&mon_ring.cond);
+                pthread_mutex_unlock(&mon_ring.lock);
         }
+        output->end(fp_monitor);
+
+        return NULL;
+}
+
+/**
+ * Monitoring loop resources that follow the monitoring groups
+ */
+static struct {
+        struct pqos_mon_data **grps;      /**< polled monitoring groups */
+        struct pqos_mon_data **data;      /**< groups polled at a tick */
+        unsigned num;                     /**< number of monitoring groups */
+        struct pqos_telemetry *telemetry; /**< published telemetry */
+        const struct mon_output *output;  /**< output functions */
+#ifdef __linux__
+        int tfd; /**< sampling timer */
+#endif
+} mon_loop;
+
+/**
+ * @brief Restarts flight recorder for the current groups and tick
+ *
+ * Capture in progress is written out with the frames recorded so far.
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+static int
+mon_recorder_restart(void)
+{
+        if (sel_recorder_spec == NULL)
+                return 0;
+
+        monitor_recorder_stop();
+        return monitor_recorder_start(sel_recorder_spec, mon_loop.num,
+                                      monitor_rates_tick(), sel_events_max);
 }
 
 /**
- * @brief Gets start_time value for given PID directory - this can be used as
- * information for how long process lives (we can get time of process creation
- * by checking st_mtime field of /proc/[pid] directory statistics)
+ * @brief Reallocates loop resources after monitoring groups changed
  *
- * @param proc_dir DIR structure for '/proc' directory
- * @param pid_dir_name name of PID directory in /proc, e.g. "1234"
- * @param start_time[out] time when process has been started (time from
- *                        beginning of epoch in seconds)
+ * Must be called with the writer idle. Streaming statistics are
+ * restarted for all groups. On error the monitoring loop is stopped.
  *
- * @return operation status
- * @retval 0 in case of success
- * @retval -1 in case of error
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
 static int
-get_proc_start_time(DIR *proc_dir, const char *pid_dir_name, time_t *start_time)
+mon_loop_update(void)
 {
-        struct stat p_dir_stat;
+        free(mon_loop.grps);
+        free(mon_loop.data);
+        mon_loop.num = get_mon_arrays(&mon_loop.grps, &mon_loop.data);
+
+        if (sel_stats_spec != NULL) {
+                monitor_stats_stop();
+                if (monitor_stats_start(sel_stats_spec, mon_loop.num,
+                                        sel_events_max) != 0)
+                        goto mon_loop_update_error;
+        }
 
-        if (start_time == NULL || pid_dir_name == NULL)
-                return -1;
+        mon_ring_free();
+        if (mon_ring_alloc_slots(mon_loop.num) != 0)
+                goto mon_loop_update_error;
 
-        if (fstatat(dirfd(proc_dir), pid_dir_name, &p_dir_stat, 0) != 0)
-                return -1;
+        if (mon_recorder_restart() != 0)
+                goto mon_loop_update_error;
 
-        *start_time = p_dir_stat.st_mtime;
+        if (mon_loop.telemetry != NULL) {
+                pqos_telemetry_destroy(mon_loop.telemetry);
+                mon_loop.telemetry = NULL;
+                if (pqos_telemetry_create(sel_publish_name, mon_loop.num,
+                                          &mon_loop.telemetry) !=
+                    PQOS_RETVAL_OK)
+                        goto mon_loop_update_error;
+        }
 
         return 0;
+
+mon_loop_update_error:
+        stop_monitoring_loop = 1;
+        return -1;
 }
 
 /**
- * @brief Gets pid number for given /proc/pid directory or returns error if
- *        given directory does not hold PID information. It can be used to
- *        filter out non-pid directories in /proc
+ * @brief Starts new output section so the header reflects changed
+ *        events or interval, optionally in another file
  *
- * @param proc_dir DIR structure for '/proc' directory
- * @param pid_dir_name name of PID directory in /proc, e.g. "1234"
- * @param pid[out] pid number to be filled
+ * Must be called with the writer idle.
  *
- * @return operation status
- * @retval 0 in case of success
- * @retval -1 in case of error
+ * @param file file to continue in or NULL to stay in the current one
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 file could not be opened, output continues in old file
  */
 static int
-get_pid_num_from_dir(DIR *proc_dir, const char *pid_dir_name, pid_t *pid)
+mon_output_restart(const char *file)
 {
-        struct stat p_dir_stat;
-        char *tmp_end; /* used for strtoul error check*/
-        int ret;
-
-        if (pid == NULL || pid_dir_name == NULL)
-                return -1;
+        FILE *fp = NULL;
+        int ret = 0;
 
-        /* trying to get pid number from directory name*/
-        *pid = strtoul(pid_dir_name, &tmp_end, 10);
-        if (!is_str_conversion_ok(tmp_end))
-                return -1; /* conversion failed, not proc-pid */
+        mon_loop.output->end(fp_monitor);
+        fflush(fp_monitor);
 
-        ret = fstatat(dirfd(proc_dir), pid_dir_name, &p_dir_stat, 0);
-        if (ret)
-                /* couldn't get valid stat, can't check pid */
-                return -1;
+        /* old file may have been moved away, reopen it by name */
+        if (file != NULL)
+                fp = mon_output_open(file);
+        if (fp != NULL) {
+                fclose(fp_monitor);
+                fp_monitor = fp;
+        } else if (file != NULL)
+                ret = -1;
 
-        if (!S_ISDIR(p_dir_stat.st_mode))
-                return -1; /* ignoring not-directories */
+        mon_loop.output->begin(fp_monitor);
 
-        /* all checks passed, marking as success */
-        return 0;
+        return ret;
 }
 
 /**
- * @brief Fills slist of proc_stats with process cpu usage stats
+ * @brief Finds monitoring group by its description
  *
- * @param pslist[out] pointer to pointer to slist of proc_stats to be filled
- *                    with new proc_stats entries or entries that will be
- *                    updated. If pslist points to a NULL, then new slist will
- *                    be created and thus memory has to be freed when list
- *                    (and list content) won't be needed anymore.
- *                    If pslist points to not-NULL slist, then content will be
- *                    updated and no additional memory will be mallocated.
+ * @param desc group description
  *
- * @return operation status
- * @retval 0 in case of success
- * @retval -1 in case of error
+ * @return monitoring group or NULL if not found
  */
-static int
-get_proc_pids_stats(struct slist **pslist)
+static struct mon_group *
+ctrl_find_group(const char *desc)
 {
-        int initialized = 0;
-        struct dirent *file;
-        DIR *proc_dir = opendir(proc_pids_dir);
-
-        ASSERT(pslist != NULL);
-        if (*pslist != NULL)
-                /* updating existing entries in list of process stats*/
-                initialized = 1;
+        unsigned i;
 
-        if (proc_dir == NULL) {
-                perror("Could not open /proc directory:");
-                return -1;
-        }
+        for (i = 0; i < sel_monitor_num; i++)
+                if (strcmp(sel_monitor_group[i].desc, desc) == 0)
+                        return &sel_monitor_group[i];
 
-        while ((file = readdir(proc_dir)) != NULL) {
-                uint64_t cputicks = 0;
-                time_t start_time = 0;
-                pid_t pid = 0;
-                int err;
+        return NULL;
+}
 
-                err = get_pid_num_from_dir(proc_dir, file->d_name, &pid);
-                if (err)
-                        continue; /* not a PID directory */
+/**
+ * @brief Prints names of the monitoring events
+ *
+ * @param fp output stream
+ * @param events monitoring events
+ */
+static void
+ctrl_print_events(FILE *fp, const enum pqos_mon_event events)
+{
+        static const struct {
+                enum pqos_mon_event event;
+                const char *name;
+        } names[] = {
+            {PQOS_MON_EVENT_L3_OCCUP, "llc"},
+            {PQOS_MON_EVENT_LMEM_BW, "mbl"},
+            {PQOS_MON_EVENT_RMEM_BW, "mbr"},
+            {PQOS_MON_EVENT_TMEM_BW, "mbt"},
+            {PQOS_PERF_EVENT_IPC, "ipc"},
+            {PQOS_PERF_EVENT_LLC_MISS, "llc_miss"},
+            {PQOS_PERF_EVENT_LLC_REF, "llc_ref"},
+            {PQOS_PERF_EVENT_LLC_MISS_PCIE_READ, "llc_miss_pcie_read"},
+            {PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE, "llc_miss_pcie_write"},
+            {PQOS_PERF_EVENT_LLC_REF_PCIE_READ, "llc_ref_pcie_read"},
+            {PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE, "llc_ref_pcie_write"},
+        };
+        const char *sep = "";
+        unsigned i;
 
-                err = get_pid_cputicks(file->d_name, &cputicks);
-                if (err)
-                        /* couldn't get cputicks, ignoring this PID-dir*/
+        for (i = 0; i < DIM(names); i++) {
+                if (!(events & names[i].event))
                         continue;
+                fprintf(fp, "%s%s", sep, names[i].name);
+                sep = ",";
+        }
+}
 
-                if (!initialized) {
-                        err = get_proc_start_time(proc_dir, file->d_name,
-                                                  &start_time);
-                        if (err)
-                                /* start time for given pid is needed for
-                                 * correct CPU usage statistics - without that
-                                 * we have to ignore problematic pid entry and
-                                 * move on
-                                 */
-                                continue;
+/**
+ * @brief Lists monitoring groups
+ *
+ * @param reply reply stream
+ *
+ * @return 0
+ */
+static int
+ctrl_list(FILE *reply)
+{
+        unsigned i, j;
 
-                        *pslist = add_proc_cpu_stat(*pslist, pid, cputicks,
-                                                    start_time);
-                } else
-                        /* only updating proc_stats entries*/
-                        update_proc_cpu_stat(*pslist, pid, cputicks);
+        fprintf(reply, "interval %ums\n", sel_mon_interval);
+        for (i = 0; i < sel_monitor_num; i++) {
+                const struct mon_group *grp = &sel_monitor_group[i];
+                const char *type = "cores";
+
+                if (grp->type == MON_GROUP_TYPE_PID)
+                        type = "pids";
+                else if (grp->type == MON_GROUP_TYPE_UNCORE)
+                        type = "sockets";
+
+                fprintf(reply, "group %s %s ", grp->desc, type);
+                for (j = 0; j < grp->num_res; j++) {
+                        unsigned res = grp->cores[j];
+
+                        if (grp->type == MON_GROUP_TYPE_PID)
+                                res = (unsigned)grp->pids[j];
+                        else if (grp->type == MON_GROUP_TYPE_UNCORE)
+                                res = grp->sockets[j];
+                        fprintf(reply, "%s%u", j > 0 ? "," : "", res);
+                }
+                fprintf(reply, " events ");
+                ctrl_print_events(reply, grp->events);
+                fprintf(reply, "\n");
         }
 
-        closedir(proc_dir);
         return 0;
 }
 
 /**
- * @brief Comparator for proc_stats structure - needed for qsort
+ * @brief Adds and starts new monitoring group
+ *
+ * Must be called with the writer idle.
  *
- * @param a proc_stat data A
- * @param b proc_stat data B
+ * @param arg "[EVENT:]LIST" where LIST is a list of cores, PIDs or
+ *            sockets depending on the monitoring mode
+ * @param reply reply stream
  *
- * @return Comparison status
- * @retval negative number when (a < b)
- * @retval 0 when (a == b)
- * @retval positive number when (a > b)
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
 static int
-proc_stats_cmp(const void *a, const void *b)
-{
-        const struct proc_stats *pa = (const struct proc_stats *)a;
-        const struct proc_stats *pb = (const struct proc_stats *)b;
-
-        if (pa->ticks_delta == pb->ticks_delta) {
-                /* when tick deltas are equal then comparing cpu_avg*/
-                /* NOTE: both ratios are double numbers therefore
-                 * comparing here manually to get correct
-                 * integer compare-result (during subtracting, if
-                 * difference would be between 0 and 1.0, then it would be
-                 * wrongly returned as '0' int value (a == b))
-                 */
-                if (pa->cpu_avg_ratio < pb->cpu_avg_ratio)
+ctrl_add(char *arg, FILE *reply)
+{
+        enum pqos_mon_event evt = (enum pqos_mon_event)PQOS_MON_EVENT_ALL;
+        const enum pqos_mon_event events_max = sel_events_max;
+        uint64_t cbuf[PARSE_MON_GRP_BUFF_SIZE];
+        struct mon_group new_grp;
+        struct mon_group *grps;
+        char *colon = strchr(arg, ':');
+        char *desc;
+        size_t len;
+        unsigned i;
+        int num;
+        int ret;
+
+        if (colon != NULL) {
+                if (str_to_event(arg, colon - arg, &evt) != 0) {
+                        fprintf(reply, "unrecognized event");
                         return -1;
-                else if (pa->cpu_avg_ratio > pb->cpu_avg_ratio)
-                        return 1;
-                else
-                        return 0;
-        } else
-                return (pa->ticks_delta - pb->ticks_delta);
+                }
+                arg = colon + 1;
+        }
+        /* brackets of the command line group syntax are optional */
+        len = strlen(arg);
+        if (len >= 2 && arg[0] == '[' && arg[len - 1] == ']') {
+                arg[len - 1] = '\0';
+                arg++;
+        }
+
+        num = monitor_control_parse_list(arg, cbuf, DIM(cbuf));
+        if (num <= 0) {
+                fprintf(reply, "invalid list '%s'", arg);
+                return -1;
+        }
+
+        desc = strdup(arg);
+        if (desc == NULL) {
+                fprintf(reply, "out of memory");
+                return -1;
+        }
+        if (sel_monitor_type == MON_GROUP_TYPE_PID)
+                ret = grp_set_pid(&new_grp, desc, cbuf, num);
+        else if (sel_monitor_type == MON_GROUP_TYPE_UNCORE)
+                ret = grp_set_uncore(&new_grp, desc, cbuf, num);
+        else
+                ret = grp_set_core(&new_grp, desc, cbuf, num);
+        if (ret != 0) {
+                grp_free(&new_grp);
+                fprintf(reply, "out of memory");
+                return -1;
+        }
+
+        for (i = 0; i < sel_monitor_num; i++)
+                if (grp_cmp(&new_grp, &sel_monitor_group[i]) != 0) {
+                        fprintf(reply, "already monitored by group %s",
+                                sel_monitor_group[i].desc);
+                        grp_free(&new_grp);
+                        return -1;
+                }
+
+        grps = realloc(sel_monitor_group,
+                       sizeof(*sel_monitor_group) * (sel_monitor_num + 1));
+        if (grps == NULL) {
+                fprintf(reply, "out of memory");
+                grp_free(&new_grp);
+                return -1;
+        }
+        sel_monitor_group = grps;
+
+        new_grp.events = evt;
+        monitor_setup_events(new_grp.type, &new_grp.events, mon_cap);
+        ret = grp_start(&new_grp);
+        if (ret != PQOS_RETVAL_OK) {
+                fprintf(reply, "monitoring start error, status %d", ret);
+                grp_free(&new_grp);
+                sel_events_max = events_max;
+                return -1;
+        }
+
+        sel_monitor_group[sel_monitor_num++] = new_grp;
+        if (mon_loop_update() != 0) {
+                fprintf(reply, "out of memory");
+                return -1;
+        }
+        if (sel_events_max != events_max)
+                (void)mon_output_restart(NULL);
+
+        return 0;
 }
 
 /**
- * @brief Fills top processes array - based on CPU usage of all processes
- *        statistics in the system stored in given slist.
- *        From all processes in the system we are choosing 'max_size' amount
- *        of resulting proc stats with highest CPU usage
+ * @brief Stops and removes monitoring group
+ *
+ * Must be called with the writer idle.
  *
- * @param pslist list with all processes statistics (holds proc_stats)
+ * @param desc group description
+ * @param reply reply stream
  *
- * @return number of valid top processes in top_procs filled array (usually
- *         this will equal to max_size)
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
 static int
-fill_top_procs(const struct slist *pslist)
+ctrl_remove(const char *desc, FILE *reply)
 {
-        const struct slist *it = NULL;
-        int current_size = 0;
-        int i;
-        struct proc_stats stats[TOP_PROC_MAX];
+        struct mon_group *grp = ctrl_find_group(desc);
+        unsigned idx;
 
-        memset(stats, 0, sizeof(stats[0]) * TOP_PROC_MAX);
+        if (grp == NULL) {
+                fprintf(reply, "no group %s", desc);
+                return -1;
+        }
+        if (sel_monitor_num == 1) {
+                fprintf(reply, "cannot remove the last group");
+                return -1;
+        }
 
-        /* Iterating on CPU usage stats for all of the stored processes in
-         * pslist in order to get max_size of 'survivors' - processes
-         * with highest CPU usage in the system
-         */
-        for (it = pslist; it != NULL; it = it->next) {
-                struct proc_stats *ps = (struct proc_stats *)it->data;
+        if (pqos_mon_stop(grp->data) != PQOS_RETVAL_OK)
+                fprintf(reply, "monitoring stop error\n");
+        grp_free(grp);
 
-                ASSERT(ps != NULL);
+        idx = (unsigned)(grp - sel_monitor_group);
+        memmove(grp, grp + 1, sizeof(*grp) * (sel_monitor_num - idx - 1));
+        sel_monitor_num--;
 
-                if (ps->valid == 0)
-                        /* ignore not-fully filled entries (e.g. dead PIDs
-                         * or abandoned statistics because of some error)
-                         */
-                        continue;
+        if (mon_loop_update() != 0) {
+                fprintf(reply, "out of memory");
+                return -1;
+        }
 
-                /* If we have free slots in stats array, then things are
-                 * simple. We have only to add proc_stats into free slot and
-                 * sort entire array afterwards (sorting is done below)
-                 */
-                if (current_size < TOP_PROC_MAX) {
-                        stats[current_size] = *ps;
-                        current_size++;
-                } else {
-                        /* Handling more pids than can be saved in the top-pids
-                         * array. At first we have to check if one of the slots
-                         * can be consumed for current proc stats.
-                         * Only have to compare smallest element in array,
-                         * (list is stored in ascending manner so if it is
-                         * smaller from first element, it is smaller than
-                         * next element as well)
-                         */
-                        if (proc_stats_cmp(ps, &stats[0]) <= 0)
-                                /* if it is smaller/equal than smallest
-                                 * element, ignoring and moving on
-                                 */
-                                continue;
+        return 0;
+}
 
-                        /* adding at place of the smallest element and array
-                         * will be sorted below
-                         */
-                        stats[0] = *ps;
-                }
+/**
+ * @brief Adds PIDs to or removes PIDs from the PID monitoring group
+ *
+ * Monitoring of the other PIDs in the group carries on.
+ * Must be called with the writer idle.
+ *
+ * @param desc group description
+ * @param list list of PIDs
+ * @param grow add PIDs when set, remove otherwise
+ * @param reply reply stream
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+static int
+ctrl_resize(const char *desc, const char *list, const int grow, FILE *reply)
+{
+        struct mon_group *grp = ctrl_find_group(desc);
+        uint64_t cbuf[PARSE_MON_GRP_BUFF_SIZE];
+        pid_t *pids;
+        unsigned num_pids = 0;
+        unsigned i, j;
+        int num;
+        int ret;
 
-                /* Some change has been made, we have to sort entire array to
-                 * make sure that array is always sorted before next element
-                 * will be added
-                 */
-                qsort(stats, current_size, sizeof(stats[0]), proc_stats_cmp);
+        if (grp == NULL) {
+                fprintf(reply, "no group %s", desc);
+                return -1;
+        }
+        if (grp->type != MON_GROUP_TYPE_PID) {
+                fprintf(reply, "not a PID group");
+                return -1;
+        }
+        if (grp->sel != NULL) {
+                fprintf(reply, "group follows process selector");
+                return -1;
+        }
+        num = monitor_control_parse_list(list, cbuf, DIM(cbuf));
+        if (num <= 0) {
+                fprintf(reply, "invalid list '%s'", list);
+                return -1;
         }
 
-        /**
-         * Fill top_proc table
-         */
-        for (i = 0; i < current_size; i++) {
-                char *desc = uinttostr((unsigned)stats[i].pid);
-                uint64_t pid = (uint64_t)stats[i].pid;
-                const struct mon_group *grp;
+        pids = malloc(sizeof(*pids) * (grp->num_res + num));
+        if (pids == NULL) {
+                fprintf(reply, "out of memory");
+                return -1;
+        }
 
-                /* finally we can add list of top-pids for LLC/MBM monitoring
-                 * NOTE: list was sorted in ascending order, so in order to have
-                 * initially top-cpu processes on top, we are adding in reverse
-                 * order
-                 */
-                grp = grp_add(MON_GROUP_TYPE_PID,
-                              (enum pqos_mon_event)PQOS_MON_EVENT_ALL, desc,
-                              &pid, 1);
-                if (grp == NULL)
-                        exit(EXIT_FAILURE);
+        /* select PIDs that actually change the group */
+        for (i = 0; i < (unsigned)num; i++) {
+                for (j = 0; j < grp->num_res; j++)
+                        if (grp->pids[j] == (pid_t)cbuf[i])
+                                break;
+                /* grow by non-members, shrink by members only */
+                if ((j < grp->num_res) == grow)
+                        continue;
+                for (j = 0; j < num_pids; j++)
+                        if (pids[j] == (pid_t)cbuf[i])
+                                break;
+                if (j == num_pids)
+                        pids[num_pids++] = (pid_t)cbuf[i];
         }
+        if (num_pids == 0) {
+                free(pids);
+                return 0;
+        }
+        if (!grow && num_pids == grp->num_res) {
+                free(pids);
+                fprintf(reply, "cannot remove all PIDs of the group");
+                return -1;
+        }
+
+        ret = grp_resize(grp, pids, num_pids, grow);
+        free(pids);
+        if (ret != PQOS_RETVAL_OK) {
+                fprintf(reply, "failed to update group, status %d", ret);
+                return -1;
+        }
+        monitor_stats_reset((unsigned)(grp - sel_monitor_group));
 
-        return current_size;
+        return 0;
 }
 
 /**
- * @brief Looks for processes with highest CPU usage on the system and
- *        starts monitoring for them. Processes are displayed and sorted
- *        afterwards by LLC occupancy
+ * @brief Restarts all monitoring groups with new events
+ *
+ * Must be called with the writer idle.
+ *
+ * @param arg comma separated list of events
+ * @param reply reply stream
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
-void
-selfn_monitor_top_pids(void)
+static int
+ctrl_events(char *arg, FILE *reply)
 {
-        int res = 0;
-        struct slist *pslist = NULL, *it = NULL;
+        enum pqos_mon_event evt = (enum pqos_mon_event)0;
+        char *saveptr = NULL;
+        char *name;
+        unsigned i;
+        int ret = 0;
 
-        printf("Monitoring top-pids enabled\n");
-        sel_mon_top_like = 1;
+        for (name = strtok_r(arg, ",", &saveptr); name != NULL;
+             name = strtok_r(NULL, ",", &saveptr)) {
+                enum pqos_mon_event e;
 
-        /* getting initial values for CPU usage for processes */
-        res = get_proc_pids_stats(&pslist);
-        if (res) {
-                printf("Getting processor usage statistic failed!");
-                goto cleanup_pslist;
+                if (str_to_event(name, strlen(name), &e) != 0) {
+                        fprintf(reply, "unrecognized event '%s'", name);
+                        return -1;
+                }
+                evt |= e;
         }
-
-        /* Giving here some time for processes for generating cpu activity.
-         * In general, there are two ways of calculating CPU usage:
-         * -the instantaneous one (checking ticks during last interval)
-         * -average one (reported ps)
-         *
-         * We are using a hybrid approach, at first looking for processes that
-         * did some work in last interval (and this is the reason for sleep
-         * here) but in case that there is not enough processes which reported
-         * cpu ticks, we are checking average ticks ratio for process lifetime.
-         * So the more time time we are sleeping here, the more processes will
-         * report ticks during this sleep interval and less processes will be
-         * found by checking average ticks ratio(it is less accurate method)
-         */
-        usleep(PID_CPU_TIME_DELAY_USEC);
-
-        /* Getting updated CPU usage statistics*/
-        res = get_proc_pids_stats(&pslist);
-        if (res) {
-                printf("Getting updated processor usage statistic failed!");
-                goto cleanup_pslist;
+        if (evt == 0) {
+                fprintf(reply, "no events");
+                return -1;
         }
 
-        fill_top_procs(pslist);
+        sel_events_max = (enum pqos_mon_event)0;
+        for (i = 0; i < sel_monitor_num;) {
+                struct mon_group *grp = &sel_monitor_group[i];
+                const enum pqos_mon_event old = grp->events;
+
+                (void)pqos_mon_stop(grp->data);
+                grp->started = 0;
+                grp->events = evt;
+                monitor_setup_events(grp->type, &grp->events, mon_cap);
+                if (grp_start(grp) == PQOS_RETVAL_OK) {
+                        i++;
+                        continue;
+                }
+
+                fprintf(reply, "%sgroup %s", ret == 0 ? "start error on " : ",",
+                        grp->desc);
+                ret = -1;
+                grp->events = old;
+                if (grp_start(grp) == PQOS_RETVAL_OK) {
+                        i++;
+                        continue;
+                }
 
-cleanup_pslist:
-        /* cleaning list of all processes stats */
-        it = pslist;
-        while (it != NULL) {
-                struct slist *tmp = it;
+                /* group could not be restarted at all */
+                grp_free(grp);
+                memmove(grp, grp + 1,
+                        sizeof(*grp) * (sel_monitor_num - i - 1));
+                sel_monitor_num--;
+        }
+        if (sel_monitor_num == 0) {
+                fprintf(reply, ", no groups left");
+                stop_monitoring_loop = 1;
+                return -1;
+        }
 
-                it = it->next;
-                free(tmp->data);
-                free(tmp);
+        if (mon_loop_update() != 0) {
+                fprintf(reply, "%sout of memory", ret == 0 ? "" : ", ");
+                return -1;
         }
+        (void)mon_output_restart(NULL);
+
+        return ret;
 }
 
+#ifdef __linux__
 /**
- * @brief Compare LLC occupancy in two monitoring data sets
+ * @brief Changes sampling interval
  *
- * @param a monitoring data A
- * @param b monitoring data B
+ * Must be called with the writer idle.
  *
- * @return LLC monitoring data compare status for descending order
- * @retval 0 if \a  = \b
- * @retval >0 if \b > \a
- * @retval <0 if \b < \a
+ * @param arg interval in 100ms units or in ms with "ms" suffix
+ * @param reply reply stream
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
 static int
-mon_qsort_llc_cmp_desc(const void *a, const void *b)
+ctrl_interval(const char *arg, FILE *reply)
 {
-        const struct pqos_mon_data *const *app =
-            (const struct pqos_mon_data *const *)a;
-        const struct pqos_mon_data *const *bpp =
-            (const struct pqos_mon_data *const *)b;
-        const struct pqos_mon_data *ap = *app;
-        const struct pqos_mon_data *bp = *bpp;
-        /**
-         * This (b-a) is to get descending order
-         * otherwise it would be (a-b)
-         */
-        return (int)(((int64_t)bp->values.llc) - ((int64_t)ap->values.llc));
+        struct itimerspec timer_spec;
+        unsigned long long interval;
+        unsigned tick;
+        char *endptr = NULL;
+
+        interval = strtoull(arg, &endptr, 10);
+        if (endptr == arg) {
+                fprintf(reply, "invalid interval '%s'", arg);
+                return -1;
+        }
+        if (strcasecmp(endptr, "ms") != 0) {
+                if (*endptr != '\0') {
+                        fprintf(reply, "invalid interval '%s'", arg);
+                        return -1;
+                }
+                interval *= 100;
+        }
+        if (interval < 1 || interval > INT_MAX) {
+                fprintf(reply, "invalid interval '%s'", arg);
+                return -1;
+        }
+
+        monitor_rates_set_interval((unsigned)interval);
+        tick = monitor_rates_tick();
+
+        timer_spec.it_interval.tv_sec = tick / 1000;
+        timer_spec.it_interval.tv_nsec = tick % 1000 * 1000000l;
+        timer_spec.it_value = timer_spec.it_interval;
+        if (timerfd_settime(mon_loop.tfd, 0, &timer_spec, NULL) != 0) {
+                monitor_rates_set_interval(sel_mon_interval);
+                fprintf(reply, "failed to set timer");
+                return -1;
+        }
+
+        sel_mon_interval = (unsigned)interval;
+        (void)mon_output_restart(NULL);
+
+        if (mon_recorder_restart() != 0) {
+                stop_monitoring_loop = 1;
+                fprintf(reply, "failed to restart flight recorder");
+                return -1;
+        }
+
+        return 0;
 }
+#endif
 
 /**
- * @brief Compare core id in two monitoring data sets
+ * @brief Executes control command
  *
- * @param a monitoring data A
- * @param b monitoring data B
+ * Commands that change the monitoring wait for the writer to write out
+ * pending samples, so each sample is written with the configuration it
+ * was taken with.
  *
- * @return Core id compare status for ascending order
- * @retval 0 if \a  = \b
- * @retval >0 if \b > \a
- * @retval <0 if \b < \a
+ * @param cmd command line
+ * @param reply reply stream
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
  */
 static int
-mon_qsort_coreid_cmp_asc(const void *a, const void *b)
+mon_control_cmd(char *cmd, FILE *reply)
 {
-        const struct pqos_mon_data *const *app =
-            (const struct pqos_mon_data *const *)a;
-        const struct pqos_mon_data *const *bpp =
-            (const struct pqos_mon_data *const *)b;
-        const struct pqos_mon_data *ap = *app;
-        const struct pqos_mon_data *bp = *bpp;
-        /**
-         * This (a-b) is to get ascending order
-         * otherwise it would be (b-a)
-         */
-        return (int)(((unsigned)ap->cores[0]) - ((unsigned)bp->cores[0]));
-}
+        const char *delim = " \t";
+        char *saveptr = NULL;
+        char *verb = strtok_r(cmd, delim, &saveptr);
+        char *arg1 = strtok_r(NULL, delim, &saveptr);
+        char *arg2 = strtok_r(NULL, delim, &saveptr);
+        int groups = 0;
+        int ret = -1;
+
+        if (strtok_r(NULL, delim, &saveptr) != NULL) {
+                fprintf(reply, "too many arguments");
+                return -1;
+        }
 
-/**
- * @brief CTRL-C handler for infinite monitoring loop
- *
- * @param signo signal number
- */
-static void
-monitoring_ctrlc(int signo)
-{
-        UNUSED_ARG(signo);
-        stop_monitoring_loop = 1;
+        if (strcasecmp(verb, "list") == 0 && arg1 == NULL)
+                return ctrl_list(reply);
+
+        if (strcasecmp(verb, "trigger") == 0 && arg1 == NULL) {
+                if (sel_recorder_spec == NULL) {
+                        fprintf(reply, "flight recorder is not enabled");
+                        return -1;
+                }
+                if (monitor_recorder_trigger("control command") != 0) {
+                        fprintf(reply, "capture in progress");
+                        return -1;
+                }
+                return 0;
+        }
+
+        if (strcasecmp(verb, "add") == 0 || strcasecmp(verb, "remove") == 0 ||
+            strcasecmp(verb, "grow") == 0 || strcasecmp(verb, "shrink") == 0) {
+                groups = 1;
+                if (top_scan != NULL) {
+                        fprintf(reply, "groups follow top processes");
+                        return -1;
+                }
+        }
+
+        mon_ring_lock_idle();
+        if (strcasecmp(verb, "add") == 0 && arg1 != NULL && arg2 == NULL)
+                ret = ctrl_add(arg1, reply);
+        else if (strcasecmp(verb, "remove") == 0 && arg1 != NULL &&
+                 arg2 == NULL)
+                ret = ctrl_remove(arg1, reply);
+        else if (strcasecmp(verb, "grow") == 0 && arg2 != NULL)
+                ret = ctrl_resize(arg1, arg2, 1, reply);
+        else if (strcasecmp(verb, "shrink") == 0 && arg2 != NULL)
+                ret = ctrl_resize(arg1, arg2, 0, reply);
+        else if (strcasecmp(verb, "events") == 0 && arg1 != NULL &&
+                 arg2 == NULL)
+                ret = ctrl_events(arg1, reply);
+#ifdef __linux__
+        else if (strcasecmp(verb, "interval") == 0 && arg1 != NULL &&
+                 arg2 == NULL)
+                ret = ctrl_interval(arg1, reply);
+#endif
+        else if (strcasecmp(verb, "rotate") == 0 && arg2 == NULL) {
+                if (sel_output_file == NULL)
+                        fprintf(reply, "output is not a file");
+                else if (arg1 != NULL && strcmp(arg1, sel_output_file) != 0) {
+                        if (mon_output_restart(arg1) != 0)
+                                fprintf(reply, "cannot open '%s'", arg1);
+                        else {
+                                selfn_strdup(&sel_output_file, arg1);
+                                ret = 0;
+                        }
+                } else if (mon_output_restart(sel_output_file) != 0)
+                        fprintf(reply, "cannot open '%s'", sel_output_file);
+                else
+                        ret = 0;
+        } else if (groups)
+                fprintf(reply, "invalid arguments");
+        else
+                fprintf(reply, "unknown command '%s'", verb);
+        mon_ring_unlock();
+
+        return ret;
 }
 
 /**
- * @brief Initializes two arrays with pointers to PQoS monitoring structures
+ * @brief Polls monitoring groups due at a scheduler tick
  *
- * Function does the following things:
- * - figures size of the array to allocate
- * - allocates memory for the two arrays
- * - initializes allocated arrays with data from core or pid table
- * - saves array pointers in \a parray1 and \a parray2
- * - both arrays have identical content
+ * Without polling rates all groups are polled for all events. Otherwise
+ * active groups are polled for the due events only and cold groups are
+ * polled for all events at the cold interval. Groups are checked for
+ * being cold after each poll of their memory bandwidth.
  *
- * @param parray1 pointer to an array of pointers to PQoS monitoring structures
- * @param parray2 pointer to an array of pointers to PQoS monitoring structures
+ * @param [in] due work due at the tick
  *
- * @return Number of elements in each of the tables
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
  */
-static unsigned
-get_mon_arrays(struct pqos_mon_data ***parray1, struct pqos_mon_data ***parray2)
+static int
+mon_poll(const struct monitor_rates_due *due)
 {
+        const enum pqos_mon_event mbm_events =
+            (enum pqos_mon_event)(PQOS_MON_EVENT_LMEM_BW |
+                                  PQOS_MON_EVENT_TMEM_BW |
+                                  PQOS_MON_EVENT_RMEM_BW);
+        unsigned num_active = 0;
+        unsigned num_cold = 0;
         unsigned i;
-        struct pqos_mon_data **p1, **p2;
+        int ret = PQOS_RETVAL_OK;
 
-        ASSERT(parray1 != NULL && parray2 != NULL);
-        p1 = malloc(sizeof(p1[0]) * sel_monitor_num);
-        p2 = malloc(sizeof(p2[0]) * sel_monitor_num);
-        if (p1 == NULL || p2 == NULL) {
-                if (p1)
-                        free(p1);
-                if (p2)
-                        free(p2);
-                printf("Error with memory allocation");
-                exit(EXIT_FAILURE);
+        if (!monitor_rates_enabled())
+                return pqos_mon_poll(mon_loop.grps, mon_loop.num);
+
+        /* active groups from the start of the table, cold from the end */
+        for (i = 0; i < mon_loop.num; i++) {
+                if (!sel_monitor_group[i].cold)
+                        mon_loop.data[num_active++] = mon_loop.grps[i];
+                else if (due->cold)
+                        mon_loop.data[mon_loop.num - ++num_cold] =
+                            mon_loop.grps[i];
         }
 
-        for (i = 0; i < sel_monitor_num; i++) {
-                p1[i] = sel_monitor_group[i].data;
-                p2[i] = p1[i];
+        if (num_active > 0 && due->events != 0)
+                ret = pqos_mon_poll_subset(mon_loop.data, num_active,
+                                           due->events);
+        if (ret == PQOS_RETVAL_OK && num_cold > 0)
+                ret = pqos_mon_poll(&mon_loop.data[mon_loop.num - num_cold],
+                                    num_cold);
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+
+        for (i = 0; i < mon_loop.num; i++) {
+                struct mon_group *grp = &sel_monitor_group[i];
+
+                if (grp->cold ? due->cold : (due->events & mbm_events) != 0)
+                        grp->cold = monitor_rates_cold(grp->data);
         }
 
-        *parray1 = p1;
-        *parray2 = p2;
-        return sel_monitor_num;
+        return PQOS_RETVAL_OK;
 }
 
 void
 monitor_loop(void)
 {
-#define TERM_MIN_NUM_LINES 3
-
-        const int istty = isatty(fileno(fp_monitor));
         unsigned cache_size;
-        unsigned mon_number = 0, display_num = 0;
-        struct pqos_mon_data **mon_data = NULL, **mon_grps = NULL;
-        long runtime = 0;
-#ifdef __linux__
-        int tfd;
-#else
+        uint64_t runtime = 0;
+#ifndef __linux__
         timer_t timerid;
         struct sigevent sev;
         sigset_t sigset;
 #endif
         int retval;
         struct itimerspec timer_spec;
-
-        struct {
-                void (*begin)(FILE *fp);
-                void (*header)(FILE *fp, const char *timestamp);
-                void (*row)(FILE *fp,
-                            const char *timestamp,
-                            const struct pqos_mon_data *data);
-                void (*footer)(FILE *fp);
-                void (*end)(FILE *fp);
-        } output;
+        struct mon_output output;
+        pthread_t writer;
+        uint64_t top_refresh = mon_clock_ns(CLOCK_MONOTONIC);
+        uint64_t select_refresh = top_refresh;
+        struct monitor_rates_due due;
+        unsigned tick;
 
         if (strcasecmp(sel_output_type, "text") == 0) {
                 output.begin = monitor_text_begin;
@@ -2013,6 +3217,18 @@ monitor_loop(void)
                 output.row = monitor_xml_row;
                 output.footer = monitor_xml_footer;
                 output.end = monitor_xml_end;
+        } else if (strcasecmp(sel_output_type, "bin") == 0) {
+                output.begin = monitor_bin_begin;
+                output.header = monitor_bin_header;
+                output.row = monitor_bin_row;
+                output.footer = monitor_bin_footer;
+                output.end = monitor_bin_end;
+        } else if (strcasecmp(sel_output_type, "raw") == 0) {
+                output.begin = monitor_raw_begin;
+                output.header = monitor_raw_header;
+                output.row = monitor_raw_row;
+                output.footer = monitor_raw_footer;
+                output.end = monitor_raw_end;
         } else {
                 printf("Invalid selection of output file type '%s'!\n",
                        sel_output_type);
@@ -2024,10 +3240,28 @@ monitor_loop(void)
                 return;
         }
 
+        if (sel_proc_fds >= 0) {
+                proc_scan_set_fd_budget(top_scan, (unsigned)sel_proc_fds);
+                proc_scan_set_fd_budget(select_scan, (unsigned)sel_proc_fds);
+        }
+
+        if (monitor_rates_start(sel_rates_spec, sel_mon_interval) != 0)
+                return;
+        tick = monitor_rates_tick();
+        if (monitor_rates_enabled() && output.row == monitor_raw_row) {
+                printf("Polling rates are not supported with raw output!\n");
+                return;
+        }
+
 #ifdef __linux__
-        tfd = timerfd_create(CLOCK_MONOTONIC, 0);
-        if (tfd == -1) {
+        mon_loop.tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (mon_loop.tfd == -1) {
 #else
+        if (sel_control_path != NULL) {
+                printf("Control socket is not supported!\n");
+                return;
+        }
+
         sigemptyset(&sigset);
         sigaddset(&sigset, SIGUSR1);
         sigprocmask(SIG_BLOCK, &sigset, NULL);
@@ -2041,8 +3275,57 @@ monitor_loop(void)
                 return;
         }
 
-        mon_number = get_mon_arrays(&mon_grps, &mon_data);
-        display_num = mon_number;
+        mon_loop.output = &output;
+        mon_loop.num = get_mon_arrays(&mon_loop.grps, &mon_loop.data);
+
+        if (sel_stats_spec != NULL &&
+            monitor_stats_start(sel_stats_spec, mon_loop.num, sel_events_max) !=
+                0) {
+                free(mon_loop.grps);
+                free(mon_loop.data);
+                return;
+        }
+
+        if (mon_ring_alloc(mon_loop.num) != 0) {
+                printf("Memory allocation error!\n");
+                monitor_stats_stop();
+                free(mon_loop.grps);
+                free(mon_loop.data);
+                return;
+        }
+
+        if (sel_publish_name != NULL &&
+            pqos_telemetry_create(sel_publish_name, mon_loop.num,
+                                  &mon_loop.telemetry) != PQOS_RETVAL_OK) {
+                printf("Failed to create telemetry segment '%s'!\n",
+                       sel_publish_name);
+                stop_monitoring_loop = 1;
+        }
+
+        if (sel_export_addr != NULL &&
+            monitor_export_start(sel_export_addr) != 0) {
+                printf("Failed to start metrics exporter on '%s'!\n",
+                       sel_export_addr);
+                stop_monitoring_loop = 1;
+        }
+
+        if (sel_control_path != NULL &&
+            monitor_control_start(sel_control_path, mon_control_cmd) != 0) {
+                printf("Failed to open control socket '%s'!\n",
+                       sel_control_path);
+                stop_monitoring_loop = 1;
+        }
+
+        if (sel_recorder_spec != NULL) {
+                if (monitor_recorder_start(sel_recorder_spec, mon_loop.num,
+                                           tick, sel_events_max) != 0)
+                        stop_monitoring_loop = 1;
+#ifdef __linux__
+                else if (signal(SIGUSR1, monitoring_recorder_trigger) ==
+                         SIG_ERR)
+                        printf("Failed to catch SIGUSR1!\n");
+#endif
+        }
 
         /**
          * Capture ctrl-c to gracefully stop the loop
@@ -2054,26 +3337,12 @@ monitor_loop(void)
         if (signal(SIGTERM, monitoring_ctrlc) == SIG_ERR)
                 printf("Failed to catch SIGTERM!\n");
 
-        if (istty) {
-                struct winsize w;
-                unsigned max_lines = 0;
-
-                if (ioctl(fileno(fp_monitor), TIOCGWINSZ, &w) != -1) {
-                        max_lines = w.ws_row;
-                        if (max_lines < TERM_MIN_NUM_LINES)
-                                max_lines = TERM_MIN_NUM_LINES;
-                }
-                if ((display_num + TERM_MIN_NUM_LINES - 1) > max_lines)
-                        display_num = max_lines - TERM_MIN_NUM_LINES + 1;
-        }
-
-        timer_spec.it_interval.tv_sec = sel_mon_interval / 10l;
-        timer_spec.it_interval.tv_nsec =
-            sel_mon_interval % 10l * 100l * 1000000l;
+        timer_spec.it_interval.tv_sec = tick / 1000l;
+        timer_spec.it_interval.tv_nsec = tick % 1000l * 1000000l;
         timer_spec.it_value.tv_sec = timer_spec.it_interval.tv_sec;
         timer_spec.it_value.tv_nsec = timer_spec.it_interval.tv_nsec;
 #ifdef __linux__
-        retval = timerfd_settime(tfd, 0, &timer_spec, NULL);
+        retval = timerfd_settime(mon_loop.tfd, 0, &timer_spec, NULL);
 #else
         retval = timer_settime(timerid, 0, &timer_spec, NULL);
 #endif
@@ -2083,16 +3352,43 @@ monitor_loop(void)
                 stop_monitoring_loop = 1;
         }
 
-        output.begin(fp_monitor);
+        /**
+         * Output is written by a separate thread so slow output does not
+         * affect the sampling period
+         */
+        if (pthread_create(&writer, NULL, mon_writer, &output) != 0) {
+                fprintf(stderr, "Failed to create writer thread\n");
+                mon_ring_free();
+                monitor_stats_stop();
+                if (sel_control_path != NULL)
+                        monitor_control_stop();
+                if (sel_recorder_spec != NULL)
+                        monitor_recorder_stop();
+                if (sel_export_addr != NULL)
+                        monitor_export_stop();
+                if (mon_loop.telemetry != NULL)
+                        pqos_telemetry_destroy(mon_loop.telemetry);
+                free(mon_loop.grps);
+                free(mon_loop.data);
+                return;
+        }
+
+        monitor_rates_due(runtime, &due);
+
         while (!stop_monitoring_loop) {
-                struct tm *ptm = NULL;
                 unsigned i = 0;
-                char cb_time[64];
                 int ret;
                 uint64_t timer_count = 0;
-                time_t curr_time;
-
-                ret = pqos_mon_poll(mon_grps, mon_number);
+                uint64_t monotonic;
+                uint64_t realtime;
+
+                ret = mon_poll(&due);
+                if (ret == PQOS_RETVAL_ERROR &&
+                    pqos_cpu_refresh() == PQOS_RETVAL_OK)
+                        /* cores could go offline, retry with new topology */
+                        ret = mon_poll(&due);
+                monotonic = mon_clock_ns(CLOCK_MONOTONIC);
+                realtime = mon_clock_ns(CLOCK_REALTIME);
                 if (ret == PQOS_RETVAL_OVERFLOW) {
                         printf("MBM counter overflow\n");
                         continue;
@@ -2101,65 +3397,112 @@ monitor_loop(void)
                         break;
                 }
 
-                memcpy(mon_data, mon_grps, mon_number * sizeof(mon_grps[0]));
-
-                if (sel_mon_top_like)
-                        qsort(mon_data, mon_number, sizeof(mon_data[0]),
-                              mon_qsort_llc_cmp_desc);
-                else if (sel_monitor_type == MON_GROUP_TYPE_CORE)
-                        qsort(mon_data, mon_number, sizeof(mon_data[0]),
-                              mon_qsort_coreid_cmp_asc);
-
-                /**
-                 * Get time string
-                 */
-                curr_time = time(0);
-                ptm = localtime(&curr_time);
-                if (ptm != NULL)
-                        strftime(cb_time, sizeof(cb_time) - 1,
-                                 "%Y-%m-%d %H:%M:%S", ptm);
-                else
-                        strncpy(cb_time, "error", sizeof(cb_time) - 1);
+                if (due.output && mon_loop.telemetry != NULL)
+                        for (i = 0; i < mon_loop.num; i++)
+                                pqos_telemetry_update(
+                                    mon_loop.telemetry, i,
+                                    sel_monitor_group[i].desc,
+                                    sel_monitor_group[i].data);
+
+                if (due.output && sel_export_addr != NULL)
+                        monitor_export_update(mon_loop.grps, mon_loop.num,
+                                              realtime);
+
+                if (sel_stats_spec != NULL)
+                        monitor_stats_update(mon_loop.grps, mon_loop.num,
+                                             monotonic);
+
+                if (sel_recorder_spec != NULL) {
+                        if (recorder_signal) {
+                                recorder_signal = 0;
+                                (void)monitor_recorder_trigger("SIGUSR1");
+                        }
+                        monitor_recorder_update(mon_loop.grps, mon_loop.num,
+                                                monotonic, realtime);
+                }
 
-                output.header(fp_monitor, cb_time);
-                for (i = 0; i < display_num; i++) {
-#ifndef __clang_analyzer__
-                        const struct pqos_mon_data *data = mon_data[i];
-#else
-                        const struct pqos_mon_data *data = NULL;
-#endif
+                if (due.output)
+                        mon_ring_push(mon_loop.grps, monotonic, realtime);
 
-                        output.row(fp_monitor, cb_time, data);
+                /* follow the current heaviest CPU users */
+                if (top_scan != NULL && monotonic - top_refresh >=
+                                            TOP_PROC_REFRESH_MS * 1000000llu) {
+                        top_procs_refresh();
+                        top_refresh = monotonic;
                 }
-                output.footer(fp_monitor);
 
-                fflush(fp_monitor);
+                /* processes join and leave selector groups */
+                if (select_scan != NULL &&
+                    monotonic - select_refresh >=
+                        PROC_SELECT_REFRESH_MS * 1000000llu) {
+                        select_procs_refresh();
+                        select_refresh = monotonic;
+                }
 
                 if (stop_monitoring_loop)
                         break;
 
                 /* timeout */
                 if (sel_timeout != TIMEOUT_INFINITE &&
-                    runtime / 1000l >= sel_timeout)
+                    runtime / 1000 >= sel_timeout)
                         break;
 
 #ifdef __linux__
-                retval = read(tfd, &timer_count, sizeof(timer_count));
+                /* serve control commands until the next sample is due */
+                if (sel_control_path != NULL &&
+                    monitor_control_wait(mon_loop.tfd) != 0) {
+                        fprintf(stderr, "Failed to wait for timer\n");
+                        break;
+                }
+                if (stop_monitoring_loop)
+                        break;
+                retval = read(mon_loop.tfd, &timer_count, sizeof(timer_count));
 #else
                 sigwaitinfo(&sigset, NULL);
                 retval = timer_getoverrun(timerid);
                 timer_count = retval + 1;
 #endif
-                if (retval < 0 || timer_count < 1 || timer_count > 100) {
+                if (retval < 0 || timer_count < 1) {
                         fprintf(stderr, "Failed to read timer\n");
                         break;
                 }
-                runtime += timer_count * sel_mon_interval * 100l;
+                runtime += timer_count * monitor_rates_tick();
+                monitor_rates_due(runtime, &due);
         }
-        output.end(fp_monitor);
 
-        free(mon_grps);
-        free(mon_data);
+        mon_ring_close();
+        pthread_join(writer, NULL);
+
+        if (mon_ring.dropped > 0)
+                fprintf(stderr,
+                        "%lu samples dropped, output could not keep up\n",
+                        mon_ring.dropped);
+
+        pthread_cond_destroy(&mon_ring.cond);
+        pthread_mutex_destroy(&mon_ring.lock);
+        mon_ring_free();
+        monitor_stats_stop();
+
+        if (sel_control_path != NULL)
+                monitor_control_stop();
+
+        if (sel_recorder_spec != NULL)
+                monitor_recorder_stop();
+
+        if (mon_loop.telemetry != NULL)
+                pqos_telemetry_destroy(mon_loop.telemetry);
+        mon_loop.telemetry = NULL;
+
+        if (sel_export_addr != NULL)
+                monitor_export_stop();
+
+#ifdef __linux__
+        close(mon_loop.tfd);
+#endif
+        free(mon_loop.grps);
+        free(mon_loop.data);
+        mon_loop.grps = NULL;
+        mon_loop.data = NULL;
 }
 
 void
@@ -2181,12 +3524,120 @@ monitor_cleanup(void)
         if (sel_output_type != NULL)
                 free(sel_output_type);
         sel_output_type = NULL;
+        if (sel_publish_name != NULL)
+                free(sel_publish_name);
+        sel_publish_name = NULL;
+        if (sel_export_addr != NULL)
+                free(sel_export_addr);
+        sel_export_addr = NULL;
+        if (sel_stats_spec != NULL)
+                free(sel_stats_spec);
+        sel_stats_spec = NULL;
+        if (sel_control_path != NULL)
+                free(sel_control_path);
+        sel_control_path = NULL;
+        if (sel_rates_spec != NULL)
+                free(sel_rates_spec);
+        sel_rates_spec = NULL;
+        if (sel_recorder_spec != NULL)
+                free(sel_recorder_spec);
+        sel_recorder_spec = NULL;
+
+        proc_scan_destroy(top_scan);
+        top_scan = NULL;
+        proc_scan_destroy(select_scan);
+        select_scan = NULL;
 }
 
 int
 monitor_get_interval(void)
 {
-        return sel_mon_interval;
+        return (int)sel_mon_interval;
+}
+
+int
+monitor_get_sample_time(uint64_t *monotonic, uint64_t *realtime)
+{
+        if (mon_sample_curr == NULL)
+                return -1;
+
+        if (monotonic != NULL)
+                *monotonic = mon_sample_curr->monotonic;
+        if (realtime != NULL)
+                *realtime = mon_sample_curr->realtime;
+
+        return 0;
+}
+
+int
+monitor_get_stat(const struct pqos_mon_data *row,
+                 const unsigned col,
+                 double *value)
+{
+        const struct mon_sample *sample = mon_sample_curr;
+        const unsigned num_columns = monitor_stats_num_columns();
+        unsigned idx;
+
+        if (sample == NULL || sample->stats == NULL || col >= num_columns ||
+            row < sample->data || row >= sample->data + mon_ring.num)
+                return -1;
+
+        idx = (unsigned)(row - sample->data);
+        *value = sample->stats[idx * num_columns + col];
+        if (isnan(*value))
+                return -1;
+
+        return 0;
+}
+
+int
+monitor_get_value(const struct pqos_mon_data *row,
+                  const enum pqos_mon_event event,
+                  uint64_t *value,
+                  uint64_t *delta)
+{
+        const struct mon_sample *sample = mon_sample_curr;
+        const uint64_t *values;
+        unsigned idx, j;
+
+        if (sample == NULL || row < sample->data ||
+            row >= sample->data + mon_ring.num)
+                return pqos_mon_get_value(row, event, value, delta);
+
+        for (j = 0; j < DIM(mon_sample_events); j++)
+                if (mon_sample_events[j] == event)
+                        break;
+        /* remaining values are part of the row */
+        if (j == DIM(mon_sample_events))
+                return pqos_mon_get_value(row, event, value, delta);
+
+        if ((row->event & event) == 0)
+                return PQOS_RETVAL_PARAM;
+
+        idx = (unsigned)(row - sample->data);
+        values = &sample->values[(idx * DIM(mon_sample_events) + j) * 2];
+        if (value != NULL)
+                *value = values[0];
+        if (delta != NULL)
+                *delta = values[1];
+
+        return PQOS_RETVAL_OK;
+}
+
+double
+monitor_get_mbm_interval(const struct pqos_mon_data *row)
+{
+        const struct mon_sample *sample = mon_sample_curr;
+        unsigned idx;
+
+        if (sample != NULL && row >= sample->data &&
+            row < sample->data + mon_ring.num) {
+                idx = (unsigned)(row - sample->data);
+                if (sample->mbm_interval[idx] > 0)
+                        return (double)sample->mbm_interval[idx] / 1000000.0;
+        }
+
+        return (double)sel_mon_interval;
 }
 
 enum pqos_mon_event
@@ -96,6 +96,55 @@ void selfn_monitor_file_type(const char *arg);
  */
 void selfn_monitor_file(const char *arg);
 
+/**
+ * @brief Selects telemetry segment to publish monitored data in
+ *
+ * @param arg string passed to --mon-publish command line option
+ */
+void selfn_monitor_publish(const char *arg);
+
+/**
+ * @brief Selects address to serve monitored data in Prometheus format on
+ *
+ * @param arg string passed to --mon-export command line option
+ */
+void selfn_monitor_export(const char *arg);
+
+/**
+ * @brief Selects streaming statistics to add to the monitoring output
+ *
+ * @param arg string passed to --mon-stats command line option
+ */
+void selfn_monitor_stats(const char *arg);
+
+/**
+ * @brief Selects control socket for live reconfiguration of monitoring
+ *
+ * @param arg string passed to --mon-control command line option
+ */
+void selfn_monitor_control(const char *arg);
+
+/**
+ * @brief Selects polling rates of event classes
+ *
+ * @param arg string passed to --mon-rates command line option
+ */
+void selfn_monitor_rates(const char *arg);
+
+/**
+ * @brief Selects number of /proc descriptors cached by process scanners
+ *
+ * @param arg string passed to --mon-proc-fds command line option
+ */
+void selfn_monitor_proc_fds(const char *arg);
+
+/**
+ * @brief Selects flight recorder ring file and triggers
+ *
+ * @param arg string passed to --mon-recorder command line option
+ */
+void selfn_monitor_recorder(const char *arg);
+
 /**
  * @brief Translates multiple monitoring request strings into
  *        internal monitoring request structures
@@ -191,10 +240,74 @@ void monitor_loop(void);
 /**
  * @brief Retrieve monitoring interval
  *
- * @return monitoring interval
+ * @return monitoring interval in milliseconds
  */
 int monitor_get_interval(void);
 
+/**
+ * @brief Retrieve time between the last two MBM polls of a group
+ *
+ * Differs from the monitoring interval when polling rates are selected.
+ *
+ * @param [in] row monitoring group of the sample being written out
+ *
+ * @return MBM poll interval in milliseconds, monitoring interval
+ *         if not known
+ */
+double monitor_get_mbm_interval(const struct pqos_mon_data *row);
+
+/**
+ * @brief Retrieve poll timestamps of the sample being written out
+ *
+ * Valid only when called from the output functions.
+ *
+ * @param [out] monotonic CLOCK_MONOTONIC time of the poll [ns]
+ * @param [out] realtime CLOCK_REALTIME time of the poll [ns]
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 no sample is being written out
+ */
+int monitor_get_sample_time(uint64_t *monotonic, uint64_t *realtime);
+
+/**
+ * @brief Retrieve streaming statistics value of the row being written out
+ *
+ * Valid only when called from the output functions.
+ *
+ * @param [in] row monitoring data passed to the row output function
+ * @param [in] col statistics column, see monitor_stats_get_column()
+ * @param [out] value column value in display units
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 value is not available
+ */
+int monitor_get_stat(const struct pqos_mon_data *row,
+                     const unsigned col,
+                     double *value);
+
+/**
+ * @brief Retrieve counter value of the row being written out
+ *
+ * Output functions must use it instead of pqos_mon_get_value(), rows are
+ * copies of the monitoring groups and values kept by the library outside
+ * of the group are copied with the sample. Other groups are passed to
+ * pqos_mon_get_value().
+ *
+ * @param [in] row monitoring data passed to the row output function
+ * @param [in] event monitoring event
+ * @param [out] value counter value, can be NULL
+ * @param [out] delta counter delta, can be NULL
+ *
+ * @return Operation status
+ * @retval PQOS_RETVAL_OK on success
+ */
+int monitor_get_value(const struct pqos_mon_data *row,
+                      const enum pqos_mon_event event,
+                      uint64_t *value,
+                      uint64_t *delta);
+
 /**
  * @brief List of events being monitored
  *
@@ -0,0 +1,278 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor_bin.h"
+
+#include "common.h"
+#include "monitor.h"
+#include "monitor_utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Columns in the order they are stored in the stream
+ */
+static const struct {
+        enum pqos_mon_event event;
+        unsigned decimals;
+        const char *name;
+} bin_columns[] = {
+    {PQOS_PERF_EVENT_IPC, 2, "IPC"},
+    {PQOS_PERF_EVENT_LLC_MISS, 0, "LLC Misses"},
+    {PQOS_PERF_EVENT_LLC_REF, 0, "LLC References"},
+    {PQOS_MON_EVENT_L3_OCCUP, 1, NULL},
+    {PQOS_MON_EVENT_LMEM_BW, 1, "MBL[MB/s]"},
+    {PQOS_MON_EVENT_RMEM_BW, 1, "MBR[MB/s]"},
+    {PQOS_MON_EVENT_TMEM_BW, 1, "MBT[MB/s]"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_READ, 0, "LLC Misses Read"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE, 0, "LLC Misses Write"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_READ, 0, "LLC References Read"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE, 0, "LLC References Write"},
+};
+
+#define BIN_NUM_COLUMNS DIM(bin_columns)
+
+/**
+ * Per group encoder state
+ */
+struct bin_group {
+        char *desc;
+        int64_t value[BIN_NUM_COLUMNS];
+};
+
+static struct {
+        enum pqos_mon_event events; /**< selected events */
+        int64_t time;               /**< previous timestamp in ms */
+        struct bin_group *groups;
+        unsigned num_groups;
+        unsigned last; /**< index of the previously written group */
+} bin;
+
+void
+monitor_bin_put_uint(FILE *fp, uint64_t val)
+{
+        do {
+                uint8_t byte = val & 0x7f;
+
+                val >>= 7;
+                if (val != 0)
+                        byte |= 0x80;
+                fputc(byte, fp);
+        } while (val != 0);
+}
+
+void
+monitor_bin_put_int(FILE *fp, int64_t val)
+{
+        monitor_bin_put_uint(fp, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+void
+monitor_bin_put_str(FILE *fp, const char *str)
+{
+        size_t len = strlen(str);
+
+        monitor_bin_put_uint(fp, len);
+        fwrite(str, 1, len, fp);
+}
+
+/**
+ * @brief Finds encoder state of the group, adding it when not seen before
+ *
+ * @param fp file descriptor
+ * @param mon_data monitoring group
+ *
+ * @return group index or -1 on error
+ */
+static int
+bin_group_get(FILE *fp, const struct pqos_mon_data *mon_data)
+{
+        const char *desc = (const char *)mon_data->context;
+        struct bin_group *group;
+        unsigned i;
+
+        /* rows are usually written in the same order in every sample */
+        i = bin.last + 1;
+        if (i < bin.num_groups && strcmp(bin.groups[i].desc, desc) == 0)
+                return i;
+
+        for (i = 0; i < bin.num_groups; i++)
+                if (strcmp(bin.groups[i].desc, desc) == 0)
+                        return i;
+
+        group = realloc(bin.groups, (bin.num_groups + 1) * sizeof(*group));
+        if (group == NULL)
+                return -1;
+        bin.groups = group;
+        group = &bin.groups[bin.num_groups];
+        memset(group, 0, sizeof(*group));
+        group->desc = strdup(desc);
+        if (group->desc == NULL)
+                return -1;
+
+        fputc(MONITOR_BIN_REC_GROUP, fp);
+        monitor_bin_put_uint(fp, bin.num_groups);
+        monitor_bin_put_uint(fp, mon_data->event & bin.events);
+        monitor_bin_put_str(fp, desc);
+
+        return bin.num_groups++;
+}
+
+void
+monitor_bin_begin(FILE *fp)
+{
+        enum monitor_llc_format format = monitor_get_llc_format();
+        char magic[MONITOR_BIN_MAGIC_LEN] = MONITOR_BIN_MAGIC;
+        unsigned num_columns = 0;
+        unsigned mode = 0;
+        unsigned i;
+
+        ASSERT(fp != NULL);
+
+        memset(&bin, 0, sizeof(bin));
+        bin.events = monitor_get_events();
+
+        if (monitor_core_mode())
+                mode = MONITOR_BIN_MODE_CORE;
+        else if (monitor_process_mode())
+                mode = MONITOR_BIN_MODE_PID;
+        else if (monitor_uncore_mode())
+                mode = MONITOR_BIN_MODE_UNCORE;
+
+        fwrite(magic, 1, sizeof(magic), fp);
+        monitor_bin_put_uint(fp, MONITOR_BIN_VERSION);
+        monitor_bin_put_uint(fp, mode);
+        monitor_bin_put_uint(fp, monitor_get_interval());
+
+        for (i = 0; i < BIN_NUM_COLUMNS; i++)
+                if (bin.events & bin_columns[i].event)
+                        num_columns++;
+
+        monitor_bin_put_uint(fp, num_columns);
+        for (i = 0; i < BIN_NUM_COLUMNS; i++) {
+                const char *name = bin_columns[i].name;
+
+                if (!(bin.events & bin_columns[i].event))
+                        continue;
+
+                if (bin_columns[i].event == PQOS_MON_EVENT_L3_OCCUP)
+                        name = format == LLC_FORMAT_KILOBYTES ? "LLC[KB]"
+                                                              : "LLC[%]";
+
+                monitor_bin_put_uint(fp, bin_columns[i].event);
+                monitor_bin_put_uint(fp, bin_columns[i].decimals);
+                monitor_bin_put_str(fp, name);
+        }
+}
+
+void
+monitor_bin_header(FILE *fp, const char *timestamp)
+{
+        uint64_t realtime;
+        int64_t time;
+
+        ASSERT(fp != NULL);
+        UNUSED_ARG(timestamp);
+
+        if (monitor_get_sample_time(NULL, &realtime) != 0)
+                return;
+        time = (int64_t)(realtime / 1000000);
+
+        fputc(MONITOR_BIN_REC_TIME, fp);
+        monitor_bin_put_int(fp, time - bin.time);
+        bin.time = time;
+}
+
+void
+monitor_bin_row(FILE *fp,
+                const char *timestamp,
+                const struct pqos_mon_data *mon_data)
+{
+        struct bin_group *group;
+        int idx;
+        unsigned i;
+
+        ASSERT(fp != NULL);
+        ASSERT(mon_data != NULL);
+        UNUSED_ARG(timestamp);
+
+        idx = bin_group_get(fp, mon_data);
+        if (idx < 0)
+                return;
+        group = &bin.groups[idx];
+        bin.last = idx;
+
+        fputc(MONITOR_BIN_REC_ROW, fp);
+        monitor_bin_put_uint(fp, idx);
+
+        for (i = 0; i < BIN_NUM_COLUMNS; i++) {
+                enum pqos_mon_event event = bin_columns[i].event;
+                double value;
+                int64_t scaled;
+                unsigned j;
+
+                if (!(mon_data->event & bin.events & event))
+                        continue;
+
+                value = monitor_utils_get_value(mon_data, event);
+                for (j = 0; j < bin_columns[i].decimals; j++)
+                        value *= 10;
+                scaled = (int64_t)(value < 0 ? value - 0.5 : value + 0.5);
+
+                monitor_bin_put_int(fp, scaled - group->value[i]);
+                group->value[i] = scaled;
+        }
+}
+
+void
+monitor_bin_footer(FILE *fp)
+{
+        UNUSED_ARG(fp);
+}
+
+void
+monitor_bin_end(FILE *fp)
+{
+        unsigned i;
+
+        ASSERT(fp != NULL);
+
+        fputc(MONITOR_BIN_REC_END, fp);
+        fflush(fp);
+
+        for (i = 0; i < bin.num_groups; i++)
+                free(bin.groups[i].desc);
+        free(bin.groups);
+        memset(&bin, 0, sizeof(bin));
+}
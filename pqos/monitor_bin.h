@@ -0,0 +1,142 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Binary monitoring output
+ *
+ * The stream starts with a self describing header:
+ *  - MONITOR_BIN_MAGIC (8 bytes)
+ *  - format version
+ *  - monitoring mode (MONITOR_BIN_MODE_*)
+ *  - sampling interval in milliseconds
+ *  - number of columns, followed by each column definition:
+ *    event id, number of decimal places and length prefixed name
+ *
+ * Header is followed by records, each starting with a single tag byte:
+ *  - MONITOR_BIN_REC_TIME: timestamp delta in milliseconds
+ *  - MONITOR_BIN_REC_GROUP: group index, event mask and length prefixed
+ *    group description; emitted before the first row of the group
+ *  - MONITOR_BIN_REC_ROW: group index followed by one value delta for
+ *    each column present in the group event mask, in column order
+ *  - MONITOR_BIN_REC_END: end of stream
+ *
+ * All integers are LEB128 encoded, deltas are zigzag encoded first.
+ * Column values are stored as integers scaled by 10^decimals and each
+ * delta is taken against the previous row of the same group.
+ */
+
+#ifndef __MONITOR_BIN_H__
+#define __MONITOR_BIN_H__
+
+#include "pqos.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define MONITOR_BIN_MAGIC     "PQOSBIN"
+#define MONITOR_BIN_MAGIC_LEN 8
+#define MONITOR_BIN_VERSION   1
+
+#define MONITOR_BIN_MODE_CORE   1
+#define MONITOR_BIN_MODE_PID    2
+#define MONITOR_BIN_MODE_UNCORE 3
+
+#define MONITOR_BIN_REC_TIME  'T'
+#define MONITOR_BIN_REC_GROUP 'G'
+#define MONITOR_BIN_REC_ROW   'R'
+#define MONITOR_BIN_REC_END   'E'
+
+/**
+ * @brief Writes unsigned LEB128 value
+ *
+ * @param fp file descriptor
+ * @param val value to write
+ */
+void monitor_bin_put_uint(FILE *fp, uint64_t val);
+
+/**
+ * @brief Writes zigzag encoded signed value
+ *
+ * @param fp file descriptor
+ * @param val value to write
+ */
+void monitor_bin_put_int(FILE *fp, int64_t val);
+
+/**
+ * @brief Writes length prefixed string
+ *
+ * @param fp file descriptor
+ * @param str string to write
+ */
+void monitor_bin_put_str(FILE *fp, const char *str);
+
+/**
+ * @brief Start binary output
+ *
+ * @param fp file descriptor
+ */
+void monitor_bin_begin(FILE *fp);
+
+/**
+ * @brief Write binary sample timestamp
+ *
+ * @param fp file descriptor
+ * @param [in] timestamp data timestamp
+ */
+void monitor_bin_header(FILE *fp, const char *timestamp);
+
+/**
+ * @brief Write monitoring data in binary format
+ *
+ * @param fp file descriptor
+ * @param [in] timestamp data timestamp
+ * @param [in] data monitoring data
+ */
+void monitor_bin_row(FILE *fp,
+                     const char *timestamp,
+                     const struct pqos_mon_data *data);
+
+/**
+ * @brief Finish binary sample
+ *
+ * @param fp file descriptor
+ */
+void monitor_bin_footer(FILE *fp);
+
+/**
+ * @brief Finalize binary output
+ *
+ * @param fp file descriptor
+ */
+void monitor_bin_end(FILE *fp);
+
+#endif /* __MONITOR_BIN_H__ */
@@ -0,0 +1,408 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor_control.h"
+
+#include "common.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define CONTROL_BACKLOG     4
+#define CONTROL_CLIENTS_MAX 8
+#define CONTROL_LINE_MAX    1024
+#define CONTROL_TIMEOUT_SEC 1
+
+/**
+ * Connected control client
+ */
+struct control_client {
+        int fd;
+        size_t len;                 /**< length of data in line */
+        int overflow;               /**< discarding too long line */
+        char line[CONTROL_LINE_MAX]; /**< partially received line */
+};
+
+static struct {
+        int fd;          /**< listening socket */
+        char *path;      /**< socket path to remove on stop */
+        monitor_control_handler_t handler;
+        struct control_client client[CONTROL_CLIENTS_MAX];
+} control = {.fd = -1};
+
+/**
+ * @brief Sends whole buffer to the client
+ *
+ * @param fd client socket
+ * @param data data to send
+ * @param len length of \a data
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+static int
+control_send(const int fd, const char *data, size_t len)
+{
+        while (len > 0) {
+                ssize_t ret = send(fd, data, len, MSG_NOSIGNAL);
+
+                if (ret < 0 && errno == EINTR)
+                        continue;
+                if (ret <= 0)
+                        return -1;
+                data += ret;
+                len -= ret;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Executes single command and sends the reply
+ *
+ * @param fd client socket
+ * @param cmd command line
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 reply could not be sent
+ */
+static int
+control_exec(const int fd, char *cmd)
+{
+        char *text = NULL;
+        size_t size = 0;
+        FILE *reply;
+        int ret;
+
+        reply = open_memstream(&text, &size);
+        if (reply == NULL) {
+                static const char err[] = "ERR out of memory\n";
+
+                return control_send(fd, err, sizeof(err) - 1);
+        }
+
+        ret = control.handler(cmd, reply);
+        if (fclose(reply) != 0 || text == NULL) {
+                free(text);
+                text = NULL;
+                size = 0;
+        }
+
+        if (ret == 0) {
+                ret = control_send(fd, text, size);
+                if (ret == 0)
+                        ret = control_send(fd, "OK\n", 3);
+        } else {
+                /* error message is reported on a single line */
+                while (size > 0 && text[size - 1] == '\n')
+                        size--;
+                ret = control_send(fd, "ERR ", 4);
+                if (ret == 0)
+                        ret = control_send(fd, text, size);
+                if (ret == 0)
+                        ret = control_send(fd, "\n", 1);
+        }
+        free(text);
+
+        return ret;
+}
+
+/**
+ * @brief Closes client connection
+ *
+ * @param client control client
+ */
+static void
+control_close(struct control_client *client)
+{
+        close(client->fd);
+        client->fd = -1;
+        client->len = 0;
+        client->overflow = 0;
+}
+
+/**
+ * @brief Reads data from the client and executes complete commands
+ *
+ * @param client control client
+ */
+static void
+control_read(struct control_client *client)
+{
+        char *line = client->line;
+        size_t start = 0;
+        size_t i;
+        ssize_t ret;
+
+        ret = recv(client->fd, line + client->len,
+                   sizeof(client->line) - client->len, MSG_DONTWAIT);
+        if (ret < 0 && (errno == EINTR || errno == EAGAIN))
+                return;
+        if (ret <= 0) {
+                control_close(client);
+                return;
+        }
+        client->len += ret;
+
+        for (i = 0; i < client->len; i++) {
+                size_t end = i;
+
+                if (line[i] != '\n')
+                        continue;
+
+                if (client->overflow) {
+                        static const char err[] = "ERR line too long\n";
+
+                        client->overflow = 0;
+                        start = i + 1;
+                        if (control_send(client->fd, err, sizeof(err) - 1) !=
+                            0) {
+                                control_close(client);
+                                return;
+                        }
+                        continue;
+                }
+
+                while (end > start && isspace(line[end - 1]))
+                        end--;
+                line[end] = '\0';
+                while (isspace(line[start]))
+                        start++;
+
+                if (line[start] != '\0' &&
+                    control_exec(client->fd, &line[start]) != 0) {
+                        control_close(client);
+                        return;
+                }
+                start = i + 1;
+        }
+
+        client->len -= start;
+        memmove(line, line + start, client->len);
+
+        /* drop the beginning of a line that does not fit the buffer */
+        if (client->len == sizeof(client->line)) {
+                client->len = 0;
+                client->overflow = 1;
+        }
+}
+
+/**
+ * @brief Accepts new client connection
+ */
+static void
+control_accept(void)
+{
+        const struct timeval tv = {.tv_sec = CONTROL_TIMEOUT_SEC};
+        unsigned i;
+        int fd;
+
+        fd = accept(control.fd, NULL, NULL);
+        if (fd < 0)
+                return;
+
+        for (i = 0; i < DIM(control.client); i++)
+                if (control.client[i].fd < 0)
+                        break;
+        if (i == DIM(control.client)) {
+                static const char err[] = "ERR too many clients\n";
+
+                (void)control_send(fd, err, sizeof(err) - 1);
+                close(fd);
+                return;
+        }
+
+        /* stalled client must not block the sampler for long */
+        (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        control.client[i].fd = fd;
+        control.client[i].len = 0;
+        control.client[i].overflow = 0;
+}
+
+int
+monitor_control_wait(const int fd)
+{
+        for (;;) {
+                struct pollfd fds[2 + CONTROL_CLIENTS_MAX];
+                struct control_client *client[CONTROL_CLIENTS_MAX];
+                unsigned num = 0;
+                unsigned i;
+
+                fds[num].fd = fd;
+                fds[num++].events = POLLIN;
+                fds[num].fd = control.fd;
+                fds[num++].events = POLLIN;
+                for (i = 0; i < DIM(control.client); i++) {
+                        if (control.client[i].fd < 0)
+                                continue;
+                        client[num - 2] = &control.client[i];
+                        fds[num].fd = control.client[i].fd;
+                        fds[num++].events = POLLIN;
+                }
+
+                if (poll(fds, num, -1) < 0) {
+                        if (errno == EINTR)
+                                return 0;
+                        return -1;
+                }
+
+                for (i = 2; i < num; i++)
+                        if (fds[i].revents != 0)
+                                control_read(client[i - 2]);
+                if (fds[1].revents & POLLIN)
+                        control_accept();
+                if (fds[0].revents != 0)
+                        return 0;
+        }
+}
+
+int
+monitor_control_parse_list(const char *str, uint64_t *tab, const unsigned max)
+{
+        unsigned num = 0;
+
+        if (str == NULL || tab == NULL)
+                return -1;
+
+        while (*str != '\0') {
+                unsigned long long start, end;
+                char *endptr;
+
+                if (!isdigit(*str))
+                        return -1;
+                start = strtoull(str, &endptr, 10);
+                end = start;
+                str = endptr;
+                if (*str == '-') {
+                        str++;
+                        if (!isdigit(*str))
+                                return -1;
+                        end = strtoull(str, &endptr, 10);
+                        str = endptr;
+                        if (end < start)
+                                return -1;
+                }
+                if (*str == ',')
+                        str++;
+                else if (*str != '\0')
+                        return -1;
+
+                for (; start <= end; start++) {
+                        if (num >= max)
+                                return -1;
+                        tab[num++] = start;
+                }
+        }
+
+        return num > 0 ? (int)num : -1;
+}
+
+int
+monitor_control_start(const char *path, monitor_control_handler_t handler)
+{
+        struct sockaddr_un sun;
+        struct stat st;
+        mode_t mask;
+        unsigned i;
+        int ret;
+
+        if (path == NULL || handler == NULL || control.fd >= 0)
+                return -1;
+        if (strlen(path) == 0 || strlen(path) >= sizeof(sun.sun_path))
+                return -1;
+
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strcpy(sun.sun_path, path);
+
+        /* remove stale socket of previous run */
+        if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+                (void)unlink(path);
+
+        for (i = 0; i < DIM(control.client); i++)
+                control.client[i].fd = -1;
+
+        control.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (control.fd < 0)
+                return -1;
+
+        /* socket is created accessible by the owner only */
+        mask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+        ret = bind(control.fd, (struct sockaddr *)&sun, sizeof(sun));
+        (void)umask(mask);
+        if (ret != 0) {
+                close(control.fd);
+                control.fd = -1;
+                return -1;
+        }
+        control.path = strdup(path);
+        if (control.path == NULL || listen(control.fd, CONTROL_BACKLOG) != 0) {
+                monitor_control_stop();
+                return -1;
+        }
+
+        control.handler = handler;
+
+        return 0;
+}
+
+void
+monitor_control_stop(void)
+{
+        unsigned i;
+
+        for (i = 0; i < DIM(control.client); i++)
+                if (control.client[i].fd >= 0)
+                        control_close(&control.client[i]);
+
+        if (control.fd >= 0)
+                close(control.fd);
+        control.fd = -1;
+
+        if (control.path != NULL) {
+                (void)unlink(control.path);
+                free(control.path);
+                control.path = NULL;
+        }
+        control.handler = NULL;
+}
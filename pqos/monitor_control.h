@@ -0,0 +1,108 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Monitoring control channel
+ *
+ * Line based command interface on a unix socket. Commands are executed
+ * by the sampler between polls, so the monitoring loop keeps running
+ * while it is being reconfigured. Each command is answered with optional
+ * text lines followed by "OK" or a single "ERR <message>" line.
+ */
+
+#ifndef __MONITOR_CONTROL_H__
+#define __MONITOR_CONTROL_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Control command handler
+ *
+ * @param [in] cmd command line without line terminator
+ * @param [out] reply stream for the reply text or the error message
+ *
+ * @return Command status
+ * @retval 0 OK
+ * @retval -1 command failed
+ */
+typedef int (*monitor_control_handler_t)(char *cmd, FILE *reply);
+
+/**
+ * @brief Opens control socket
+ *
+ * Socket is accessible to the owner only.
+ *
+ * @param [in] path unix socket path
+ * @param [in] handler command handler
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int monitor_control_start(const char *path,
+                          monitor_control_handler_t handler);
+
+/**
+ * @brief Waits for \a fd to become readable serving control clients
+ *
+ * Commands are executed in the context of the caller.
+ *
+ * @param [in] fd file descriptor to wait for
+ *
+ * @return Operation status
+ * @retval 0 \a fd is readable or wait was interrupted by a signal
+ * @retval -1 error
+ */
+int monitor_control_wait(const int fd);
+
+/**
+ * @brief Converts list of numbers and ranges into a table
+ *
+ * Unlike the command line parsers this does not terminate the program
+ * on malformed input.
+ *
+ * @param [in] str list, e.g. "1,3-5"
+ * @param [out] tab table of numbers
+ * @param [in] max size of \a tab
+ *
+ * @return Number of elements in \a tab or -1 on error
+ */
+int monitor_control_parse_list(const char *str, uint64_t *tab,
+                               const unsigned max);
+
+/**
+ * @brief Closes control socket and all client connections
+ */
+void monitor_control_stop(void);
+
+#endif /* __MONITOR_CONTROL_H__ */
@@ -34,6 +34,7 @@
 
 #include "common.h"
 #include "monitor.h"
+#include "monitor_stats.h"
 #include "monitor_utils.h"
 
 #include <string.h>
@@ -43,6 +44,7 @@ monitor_csv_begin(FILE *fp)
 {
         enum pqos_mon_event events = monitor_get_events();
         enum monitor_llc_format format = monitor_get_llc_format();
+        unsigned i;
 
         ASSERT(fp != NULL);
 
@@ -88,6 +90,13 @@ monitor_csv_begin(FILE *fp)
         if (events & PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE)
                 fprintf(fp, ",%11s", "LLC References Write");
 
+        for (i = 0; i < monitor_stats_num_columns(); i++) {
+                const struct monitor_stats_column *column =
+                    monitor_stats_get_column(i);
+
+                fprintf(fp, ",%s%s", column->name, column->unit);
+        }
+
         fputs("\n", fp);
 }
 
@@ -197,7 +206,7 @@ monitor_csv_row(FILE *fp,
         }
 
         if (monitor_core_mode() || monitor_uncore_mode())
-                fprintf(fp, "%s,\"%s\"%s\n", timestamp,
+                fprintf(fp, "%s,\"%s\"%s", timestamp,
                         (char *)mon_data->context, data);
         else if (monitor_process_mode()) {
                 memset(core_list, 0, sizeof(core_list));
@@ -207,9 +216,21 @@ monitor_csv_row(FILE *fp,
                         strncpy(core_list, "err", sizeof(core_list) - 1);
                 }
 
-                fprintf(fp, "%s,\"%s\",\"%s\"%s\n", timestamp,
+                fprintf(fp, "%s,\"%s\",\"%s\"%s", timestamp,
                         (char *)mon_data->context, core_list, data);
         }
+
+        for (i = 0; i < monitor_stats_num_columns(); i++) {
+                const struct monitor_stats_column *column =
+                    monitor_stats_get_column(i);
+                double value;
+
+                if (monitor_get_stat(mon_data, i, &value) == 0)
+                        fprintf(fp, ",%.*f", column->decimals, value);
+                else
+                        fputs(",", fp);
+        }
+        fputs("\n", fp);
 }
 
 void
@@ -0,0 +1,646 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor_export.h"
+
+#include "common.h"
+#include "monitor.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define EXPORT_HOST_DEFAULT "127.0.0.1"
+#define EXPORT_UNIX_PREFIX  "unix:"
+#define EXPORT_BACKLOG      16
+#define EXPORT_TIMEOUT_SEC  1
+
+/**
+ * Source of the metric value
+ */
+enum export_src {
+        EXPORT_SRC_LLC,
+        EXPORT_SRC_MBL,
+        EXPORT_SRC_MBT,
+        EXPORT_SRC_MBR,
+        EXPORT_SRC_IPC,
+        EXPORT_SRC_COUNTER, /**< cumulative event counter */
+};
+
+static const struct {
+        enum pqos_mon_event event;
+        enum export_src src;
+        const char *name;
+        const char *type;
+        const char *help;
+} export_metrics[] = {
+    {PQOS_MON_EVENT_L3_OCCUP, EXPORT_SRC_LLC, "pqos_llc_occupancy_bytes",
+     "gauge", "LLC occupancy"},
+    {PQOS_MON_EVENT_LMEM_BW, EXPORT_SRC_MBL,
+     "pqos_mbm_local_bytes_per_second", "gauge", "Local memory bandwidth"},
+    {PQOS_MON_EVENT_TMEM_BW, EXPORT_SRC_MBT,
+     "pqos_mbm_total_bytes_per_second", "gauge", "Total memory bandwidth"},
+    {PQOS_MON_EVENT_RMEM_BW, EXPORT_SRC_MBR,
+     "pqos_mbm_remote_bytes_per_second", "gauge", "Remote memory bandwidth"},
+    {PQOS_PERF_EVENT_IPC, EXPORT_SRC_IPC, "pqos_ipc", "gauge",
+     "Instructions per cycle"},
+    {PQOS_PERF_EVENT_LLC_MISS, EXPORT_SRC_COUNTER, "pqos_llc_misses_total",
+     "counter", "LLC misses"},
+    {PQOS_PERF_EVENT_LLC_REF, EXPORT_SRC_COUNTER, "pqos_llc_references_total",
+     "counter", "LLC references"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_READ, EXPORT_SRC_COUNTER,
+     "pqos_llc_misses_pcie_read_total", "counter", "LLC misses by PCIe reads"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE, EXPORT_SRC_COUNTER,
+     "pqos_llc_misses_pcie_write_total", "counter",
+     "LLC misses by PCIe writes"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_READ, EXPORT_SRC_COUNTER,
+     "pqos_llc_references_pcie_read_total", "counter",
+     "LLC references by PCIe reads"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE, EXPORT_SRC_COUNTER,
+     "pqos_llc_references_pcie_write_total", "counter",
+     "LLC references by PCIe writes"},
+};
+
+/**
+ * Growable text buffer
+ */
+struct export_buf {
+        char *data;
+        size_t len;
+        size_t size;
+};
+
+static struct {
+        int fd;                /**< listening socket */
+        int stop_fd[2];        /**< pipe to wake up the server on stop */
+        char *unix_path;       /**< unix socket path to remove on stop */
+        pthread_t thread;      /**< server thread */
+        pthread_mutex_t lock;  /**< protects metrics text */
+        struct export_buf txt; /**< rendered metrics served to clients */
+        struct export_buf tmp; /**< metrics being rendered */
+        struct export_buf lbl; /**< labels of the groups */
+        size_t *lbl_off;       /**< offsets of group labels in lbl */
+        struct pqos_mon_values values;
+        unsigned num_values; /**< size of value tables */
+        int running;
+} export = {.fd = -1, .stop_fd = {-1, -1}};
+
+/**
+ * @brief Appends formatted text to the buffer
+ *
+ * @param buf text buffer
+ * @param fmt format string
+ */
+static void export_printf(struct export_buf *buf, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void
+export_printf(struct export_buf *buf, const char *fmt, ...)
+{
+        va_list ap;
+        int len;
+
+        for (;;) {
+                size_t avail = buf->size - buf->len;
+
+                va_start(ap, fmt);
+                len = vsnprintf(buf->data + buf->len, avail, fmt, ap);
+                va_end(ap);
+
+                if (len < 0)
+                        return;
+                if ((size_t)len < avail) {
+                        buf->len += len;
+                        return;
+                } else {
+                        size_t size = buf->size * 2 + len + 1;
+                        char *data = realloc(buf->data, size);
+
+                        if (data == NULL)
+                                return;
+                        buf->data = data;
+                        buf->size = size;
+                }
+        }
+}
+
+/**
+ * @brief Appends label value with Prometheus escaping
+ *
+ * @param buf text buffer
+ * @param str label value
+ */
+static void
+export_label_value(struct export_buf *buf, const char *str)
+{
+        export_printf(buf, "\"");
+        for (; *str != '\0'; str++) {
+                if (*str == '\\' || *str == '"')
+                        export_printf(buf, "\\%c", *str);
+                else if (*str == '\n')
+                        export_printf(buf, "\\n");
+                else
+                        export_printf(buf, "%c", *str);
+        }
+        export_printf(buf, "\"");
+}
+
+/**
+ * @brief Appends labels of the monitoring group
+ *
+ * @param buf text buffer
+ * @param group monitoring group
+ */
+static void
+export_labels(struct export_buf *buf, const struct pqos_mon_data *group)
+{
+        const char *name = "core";
+        unsigned class_id;
+
+        if (monitor_process_mode())
+                name = "pid";
+        else if (monitor_uncore_mode())
+                name = "socket";
+
+        export_printf(buf, "{%s=", name);
+        export_label_value(buf, (const char *)group->context);
+
+        if (monitor_core_mode() && group->num_cores > 0 &&
+            pqos_alloc_assoc_get(group->cores[0], &class_id) ==
+                PQOS_RETVAL_OK)
+                export_printf(buf, ",cos=\"%u\"", class_id);
+
+        export_printf(buf, "}");
+}
+
+/**
+ * @brief Makes sure value tables can hold \a num groups
+ *
+ * @param num number of groups
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 memory allocation error
+ */
+static int
+export_values_alloc(const unsigned num)
+{
+        struct pqos_mon_values *v = &export.values;
+
+        if (export.num_values >= num)
+                return 0;
+
+        free(v->llc);
+        free(v->mbm_local_rate);
+        free(v->mbm_total_rate);
+        free(v->mbm_remote_rate);
+        free(v->ipc);
+        free(export.lbl_off);
+        memset(v, 0, sizeof(*v));
+        export.lbl_off = NULL;
+        export.num_values = 0;
+
+        v->llc = calloc(num, sizeof(v->llc[0]));
+        v->mbm_local_rate = calloc(num, sizeof(v->mbm_local_rate[0]));
+        v->mbm_total_rate = calloc(num, sizeof(v->mbm_total_rate[0]));
+        v->mbm_remote_rate = calloc(num, sizeof(v->mbm_remote_rate[0]));
+        v->ipc = calloc(num, sizeof(v->ipc[0]));
+        export.lbl_off = calloc(num + 1, sizeof(export.lbl_off[0]));
+        if (v->llc == NULL || v->mbm_local_rate == NULL ||
+            v->mbm_total_rate == NULL || v->mbm_remote_rate == NULL ||
+            v->ipc == NULL || export.lbl_off == NULL)
+                return -1;
+
+        export.num_values = num;
+
+        return 0;
+}
+
+void
+monitor_export_update(struct pqos_mon_data *const *groups,
+                      const unsigned num,
+                      const uint64_t realtime)
+{
+        const enum pqos_mon_event events = monitor_get_events();
+        struct export_buf *buf = &export.tmp;
+        struct export_buf swap;
+        unsigned i, j;
+
+        if (!export.running || num == 0)
+                return;
+
+        if (export_values_alloc(num) != 0 ||
+            pqos_mon_get_values(groups, num, &export.values) != PQOS_RETVAL_OK)
+                return;
+
+        /* class of service lookup is done once per group */
+        export.lbl.len = 0;
+        for (j = 0; j < num; j++) {
+                export.lbl_off[j] = export.lbl.len;
+                export_labels(&export.lbl, groups[j]);
+        }
+        export.lbl_off[num] = export.lbl.len;
+
+        buf->len = 0;
+        export_printf(buf,
+                      "# HELP pqos_last_poll_timestamp_seconds "
+                      "Time of the last poll\n"
+                      "# TYPE pqos_last_poll_timestamp_seconds gauge\n"
+                      "pqos_last_poll_timestamp_seconds %.3f\n",
+                      (double)realtime / 1000000000.0);
+
+        for (i = 0; i < DIM(export_metrics); i++) {
+                if (!(events & export_metrics[i].event))
+                        continue;
+
+                export_printf(buf, "# HELP %s %s\n# TYPE %s %s\n",
+                              export_metrics[i].name, export_metrics[i].help,
+                              export_metrics[i].name, export_metrics[i].type);
+
+                for (j = 0; j < num; j++) {
+                        const struct pqos_mon_values *v = &export.values;
+                        uint64_t counter = 0;
+
+                        if (!(groups[j]->event & export_metrics[i].event))
+                                continue;
+
+                        export_printf(
+                            buf, "%s%.*s", export_metrics[i].name,
+                            (int)(export.lbl_off[j + 1] - export.lbl_off[j]),
+                            export.lbl.data + export.lbl_off[j]);
+
+                        switch (export_metrics[i].src) {
+                        case EXPORT_SRC_LLC:
+                                export_printf(buf, " %llu\n",
+                                              (unsigned long long)v->llc[j]);
+                                break;
+                        case EXPORT_SRC_MBL:
+                                export_printf(buf, " %.0f\n",
+                                              v->mbm_local_rate[j]);
+                                break;
+                        case EXPORT_SRC_MBT:
+                                export_printf(buf, " %.0f\n",
+                                              v->mbm_total_rate[j]);
+                                break;
+                        case EXPORT_SRC_MBR:
+                                export_printf(buf, " %.0f\n",
+                                              v->mbm_remote_rate[j]);
+                                break;
+                        case EXPORT_SRC_IPC:
+                                export_printf(buf, " %.3f\n", v->ipc[j]);
+                                break;
+                        case EXPORT_SRC_COUNTER:
+                                (void)pqos_mon_get_value(
+                                    groups[j], export_metrics[i].event,
+                                    &counter, NULL);
+                                export_printf(buf, " %llu\n",
+                                              (unsigned long long)counter);
+                                break;
+                        }
+                }
+        }
+
+        pthread_mutex_lock(&export.lock);
+        swap = export.txt;
+        export.txt = export.tmp;
+        export.tmp = swap;
+        pthread_mutex_unlock(&export.lock);
+}
+
+/**
+ * @brief Sends whole buffer to the client
+ *
+ * @param fd client socket
+ * @param data data to send
+ * @param len length of \a data
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+static int
+export_send(const int fd, const char *data, size_t len)
+{
+        while (len > 0) {
+                ssize_t ret = send(fd, data, len, MSG_NOSIGNAL);
+
+                if (ret < 0 && errno == EINTR)
+                        continue;
+                if (ret <= 0)
+                        return -1;
+                data += ret;
+                len -= ret;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Handles single HTTP request
+ *
+ * @param fd client socket
+ * @param body scratch buffer for the response body
+ */
+static void
+export_client(const int fd, struct export_buf *body)
+{
+        const struct timeval tv = {.tv_sec = EXPORT_TIMEOUT_SEC};
+        char req[1024];
+        char hdr[256];
+        size_t len = 0;
+        int hdr_len;
+        int found;
+
+        (void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        /* read request line and headers */
+        while (len < sizeof(req) - 1) {
+                ssize_t ret = recv(fd, req + len, sizeof(req) - 1 - len, 0);
+
+                if (ret < 0 && errno == EINTR)
+                        continue;
+                if (ret <= 0)
+                        return;
+                len += ret;
+                req[len] = '\0';
+                if (strstr(req, "\r\n\r\n") != NULL ||
+                    strstr(req, "\n\n") != NULL)
+                        break;
+        }
+        req[len] = '\0';
+
+        found = strncmp(req, "GET /metrics ", 13) == 0 ||
+                strncmp(req, "GET / ", 6) == 0;
+        if (!found) {
+                static const char not_found[] =
+                    "HTTP/1.0 404 Not Found\r\n"
+                    "Content-Length: 0\r\nConnection: close\r\n\r\n";
+
+                (void)export_send(fd, not_found, sizeof(not_found) - 1);
+                return;
+        }
+
+        /* copy so the lock is not held while sending */
+        body->len = 0;
+        pthread_mutex_lock(&export.lock);
+        if (export.txt.len > 0)
+                export_printf(body, "%.*s", (int)export.txt.len,
+                              export.txt.data);
+        pthread_mutex_unlock(&export.lock);
+
+        hdr_len = snprintf(hdr, sizeof(hdr),
+                           "HTTP/1.0 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %zu\r\n"
+                           "Connection: close\r\n\r\n",
+                           body->len);
+
+        if (export_send(fd, hdr, hdr_len) == 0)
+                (void)export_send(fd, body->data, body->len);
+}
+
+/**
+ * @brief Server thread, accepts connections until stopped
+ *
+ * @param arg unused
+ *
+ * @return NULL
+ */
+static void *
+export_server(void *arg)
+{
+        struct export_buf body = {NULL, 0, 0};
+
+        UNUSED_ARG(arg);
+
+        for (;;) {
+                struct pollfd fds[2] = {
+                    {.fd = export.fd, .events = POLLIN},
+                    {.fd = export.stop_fd[0], .events = POLLIN},
+                };
+                int fd;
+
+                if (poll(fds, DIM(fds), -1) < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        break;
+                }
+                if (fds[1].revents != 0)
+                        break;
+                if (!(fds[0].revents & POLLIN))
+                        continue;
+
+                fd = accept(export.fd, NULL, NULL);
+                if (fd < 0)
+                        continue;
+                export_client(fd, &body);
+                close(fd);
+        }
+
+        free(body.data);
+
+        return NULL;
+}
+
+/**
+ * @brief Opens listening socket
+ *
+ * @param addr listen address
+ *
+ * @return socket or -1 on error
+ */
+static int
+export_listen(const char *addr)
+{
+        const size_t prefix = strlen(EXPORT_UNIX_PREFIX);
+        struct addrinfo hints, *res, *ai;
+        const char *host = EXPORT_HOST_DEFAULT;
+        const char *port = addr;
+        char *copy = NULL;
+        const int on = 1;
+        int fd = -1;
+
+        if (strncmp(addr, EXPORT_UNIX_PREFIX, prefix) == 0) {
+                struct sockaddr_un sun;
+                struct stat st;
+                const char *path = addr + prefix;
+
+                if (strlen(path) == 0 || strlen(path) >= sizeof(sun.sun_path))
+                        return -1;
+
+                memset(&sun, 0, sizeof(sun));
+                sun.sun_family = AF_UNIX;
+                strcpy(sun.sun_path, path);
+
+                /* remove stale socket of previous run */
+                if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+                        (void)unlink(path);
+
+                fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd < 0)
+                        return -1;
+                if (bind(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0 ||
+                    listen(fd, EXPORT_BACKLOG) != 0) {
+                        close(fd);
+                        return -1;
+                }
+                export.unix_path = strdup(path);
+
+                return fd;
+        }
+
+        copy = strdup(addr);
+        if (copy == NULL)
+                return -1;
+        if (strrchr(copy, ':') != NULL) {
+                char *sep = strrchr(copy, ':');
+
+                *sep = '\0';
+                host = copy;
+                port = sep + 1;
+                /* strip brackets of IPv6 address */
+                if (host[0] == '[' && sep > copy && sep[-1] == ']') {
+                        sep[-1] = '\0';
+                        host++;
+                }
+        }
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        if (getaddrinfo(host, port, &hints, &res) != 0) {
+                free(copy);
+                return -1;
+        }
+
+        for (ai = res; ai != NULL; ai = ai->ai_next) {
+                fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                            ai->ai_protocol);
+                if (fd < 0)
+                        continue;
+                (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on,
+                                 sizeof(on));
+                if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+                    listen(fd, EXPORT_BACKLOG) == 0)
+                        break;
+                close(fd);
+                fd = -1;
+        }
+
+        freeaddrinfo(res);
+        free(copy);
+
+        return fd;
+}
+
+int
+monitor_export_start(const char *addr)
+{
+        if (addr == NULL || export.running)
+                return -1;
+
+        export.fd = export_listen(addr);
+        if (export.fd < 0)
+                return -1;
+
+        if (pipe(export.stop_fd) != 0) {
+                monitor_export_stop();
+                return -1;
+        }
+
+        pthread_mutex_init(&export.lock, NULL);
+        if (pthread_create(&export.thread, NULL, export_server, NULL) != 0) {
+                pthread_mutex_destroy(&export.lock);
+                monitor_export_stop();
+                return -1;
+        }
+        export.running = 1;
+
+        return 0;
+}
+
+void
+monitor_export_stop(void)
+{
+        if (export.running) {
+                if (write(export.stop_fd[1], "", 1) != 1)
+                        (void)shutdown(export.fd, SHUT_RDWR);
+                pthread_join(export.thread, NULL);
+                pthread_mutex_destroy(&export.lock);
+                export.running = 0;
+        }
+
+        if (export.fd >= 0)
+                close(export.fd);
+        if (export.stop_fd[0] >= 0)
+                close(export.stop_fd[0]);
+        if (export.stop_fd[1] >= 0)
+                close(export.stop_fd[1]);
+        export.fd = -1;
+        export.stop_fd[0] = -1;
+        export.stop_fd[1] = -1;
+
+        if (export.unix_path != NULL) {
+                (void)unlink(export.unix_path);
+                free(export.unix_path);
+                export.unix_path = NULL;
+        }
+
+        free(export.txt.data);
+        free(export.tmp.data);
+        free(export.lbl.data);
+        free(export.lbl_off);
+        memset(&export.txt, 0, sizeof(export.txt));
+        memset(&export.tmp, 0, sizeof(export.tmp));
+        memset(&export.lbl, 0, sizeof(export.lbl));
+        export.lbl_off = NULL;
+
+        free(export.values.llc);
+        free(export.values.mbm_local_rate);
+        free(export.values.mbm_total_rate);
+        free(export.values.mbm_remote_rate);
+        free(export.values.ipc);
+        memset(&export.values, 0, sizeof(export.values));
+        export.num_values = 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Metrics exporter
+ *
+ * Serves the most recent monitoring data in Prometheus text exposition
+ * format over HTTP. Metrics are rendered once per monitoring interval by
+ * the sampler and cached, so scrapes never trigger hardware access.
+ */
+
+#ifndef __MONITOR_EXPORT_H__
+#define __MONITOR_EXPORT_H__
+
+#include "pqos.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Starts metrics server
+ *
+ * @param [in] addr listen address, "[HOST:]PORT" or "unix:PATH".
+ *             HOST defaults to 127.0.0.1.
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int monitor_export_start(const char *addr);
+
+/**
+ * @brief Renders metrics of polled monitoring groups
+ *
+ * @param [in] groups monitoring groups
+ * @param [in] num number of monitoring groups
+ * @param [in] realtime CLOCK_REALTIME time of the poll [ns]
+ */
+void monitor_export_update(struct pqos_mon_data *const *groups,
+                           const unsigned num,
+                           const uint64_t realtime);
+
+/**
+ * @brief Stops metrics server and frees its resources
+ */
+void monitor_export_stop(void);
+
+#endif /* __MONITOR_EXPORT_H__ */
@@ -0,0 +1,353 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Multi-rate polling schedule of pqos monitoring
+ *
+ * Each class of events can be polled at its own interval, the scheduler
+ * ticks at the greatest common divisor of all configured intervals.
+ * Groups with memory bandwidth below a threshold are considered cold and
+ * are polled at the cold interval only.
+ */
+
+#include "monitor_rates.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * Cold group threshold used when cold-mbps is not given [MB/s]
+ */
+#define RATES_COLD_MBPS_DEFAULT 1
+
+/**
+ * Event classes with configurable polling interval
+ */
+static struct {
+        const char *name;           /**< class name in the specification */
+        enum pqos_mon_event events; /**< events of the class */
+        unsigned interval;          /**< polling interval [ms], 0 if none */
+        uint64_t next;              /**< time of the next poll [ms] */
+} rates_class[] = {
+    {"llc", PQOS_MON_EVENT_L3_OCCUP, 0, 0},
+    {"mbm",
+     (enum pqos_mon_event)(PQOS_MON_EVENT_LMEM_BW | PQOS_MON_EVENT_TMEM_BW |
+                           PQOS_MON_EVENT_RMEM_BW),
+     0, 0},
+    {"ipc", PQOS_PERF_EVENT_IPC, 0, 0},
+    {"llc_miss", PQOS_PERF_EVENT_LLC_MISS, 0, 0},
+    {"llc_ref", PQOS_PERF_EVENT_LLC_REF, 0, 0},
+    {"pcie",
+     (enum pqos_mon_event)(PQOS_PERF_EVENT_LLC_MISS_PCIE_READ |
+                           PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE |
+                           PQOS_PERF_EVENT_LLC_REF_PCIE_READ |
+                           PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE),
+     0, 0},
+};
+
+#define RATES_NUM_CLASSES (sizeof(rates_class) / sizeof(rates_class[0]))
+
+/**
+ * Scheduler state
+ */
+static struct {
+        unsigned interval;    /**< output interval [ms] */
+        unsigned tick;        /**< timer period [ms] */
+        unsigned cold;        /**< cold group polling interval [ms] */
+        double cold_mbps;     /**< cold group bandwidth threshold [MB/s] */
+        uint64_t next_output; /**< time of the next output [ms] */
+        uint64_t next_cold;   /**< time of the next cold group poll [ms] */
+        int restart;          /**< schedule restarts at the next tick */
+} rates;
+
+/**
+ * @brief Parses interval value
+ *
+ * Interval is given in 100ms units unless "ms" or "s" suffix is used.
+ *
+ * @param [in] str string to parse
+ * @param [out] val parsed interval [ms]
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+rates_parse_interval(const char *str, unsigned *val)
+{
+        unsigned long long interval;
+        char *endptr = NULL;
+
+        interval = strtoull(str, &endptr, 10);
+        if (endptr == str || str[0] == '-')
+                goto rates_parse_interval_error;
+
+        if (strcasecmp(endptr, "ms") == 0)
+                ;
+        else if (strcasecmp(endptr, "s") == 0)
+                interval *= 1000;
+        else if (*endptr == '\0')
+                interval *= 100;
+        else
+                goto rates_parse_interval_error;
+
+        if (interval < 1 || interval > INT_MAX)
+                goto rates_parse_interval_error;
+
+        *val = (unsigned)interval;
+        return 0;
+
+rates_parse_interval_error:
+        printf("Invalid polling interval '%s'!\n", str);
+        return -1;
+}
+
+/**
+ * @brief Computes greatest common divisor
+ */
+static unsigned
+rates_gcd(unsigned a, unsigned b)
+{
+        while (b != 0) {
+                const unsigned t = a % b;
+
+                a = b;
+                b = t;
+        }
+
+        return a;
+}
+
+/**
+ * @brief Computes timer period from the configured intervals
+ */
+static void
+rates_update_tick(void)
+{
+        unsigned i;
+
+        rates.tick = rates.interval;
+        for (i = 0; i < RATES_NUM_CLASSES; i++)
+                if (rates_class[i].interval > 0)
+                        rates.tick =
+                            rates_gcd(rates.tick, rates_class[i].interval);
+        if (rates.cold > 0)
+                rates.tick = rates_gcd(rates.tick, rates.cold);
+}
+
+/**
+ * @brief Checks if scheduled work is due and schedules the next one
+ *
+ * @param [in] runtime current time [ms]
+ * @param [in] interval work interval [ms]
+ * @param [in,out] next time the work is due [ms]
+ *
+ * @return 1 if the work is due, 0 otherwise
+ */
+static int
+rates_check(const uint64_t runtime, const unsigned interval, uint64_t *next)
+{
+        if (runtime < *next)
+                return 0;
+
+        *next += interval;
+        /* skip polls missed due to timer overrun */
+        if (*next <= runtime)
+                *next = runtime + interval;
+
+        return 1;
+}
+
+int
+monitor_rates_start(const char *spec, const unsigned interval)
+{
+        char *str, *tok, *saveptr = NULL;
+        int cold_mbps = 0;
+        unsigned i;
+        int ret = -1;
+
+        memset(&rates, 0, sizeof(rates));
+        for (i = 0; i < RATES_NUM_CLASSES; i++) {
+                rates_class[i].interval = 0;
+                rates_class[i].next = 0;
+        }
+        rates.interval = interval;
+        rates.cold_mbps = RATES_COLD_MBPS_DEFAULT;
+
+        if (spec == NULL) {
+                rates_update_tick();
+                return 0;
+        }
+
+        str = strdup(spec);
+        if (str == NULL)
+                return -1;
+
+        for (tok = strtok_r(str, ",", &saveptr); tok != NULL;
+             tok = strtok_r(NULL, ",", &saveptr)) {
+                char *val = strchr(tok, '=');
+
+                if (val == NULL) {
+                        printf("Invalid polling rate '%s'!\n", tok);
+                        goto exit;
+                }
+                *val++ = '\0';
+
+                if (strcasecmp(tok, "cold") == 0) {
+                        if (rates_parse_interval(val, &rates.cold) != 0)
+                                goto exit;
+                        continue;
+                }
+                if (strcasecmp(tok, "cold-mbps") == 0) {
+                        char *endptr = NULL;
+
+                        rates.cold_mbps = strtod(val, &endptr);
+                        if (endptr == val || *endptr != '\0' ||
+                            !(rates.cold_mbps > 0)) {
+                                printf("Invalid cold group threshold '%s'!\n",
+                                       val);
+                                goto exit;
+                        }
+                        cold_mbps = 1;
+                        continue;
+                }
+
+                for (i = 0; i < RATES_NUM_CLASSES; i++)
+                        if (strcasecmp(tok, rates_class[i].name) == 0)
+                                break;
+                if (i == RATES_NUM_CLASSES) {
+                        printf("Invalid event class '%s'!\n", tok);
+                        goto exit;
+                }
+                if (rates_parse_interval(val, &rates_class[i].interval) != 0)
+                        goto exit;
+        }
+
+        if (cold_mbps && rates.cold == 0) {
+                printf("Cold group threshold requires cold interval!\n");
+                goto exit;
+        }
+
+        rates_update_tick();
+        ret = 0;
+
+exit:
+        free(str);
+        return ret;
+}
+
+void
+monitor_rates_set_interval(const unsigned interval)
+{
+        rates.interval = interval;
+        rates.restart = 1;
+        rates_update_tick();
+}
+
+unsigned
+monitor_rates_tick(void)
+{
+        return rates.tick;
+}
+
+void
+monitor_rates_due(const uint64_t runtime, struct monitor_rates_due *due)
+{
+        unsigned i;
+
+        if (rates.restart) {
+                for (i = 0; i < RATES_NUM_CLASSES; i++)
+                        rates_class[i].next = runtime;
+                rates.next_output = runtime;
+                rates.next_cold = runtime;
+                rates.restart = 0;
+        }
+
+        due->events = (enum pqos_mon_event)0;
+        for (i = 0; i < RATES_NUM_CLASSES; i++) {
+                const unsigned interval = rates_class[i].interval > 0
+                                              ? rates_class[i].interval
+                                              : rates.interval;
+
+                if (rates_check(runtime, interval, &rates_class[i].next))
+                        due->events |= rates_class[i].events;
+        }
+
+        due->output = rates_check(runtime, rates.interval, &rates.next_output);
+        due->cold = rates.cold > 0 &&
+                    rates_check(runtime, rates.cold, &rates.next_cold);
+}
+
+int
+monitor_rates_cold(const struct pqos_mon_data *group)
+{
+        enum pqos_mon_event event;
+        uint64_t delta = 0;
+        uint64_t interval = 0;
+
+        if (rates.cold == 0)
+                return 0;
+
+        if (group->event & PQOS_MON_EVENT_TMEM_BW)
+                event = PQOS_MON_EVENT_TMEM_BW;
+        else if (group->event & PQOS_MON_EVENT_LMEM_BW)
+                event = PQOS_MON_EVENT_LMEM_BW;
+        else
+                return 0;
+
+        if (pqos_mon_get_poll_time(group, event, NULL, &interval) !=
+                PQOS_RETVAL_OK ||
+            interval == 0)
+                return 0;
+        if (pqos_mon_get_value(group, event, NULL, &delta) != PQOS_RETVAL_OK)
+                return 0;
+
+        /* bytes per ns to MB/s */
+        return (double)delta * 1000000000.0 / (double)interval /
+                   (1024.0 * 1024.0) <
+               rates.cold_mbps;
+}
+
+int
+monitor_rates_enabled(void)
+{
+        unsigned i;
+
+        if (rates.cold > 0)
+                return 1;
+        for (i = 0; i < RATES_NUM_CLASSES; i++)
+                if (rates_class[i].interval > 0)
+                        return 1;
+
+        return 0;
+}
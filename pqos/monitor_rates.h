@@ -0,0 +1,113 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Multi-rate polling schedule of pqos monitoring
+ */
+
+#ifndef __MONITOR_RATES_H__
+#define __MONITOR_RATES_H__
+
+#include "pqos.h"
+
+#include <stdint.h>
+
+/**
+ * Work due at a scheduler tick
+ */
+struct monitor_rates_due {
+        enum pqos_mon_event events; /**< events to poll in active groups */
+        int cold;                   /**< cold groups are to be polled */
+        int output;                 /**< sample is to be output */
+};
+
+/**
+ * @brief Parses polling rates specification and sets up the schedule
+ *
+ * @param [in] spec comma separated list of CLASS=INTERVAL settings,
+ *             cold=INTERVAL and cold-mbps=N, NULL to poll all events
+ *             at the output interval
+ * @param [in] interval output interval [ms]
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int monitor_rates_start(const char *spec, const unsigned interval);
+
+/**
+ * @brief Changes output interval
+ *
+ * Events without own polling rate follow the output interval.
+ * Schedule restarts at the next call to \a monitor_rates_due.
+ *
+ * @param [in] interval output interval [ms]
+ */
+void monitor_rates_set_interval(const unsigned interval);
+
+/**
+ * @brief Gets scheduler tick
+ *
+ * @return period of the sampling timer [ms]
+ */
+unsigned monitor_rates_tick(void);
+
+/**
+ * @brief Gets work due at given time
+ *
+ * Ticks missed due to timer overruns are merged into one.
+ *
+ * @param [in] runtime time since start of the monitoring [ms]
+ * @param [out] due work to be done
+ */
+void monitor_rates_due(const uint64_t runtime, struct monitor_rates_due *due);
+
+/**
+ * @brief Checks if group is cold after it has been polled
+ *
+ * Cold groups have memory bandwidth below the cold-mbps threshold and
+ * are polled for all events at the cold interval only.
+ *
+ * @param [in] group polled monitoring group
+ *
+ * @return 1 if the group is cold, 0 otherwise
+ */
+int monitor_rates_cold(const struct pqos_mon_data *group);
+
+/**
+ * @brief Checks if any event is polled at other than the output interval
+ *
+ * @return 1 if multi-rate polling is enabled, 0 otherwise
+ */
+int monitor_rates_enabled(void);
+
+#endif /* __MONITOR_RATES_H__ */
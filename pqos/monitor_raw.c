@@ -0,0 +1,319 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor_raw.h"
+
+#include "common.h"
+#include "monitor.h"
+#include "monitor_bin.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Events of the row fields in MONITOR_RAW_FIELD_* order
+ */
+static const enum pqos_mon_event raw_field_event[MONITOR_RAW_FIELD_NUM] = {
+    PQOS_MON_EVENT_L3_OCCUP,
+    PQOS_MON_EVENT_LMEM_BW,
+    PQOS_MON_EVENT_TMEM_BW,
+    PQOS_MON_EVENT_RMEM_BW,
+    PQOS_PERF_EVENT_IPC,
+    PQOS_PERF_EVENT_IPC,
+    PQOS_PERF_EVENT_LLC_MISS,
+    PQOS_PERF_EVENT_LLC_REF,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE,
+};
+
+/**
+ * Per group recorder state
+ */
+struct raw_group {
+        char *desc;
+        unsigned class_id; /**< last recorded class of service */
+        int class_valid;
+};
+
+static struct {
+        enum pqos_mon_event events; /**< selected events */
+        int core_mode;
+        uint64_t monotonic; /**< previous sample time [ns] */
+        uint64_t realtime;  /**< previous sample time [ns] */
+        struct raw_group *groups;
+        unsigned num_groups;
+        unsigned last; /**< index of the previously written group */
+} raw;
+
+/**
+ * @brief Writes topology of the system
+ *
+ * @param fp file descriptor
+ */
+static void
+raw_put_topology(FILE *fp)
+{
+        const struct pqos_cpuinfo *cpu = NULL;
+        unsigned i;
+
+        if (pqos_cap_get(NULL, &cpu) != PQOS_RETVAL_OK || cpu == NULL) {
+                monitor_bin_put_uint(fp, 0);
+                monitor_bin_put_uint(fp, 0);
+                return;
+        }
+
+        monitor_bin_put_uint(fp, cpu->l3.total_size);
+        monitor_bin_put_uint(fp, cpu->num_cores);
+        for (i = 0; i < cpu->num_cores; i++) {
+                monitor_bin_put_uint(fp, cpu->cores[i].lcore);
+                monitor_bin_put_uint(fp, cpu->cores[i].socket);
+                monitor_bin_put_uint(fp, cpu->cores[i].l3_id);
+        }
+}
+
+/**
+ * @brief Finds recorder state of the group, adding it when not seen before
+ *
+ * @param fp file descriptor
+ * @param mon_data monitoring group
+ *
+ * @return group index or -1 on error
+ */
+static int
+raw_group_get(FILE *fp, const struct pqos_mon_data *mon_data)
+{
+        const char *desc = (const char *)mon_data->context;
+        struct raw_group *group;
+        unsigned i;
+
+        /* rows are usually written in the same order in every sample */
+        i = raw.last + 1;
+        if (i < raw.num_groups && strcmp(raw.groups[i].desc, desc) == 0)
+                return i;
+
+        for (i = 0; i < raw.num_groups; i++)
+                if (strcmp(raw.groups[i].desc, desc) == 0)
+                        return i;
+
+        group = realloc(raw.groups, (raw.num_groups + 1) * sizeof(*group));
+        if (group == NULL)
+                return -1;
+        raw.groups = group;
+        group = &raw.groups[raw.num_groups];
+        memset(group, 0, sizeof(*group));
+        group->desc = strdup(desc);
+        if (group->desc == NULL)
+                return -1;
+
+        fputc(MONITOR_RAW_REC_GROUP, fp);
+        monitor_bin_put_uint(fp, raw.num_groups);
+        monitor_bin_put_uint(fp, mon_data->event & raw.events);
+        monitor_bin_put_str(fp, desc);
+        if (raw.core_mode) {
+                monitor_bin_put_uint(fp, mon_data->num_cores);
+                for (i = 0; i < mon_data->num_cores; i++)
+                        monitor_bin_put_uint(fp, mon_data->cores[i]);
+        } else if (mon_data->pids != NULL) {
+                monitor_bin_put_uint(fp, mon_data->num_pids);
+                for (i = 0; i < mon_data->num_pids; i++)
+                        monitor_bin_put_uint(fp, mon_data->pids[i]);
+        } else
+                monitor_bin_put_uint(fp, 0);
+
+        return raw.num_groups++;
+}
+
+/**
+ * @brief Records class of service of the core group when it changed
+ *
+ * @param fp file descriptor
+ * @param idx group index
+ * @param mon_data monitoring group
+ */
+static void
+raw_put_class(FILE *fp,
+              const unsigned idx,
+              const struct pqos_mon_data *mon_data)
+{
+        struct raw_group *group = &raw.groups[idx];
+        unsigned class_id;
+
+        if (!raw.core_mode || mon_data->num_cores == 0)
+                return;
+        if (pqos_alloc_assoc_get(mon_data->cores[0], &class_id) !=
+            PQOS_RETVAL_OK)
+                return;
+        if (group->class_valid && group->class_id == class_id)
+                return;
+
+        fputc(MONITOR_RAW_REC_CLASS, fp);
+        monitor_bin_put_uint(fp, idx);
+        monitor_bin_put_uint(fp, class_id);
+        group->class_id = class_id;
+        group->class_valid = 1;
+}
+
+/**
+ * @brief Reads raw counter of the row field
+ *
+ * @param mon_data monitoring group
+ * @param field row field
+ *
+ * @return counter value
+ */
+static uint64_t
+raw_get_field(const struct pqos_mon_data *mon_data,
+              const enum monitor_raw_field field)
+{
+        const struct pqos_event_values *values = &mon_data->values;
+        uint64_t delta = 0;
+
+        switch (field) {
+        case MONITOR_RAW_FIELD_LLC:
+                return values->llc;
+        case MONITOR_RAW_FIELD_MBL:
+                return values->mbm_local_delta;
+        case MONITOR_RAW_FIELD_MBT:
+                return values->mbm_total_delta;
+        case MONITOR_RAW_FIELD_MBR:
+                return values->mbm_remote_delta;
+        case MONITOR_RAW_FIELD_INSTRUCTIONS:
+                return values->ipc_retired_delta;
+        case MONITOR_RAW_FIELD_CYCLES:
+                return values->ipc_unhalted_delta;
+        case MONITOR_RAW_FIELD_LLC_MISS:
+                return values->llc_misses_delta;
+        default:
+                (void)monitor_get_value(mon_data, raw_field_event[field], NULL,
+                                        &delta);
+                return delta;
+        }
+}
+
+void
+monitor_raw_begin(FILE *fp)
+{
+        char magic[MONITOR_RAW_MAGIC_LEN] = MONITOR_RAW_MAGIC;
+        unsigned mode = 0;
+
+        ASSERT(fp != NULL);
+
+        memset(&raw, 0, sizeof(raw));
+        raw.events = monitor_get_events();
+
+        if (monitor_core_mode())
+                mode = MONITOR_BIN_MODE_CORE;
+        else if (monitor_process_mode())
+                mode = MONITOR_BIN_MODE_PID;
+        else if (monitor_uncore_mode())
+                mode = MONITOR_BIN_MODE_UNCORE;
+        raw.core_mode = (mode == MONITOR_BIN_MODE_CORE);
+
+        fwrite(magic, 1, sizeof(magic), fp);
+        monitor_bin_put_uint(fp, MONITOR_RAW_VERSION);
+        monitor_bin_put_uint(fp, mode);
+        monitor_bin_put_uint(fp, monitor_get_interval());
+        raw_put_topology(fp);
+}
+
+void
+monitor_raw_header(FILE *fp, const char *timestamp)
+{
+        uint64_t monotonic;
+        uint64_t realtime;
+
+        ASSERT(fp != NULL);
+        UNUSED_ARG(timestamp);
+
+        if (monitor_get_sample_time(&monotonic, &realtime) != 0)
+                return;
+
+        /* first sample is stored relative to zero */
+        fputc(MONITOR_RAW_REC_SAMPLE, fp);
+        monitor_bin_put_uint(fp, monotonic - raw.monotonic);
+        monitor_bin_put_int(fp, (int64_t)(realtime - raw.realtime));
+        raw.monotonic = monotonic;
+        raw.realtime = realtime;
+}
+
+void
+monitor_raw_row(FILE *fp,
+                const char *timestamp,
+                const struct pqos_mon_data *mon_data)
+{
+        enum pqos_mon_event events;
+        int idx;
+        unsigned i;
+
+        ASSERT(fp != NULL);
+        ASSERT(mon_data != NULL);
+        UNUSED_ARG(timestamp);
+
+        idx = raw_group_get(fp, mon_data);
+        if (idx < 0)
+                return;
+        raw.last = idx;
+        raw_put_class(fp, idx, mon_data);
+
+        events = mon_data->event & raw.events;
+
+        fputc(MONITOR_RAW_REC_ROW, fp);
+        monitor_bin_put_uint(fp, idx);
+        for (i = 0; i < MONITOR_RAW_FIELD_NUM; i++)
+                if (events & raw_field_event[i])
+                        monitor_bin_put_uint(fp, raw_get_field(mon_data, i));
+}
+
+void
+monitor_raw_footer(FILE *fp)
+{
+        UNUSED_ARG(fp);
+}
+
+void
+monitor_raw_end(FILE *fp)
+{
+        unsigned i;
+
+        ASSERT(fp != NULL);
+
+        fputc(MONITOR_RAW_REC_END, fp);
+        fflush(fp);
+
+        for (i = 0; i < raw.num_groups; i++)
+                free(raw.groups[i].desc);
+        free(raw.groups);
+        memset(&raw, 0, sizeof(raw));
+}
@@ -0,0 +1,138 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Raw monitoring recording
+ *
+ * Unlike other output formats, counters are recorded as polled, before
+ * any rate or unit conversion, so the session can be re-aggregated
+ * offline. Stream layout:
+ *  - MONITOR_RAW_MAGIC (8 bytes)
+ *  - format version
+ *  - monitoring mode (MONITOR_BIN_MODE_*)
+ *  - sampling interval in milliseconds
+ *  - total L3 cache size in bytes
+ *  - number of cores, followed by lcore, socket and L3 id of each core
+ *
+ * Header is followed by records, each starting with a single tag byte:
+ *  - MONITOR_RAW_REC_SAMPLE: CLOCK_MONOTONIC delta and zigzag encoded
+ *    CLOCK_REALTIME delta of the poll in nanoseconds
+ *  - MONITOR_RAW_REC_GROUP: group index, event mask, length prefixed
+ *    description, number of resources and their ids (cores or pids);
+ *    emitted before the first row of the group
+ *  - MONITOR_RAW_REC_CLASS: group index and class of service of its
+ *    first core; emitted in core mode whenever the association changes
+ *  - MONITOR_RAW_REC_ROW: group index followed by counters of the group
+ *    events in MONITOR_RAW_FIELD_* order: LLC occupancy in bytes and
+ *    counter increments since the previous poll for other events
+ *  - MONITOR_RAW_REC_END: end of stream
+ *
+ * All integers are LEB128 encoded.
+ */
+
+#ifndef __MONITOR_RAW_H__
+#define __MONITOR_RAW_H__
+
+#include "pqos.h"
+
+#include <stdio.h>
+
+#define MONITOR_RAW_MAGIC     "PQOSRAW"
+#define MONITOR_RAW_MAGIC_LEN 8
+#define MONITOR_RAW_VERSION   1
+
+#define MONITOR_RAW_REC_SAMPLE 'S'
+#define MONITOR_RAW_REC_GROUP  'G'
+#define MONITOR_RAW_REC_CLASS  'A'
+#define MONITOR_RAW_REC_ROW    'R'
+#define MONITOR_RAW_REC_END    'E'
+
+/**
+ * Row fields, stored when the event is set in the group event mask
+ */
+enum monitor_raw_field {
+        MONITOR_RAW_FIELD_LLC = 0,         /**< PQOS_MON_EVENT_L3_OCCUP */
+        MONITOR_RAW_FIELD_MBL,             /**< PQOS_MON_EVENT_LMEM_BW */
+        MONITOR_RAW_FIELD_MBT,             /**< PQOS_MON_EVENT_TMEM_BW */
+        MONITOR_RAW_FIELD_MBR,             /**< PQOS_MON_EVENT_RMEM_BW */
+        MONITOR_RAW_FIELD_INSTRUCTIONS,    /**< PQOS_PERF_EVENT_IPC */
+        MONITOR_RAW_FIELD_CYCLES,          /**< PQOS_PERF_EVENT_IPC */
+        MONITOR_RAW_FIELD_LLC_MISS,        /**< PQOS_PERF_EVENT_LLC_MISS */
+        MONITOR_RAW_FIELD_LLC_REF,         /**< PQOS_PERF_EVENT_LLC_REF */
+        MONITOR_RAW_FIELD_PCIE_MISS_READ,  /**< LLC_MISS_PCIE_READ */
+        MONITOR_RAW_FIELD_PCIE_MISS_WRITE, /**< LLC_MISS_PCIE_WRITE */
+        MONITOR_RAW_FIELD_PCIE_REF_READ,   /**< LLC_REF_PCIE_READ */
+        MONITOR_RAW_FIELD_PCIE_REF_WRITE,  /**< LLC_REF_PCIE_WRITE */
+        MONITOR_RAW_FIELD_NUM
+};
+
+/**
+ * @brief Start raw recording
+ *
+ * @param fp file descriptor
+ */
+void monitor_raw_begin(FILE *fp);
+
+/**
+ * @brief Write sample timestamps
+ *
+ * @param fp file descriptor
+ * @param [in] timestamp data timestamp
+ */
+void monitor_raw_header(FILE *fp, const char *timestamp);
+
+/**
+ * @brief Write raw counters of the monitoring group
+ *
+ * @param fp file descriptor
+ * @param [in] timestamp data timestamp
+ * @param [in] data monitoring data
+ */
+void monitor_raw_row(FILE *fp,
+                     const char *timestamp,
+                     const struct pqos_mon_data *data);
+
+/**
+ * @brief Finish raw sample
+ *
+ * @param fp file descriptor
+ */
+void monitor_raw_footer(FILE *fp);
+
+/**
+ * @brief Finalize raw recording
+ *
+ * @param fp file descriptor
+ */
+void monitor_raw_end(FILE *fp);
+
+#endif /* __MONITOR_RAW_H__ */
@@ -0,0 +1,647 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Flight recorder of pqos monitoring
+ *
+ * Recording costs one bulk value read of all groups per poll written
+ * straight into the memory mapped ring. Nothing is persisted until a
+ * trigger fires, captures are written out by a separate thread so the
+ * sampling period is not affected.
+ */
+
+#include "monitor_recorder.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECORDER_BEFORE_DEFAULT 10 /**< seconds recorded before trigger */
+#define RECORDER_AFTER_DEFAULT  5  /**< seconds recorded after trigger */
+#define RECORDER_REASON_LEN     128
+
+/**
+ * Per group value tables of a frame
+ */
+enum recorder_table {
+        RECORDER_TAB_LLC = 0,
+        RECORDER_TAB_MBL,
+        RECORDER_TAB_MBT,
+        RECORDER_TAB_MBR,
+        RECORDER_TAB_IPC,
+        RECORDER_TAB_MISSES,
+        RECORDER_TAB_NUM
+};
+
+/**
+ * Capture being written out
+ */
+struct recorder_capture {
+        char path[PATH_MAX];                /**< capture file path */
+        char reason[RECORDER_REASON_LEN];   /**< trigger description */
+        uint64_t trigger;                   /**< trigger time [ns] */
+        unsigned num_groups;                /**< number of groups */
+        unsigned num_frames;                /**< number of frames */
+        size_t frame_size;                  /**< size of a frame */
+        enum pqos_mon_event events;         /**< monitored events */
+        char **names;                       /**< group names */
+        unsigned char *frames;              /**< copy of captured frames */
+};
+
+/**
+ * Recorder state
+ */
+static struct {
+        char *path;                          /**< ring file path */
+        int fd;                              /**< ring file descriptor */
+        void *map;                           /**< mapped ring file */
+        size_t map_size;                     /**< size of the mapping */
+        struct monitor_recorder_header *hdr; /**< ring file header */
+        unsigned num_groups;                 /**< number of groups */
+        unsigned num_frames;                 /**< number of ring frames */
+        size_t frame_size;                   /**< size of a frame */
+        enum pqos_mon_event events;          /**< monitored events */
+        double before;                       /**< window before [s] */
+        double after;                        /**< window after [s] */
+        double ipc_below;                    /**< IPC trigger, 0 if off */
+        double mbm_above;      /**< bandwidth trigger [MB/s], 0 if off */
+        int ipc_low;           /**< IPC was below threshold */
+        int mbm_high;          /**< bandwidth was above threshold */
+        int fired;             /**< trigger fired since previous frame */
+        char reason[RECORDER_REASON_LEN]; /**< description of the trigger */
+        struct recorder_capture *capture; /**< capture in progress */
+        pthread_t writer;                 /**< capture writer thread */
+        int writer_running;               /**< writer thread was started */
+} rec = {.fd = -1};
+
+/**
+ * @brief Gets frame of given sequence number
+ */
+static unsigned char *
+recorder_frame(const uint64_t seq)
+{
+        return (unsigned char *)rec.map + sizeof(*rec.hdr) +
+               (seq % rec.num_frames) * rec.frame_size;
+}
+
+/**
+ * @brief Gets value table of a frame
+ *
+ * @param [in] frame frame data
+ * @param [in] num_groups number of groups
+ * @param [in] table table to get
+ *
+ * @return pointer to the table
+ */
+static void *
+recorder_table(unsigned char *frame,
+               const unsigned num_groups,
+               const enum recorder_table table)
+{
+        return frame + sizeof(struct monitor_recorder_frame) +
+               (size_t)table * num_groups * sizeof(uint64_t);
+}
+
+/**
+ * @brief Gets name of monitoring group
+ */
+static const char *
+recorder_name(const struct pqos_mon_data *group)
+{
+        return group->context != NULL ? (const char *)group->context : "";
+}
+
+/**
+ * @brief Parses time window value
+ *
+ * @param [in] str string to parse
+ * @param [out] val parsed value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+recorder_parse_value(const char *str, double *val)
+{
+        char *endptr = NULL;
+
+        *val = strtod(str, &endptr);
+        if (endptr == str || *endptr != '\0' || !(*val >= 0)) {
+                printf("Invalid flight recorder setting value '%s'!\n", str);
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Formats CLOCK_REALTIME time with milliseconds
+ */
+static void
+recorder_time(char *buf, const size_t size, const uint64_t realtime)
+{
+        const time_t sec = (time_t)(realtime / 1000000000llu);
+        struct tm tm;
+        size_t len;
+
+        if (localtime_r(&sec, &tm) == NULL) {
+                snprintf(buf, size, "error");
+                return;
+        }
+
+        len = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+        snprintf(buf + len, size - len, ".%03u",
+                 (unsigned)(realtime / 1000000llu % 1000));
+}
+
+/**
+ * @brief Frees capture
+ */
+static void
+recorder_capture_free(struct recorder_capture *cap)
+{
+        unsigned i;
+
+        if (cap == NULL)
+                return;
+
+        if (cap->names != NULL)
+                for (i = 0; i < cap->num_groups; i++)
+                        free(cap->names[i]);
+        free(cap->names);
+        free(cap->frames);
+        free(cap);
+}
+
+/**
+ * @brief Writes capture out to CSV file and frees it
+ *
+ * @param [in] arg capture to write
+ *
+ * @return NULL
+ */
+static void *
+recorder_write(void *arg)
+{
+        struct recorder_capture *cap = (struct recorder_capture *)arg;
+        const enum pqos_mon_event events = cap->events;
+        const unsigned n = cap->num_groups;
+        unsigned i, j;
+        FILE *fp;
+
+        fp = fopen(cap->path, "w");
+        if (fp == NULL) {
+                fprintf(stderr, "Failed to write flight recorder capture %s\n",
+                        cap->path);
+                recorder_capture_free(cap);
+                return NULL;
+        }
+
+        fprintf(fp, "# trigger: %s\n", cap->reason);
+        fprintf(fp, "Time,Offset[ms],Group");
+        if (events & PQOS_PERF_EVENT_IPC)
+                fprintf(fp, ",IPC");
+        if (events & PQOS_PERF_EVENT_LLC_MISS)
+                fprintf(fp, ",LLC Misses");
+        if (events & PQOS_MON_EVENT_L3_OCCUP)
+                fprintf(fp, ",LLC[KB]");
+        if (events & PQOS_MON_EVENT_LMEM_BW)
+                fprintf(fp, ",MBL[MB/s]");
+        if (events & PQOS_MON_EVENT_RMEM_BW)
+                fprintf(fp, ",MBR[MB/s]");
+        if (events & PQOS_MON_EVENT_TMEM_BW)
+                fprintf(fp, ",MBT[MB/s]");
+        fputs("\n", fp);
+
+        for (i = 0; i < cap->num_frames; i++) {
+                unsigned char *frame = cap->frames + i * cap->frame_size;
+                const struct monitor_recorder_frame *hdr =
+                    (const struct monitor_recorder_frame *)frame;
+                const uint64_t *llc =
+                    recorder_table(frame, n, RECORDER_TAB_LLC);
+                const double *mbl = recorder_table(frame, n, RECORDER_TAB_MBL);
+                const double *mbt = recorder_table(frame, n, RECORDER_TAB_MBT);
+                const double *mbr = recorder_table(frame, n, RECORDER_TAB_MBR);
+                const double *ipc = recorder_table(frame, n, RECORDER_TAB_IPC);
+                const uint64_t *misses =
+                    recorder_table(frame, n, RECORDER_TAB_MISSES);
+                const double offset =
+                    ((double)hdr->monotonic - (double)cap->trigger) / 1000000.0;
+                char timestamp[32];
+
+                recorder_time(timestamp, sizeof(timestamp), hdr->realtime);
+
+                for (j = 0; j < n; j++) {
+                        fprintf(fp, "%s,%.3f,\"%s\"", timestamp, offset,
+                                cap->names[j]);
+                        if (events & PQOS_PERF_EVENT_IPC)
+                                fprintf(fp, ",%.2f", ipc[j]);
+                        if (events & PQOS_PERF_EVENT_LLC_MISS)
+                                fprintf(fp, ",%llu",
+                                        (unsigned long long)misses[j]);
+                        if (events & PQOS_MON_EVENT_L3_OCCUP)
+                                fprintf(fp, ",%.1f", (double)llc[j] / 1024.0);
+                        if (events & PQOS_MON_EVENT_LMEM_BW)
+                                fprintf(fp, ",%.1f",
+                                        mbl[j] / (1024.0 * 1024.0));
+                        if (events & PQOS_MON_EVENT_RMEM_BW)
+                                fprintf(fp, ",%.1f",
+                                        mbr[j] / (1024.0 * 1024.0));
+                        if (events & PQOS_MON_EVENT_TMEM_BW)
+                                fprintf(fp, ",%.1f",
+                                        mbt[j] / (1024.0 * 1024.0));
+                        fputs("\n", fp);
+                }
+        }
+
+        if (fclose(fp) != 0)
+                fprintf(stderr, "Failed to write flight recorder capture %s\n",
+                        cap->path);
+        else
+                fprintf(stderr,
+                        "Flight recorder captured %u samples to %s (%s)\n",
+                        cap->num_frames, cap->path, cap->reason);
+
+        recorder_capture_free(cap);
+        return NULL;
+}
+
+/**
+ * @brief Waits for the previous capture to be written out
+ */
+static void
+recorder_join(void)
+{
+        if (!rec.writer_running)
+                return;
+
+        pthread_join(rec.writer, NULL);
+        rec.writer_running = 0;
+}
+
+/**
+ * @brief Starts capture of the frames around the trigger
+ *
+ * @param [in] groups monitoring groups
+ * @param [in] monotonic trigger time [ns]
+ * @param [in] realtime trigger wall clock time [ns]
+ */
+static void
+recorder_capture_start(struct pqos_mon_data *const *groups,
+                       const uint64_t monotonic,
+                       const uint64_t realtime)
+{
+        struct recorder_capture *cap;
+        const time_t sec = (time_t)(realtime / 1000000000llu);
+        char stamp[32] = "";
+        struct tm tm;
+        unsigned i;
+
+        cap = calloc(1, sizeof(*cap));
+        if (cap == NULL)
+                return;
+        cap->names = calloc(rec.num_groups, sizeof(cap->names[0]));
+        if (cap->names == NULL) {
+                free(cap);
+                return;
+        }
+        cap->num_groups = rec.num_groups;
+        for (i = 0; i < rec.num_groups; i++) {
+                cap->names[i] = strdup(recorder_name(groups[i]));
+                if (cap->names[i] == NULL) {
+                        recorder_capture_free(cap);
+                        return;
+                }
+        }
+
+        if (localtime_r(&sec, &tm) != NULL)
+                strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+        snprintf(cap->path, sizeof(cap->path), "%s.%s.%03u.csv", rec.path,
+                 stamp, (unsigned)(realtime / 1000000llu % 1000));
+        snprintf(cap->reason, sizeof(cap->reason), "%s", rec.reason);
+        cap->trigger = monotonic;
+        cap->frame_size = rec.frame_size;
+        cap->events = rec.events;
+
+        rec.capture = cap;
+}
+
+/**
+ * @brief Copies captured frames and hands the capture to the writer
+ */
+static void
+recorder_capture_finish(void)
+{
+        struct recorder_capture *cap = rec.capture;
+        const uint64_t head = rec.hdr->head;
+        const uint64_t before = (uint64_t)(rec.before * 1000000000.0);
+        uint64_t first = head > rec.num_frames ? head - rec.num_frames : 0;
+        uint64_t seq;
+
+        rec.capture = NULL;
+
+        /* skip frames older than the window before the trigger */
+        while (first < head) {
+                const struct monitor_recorder_frame *frame =
+                    (const struct monitor_recorder_frame *)recorder_frame(
+                        first);
+
+                if (frame->monotonic + before >= cap->trigger)
+                        break;
+                first++;
+        }
+
+        cap->frames = malloc((head - first) * cap->frame_size + 1);
+        if (cap->frames == NULL) {
+                recorder_capture_free(cap);
+                return;
+        }
+        for (seq = first; seq < head; seq++)
+                memcpy(cap->frames + cap->num_frames++ * cap->frame_size,
+                       recorder_frame(seq), cap->frame_size);
+
+        recorder_join();
+        if (pthread_create(&rec.writer, NULL, recorder_write, cap) == 0)
+                rec.writer_running = 1;
+        else
+                (void)recorder_write(cap);
+}
+
+/**
+ * @brief Checks threshold triggers on the latest frame
+ *
+ * Triggers fire when the first group crosses the threshold.
+ *
+ * @param [in] groups monitoring groups
+ * @param [in] frame latest frame
+ */
+static void
+recorder_check(struct pqos_mon_data *const *groups, unsigned char *frame)
+{
+        const unsigned n = rec.num_groups;
+        const double *ipc = recorder_table(frame, n, RECORDER_TAB_IPC);
+        const double *mbl = recorder_table(frame, n, RECORDER_TAB_MBL);
+        const double *mbt = recorder_table(frame, n, RECORDER_TAB_MBT);
+        unsigned ipc_low = n;
+        unsigned mbm_high = n;
+        unsigned i;
+
+        for (i = 0; i < n; i++) {
+                const double mbps =
+                    (mbt[i] > 0 ? mbt[i] : mbl[i]) / (1024.0 * 1024.0);
+
+                /* idle groups do not report IPC */
+                if (ipc_low == n && rec.ipc_below > 0 && ipc[i] > 0 &&
+                    ipc[i] < rec.ipc_below)
+                        ipc_low = i;
+                if (mbm_high == n && rec.mbm_above > 0 &&
+                    mbps > rec.mbm_above)
+                        mbm_high = i;
+        }
+
+        if (!rec.fired && ipc_low < n && !rec.ipc_low) {
+                snprintf(rec.reason, sizeof(rec.reason),
+                         "IPC %.2f of group %s below %.2f", ipc[ipc_low],
+                         recorder_name(groups[ipc_low]),
+                         rec.ipc_below);
+                rec.fired = 1;
+        }
+        if (!rec.fired && mbm_high < n && !rec.mbm_high) {
+                i = mbm_high;
+                snprintf(rec.reason, sizeof(rec.reason),
+                         "bandwidth %.1fMB/s of group %s above %.1fMB/s",
+                         (mbt[i] > 0 ? mbt[i] : mbl[i]) / (1024.0 * 1024.0),
+                         recorder_name(groups[i]), rec.mbm_above);
+                rec.fired = 1;
+        }
+        rec.ipc_low = ipc_low < n;
+        rec.mbm_high = mbm_high < n;
+}
+
+int
+monitor_recorder_start(const char *spec,
+                       const unsigned num_groups,
+                       const unsigned tick,
+                       const enum pqos_mon_event events)
+{
+        char *str, *tok, *saveptr = NULL;
+        size_t size;
+        double window;
+
+        rec.before = RECORDER_BEFORE_DEFAULT;
+        rec.after = RECORDER_AFTER_DEFAULT;
+        rec.ipc_below = 0;
+        rec.mbm_above = 0;
+        rec.ipc_low = 0;
+        rec.mbm_high = 0;
+        rec.fired = 0;
+
+        str = strdup(spec);
+        if (str == NULL)
+                return -1;
+
+        tok = strtok_r(str, ",", &saveptr);
+        if (tok == NULL) {
+                printf("Invalid flight recorder file!\n");
+                goto recorder_start_error;
+        }
+        rec.path = strdup(tok);
+        if (rec.path == NULL)
+                goto recorder_start_error;
+
+        for (tok = strtok_r(NULL, ",", &saveptr); tok != NULL;
+             tok = strtok_r(NULL, ",", &saveptr)) {
+                int ret;
+
+                if (strncasecmp(tok, "before=", 7) == 0)
+                        ret = recorder_parse_value(tok + 7, &rec.before);
+                else if (strncasecmp(tok, "after=", 6) == 0)
+                        ret = recorder_parse_value(tok + 6, &rec.after);
+                else if (strncasecmp(tok, "ipc-below=", 10) == 0)
+                        ret = recorder_parse_value(tok + 10, &rec.ipc_below);
+                else if (strncasecmp(tok, "mbm-above=", 10) == 0)
+                        ret = recorder_parse_value(tok + 10, &rec.mbm_above);
+                else {
+                        printf("Invalid flight recorder setting '%s'!\n", tok);
+                        ret = -1;
+                }
+                if (ret != 0)
+                        goto recorder_start_error;
+        }
+        free(str);
+        str = NULL;
+
+        /* ring holds the whole window plus the frame being written */
+        window = (rec.before + rec.after) * 1000.0 / tick;
+        if (num_groups == 0 || window > (double)(UINT32_MAX - 2)) {
+                printf("Invalid flight recorder window!\n");
+                goto recorder_start_error;
+        }
+        rec.num_groups = num_groups;
+        rec.num_frames = (unsigned)window + 2;
+        rec.frame_size = sizeof(struct monitor_recorder_frame) +
+                         RECORDER_TAB_NUM * num_groups * sizeof(uint64_t);
+        rec.events = events;
+        size = sizeof(*rec.hdr) + (size_t)rec.num_frames * rec.frame_size;
+
+        rec.fd = open(rec.path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (rec.fd < 0) {
+                printf("Failed to open flight recorder file '%s'!\n", rec.path);
+                goto recorder_start_error;
+        }
+        if (ftruncate(rec.fd, (off_t)size) != 0) {
+                printf("Failed to resize flight recorder file '%s'!\n",
+                       rec.path);
+                goto recorder_start_error;
+        }
+        rec.map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, rec.fd,
+                       0);
+        if (rec.map == MAP_FAILED) {
+                rec.map = NULL;
+                printf("Failed to map flight recorder file '%s'!\n", rec.path);
+                goto recorder_start_error;
+        }
+        rec.map_size = size;
+
+        rec.hdr = (struct monitor_recorder_header *)rec.map;
+        rec.hdr->version = MONITOR_RECORDER_VERSION;
+        rec.hdr->num_groups = rec.num_groups;
+        rec.hdr->num_frames = rec.num_frames;
+        rec.hdr->frame_size = (uint32_t)rec.frame_size;
+        rec.hdr->tick = tick;
+        rec.hdr->events = (uint32_t)events;
+        rec.hdr->head = 0;
+        memcpy(rec.hdr->magic, MONITOR_RECORDER_MAGIC,
+               MONITOR_RECORDER_MAGIC_LEN);
+
+        return 0;
+
+recorder_start_error:
+        free(str);
+        monitor_recorder_stop();
+        return -1;
+}
+
+void
+monitor_recorder_update(struct pqos_mon_data *const *groups,
+                        const unsigned num_groups,
+                        const uint64_t monotonic,
+                        const uint64_t realtime)
+{
+        struct monitor_recorder_frame *hdr;
+        struct pqos_mon_values values;
+        unsigned char *frame;
+        uint64_t seq;
+
+        if (rec.map == NULL || num_groups != rec.num_groups)
+                return;
+
+        seq = rec.hdr->head;
+        frame = recorder_frame(seq);
+        hdr = (struct monitor_recorder_frame *)frame;
+
+        values.llc = recorder_table(frame, num_groups, RECORDER_TAB_LLC);
+        values.mbm_local_rate =
+            recorder_table(frame, num_groups, RECORDER_TAB_MBL);
+        values.mbm_total_rate =
+            recorder_table(frame, num_groups, RECORDER_TAB_MBT);
+        values.mbm_remote_rate =
+            recorder_table(frame, num_groups, RECORDER_TAB_MBR);
+        values.ipc = recorder_table(frame, num_groups, RECORDER_TAB_IPC);
+        values.llc_misses =
+            recorder_table(frame, num_groups, RECORDER_TAB_MISSES);
+        if (pqos_mon_get_values(groups, num_groups, &values) !=
+            PQOS_RETVAL_OK)
+                return;
+
+        hdr->seq = seq;
+        hdr->monotonic = monotonic;
+        hdr->realtime = realtime;
+        hdr->reserved = 0;
+        /* frame is complete for readers of the ring file */
+        __atomic_store_n(&rec.hdr->head, seq + 1, __ATOMIC_RELEASE);
+
+        /* triggers during capture are ignored */
+        recorder_check(groups, frame);
+        if (rec.fired && rec.capture == NULL)
+                recorder_capture_start(groups, monotonic, realtime);
+        rec.fired = 0;
+
+        if (rec.capture != NULL &&
+            monotonic >= rec.capture->trigger +
+                             (uint64_t)(rec.after * 1000000000.0))
+                recorder_capture_finish();
+}
+
+int
+monitor_recorder_trigger(const char *reason)
+{
+        if (rec.map == NULL || rec.capture != NULL)
+                return -1;
+
+        snprintf(rec.reason, sizeof(rec.reason), "%s", reason);
+        rec.fired = 1;
+
+        return 0;
+}
+
+void
+monitor_recorder_stop(void)
+{
+        /* write out what was recorded after the trigger so far */
+        if (rec.capture != NULL)
+                recorder_capture_finish();
+        recorder_join();
+
+        if (rec.map != NULL)
+                munmap(rec.map, rec.map_size);
+        rec.map = NULL;
+        rec.hdr = NULL;
+        rec.map_size = 0;
+
+        if (rec.fd >= 0) {
+                close(rec.fd);
+                /* ring contents are not persisted */
+                if (unlink(rec.path) != 0)
+                        fprintf(stderr, "Failed to remove %s\n", rec.path);
+        }
+        rec.fd = -1;
+
+        free(rec.path);
+        rec.path = NULL;
+}
@@ -0,0 +1,138 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Flight recorder of pqos monitoring
+ *
+ * Values of all monitoring groups are recorded at every poll into a ring
+ * of fixed size frames in a memory mapped file. Ring file layout:
+ *  - struct monitor_recorder_header
+ *  - num_frames frames of frame_size bytes, each consisting of
+ *    struct monitor_recorder_frame followed by per group tables of
+ *    LLC occupancy [B] (uint64_t), local, total and remote memory
+ *    bandwidth [B/s] (double), IPC (double) and LLC misses since the
+ *    previous poll (uint64_t)
+ *
+ * Frame with sequence number seq is stored at index seq % num_frames.
+ * When a trigger fires, frames from before to after the trigger are
+ * written out to a CSV capture file.
+ */
+
+#ifndef __MONITOR_RECORDER_H__
+#define __MONITOR_RECORDER_H__
+
+#include "pqos.h"
+
+#include <stdint.h>
+
+#define MONITOR_RECORDER_MAGIC     "PQOSFLR"
+#define MONITOR_RECORDER_MAGIC_LEN 8
+#define MONITOR_RECORDER_VERSION   1
+
+/**
+ * Ring file header
+ */
+struct monitor_recorder_header {
+        char magic[MONITOR_RECORDER_MAGIC_LEN];
+        uint32_t version;
+        uint32_t num_groups; /**< number of monitoring groups */
+        uint32_t num_frames; /**< number of frames in the ring */
+        uint32_t frame_size; /**< size of a frame in bytes */
+        uint32_t tick;       /**< poll period [ms] */
+        uint32_t events;     /**< monitored events */
+        uint64_t head;       /**< sequence number of the next frame */
+};
+
+/**
+ * Frame header
+ */
+struct monitor_recorder_frame {
+        uint64_t seq;       /**< frame sequence number */
+        uint64_t monotonic; /**< CLOCK_MONOTONIC poll time [ns] */
+        uint64_t realtime;  /**< CLOCK_REALTIME poll time [ns] */
+        uint64_t reserved;
+};
+
+/**
+ * @brief Parses recorder specification and creates the ring file
+ *
+ * @param [in] spec ring file path followed by optional comma separated
+ *             before=SEC, after=SEC, ipc-below=IPC and mbm-above=MBPS
+ *             settings
+ * @param [in] num_groups number of monitoring groups
+ * @param [in] tick poll period [ms]
+ * @param [in] events monitored events
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int monitor_recorder_start(const char *spec,
+                           const unsigned num_groups,
+                           const unsigned tick,
+                           const enum pqos_mon_event events);
+
+/**
+ * @brief Records values of polled monitoring groups
+ *
+ * Checks threshold triggers and writes out the capture when the window
+ * after the trigger is complete.
+ *
+ * @param [in] groups polled monitoring groups
+ * @param [in] num_groups number of monitoring groups
+ * @param [in] monotonic CLOCK_MONOTONIC poll time [ns]
+ * @param [in] realtime CLOCK_REALTIME poll time [ns]
+ */
+void monitor_recorder_update(struct pqos_mon_data *const *groups,
+                             const unsigned num_groups,
+                             const uint64_t monotonic,
+                             const uint64_t realtime);
+
+/**
+ * @brief Fires the trigger at the next recorded frame
+ *
+ * Triggers are ignored while a capture is in progress.
+ *
+ * @param [in] reason trigger description stored in the capture
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 recorder is not running or capture is in progress
+ */
+int monitor_recorder_trigger(const char *reason);
+
+/**
+ * @brief Writes out pending capture and removes the ring file
+ */
+void monitor_recorder_stop(void);
+
+#endif /* __MONITOR_RECORDER_H__ */
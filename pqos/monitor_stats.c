@@ -0,0 +1,347 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor_stats.h"
+
+#include "common.h"
+#include "monitor.h"
+#include "monitor_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define STATS_MAX_KINDS 16
+
+/**
+ * Statistics kinds
+ */
+enum stats_kind {
+        STATS_EWMA,
+        STATS_MIN,
+        STATS_MAX,
+        STATS_QUANTILE,
+};
+
+/**
+ * Events with statistics in output column order
+ */
+static const struct {
+        enum pqos_mon_event event;
+        const char *name;
+        int decimals;
+} stats_events[] = {
+    {PQOS_PERF_EVENT_IPC, "IPC", 2},
+    {PQOS_MON_EVENT_L3_OCCUP, "LLC", 1},
+    {PQOS_MON_EVENT_LMEM_BW, "MBL", 1},
+    {PQOS_MON_EVENT_RMEM_BW, "MBR", 1},
+    {PQOS_MON_EVENT_TMEM_BW, "MBT", 1},
+};
+
+static struct {
+        struct pqos_mon_stats **group;       /**< statistics of each group */
+        unsigned num_groups;                 /**< number of groups */
+        struct monitor_stats_column *column; /**< output columns */
+        enum stats_kind *kind;               /**< kind of each column */
+        double *quantile;                    /**< quantile of each column */
+        unsigned num_columns;                /**< number of columns */
+        unsigned cache_size;                 /**< L3 size for LLC [%] */
+} stats;
+
+/**
+ * @brief Parses seconds value of the setting
+ *
+ * @param [in] str value string
+ * @param [out] val parsed value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+stats_parse_seconds(const char *str, double *val)
+{
+        char *endptr = NULL;
+
+        *val = strtod(str, &endptr);
+        if (endptr == str || *endptr != '\0' || !(*val > 0)) {
+                printf("Invalid statistics setting value '%s'!\n", str);
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Converts library statistics value to display units
+ *
+ * @param [in] event monitored event
+ * @param [in] val value in library units
+ *
+ * @return value in units of the regular output columns
+ */
+static double
+stats_to_display(const enum pqos_mon_event event, const double val)
+{
+        switch (event) {
+        case PQOS_MON_EVENT_L3_OCCUP:
+                if (monitor_get_llc_format() == LLC_FORMAT_PERCENT)
+                        return stats.cache_size ? val * 100 / stats.cache_size
+                                                : 0.0;
+                return val / 1024.0;
+        case PQOS_MON_EVENT_LMEM_BW:
+        case PQOS_MON_EVENT_RMEM_BW:
+        case PQOS_MON_EVENT_TMEM_BW:
+                return val / (1024.0 * 1024.0);
+        default:
+                return val;
+        }
+}
+
+int
+monitor_stats_start(const char *spec,
+                    const unsigned num_groups,
+                    const enum pqos_mon_event events)
+{
+        struct pqos_mon_stats_config config;
+        enum stats_kind kind[STATS_MAX_KINDS];
+        double quantile[STATS_MAX_KINDS];
+        char label[STATS_MAX_KINDS][8];
+        unsigned num_kinds = 0;
+        char *str, *tok, *saveptr = NULL;
+        unsigned i, j;
+        int ret = -1;
+
+        memset(&config, 0, sizeof(config));
+
+        str = strdup(spec);
+        if (str == NULL)
+                return -1;
+
+        for (tok = strtok_r(str, ",", &saveptr); tok != NULL;
+             tok = strtok_r(NULL, ",", &saveptr)) {
+                if (strncasecmp(tok, "half-life=", 10) == 0) {
+                        if (stats_parse_seconds(tok + 10, &config.half_life))
+                                goto exit;
+                        continue;
+                }
+                if (strncasecmp(tok, "window=", 7) == 0) {
+                        if (stats_parse_seconds(tok + 7, &config.window))
+                                goto exit;
+                        continue;
+                }
+                if (num_kinds == STATS_MAX_KINDS) {
+                        printf("Too many statistics selected!\n");
+                        goto exit;
+                }
+
+                quantile[num_kinds] = 0;
+                if (strcasecmp(tok, "ewma") == 0)
+                        kind[num_kinds] = STATS_EWMA;
+                else if (strcasecmp(tok, "min") == 0)
+                        kind[num_kinds] = STATS_MIN;
+                else if (strcasecmp(tok, "max") == 0)
+                        kind[num_kinds] = STATS_MAX;
+                else if ((tok[0] == 'p' || tok[0] == 'P') &&
+                         strlen(tok) < sizeof(label[0])) {
+                        char *endptr = NULL;
+                        double pct = strtod(tok + 1, &endptr);
+
+                        if (endptr == tok + 1 || *endptr != '\0' ||
+                            !(pct > 0) || pct > 100) {
+                                printf("Invalid quantile '%s'!\n", tok);
+                                goto exit;
+                        }
+                        kind[num_kinds] = STATS_QUANTILE;
+                        quantile[num_kinds] = pct / 100;
+                } else {
+                        printf("Invalid statistic '%s'!\n", tok);
+                        goto exit;
+                }
+                snprintf(label[num_kinds], sizeof(label[0]), "%s", tok);
+                for (j = 0; label[num_kinds][j] != '\0'; j++)
+                        if (label[num_kinds][j] >= 'A' &&
+                            label[num_kinds][j] <= 'Z')
+                                label[num_kinds][j] += 'a' - 'A';
+                num_kinds++;
+        }
+
+        if (num_kinds == 0) {
+                printf("No statistics selected!\n");
+                goto exit;
+        }
+
+        if (monitor_utils_get_cache_size(&stats.cache_size) != PQOS_RETVAL_OK)
+                stats.cache_size = 0;
+
+        stats.column = calloc(num_kinds * DIM(stats_events),
+                              sizeof(stats.column[0]));
+        stats.kind = calloc(num_kinds * DIM(stats_events),
+                            sizeof(stats.kind[0]));
+        stats.quantile = calloc(num_kinds * DIM(stats_events),
+                                sizeof(stats.quantile[0]));
+        stats.group = calloc(num_groups, sizeof(stats.group[0]));
+        if (stats.column == NULL || stats.kind == NULL ||
+            stats.quantile == NULL || stats.group == NULL) {
+                printf("Memory allocation error!\n");
+                goto exit;
+        }
+        stats.num_groups = num_groups;
+
+        for (i = 0; i < num_kinds; i++)
+                for (j = 0; j < DIM(stats_events); j++) {
+                        const enum pqos_mon_event event =
+                            stats_events[j].event;
+                        struct monitor_stats_column *column =
+                            &stats.column[stats.num_columns];
+
+                        if (!(events & event))
+                                continue;
+
+                        column->event = event;
+                        column->decimals = stats_events[j].decimals;
+                        snprintf(column->name, sizeof(column->name),
+                                 "%.3s_%.7s", stats_events[j].name, label[i]);
+                        if (event == PQOS_PERF_EVENT_IPC)
+                                column->unit = "";
+                        else if (event == PQOS_MON_EVENT_L3_OCCUP)
+                                column->unit = monitor_get_llc_format() ==
+                                                       LLC_FORMAT_PERCENT
+                                                   ? "[%]"
+                                                   : "[KB]";
+                        else
+                                column->unit = "[MB/s]";
+                        stats.kind[stats.num_columns] = kind[i];
+                        stats.quantile[stats.num_columns] = quantile[i];
+                        stats.num_columns++;
+                }
+
+        for (i = 0; i < num_groups; i++)
+                if (pqos_mon_stats_create(&config, &stats.group[i]) !=
+                    PQOS_RETVAL_OK) {
+                        printf("Failed to create monitoring statistics!\n");
+                        goto exit;
+                }
+
+        ret = 0;
+exit:
+        free(str);
+        if (ret != 0)
+                monitor_stats_stop();
+
+        return ret;
+}
+
+void
+monitor_stats_update(struct pqos_mon_data *const *groups,
+                     const unsigned num_groups,
+                     const uint64_t monotonic)
+{
+        unsigned i;
+
+        for (i = 0; i < num_groups && i < stats.num_groups; i++)
+                (void)pqos_mon_stats_update(stats.group[i], groups[i],
+                                            monotonic);
+}
+
+void
+monitor_stats_reset(const unsigned idx)
+{
+        if (idx < stats.num_groups)
+                (void)pqos_mon_stats_reset(stats.group[idx]);
+}
+
+unsigned
+monitor_stats_num_columns(void)
+{
+        return stats.num_columns;
+}
+
+const struct monitor_stats_column *
+monitor_stats_get_column(const unsigned col)
+{
+        ASSERT(col < stats.num_columns);
+
+        return &stats.column[col];
+}
+
+void
+monitor_stats_snapshot(const unsigned idx, double *values)
+{
+        unsigned i;
+
+        for (i = 0; i < stats.num_columns; i++) {
+                const enum pqos_mon_event event = stats.column[i].event;
+                struct pqos_mon_stat stat;
+                double val = NAN;
+
+                values[i] = NAN;
+                if (idx >= stats.num_groups ||
+                    pqos_mon_stats_get(stats.group[idx], event, &stat) !=
+                        PQOS_RETVAL_OK)
+                        continue;
+
+                switch (stats.kind[i]) {
+                case STATS_EWMA:
+                        val = stat.ewma;
+                        break;
+                case STATS_MIN:
+                        val = stat.min;
+                        break;
+                case STATS_MAX:
+                        val = stat.max;
+                        break;
+                case STATS_QUANTILE:
+                        if (pqos_mon_stats_get_quantile(
+                                stats.group[idx], event, stats.quantile[i],
+                                &val) != PQOS_RETVAL_OK)
+                                continue;
+                        break;
+                }
+
+                values[i] = stats_to_display(event, val);
+        }
+}
+
+void
+monitor_stats_stop(void)
+{
+        unsigned i;
+
+        for (i = 0; i < stats.num_groups; i++)
+                if (stats.group[i] != NULL)
+                        pqos_mon_stats_destroy(stats.group[i]);
+        free(stats.group);
+        free(stats.column);
+        free(stats.kind);
+        free(stats.quantile);
+        memset(&stats, 0, sizeof(stats));
+}
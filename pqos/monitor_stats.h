@@ -0,0 +1,116 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Streaming statistics columns of pqos monitoring output
+ */
+
+#ifndef __MONITOR_STATS_H__
+#define __MONITOR_STATS_H__
+
+#include "pqos.h"
+
+#include <stdint.h>
+
+/**
+ * Statistics output column
+ */
+struct monitor_stats_column {
+        enum pqos_mon_event event; /**< monitored event */
+        char name[16];             /**< column name e.g. MBL_p99 */
+        const char *unit;          /**< unit for CSV header */
+        int decimals;              /**< number of decimal places */
+};
+
+/**
+ * @brief Parses statistics specification and allocates group statistics
+ *
+ * @param [in] spec comma separated list of ewma, min, max, pN quantiles
+ *             and half-life=SEC and window=SEC settings
+ * @param [in] num_groups number of monitoring groups
+ * @param [in] events monitored events
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int monitor_stats_start(const char *spec,
+                        const unsigned num_groups,
+                        const enum pqos_mon_event events);
+
+/**
+ * @brief Updates statistics after poll of monitoring groups
+ *
+ * @param [in] groups polled monitoring groups
+ * @param [in] num_groups number of monitoring groups
+ * @param [in] monotonic CLOCK_MONOTONIC poll time [ns]
+ */
+void monitor_stats_update(struct pqos_mon_data *const *groups,
+                          const unsigned num_groups,
+                          const uint64_t monotonic);
+
+/**
+ * @brief Drops statistics of the group, e.g. when it follows new process
+ *
+ * @param [in] idx group index
+ */
+void monitor_stats_reset(const unsigned idx);
+
+/**
+ * @brief Retrieves number of statistics columns, 0 when not enabled
+ */
+unsigned monitor_stats_num_columns(void);
+
+/**
+ * @brief Retrieves statistics column
+ *
+ * @param [in] col column index
+ *
+ * @return column description
+ */
+const struct monitor_stats_column *monitor_stats_get_column(const unsigned col);
+
+/**
+ * @brief Stores current column values of the group in display units
+ *
+ * @param [in] idx group index
+ * @param [out] values table of monitor_stats_num_columns() entries,
+ *              NAN where no value is available yet
+ */
+void monitor_stats_snapshot(const unsigned idx, double *values);
+
+/**
+ * @brief Releases statistics
+ */
+void monitor_stats_stop(void);
+
+#endif /* __MONITOR_STATS_H__ */
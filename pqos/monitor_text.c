@@ -34,6 +34,7 @@
 
 #include "common.h"
 #include "monitor.h"
+#include "monitor_stats.h"
 #include "monitor_utils.h"
 
 #include <stdio.h>
@@ -51,6 +52,7 @@ monitor_text_header(FILE *fp, const char *timestamp)
 {
         enum pqos_mon_event events = monitor_get_events();
         enum monitor_llc_format format = monitor_get_llc_format();
+        unsigned i;
 
         ASSERT(fp != NULL);
         ASSERT(timestamp != NULL);
@@ -102,6 +104,9 @@ monitor_text_header(FILE *fp, const char *timestamp)
                 fprintf(fp, " %11s", "REF_READ");
         if (events & PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE)
                 fprintf(fp, " %11s", "REF_WRITE");
+
+        for (i = 0; i < monitor_stats_num_columns(); i++)
+                fprintf(fp, " %11s", monitor_stats_get_column(i)->name);
 }
 
 /**
@@ -231,6 +236,16 @@ monitor_text_row(FILE *fp,
                 fprintf(fp, "\n%8.8s %8.8s%s", (char *)mon_data->context,
                         core_list, data);
         }
+
+        for (i = 0; i < monitor_stats_num_columns(); i++) {
+                double value;
+
+                if (monitor_get_stat(mon_data, i, &value) == 0)
+                        fprintf(fp, " %11.*f",
+                                monitor_stats_get_column(i)->decimals, value);
+                else
+                        fprintf(fp, " %11s", "");
+        }
 }
 
 void
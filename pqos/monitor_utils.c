@@ -91,14 +91,14 @@ monitor_utils_get_value(const struct pqos_mon_data *const group,
         double value;
 
         /** Coefficient to display the data as MB/s */
-        const double coeff = 10.0 / (double)monitor_get_interval();
+        const double coeff = 1000.0 / monitor_get_mbm_interval(group);
 
         if ((group->event & event) == 0)
                 return 0.0;
 
         switch (event) {
         case PQOS_MON_EVENT_L3_OCCUP:
-                ret = pqos_mon_get_value(group, event, &delta, NULL);
+                ret = monitor_get_value(group, event, &delta, NULL);
                 if (ret == PQOS_RETVAL_OK) {
                         enum monitor_llc_format format =
                             monitor_get_llc_format();
@@ -124,7 +124,7 @@ monitor_utils_get_value(const struct pqos_mon_data *const group,
         case PQOS_MON_EVENT_LMEM_BW:
         case PQOS_MON_EVENT_TMEM_BW:
         case PQOS_MON_EVENT_RMEM_BW:
-                ret = pqos_mon_get_value(group, event, NULL, &delta);
+                ret = monitor_get_value(group, event, NULL, &delta);
                 if (ret == PQOS_RETVAL_OK)
                         value = bytes_to_mb(delta) * coeff;
 
@@ -135,7 +135,7 @@ monitor_utils_get_value(const struct pqos_mon_data *const group,
         case PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE:
         case PQOS_PERF_EVENT_LLC_REF_PCIE_READ:
         case PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE:
-                ret = pqos_mon_get_value(group, event, NULL, &delta);
+                ret = monitor_get_value(group, event, NULL, &delta);
                 value = (double)delta;
                 break;
         case PQOS_PERF_EVENT_IPC:
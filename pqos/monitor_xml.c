@@ -34,8 +34,10 @@
 
 #include "common.h"
 #include "monitor.h"
+#include "monitor_stats.h"
 #include "monitor_utils.h"
 
+#include <ctype.h>
 #include <string.h>
 
 static const char *xml_root_open = "<records>";
@@ -222,6 +224,24 @@ monitor_xml_row(FILE *fp,
                         "\t<socket>%s</socket>\n"
                         "%s",
                         (char *)mon_data->context, data);
+
+        for (i = 0; i < monitor_stats_num_columns(); i++) {
+                const struct monitor_stats_column *column =
+                    monitor_stats_get_column(i);
+                char node_name[sizeof(column->name)];
+                double value;
+                unsigned j;
+
+                for (j = 0; j < sizeof(node_name) - 1; j++)
+                        node_name[j] = (char)tolower(column->name[j]);
+                node_name[j] = '\0';
+
+                if (monitor_get_stat(mon_data, i, &value) == 0)
+                        fprintf(fp, "\t<%s>%.*f</%s>\n", node_name,
+                                column->decimals, value, node_name);
+                else
+                        fprintf(fp, "\t<%s></%s>\n", node_name, node_name);
+        }
         fprintf(fp, "%s\n", xml_child_close);
 }
 
@@ -0,0 +1,746 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "proc_scan.h"
+
+#include "common.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROC_SCAN_BUCKETS_MIN 1024 /**< initial size of the hash table */
+#define PROC_SCAN_FD_MAX 1024      /**< default cap of cached descriptors */
+#define PROC_SCAN_FD_SHARE 4       /**< 1/N of open files limit is cached */
+
+/**
+ * Tracked process
+ */
+struct proc_node {
+        struct proc_scan_entry entry;
+        int fd;                 /**< cached stat file descriptor or -1 */
+        unsigned gen;           /**< last scan the process was seen in */
+        struct proc_node *next; /**< next process in the hash bucket */
+};
+
+struct proc_scan {
+        char *proc_dir;              /**< proc file system location */
+        struct proc_node **buckets;  /**< hash table of processes */
+        unsigned num_buckets;        /**< hash table size, power of 2 */
+        unsigned num_procs;          /**< number of tracked processes */
+        unsigned gen;                /**< scan generation */
+        unsigned fd_budget;          /**< max number of cached descriptors */
+        unsigned fd_used;            /**< number of cached descriptors */
+        long clk_tck;                /**< clock ticks per second */
+        int track_uid;               /**< read process owners */
+        struct proc_scan_entry **changed; /**< changed in the last scan */
+        unsigned num_changed;             /**< number of changed processes */
+        unsigned max_changed;             /**< size of changed table */
+};
+
+/**
+ * @brief Returns time since boot in clock ticks
+ *
+ * @param scan process scanner
+ *
+ * @return time since boot
+ */
+static uint64_t
+proc_scan_uptime(const struct proc_scan *scan)
+{
+        struct timespec ts;
+
+#ifdef CLOCK_BOOTTIME
+        if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0)
+#else
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+#endif
+                return 0;
+
+        return (uint64_t)ts.tv_sec * scan->clk_tck +
+               (uint64_t)ts.tv_nsec * scan->clk_tck / 1000000000llu;
+}
+
+/**
+ * @brief Determines default number of stat descriptors kept open
+ *
+ * Scanner takes a small share of the open files soft limit, so the rest
+ * is left for the library and other users. The limit is not changed.
+ *
+ * @return number of descriptors
+ */
+static unsigned
+proc_scan_fd_budget(void)
+{
+        struct rlimit rlim;
+
+        if (getrlimit(RLIMIT_NOFILE, &rlim) != 0)
+                return 0;
+
+        if (rlim.rlim_cur == RLIM_INFINITY ||
+            rlim.rlim_cur / PROC_SCAN_FD_SHARE > PROC_SCAN_FD_MAX)
+                return PROC_SCAN_FD_MAX;
+
+        return (unsigned)(rlim.rlim_cur / PROC_SCAN_FD_SHARE);
+}
+
+struct proc_scan *
+proc_scan_create(const char *proc_dir)
+{
+        struct proc_scan *scan;
+
+        if (proc_dir == NULL)
+                return NULL;
+
+        scan = calloc(1, sizeof(*scan));
+        if (scan == NULL)
+                return NULL;
+
+        scan->proc_dir = strdup(proc_dir);
+        scan->num_buckets = PROC_SCAN_BUCKETS_MIN;
+        scan->buckets = calloc(scan->num_buckets, sizeof(scan->buckets[0]));
+        if (scan->proc_dir == NULL || scan->buckets == NULL) {
+                proc_scan_destroy(scan);
+                return NULL;
+        }
+
+        scan->clk_tck = sysconf(_SC_CLK_TCK);
+        if (scan->clk_tck <= 0)
+                scan->clk_tck = 100;
+        scan->fd_budget = proc_scan_fd_budget();
+
+        return scan;
+}
+
+/**
+ * @brief Releases process node
+ *
+ * @param scan process scanner
+ * @param node process node
+ */
+static void
+proc_node_free(struct proc_scan *scan, struct proc_node *node)
+{
+        if (node->fd >= 0) {
+                close(node->fd);
+                scan->fd_used--;
+        }
+        free(node);
+}
+
+void
+proc_scan_destroy(struct proc_scan *scan)
+{
+        unsigned i;
+
+        if (scan == NULL)
+                return;
+
+        if (scan->buckets != NULL)
+                for (i = 0; i < scan->num_buckets; i++) {
+                        struct proc_node *node = scan->buckets[i];
+
+                        while (node != NULL) {
+                                struct proc_node *next = node->next;
+
+                                proc_node_free(scan, node);
+                                node = next;
+                        }
+                }
+
+        free(scan->changed);
+        free(scan->buckets);
+        free(scan->proc_dir);
+        free(scan);
+}
+
+void
+proc_scan_set_fd_budget(struct proc_scan *scan, const unsigned budget)
+{
+        unsigned i;
+
+        if (scan == NULL)
+                return;
+
+        scan->fd_budget = budget;
+
+        /* close descriptors above the new budget */
+        for (i = 0; i < scan->num_buckets && scan->fd_used > budget; i++) {
+                struct proc_node *node;
+
+                for (node = scan->buckets[i];
+                     node != NULL && scan->fd_used > budget;
+                     node = node->next)
+                        if (node->fd >= 0) {
+                                close(node->fd);
+                                node->fd = -1;
+                                scan->fd_used--;
+                        }
+        }
+}
+
+void
+proc_scan_track_uid(struct proc_scan *scan)
+{
+        if (scan != NULL)
+                scan->track_uid = 1;
+}
+
+/**
+ * @brief Doubles the hash table size
+ *
+ * @param scan process scanner
+ */
+static void
+proc_scan_grow(struct proc_scan *scan)
+{
+        const unsigned num_buckets = scan->num_buckets * 2;
+        struct proc_node **buckets;
+        unsigned i;
+
+        buckets = calloc(num_buckets, sizeof(buckets[0]));
+        if (buckets == NULL)
+                return; /* keep using longer chains */
+
+        for (i = 0; i < scan->num_buckets; i++) {
+                struct proc_node *node = scan->buckets[i];
+
+                while (node != NULL) {
+                        struct proc_node *next = node->next;
+                        unsigned b = (unsigned)node->entry.pid &
+                                     (num_buckets - 1);
+
+                        node->next = buckets[b];
+                        buckets[b] = node;
+                        node = next;
+                }
+        }
+
+        free(scan->buckets);
+        scan->buckets = buckets;
+        scan->num_buckets = num_buckets;
+}
+
+/**
+ * @brief Looks up process by PID
+ *
+ * @param scan process scanner
+ * @param pid process id
+ *
+ * @return process node or NULL when not tracked
+ */
+static struct proc_node *
+proc_scan_find(const struct proc_scan *scan, const pid_t pid)
+{
+        struct proc_node *node;
+
+        node = scan->buckets[(unsigned)pid & (scan->num_buckets - 1)];
+        while (node != NULL && node->entry.pid != pid)
+                node = node->next;
+
+        return node;
+}
+
+/**
+ * @brief Parses content of /proc/<pid>/stat file
+ *
+ * @param buf file content
+ * @param [out] entry process statistics
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 parse error
+ */
+static int
+proc_stat_parse(const char *buf, struct proc_scan_entry *entry)
+{
+        const char *comm = strchr(buf, '(');
+        const char *end = strrchr(buf, ')');
+        uint64_t utime, stime;
+        size_t len;
+        int ppid;
+
+        if (comm == NULL || end == NULL || end < comm)
+                return -1;
+
+        len = end - comm - 1;
+        if (len >= sizeof(entry->comm))
+                len = sizeof(entry->comm) - 1;
+        memcpy(entry->comm, comm + 1, len);
+        entry->comm[len] = '\0';
+
+        /* fields 3 (state) to 22 (starttime) of proc(5) */
+        if (sscanf(end + 1,
+                   " %c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u"
+                   " %" SCNu64 " %" SCNu64 " %*d %*d %*d %*d %*d %*d"
+                   " %" SCNu64,
+                   &entry->state, &ppid, &utime, &stime,
+                   &entry->starttime) != 5)
+                return -1;
+
+        entry->ppid = (pid_t)ppid;
+        entry->ticks = utime + stime;
+
+        return 0;
+}
+
+/**
+ * @brief Reads statistics of the process
+ *
+ * Stat file descriptor is cached while the descriptor budget allows.
+ *
+ * @param scan process scanner
+ * @param dir_fd proc directory descriptor
+ * @param name process directory name
+ * @param node process node
+ * @param [out] entry process statistics
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 process is gone or its statistics are not readable
+ */
+static int
+proc_stat_read(struct proc_scan *scan,
+               const int dir_fd,
+               const char *name,
+               struct proc_node *node,
+               struct proc_scan_entry *entry)
+{
+        char path[64];
+        char buf[1024];
+        ssize_t len;
+        int fd = node->fd;
+
+        if (fd < 0) {
+                snprintf(path, sizeof(path), "%s/stat", name);
+                fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                        return -1;
+        }
+
+        len = pread(fd, buf, sizeof(buf) - 1, 0);
+
+        if (node->fd < 0) {
+                if (len > 0 && scan->fd_used < scan->fd_budget) {
+                        node->fd = fd;
+                        scan->fd_used++;
+                } else
+                        close(fd);
+        }
+
+        if (len <= 0)
+                return -1;
+        buf[len] = '\0';
+
+        return proc_stat_parse(buf, entry);
+}
+
+/**
+ * @brief Records process that started or changed in the current scan
+ *
+ * @param scan process scanner
+ * @param node process node
+ */
+static void
+proc_scan_mark_changed(struct proc_scan *scan, struct proc_node *node)
+{
+        node->entry.changed = 1;
+
+        if (scan->num_changed == scan->max_changed) {
+                const unsigned max =
+                    scan->max_changed == 0 ? 64 : scan->max_changed * 2;
+                struct proc_scan_entry **changed;
+
+                changed = realloc(scan->changed, max * sizeof(changed[0]));
+                if (changed == NULL)
+                        return; /* entry still carries the changed flag */
+                scan->changed = changed;
+                scan->max_changed = max;
+        }
+
+        scan->changed[scan->num_changed++] = &node->entry;
+}
+
+/**
+ * @brief Removes processes that were not seen in the last scan
+ *
+ * @param scan process scanner
+ */
+static void
+proc_scan_sweep(struct proc_scan *scan)
+{
+        unsigned i;
+
+        for (i = 0; i < scan->num_buckets; i++) {
+                struct proc_node **pnode = &scan->buckets[i];
+
+                while (*pnode != NULL) {
+                        struct proc_node *node = *pnode;
+
+                        if (node->gen == scan->gen) {
+                                pnode = &node->next;
+                                continue;
+                        }
+
+                        *pnode = node->next;
+                        proc_node_free(scan, node);
+                        scan->num_procs--;
+                }
+        }
+}
+
+int
+proc_scan_update(struct proc_scan *scan)
+{
+        struct dirent *file;
+        uint64_t uptime;
+        DIR *dir;
+
+        if (scan == NULL)
+                return -1;
+
+        dir = opendir(scan->proc_dir);
+        if (dir == NULL)
+                return -1;
+
+        scan->gen++;
+        scan->num_changed = 0;
+        uptime = proc_scan_uptime(scan);
+
+        while ((file = readdir(dir)) != NULL) {
+                struct proc_scan_entry entry;
+                struct proc_node *node;
+                uint64_t lifetime;
+                struct stat st;
+                int changed = 1;
+                char *end;
+                pid_t pid;
+
+                if (file->d_type != DT_DIR && file->d_type != DT_UNKNOWN)
+                        continue;
+                if (file->d_name[0] < '1' || file->d_name[0] > '9')
+                        continue;
+                pid = (pid_t)strtoul(file->d_name, &end, 10);
+                if (*end != '\0')
+                        continue;
+
+                memset(&entry, 0, sizeof(entry));
+                entry.pid = pid;
+
+                node = proc_scan_find(scan, pid);
+                if (node == NULL) {
+                        node = calloc(1, sizeof(*node));
+                        if (node == NULL)
+                                break;
+                        node->fd = -1;
+                        node->entry.pid = pid;
+                        if (proc_stat_read(scan, dirfd(dir), file->d_name,
+                                           node, &entry) != 0) {
+                                proc_node_free(scan, node);
+                                continue;
+                        }
+                        if (scan->num_procs >= scan->num_buckets)
+                                proc_scan_grow(scan);
+                        node->next =
+                            scan->buckets[(unsigned)pid &
+                                          (scan->num_buckets - 1)];
+                        scan->buckets[(unsigned)pid &
+                                      (scan->num_buckets - 1)] = node;
+                        scan->num_procs++;
+                } else if (proc_stat_read(scan, dirfd(dir), file->d_name,
+                                          node, &entry) != 0)
+                        continue; /* removed by the sweep below */
+                else if (node->entry.starttime == entry.starttime &&
+                         entry.ticks >= node->entry.ticks) {
+                        /* different start time means the PID was reused */
+                        entry.ticks_delta = entry.ticks - node->entry.ticks;
+                        entry.valid = 1;
+                }
+
+                /* owner of the process directory is the process owner */
+                if (scan->track_uid) {
+                        if (fstatat(dirfd(dir), file->d_name, &st, 0) == 0)
+                                entry.uid = st.st_uid;
+                        else
+                                entry.uid = node->entry.uid;
+                }
+
+                if (node->gen != 0 &&
+                    node->entry.starttime == entry.starttime &&
+                    node->entry.ppid == entry.ppid &&
+                    node->entry.uid == entry.uid &&
+                    strcmp(node->entry.comm, entry.comm) == 0)
+                        changed = 0;
+
+                lifetime = 0;
+                if (uptime > entry.starttime)
+                        lifetime = (uptime - entry.starttime) / scan->clk_tck;
+                if (lifetime != 0)
+                        entry.cpu_avg_ratio = (double)entry.ticks / lifetime;
+
+                node->entry = entry;
+                node->gen = scan->gen;
+                if (changed)
+                        proc_scan_mark_changed(scan, node);
+        }
+
+        closedir(dir);
+
+        proc_scan_sweep(scan);
+
+        return 0;
+}
+
+/**
+ * @brief Compares CPU usage of two processes
+ *
+ * @param a process A
+ * @param b process B
+ *
+ * @return Comparison status
+ * @retval negative number when (a < b)
+ * @retval 0 when (a == b)
+ * @retval positive number when (a > b)
+ */
+static int
+proc_entry_cmp(const struct proc_scan_entry *a, const struct proc_scan_entry *b)
+{
+        if (a->ticks_delta != b->ticks_delta)
+                return a->ticks_delta < b->ticks_delta ? -1 : 1;
+        if (a->cpu_avg_ratio != b->cpu_avg_ratio)
+                return a->cpu_avg_ratio < b->cpu_avg_ratio ? -1 : 1;
+
+        return 0;
+}
+
+/**
+ * @brief Restores min-heap order below \a i
+ *
+ * @param heap heap table
+ * @param num number of heap elements
+ * @param i element to move down
+ */
+static void
+proc_heap_down(const struct proc_scan_entry **heap,
+               const unsigned num,
+               unsigned i)
+{
+        for (;;) {
+                unsigned min = i;
+                unsigned l = 2 * i + 1;
+                unsigned r = l + 1;
+                const struct proc_scan_entry *tmp;
+
+                if (l < num && proc_entry_cmp(heap[l], heap[min]) < 0)
+                        min = l;
+                if (r < num && proc_entry_cmp(heap[r], heap[min]) < 0)
+                        min = r;
+                if (min == i)
+                        return;
+
+                tmp = heap[i];
+                heap[i] = heap[min];
+                heap[min] = tmp;
+                i = min;
+        }
+}
+
+/**
+ * @brief Restores min-heap order above \a i
+ *
+ * @param heap heap table
+ * @param i element to move up
+ */
+static void
+proc_heap_up(const struct proc_scan_entry **heap, unsigned i)
+{
+        while (i > 0) {
+                const unsigned parent = (i - 1) / 2;
+                const struct proc_scan_entry *tmp;
+
+                if (proc_entry_cmp(heap[i], heap[parent]) >= 0)
+                        return;
+
+                tmp = heap[i];
+                heap[i] = heap[parent];
+                heap[parent] = tmp;
+                i = parent;
+        }
+}
+
+unsigned
+proc_scan_top(const struct proc_scan *scan,
+              const char *states,
+              struct proc_scan_entry *top,
+              const unsigned max)
+{
+        const struct proc_scan_entry **heap;
+        unsigned num = 0;
+        unsigned i;
+
+        if (scan == NULL || top == NULL || max == 0)
+                return 0;
+
+        heap = malloc(max * sizeof(heap[0]));
+        if (heap == NULL)
+                return 0;
+
+        /* min-heap keeps the best max processes seen so far */
+        for (i = 0; i < scan->num_buckets; i++) {
+                const struct proc_node *node;
+
+                for (node = scan->buckets[i]; node != NULL; node = node->next) {
+                        const struct proc_scan_entry *entry = &node->entry;
+
+                        if (!entry->valid)
+                                continue;
+                        if (states != NULL &&
+                            strchr(states, entry->state) == NULL)
+                                continue;
+
+                        if (num < max) {
+                                heap[num] = entry;
+                                proc_heap_up(heap, num++);
+                        } else if (proc_entry_cmp(entry, heap[0]) > 0) {
+                                heap[0] = entry;
+                                proc_heap_down(heap, num, 0);
+                        }
+                }
+        }
+
+        /* pop the smallest into the last free slot for descending order */
+        for (i = num; i > 0; i--) {
+                top[i - 1] = *heap[0];
+                heap[0] = heap[i - 1];
+                proc_heap_down(heap, i - 1, 0);
+        }
+
+        free(heap);
+
+        return num;
+}
+
+const struct proc_scan_entry *
+proc_scan_get(const struct proc_scan *scan, const pid_t pid)
+{
+        const struct proc_node *node;
+
+        if (scan == NULL)
+                return NULL;
+
+        node = proc_scan_find(scan, pid);
+
+        return node == NULL ? NULL : &node->entry;
+}
+
+const struct proc_scan_entry *
+proc_scan_next(const struct proc_scan *scan,
+               const struct proc_scan_entry *prev)
+{
+        const struct proc_node *node = NULL;
+        unsigned i = 0;
+
+        if (scan == NULL)
+                return NULL;
+
+        /* entry is the first member of the process node */
+        if (prev != NULL) {
+                node = ((const struct proc_node *)prev)->next;
+                i = ((unsigned)prev->pid & (scan->num_buckets - 1)) + 1;
+        }
+
+        while (node == NULL && i < scan->num_buckets)
+                node = scan->buckets[i++];
+
+        return node == NULL ? NULL : &node->entry;
+}
+
+const struct proc_scan_entry *const *
+proc_scan_changed(const struct proc_scan *scan, unsigned *num)
+{
+        if (scan == NULL || num == NULL)
+                return NULL;
+
+        *num = scan->num_changed;
+
+        return (const struct proc_scan_entry *const *)scan->changed;
+}
+
+int
+proc_scan_cmdline(const struct proc_scan *scan,
+                  const pid_t pid,
+                  char *buf,
+                  const size_t size)
+{
+        char path[PATH_MAX];
+        ssize_t len;
+        ssize_t i;
+        int fd;
+
+        if (scan == NULL || buf == NULL || size == 0)
+                return -1;
+
+        snprintf(path, sizeof(path), "%s/%d/cmdline", scan->proc_dir,
+                 (int)pid);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+                return -1;
+        len = read(fd, buf, size - 1);
+        close(fd);
+        if (len < 0)
+                return -1;
+
+        /* arguments are separated by NUL characters */
+        while (len > 0 && buf[len - 1] == '\0')
+                len--;
+        for (i = 0; i < len; i++)
+                if (buf[i] == '\0')
+                        buf[i] = ' ';
+        buf[len] = '\0';
+
+        return 0;
+}
+
+unsigned
+proc_scan_num(const struct proc_scan *scan)
+{
+        return scan == NULL ? 0 : scan->num_procs;
+}
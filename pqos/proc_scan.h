@@ -0,0 +1,207 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Incremental scanner of process statistics in /proc
+ *
+ * Scanner keeps a table of processes hashed by PID together with an open
+ * descriptor of their stat file, so a rescan costs one directory walk and
+ * a single read per process. Processes are identified by PID and start
+ * time, so a reused PID is detected as a new process.
+ */
+
+#ifndef __PROC_SCAN_H__
+#define __PROC_SCAN_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Process statistics
+ */
+struct proc_scan_entry {
+        pid_t pid;            /**< process id */
+        pid_t ppid;           /**< parent process id */
+        char comm[16];        /**< executable name */
+        char state;           /**< process state letter */
+        uint64_t starttime;   /**< start time [clock ticks after boot] */
+        uint64_t ticks;       /**< user and system CPU time [clock ticks] */
+        uint64_t ticks_delta; /**< CPU time since previous scan */
+        double cpu_avg_ratio; /**< CPU time per second of process life */
+        int valid;            /**< ticks_delta is valid */
+        uid_t uid;            /**< owner, see proc_scan_track_uid() */
+        int changed;          /**< started or changed in the last scan */
+};
+
+struct proc_scan;
+
+/**
+ * @brief Creates process scanner
+ *
+ * @param [in] proc_dir location of proc file system, usually "/proc"
+ *
+ * @return scanner or NULL on error
+ */
+struct proc_scan *proc_scan_create(const char *proc_dir);
+
+/**
+ * @brief Closes cached descriptors and frees the scanner
+ *
+ * @param [in] scan process scanner
+ */
+void proc_scan_destroy(struct proc_scan *scan);
+
+/**
+ * @brief Enables reading of process owners
+ *
+ * Owner is read from the process directory, which costs one extra system
+ * call per process and scan.
+ *
+ * @param [in] scan process scanner
+ */
+void proc_scan_track_uid(struct proc_scan *scan);
+
+/**
+ * @brief Sets maximum number of cached stat descriptors
+ *
+ * By default a quarter of the open files soft limit, at most 1024
+ * descriptors, is used. Processes above the budget have their stat file
+ * reopened on every scan. Descriptors above a lowered budget are closed.
+ *
+ * @param [in] scan process scanner
+ * @param [in] budget number of descriptors, 0 disables caching
+ */
+void proc_scan_set_fd_budget(struct proc_scan *scan, const unsigned budget);
+
+/**
+ * @brief Rescans processes
+ *
+ * New processes are added, exited ones are removed and CPU time deltas
+ * are updated for the processes seen by the previous scan. Processes that
+ * are new, reused a PID or changed their name, parent or owner are
+ * reported by proc_scan_changed().
+ *
+ * @param [in] scan process scanner
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int proc_scan_update(struct proc_scan *scan);
+
+/**
+ * @brief Selects processes with the highest CPU usage
+ *
+ * Processes are ordered by CPU time used since the previous scan and then
+ * by average CPU usage over their lifetime.
+ *
+ * @param [in] scan process scanner
+ * @param [in] states process states to consider e.g. "RSD"
+ * @param [out] top table for selected processes, highest usage first
+ * @param [in] max size of \a top table
+ *
+ * @return number of selected processes
+ */
+unsigned proc_scan_top(const struct proc_scan *scan,
+                       const char *states,
+                       struct proc_scan_entry *top,
+                       const unsigned max);
+
+/**
+ * @brief Looks up a process
+ *
+ * @param [in] scan process scanner
+ * @param [in] pid process id
+ *
+ * @return process statistics or NULL when the process is not tracked
+ */
+const struct proc_scan_entry *proc_scan_get(const struct proc_scan *scan,
+                                            const pid_t pid);
+
+/**
+ * @brief Iterates over tracked processes
+ *
+ * @param [in] scan process scanner
+ * @param [in] prev previous process or NULL to start the iteration
+ *
+ * @return next process or NULL at the end
+ */
+const struct proc_scan_entry *
+proc_scan_next(const struct proc_scan *scan,
+               const struct proc_scan_entry *prev);
+
+/**
+ * @brief Returns processes that started or changed in the last scan
+ *
+ * @param [in] scan process scanner
+ * @param [out] num number of changed processes
+ *
+ * @return table of changed processes, valid until the next update
+ */
+const struct proc_scan_entry *const *
+proc_scan_changed(const struct proc_scan *scan, unsigned *num);
+
+/**
+ * @brief Reads command line of a process
+ *
+ * @param [in] scan process scanner
+ * @param [in] pid process id
+ * @param [out] buf buffer for arguments separated by spaces
+ * @param [in] size buffer size, longer command lines are truncated
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 process is gone or its command line is not readable
+ */
+int proc_scan_cmdline(const struct proc_scan *scan,
+                      const pid_t pid,
+                      char *buf,
+                      const size_t size);
+
+/**
+ * @brief Returns number of tracked processes
+ *
+ * @param [in] scan process scanner
+ *
+ * @return number of processes
+ */
+unsigned proc_scan_num(const struct proc_scan *scan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROC_SCAN_H__ */
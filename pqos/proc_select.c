@@ -0,0 +1,470 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "proc_select.h"
+
+#include "common.h"
+
+#include <errno.h>
+#include <pwd.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PROC_SELECT_CMDLINE_MAX 4096 /**< command line bytes matched */
+
+/**
+ * Selector types
+ */
+enum proc_select_type {
+        PROC_SELECT_COMM,
+        PROC_SELECT_CMDLINE,
+        PROC_SELECT_USER,
+        PROC_SELECT_PPID,
+};
+
+/**
+ * Selected process
+ */
+struct proc_select_member {
+        pid_t pid;          /**< process id */
+        uint64_t starttime; /**< start time, detects PID reuse */
+};
+
+struct proc_select {
+        char *expr;                 /**< selector expression */
+        enum proc_select_type type; /**< selector type */
+        char comm[16];              /**< executable name */
+        regex_t regex;              /**< command line pattern */
+        uid_t uid;                  /**< process owner */
+        pid_t ppid;                 /**< parent process */
+        int descendants;            /**< select all descendants of ppid */
+        int resolved;               /**< all processes were evaluated */
+        struct proc_select_member *members; /**< sorted by pid */
+        pid_t *pids;                        /**< pids of members */
+        unsigned num;                       /**< number of members */
+        unsigned max;                       /**< size of member tables */
+};
+
+/**
+ * Expression prefixes, order matches enum proc_select_type
+ */
+static const char *const proc_select_prefix[] = {
+    "comm:",
+    "cmdline~",
+    "user:",
+    "ppid:",
+};
+
+int
+proc_select_is_expr(const char *str)
+{
+        unsigned i;
+
+        if (str == NULL)
+                return 0;
+
+        for (i = 0; i < DIM(proc_select_prefix); i++)
+                if (strncmp(str, proc_select_prefix[i],
+                            strlen(proc_select_prefix[i])) == 0)
+                        return 1;
+
+        return 0;
+}
+
+/**
+ * @brief Parses decimal number
+ *
+ * @param str string to parse
+ * @param [out] end first character after the number
+ * @param [out] value parsed number
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 not a number
+ */
+static int
+proc_select_num(const char *str, char **end, unsigned long *value)
+{
+        if (*str < '0' || *str > '9')
+                return -1;
+
+        errno = 0;
+        *value = strtoul(str, end, 10);
+        if (errno != 0 || *value > INT32_MAX)
+                return -1;
+
+        return 0;
+}
+
+/**
+ * @brief Parses argument of the selector
+ *
+ * @param sel process selector
+ * @param arg selector argument
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 invalid argument
+ */
+static int
+proc_select_parse(struct proc_select *sel, const char *arg)
+{
+        const struct passwd *pw;
+        unsigned long value;
+        char *end = NULL;
+        int ret;
+
+        switch (sel->type) {
+        case PROC_SELECT_COMM:
+                if (*arg == '\0' || strlen(arg) >= sizeof(sel->comm)) {
+                        printf("Process name has to be 1 to %u characters\n",
+                               (unsigned)sizeof(sel->comm) - 1);
+                        return -1;
+                }
+                strcpy(sel->comm, arg);
+                break;
+        case PROC_SELECT_CMDLINE:
+                ret = regcomp(&sel->regex, arg, REG_EXTENDED | REG_NOSUB);
+                if (ret != 0) {
+                        char err[128];
+
+                        regerror(ret, &sel->regex, err, sizeof(err));
+                        printf("Invalid regular expression '%s': %s\n", arg,
+                               err);
+                        return -1;
+                }
+                break;
+        case PROC_SELECT_USER:
+                pw = getpwnam(arg);
+                if (pw != NULL)
+                        sel->uid = pw->pw_uid;
+                else if (proc_select_num(arg, &end, &value) == 0 &&
+                         *end == '\0')
+                        sel->uid = (uid_t)value;
+                else {
+                        printf("Unknown user '%s'\n", arg);
+                        return -1;
+                }
+                break;
+        case PROC_SELECT_PPID:
+                if (proc_select_num(arg, &end, &value) != 0 || value == 0) {
+                        printf("Invalid parent process id '%s'\n", arg);
+                        return -1;
+                }
+                if (strcmp(end, "+descendants") == 0)
+                        sel->descendants = 1;
+                else if (*end != '\0') {
+                        printf("Invalid parent process id '%s'\n", arg);
+                        return -1;
+                }
+                sel->ppid = (pid_t)value;
+                break;
+        }
+
+        return 0;
+}
+
+struct proc_select *
+proc_select_create(const char *expr, struct proc_scan *scan)
+{
+        struct proc_select *sel;
+        unsigned i;
+
+        if (expr == NULL || scan == NULL)
+                return NULL;
+
+        for (i = 0; i < DIM(proc_select_prefix); i++)
+                if (strncmp(expr, proc_select_prefix[i],
+                            strlen(proc_select_prefix[i])) == 0)
+                        break;
+        if (i == DIM(proc_select_prefix)) {
+                printf("Invalid process selector '%s'\n", expr);
+                return NULL;
+        }
+
+        sel = calloc(1, sizeof(*sel));
+        if (sel == NULL)
+                return NULL;
+
+        sel->type = (enum proc_select_type)i;
+        if (proc_select_parse(sel, expr + strlen(proc_select_prefix[i])) !=
+            0) {
+                free(sel);
+                return NULL;
+        }
+
+        sel->expr = strdup(expr);
+        if (sel->expr == NULL) {
+                proc_select_destroy(sel);
+                return NULL;
+        }
+
+        if (sel->type == PROC_SELECT_USER)
+                proc_scan_track_uid(scan);
+
+        return sel;
+}
+
+void
+proc_select_destroy(struct proc_select *sel)
+{
+        if (sel == NULL)
+                return;
+
+        if (sel->type == PROC_SELECT_CMDLINE)
+                regfree(&sel->regex);
+        free(sel->members);
+        free(sel->pids);
+        free(sel->expr);
+        free(sel);
+}
+
+/**
+ * @brief Checks if the process matches the selector
+ *
+ * @param sel process selector
+ * @param scan process scanner
+ * @param entry process to check
+ *
+ * @return 1 on match, 0 otherwise
+ */
+static int
+proc_select_match(const struct proc_select *sel,
+                  const struct proc_scan *scan,
+                  const struct proc_scan_entry *entry)
+{
+        char cmdline[PROC_SELECT_CMDLINE_MAX];
+        unsigned depth;
+
+        /* never select the tool itself */
+        if (entry->pid == getpid())
+                return 0;
+
+        switch (sel->type) {
+        case PROC_SELECT_COMM:
+                return strcmp(entry->comm, sel->comm) == 0;
+        case PROC_SELECT_CMDLINE:
+                /* kernel threads have no command line */
+                if (proc_scan_cmdline(scan, entry->pid, cmdline,
+                                      sizeof(cmdline)) != 0 ||
+                    cmdline[0] == '\0')
+                        return 0;
+                return regexec(&sel->regex, cmdline, 0, NULL, 0) == 0;
+        case PROC_SELECT_USER:
+                return entry->uid == sel->uid;
+        case PROC_SELECT_PPID:
+                if (!sel->descendants)
+                        return entry->ppid == sel->ppid;
+                /* depth limit guards against a stale parent loop */
+                for (depth = proc_scan_num(scan); depth > 0; depth--) {
+                        if (entry->ppid == sel->ppid)
+                                return 1;
+                        entry = proc_scan_get(scan, entry->ppid);
+                        if (entry == NULL)
+                                return 0;
+                }
+                return 0;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Finds position of the process in the member table
+ *
+ * @param sel process selector
+ * @param pid process id
+ * @param [out] pos member index or insert position
+ *
+ * @return 1 when the process is a member, 0 otherwise
+ */
+static int
+proc_select_find(const struct proc_select *sel, const pid_t pid, unsigned *pos)
+{
+        unsigned lo = 0;
+        unsigned hi = sel->num;
+
+        while (lo < hi) {
+                const unsigned mid = lo + (hi - lo) / 2;
+
+                if (sel->members[mid].pid < pid)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        *pos = lo;
+
+        return lo < sel->num && sel->members[lo].pid == pid;
+}
+
+/**
+ * @brief Inserts a member at given position
+ *
+ * @param sel process selector
+ * @param pos insert position
+ * @param entry selected process
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 out of memory
+ */
+static int
+proc_select_insert(struct proc_select *sel,
+                   const unsigned pos,
+                   const struct proc_scan_entry *entry)
+{
+        if (sel->num == sel->max) {
+                const unsigned max = sel->max == 0 ? 16 : sel->max * 2;
+                struct proc_select_member *members;
+                pid_t *pids;
+
+                members = realloc(sel->members, max * sizeof(members[0]));
+                if (members == NULL)
+                        return -1;
+                sel->members = members;
+                pids = realloc(sel->pids, max * sizeof(pids[0]));
+                if (pids == NULL)
+                        return -1;
+                sel->pids = pids;
+                sel->max = max;
+        }
+
+        memmove(&sel->members[pos + 1], &sel->members[pos],
+                (sel->num - pos) * sizeof(sel->members[0]));
+        sel->members[pos].pid = entry->pid;
+        sel->members[pos].starttime = entry->starttime;
+        sel->num++;
+
+        return 0;
+}
+
+/**
+ * @brief Adds or removes a process depending on the match
+ *
+ * @param sel process selector
+ * @param scan process scanner
+ * @param entry process to evaluate
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 out of memory
+ */
+static int
+proc_select_eval(struct proc_select *sel,
+                 const struct proc_scan *scan,
+                 const struct proc_scan_entry *entry)
+{
+        const int match = proc_select_match(sel, scan, entry);
+        unsigned pos;
+
+        if (proc_select_find(sel, entry->pid, &pos)) {
+                if (match)
+                        sel->members[pos].starttime = entry->starttime;
+                else {
+                        sel->num--;
+                        memmove(&sel->members[pos], &sel->members[pos + 1],
+                                (sel->num - pos) * sizeof(sel->members[0]));
+                }
+                return 0;
+        }
+
+        return match ? proc_select_insert(sel, pos, entry) : 0;
+}
+
+int
+proc_select_update(struct proc_select *sel, const struct proc_scan *scan)
+{
+        const struct proc_scan_entry *const *changed;
+        const struct proc_scan_entry *entry;
+        unsigned num_changed;
+        unsigned i, j;
+
+        if (sel == NULL || scan == NULL)
+                return -1;
+
+        if (!sel->resolved) {
+                for (entry = proc_scan_next(scan, NULL); entry != NULL;
+                     entry = proc_scan_next(scan, entry))
+                        if (proc_select_eval(sel, scan, entry) != 0)
+                                return -1;
+                sel->resolved = 1;
+                goto out;
+        }
+
+        /*
+         * Drop processes that exited or reused PID. Descendants are
+         * re-checked as reparenting of an ancestor changes only the
+         * ancestor entry.
+         */
+        for (i = 0, j = 0; i < sel->num; i++) {
+                entry = proc_scan_get(scan, sel->members[i].pid);
+                if (entry == NULL ||
+                    entry->starttime != sel->members[i].starttime)
+                        continue;
+                if (sel->descendants && !proc_select_match(sel, scan, entry))
+                        continue;
+                sel->members[j++] = sel->members[i];
+        }
+        sel->num = j;
+
+        changed = proc_scan_changed(scan, &num_changed);
+        for (i = 0; i < num_changed; i++)
+                if (proc_select_eval(sel, scan, changed[i]) != 0)
+                        return -1;
+
+out:
+        for (i = 0; i < sel->num; i++)
+                sel->pids[i] = sel->members[i].pid;
+
+        return 0;
+}
+
+const pid_t *
+proc_select_pids(const struct proc_select *sel, unsigned *num)
+{
+        if (sel == NULL || num == NULL)
+                return NULL;
+
+        *num = sel->num;
+
+        return sel->pids;
+}
+
+const char *
+proc_select_expr(const struct proc_select *sel)
+{
+        return sel == NULL ? NULL : sel->expr;
+}
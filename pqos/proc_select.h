@@ -0,0 +1,130 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Process selector expressions
+ *
+ * Selector resolves to a set of processes and follows it as processes
+ * start, exit or change. Only processes reported as changed by the scanner
+ * are evaluated, so re-resolution does not depend on the size of the
+ * process table.
+ *
+ * Supported expressions:
+ * - comm:NAME              - executable name equal to NAME
+ * - cmdline~REGEX          - command line matching extended REGEX
+ * - user:NAME|UID          - processes owned by the user
+ * - ppid:PID               - children of PID
+ * - ppid:PID+descendants   - all descendants of PID
+ */
+
+#ifndef __PROC_SELECT_H__
+#define __PROC_SELECT_H__
+
+#include "proc_scan.h"
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct proc_select;
+
+/**
+ * @brief Checks if string is a selector expression rather than PID list
+ *
+ * @param [in] str string to check
+ *
+ * @return 1 for selector expression, 0 otherwise
+ */
+int proc_select_is_expr(const char *str);
+
+/**
+ * @brief Parses selector expression
+ *
+ * Errors are reported on the standard output.
+ *
+ * @param [in] expr selector expression
+ * @param [in] scan scanner used to resolve the selector
+ *
+ * @return selector or NULL on error
+ */
+struct proc_select *proc_select_create(const char *expr,
+                                       struct proc_scan *scan);
+
+/**
+ * @brief Frees the selector
+ *
+ * @param [in] sel process selector
+ */
+void proc_select_destroy(struct proc_select *sel);
+
+/**
+ * @brief Re-resolves the selector after a scanner update
+ *
+ * First call evaluates all tracked processes, subsequent calls evaluate
+ * processes changed in the last scan and drop processes that exited.
+ *
+ * @param [in] sel process selector
+ * @param [in] scan process scanner passed to proc_select_create()
+ *
+ * @return Operation status
+ * @retval 0 OK
+ * @retval -1 error
+ */
+int proc_select_update(struct proc_select *sel, const struct proc_scan *scan);
+
+/**
+ * @brief Returns selected processes
+ *
+ * @param [in] sel process selector
+ * @param [out] num number of processes
+ *
+ * @return table of process ids in ascending order, valid until the next
+ *         update
+ */
+const pid_t *proc_select_pids(const struct proc_select *sel, unsigned *num);
+
+/**
+ * @brief Returns the selector expression
+ *
+ * @param [in] sel process selector
+ *
+ * @return expression string
+ */
+const char *proc_select_expr(const struct proc_select *sel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROC_SELECT_H__ */
@@ -51,6 +51,8 @@ static const struct pqos_cpuinfo *m_cpu = NULL;
 static const struct pqos_capability *m_cap_l2ca = NULL;
 static const struct pqos_capability *m_cap_l3ca = NULL;
 static const struct pqos_capability *m_cap_mba = NULL;
+static unsigned m_pid_cos = 0;  /**< COS of the PID configuration */
+static int m_pid_cos_valid = 0; /**< PID configuration is applied */
 
 /**
  * @brief Prints L2, L3 or MBA configuration in \a cfg
@@ -1845,10 +1847,46 @@ cfg_set_pids(const unsigned technology,
 set_pids_exit:
         if (ret != 0)
                 (void)pqos_alloc_release_pid(p, num_pids);
+        else {
+                m_pid_cos = cos_id;
+                m_pid_cos_valid = 1;
+        }
 
         return ret;
 }
 
+int
+alloc_assign_pids(const pid_t *pids, const unsigned num_pids)
+{
+        unsigned i;
+        int ret = 0;
+
+        if (!m_pid_cos_valid)
+                return 0;
+
+        for (i = 0; i < num_pids; i++)
+                if (pqos_alloc_assoc_set_pid(pids[i], m_pid_cos) !=
+                    PQOS_RETVAL_OK)
+                        ret = -EFAULT;
+
+        if (ret == 0 && g_cfg.verbose)
+                print_pid_association(m_pid_cos, num_pids, pids);
+
+        return ret;
+}
+
+int
+alloc_release_pids(const pid_t *pids, const unsigned num_pids)
+{
+        if (!m_pid_cos_valid)
+                return 0;
+
+        if (pqos_alloc_release_pid(pids, num_pids) != PQOS_RETVAL_OK)
+                return -EFAULT;
+
+        return 0;
+}
+
 int
 alloc_configure(void)
 {
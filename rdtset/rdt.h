@@ -118,6 +118,32 @@ int parse_iface(const char *iface);
  */
 int alloc_configure(void);
 
+/**
+ * @brief Associates PIDs with the COS of the applied PID configuration
+ *
+ * Does nothing when no PID configuration was applied.
+ *
+ * @param [in] pids PIDs to associate
+ * @param [in] num_pids number of PIDs
+ *
+ * @return status
+ * @retval 0 on success
+ * @retval negative on error (-errno)
+ */
+int alloc_assign_pids(const pid_t *pids, const unsigned num_pids);
+
+/**
+ * @brief Associates PIDs with COS#0 if a PID configuration was applied
+ *
+ * @param [in] pids PIDs to release
+ * @param [in] num_pids number of PIDs
+ *
+ * @return status
+ * @retval 0 on success
+ * @retval negative on error (-errno)
+ */
+int alloc_release_pids(const pid_t *pids, const unsigned num_pids);
+
 /*
  * @brief Resets COS association (assign COS#0) on listed CPUs
  *
@@ -33,6 +33,7 @@
 #include "common.h"
 #include "cpu.h"
 #include "mba_sc.h"
+#include "proc_select.h"
 #include "rdt.h"
 
 #include <errno.h>
@@ -230,6 +231,16 @@ print_usage(char *prgname, unsigned short_usage)
                "specify CPUs (affinity)\n"
                " -p <pidlist>, --pid <pidlist>                 "
                "operate on existing given pid\n"
+               "                                       "
+               "<pidlist> can be a process selector: comm:NAME,\n"
+               "                                       "
+               "cmdline~REGEX, user:NAME|UID, ppid:PID or\n"
+               "                                       "
+               "ppid:PID+descendants. rdtset then stays running and\n"
+               "                                       "
+               "applies the configuration to matching processes\n"
+               "                                       "
+               "as they start, until interrupted\n"
                " -r <cpulist>, --reset <cpulist>       "
                "reset allocation for CPUs\n"
                " -k, --sudokeep                        "
@@ -318,6 +329,10 @@ print_usage(char *prgname, unsigned short_usage)
         printf("Example PID configuration strings:\n"
                "    --iface os -t 'l3=0xf' -p 23187,567-570\n"
                "        Specified processes use four L3 cache-ways (mask 0xf)\n"
+               "    --iface os -t 'l3=0xf' -c 2-3 -p comm:nginx\n"
+               "        All nginx processes, including ones started later, "
+               "use four L3\n"
+               "        cache-ways (mask 0xf) and run on CPUs 2-3\n"
                "    --iface os -t 'mba=50' -k memtester 10M\n"
                "        Restrict memory B/W availability to 50%% for the "
                "memtester application (using PID allocation)\n\n");
@@ -384,6 +399,141 @@ validate_args(const int f_r,
                (f_i && f_n && f_p && !cmd) || f_w;
 }
 
+#define PID_SELECT_REFRESH_SEC 1 /**< process selector refresh period */
+
+/**
+ * Process scanner and selector for -p selector expressions
+ */
+static struct proc_scan *pid_scan = NULL;
+static struct proc_select *pid_select = NULL;
+
+/**
+ * Signal that stops following the process selector, 0 if none
+ */
+static volatile sig_atomic_t pid_select_signum = 0;
+
+/**
+ * @brief Parse process selector and add matching PIDs to PID table
+ *
+ * @param expr process selector expression
+ *
+ * @return Operation status
+ * @retval 0 on success
+ * @retval negative on error
+ */
+static int
+parse_pid_select(const char *expr)
+{
+        const pid_t *pids;
+        unsigned num, i;
+
+        if (pid_select != NULL || g_cfg.pid_count != 0) {
+                fprintf(stderr, "Process selector cannot be combined with "
+                                "other PIDs!\n");
+                return -EINVAL;
+        }
+
+        pid_scan = proc_scan_create("/proc");
+        if (pid_scan == NULL)
+                return -ENOMEM;
+        pid_select = proc_select_create(expr, pid_scan);
+        if (pid_select == NULL)
+                return -EINVAL;
+
+        if (proc_scan_update(pid_scan) != 0 ||
+            proc_select_update(pid_select, pid_scan) != 0) {
+                fprintf(stderr, "Failed to resolve process selector!\n");
+                return -EFAULT;
+        }
+
+        pids = proc_select_pids(pid_select, &num);
+        if (num == 0) {
+                fprintf(stderr, "No process matches '%s'!\n", expr);
+                return -EINVAL;
+        }
+        if (num > RDT_MAX_PIDS)
+                fprintf(stderr,
+                        "Too many PIDs selected! "
+                        "Using first %d...\n",
+                        (int)RDT_MAX_PIDS);
+
+        for (i = 0; i < num && i < RDT_MAX_PIDS; i++)
+                g_cfg.pids[g_cfg.pid_count++] = pids[i];
+
+        return 0;
+}
+
+/**
+ * @brief Compares two PIDs
+ *
+ * @param [in] a PID A
+ * @param [in] b PID B
+ *
+ * @return PID compare status for ascending order
+ */
+static int
+pid_cmp(const void *a, const void *b)
+{
+        const pid_t pa = *(const pid_t *)a;
+        const pid_t pb = *(const pid_t *)b;
+
+        return (pa > pb) - (pa < pb);
+}
+
+/**
+ * @brief Re-resolves process selector and updates selected PIDs
+ *
+ * Processes that no longer match are released, new matching processes
+ * are associated with the PID configuration COS and moved to the CPUs
+ * selected with -c.
+ */
+static void
+pid_select_refresh(void)
+{
+        const pid_t *pids;
+        unsigned num, i, j;
+
+        if (proc_scan_update(pid_scan) != 0 ||
+            proc_select_update(pid_select, pid_scan) != 0)
+                return;
+
+        pids = proc_select_pids(pid_select, &num);
+
+        /* exited processes fail to release, which is harmless */
+        for (i = 0, j = 0; i < g_cfg.pid_count; i++) {
+                if (bsearch(&g_cfg.pids[i], pids, num, sizeof(*pids),
+                            pid_cmp) != NULL) {
+                        g_cfg.pids[j++] = g_cfg.pids[i];
+                        continue;
+                }
+                (void)alloc_release_pids(&g_cfg.pids[i], 1);
+                if (g_cfg.verbose)
+                        printf("PID: Process %d left\n", (int)g_cfg.pids[i]);
+        }
+        g_cfg.pid_count = j;
+
+        for (i = 0; i < num; i++) {
+                for (j = 0; j < g_cfg.pid_count; j++)
+                        if (g_cfg.pids[j] == pids[i])
+                                break;
+                if (j < g_cfg.pid_count)
+                        continue;
+                if (g_cfg.pid_count == RDT_MAX_PIDS)
+                        break;
+
+                if (alloc_assign_pids(&pids[i], 1) != 0)
+                        continue; /* exited meanwhile */
+                if (0 != CPU_COUNT(&g_cfg.cpu_aff_cpuset) &&
+                    0 != set_affinity(pids[i]))
+                        fprintf(stderr, "Failed to set core affinity for pid "
+                                        "%d!\n",
+                                (int)pids[i]);
+                g_cfg.pids[g_cfg.pid_count++] = pids[i];
+                if (g_cfg.verbose)
+                        printf("PID: Process %d joined\n", (int)pids[i]);
+        }
+}
+
 /**
  * @brief Parse selected PIDs and add to PID table
  *
@@ -402,6 +552,15 @@ parse_pids(char *pidstr)
         if (pidstr == NULL)
                 return -EINVAL;
 
+        if (proc_select_is_expr(pidstr))
+                return parse_pid_select(pidstr);
+
+        if (pid_select != NULL) {
+                fprintf(stderr, "Process selector cannot be combined with "
+                                "other PIDs!\n");
+                return -EINVAL;
+        }
+
         n = strlisttotab(pidstr, pids, DIM(pids));
         if (n == 0)
                 return -EINVAL;
@@ -560,6 +719,52 @@ signal_handler(int signum)
         }
 }
 
+/**
+ * @brief Signal handler used while following the process selector
+ *
+ * Refresh makes library calls under the API lock, clean-up is left to
+ * the main loop.
+ *
+ * @param [in] signum signal
+ */
+static void
+pid_select_signal_handler(int signum)
+{
+        pid_select_signum = signum;
+}
+
+/**
+ * @brief Follows processes matching the selector until signalled
+ *
+ * Reverts settings and exits with the status expected for the signal.
+ */
+static void
+pid_select_follow(void)
+{
+        const int signum_list[] = {SIGINT, SIGTERM};
+        unsigned i;
+        int signum;
+
+        for (i = 0; i < DIM(signum_list); i++)
+                signal(signum_list[i], pid_select_signal_handler);
+
+        while (pid_select_signum == 0) {
+                /* returns early once signal is delivered */
+                sleep(PID_SELECT_REFRESH_SEC);
+                if (pid_select_signum == 0)
+                        pid_select_refresh();
+        }
+
+        signum = (int)pid_select_signum;
+        printf("\nRDTSET: Signal %d received, preparing to exit...\n", signum);
+
+        rdtset_exit();
+
+        /* exit with the expected status */
+        signal(signum, SIG_DFL);
+        kill(getpid(), signum);
+}
+
 /**
  * @brief Initialize rdtset submodules
  *
@@ -727,6 +932,14 @@ main(int argc, char **argv)
                         }
         }
 
+        /* follow processes matching the selector until signalled */
+        if (pid_select != NULL && !mba_sc_mode(&g_cfg)) {
+                if (g_cfg.verbose)
+                        printf("PID: Following processes matching '%s'...\n",
+                               proc_select_expr(pid_select));
+                pid_select_follow();
+        }
+
         if (mba_sc_mode(&g_cfg)) {
                 mba_sc_main(child);
 
@@ -0,0 +1,552 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Converts binary pqos monitoring output into CSV or JSON
+ */
+
+#include "monitor_bin.h"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define MAX_COLUMNS 64
+
+enum output_format {
+        FORMAT_CSV,
+        FORMAT_JSON,
+};
+
+struct column {
+        uint64_t event;
+        unsigned decimals;
+        char *name;
+};
+
+struct group {
+        uint64_t mask;
+        char *desc;
+        int64_t value[MAX_COLUMNS];
+};
+
+static struct {
+        enum output_format format;
+        unsigned mode;
+        unsigned interval;
+        struct column columns[MAX_COLUMNS];
+        unsigned num_columns;
+        struct group *groups;
+        unsigned num_groups;
+        int64_t time;
+        char time_str[64];
+} conv;
+
+/**
+ * @brief Reads unsigned LEB128 value
+ *
+ * @param fp input file
+ * @param [out] val decoded value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+get_uint(FILE *fp, uint64_t *val)
+{
+        unsigned shift = 0;
+        int byte;
+
+        *val = 0;
+        do {
+                byte = fgetc(fp);
+                if (byte == EOF || shift > 63)
+                        return -1;
+                *val |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+        } while (byte & 0x80);
+
+        return 0;
+}
+
+/**
+ * @brief Reads zigzag encoded signed value
+ *
+ * @param fp input file
+ * @param [out] val decoded value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+get_int(FILE *fp, int64_t *val)
+{
+        uint64_t raw;
+
+        if (get_uint(fp, &raw) != 0)
+                return -1;
+
+        *val = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+
+        return 0;
+}
+
+/**
+ * @brief Reads length prefixed string
+ *
+ * @param fp input file
+ *
+ * @return allocated string or NULL on error
+ */
+static char *
+get_str(FILE *fp)
+{
+        uint64_t len;
+        char *str;
+
+        if (get_uint(fp, &len) != 0 || len > 4096)
+                return NULL;
+
+        str = calloc(len + 1, 1);
+        if (str == NULL)
+                return NULL;
+
+        if (fread(str, 1, len, fp) != len) {
+                free(str);
+                return NULL;
+        }
+
+        return str;
+}
+
+/**
+ * @brief Prints string escaped for CSV or JSON double quoted value
+ *
+ * @param out output file
+ * @param str string to print
+ */
+static void
+put_quoted(FILE *out, const char *str)
+{
+        fputc('"', out);
+        for (; *str != '\0'; str++) {
+                if (*str == '"')
+                        fputc(conv.format == FORMAT_CSV ? '"' : '\\', out);
+                else if (*str == '\\' && conv.format == FORMAT_JSON)
+                        fputc('\\', out);
+                fputc(*str, out);
+        }
+        fputc('"', out);
+}
+
+/**
+ * @brief Prints value of the column
+ *
+ * @param out output file
+ * @param column column definition
+ * @param val scaled column value
+ */
+static void
+put_value(FILE *out, const struct column *column, int64_t val)
+{
+        double value = (double)val;
+        unsigned i;
+
+        for (i = 0; i < column->decimals; i++)
+                value /= 10;
+
+        fprintf(out, "%.*f", (int)column->decimals, value);
+}
+
+/**
+ * @brief Returns name of the group column for the monitoring mode
+ */
+static const char *
+group_label(void)
+{
+        switch (conv.mode) {
+        case MONITOR_BIN_MODE_PID:
+                return "PID";
+        case MONITOR_BIN_MODE_UNCORE:
+                return "Socket";
+        default:
+                return "Core";
+        }
+}
+
+/**
+ * @brief Reads and validates stream header
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_header(FILE *fp)
+{
+        char magic[MONITOR_BIN_MAGIC_LEN];
+        uint64_t val;
+        unsigned i;
+
+        if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+            memcmp(magic, MONITOR_BIN_MAGIC, sizeof(magic)) != 0) {
+                fprintf(stderr, "Not a pqos binary monitoring file\n");
+                return -1;
+        }
+
+        if (get_uint(fp, &val) != 0 || val != MONITOR_BIN_VERSION) {
+                fprintf(stderr, "Unsupported format version\n");
+                return -1;
+        }
+
+        if (get_uint(fp, &val) != 0)
+                return -1;
+        conv.mode = (unsigned)val;
+        if (get_uint(fp, &val) != 0)
+                return -1;
+        conv.interval = (unsigned)val;
+        if (get_uint(fp, &val) != 0 || val > MAX_COLUMNS)
+                return -1;
+        conv.num_columns = (unsigned)val;
+
+        for (i = 0; i < conv.num_columns; i++) {
+                struct column *column = &conv.columns[i];
+
+                if (get_uint(fp, &column->event) != 0)
+                        return -1;
+                if (get_uint(fp, &val) != 0 || val > 9)
+                        return -1;
+                column->decimals = (unsigned)val;
+                column->name = get_str(fp);
+                if (column->name == NULL)
+                        return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Prints CSV header line
+ *
+ * @param out output file
+ */
+static void
+print_header(FILE *out)
+{
+        unsigned i;
+
+        if (conv.format != FORMAT_CSV)
+                return;
+
+        fprintf(out, "Time,%s", group_label());
+        for (i = 0; i < conv.num_columns; i++)
+                fprintf(out, ",%s", conv.columns[i].name);
+        fputs("\n", out);
+}
+
+/**
+ * @brief Handles time record
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_time(FILE *fp)
+{
+        int64_t delta;
+        struct tm tm;
+        time_t sec;
+        size_t len;
+
+        if (get_int(fp, &delta) != 0)
+                return -1;
+
+        conv.time += delta;
+        sec = (time_t)(conv.time / 1000);
+        if (localtime_r(&sec, &tm) == NULL)
+                return -1;
+
+        len = strftime(conv.time_str, sizeof(conv.time_str),
+                       "%Y-%m-%d %H:%M:%S", &tm);
+        snprintf(conv.time_str + len, sizeof(conv.time_str) - len, ".%03d",
+                 (int)(conv.time % 1000));
+
+        return 0;
+}
+
+/**
+ * @brief Handles group definition record
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_group(FILE *fp)
+{
+        struct group *groups;
+        uint64_t idx;
+        uint64_t mask;
+        char *desc;
+
+        if (get_uint(fp, &idx) != 0 || idx != conv.num_groups)
+                return -1;
+        if (get_uint(fp, &mask) != 0)
+                return -1;
+        desc = get_str(fp);
+        if (desc == NULL)
+                return -1;
+
+        groups = realloc(conv.groups, (idx + 1) * sizeof(*groups));
+        if (groups == NULL) {
+                free(desc);
+                return -1;
+        }
+        conv.groups = groups;
+        memset(&groups[idx], 0, sizeof(groups[idx]));
+        groups[idx].mask = mask;
+        groups[idx].desc = desc;
+        conv.num_groups++;
+
+        return 0;
+}
+
+/**
+ * @brief Handles row record and prints it
+ *
+ * @param fp input file
+ * @param out output file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_row(FILE *fp, FILE *out)
+{
+        struct group *group;
+        uint64_t idx;
+        unsigned i;
+
+        if (get_uint(fp, &idx) != 0 || idx >= conv.num_groups)
+                return -1;
+        group = &conv.groups[idx];
+
+        for (i = 0; i < conv.num_columns; i++) {
+                int64_t delta;
+
+                if (!(group->mask & conv.columns[i].event))
+                        continue;
+                if (get_int(fp, &delta) != 0)
+                        return -1;
+                group->value[i] += delta;
+        }
+
+        if (conv.format == FORMAT_CSV) {
+                fprintf(out, "%s,", conv.time_str);
+                put_quoted(out, group->desc);
+                for (i = 0; i < conv.num_columns; i++) {
+                        fputc(',', out);
+                        if (group->mask & conv.columns[i].event)
+                                put_value(out, &conv.columns[i],
+                                          group->value[i]);
+                }
+                fputs("\n", out);
+                return 0;
+        }
+
+        fprintf(out, "{\"time\":\"%s\",", conv.time_str);
+        put_quoted(out, group_label());
+        fputc(':', out);
+        put_quoted(out, group->desc);
+        for (i = 0; i < conv.num_columns; i++) {
+                if (!(group->mask & conv.columns[i].event))
+                        continue;
+                fputc(',', out);
+                put_quoted(out, conv.columns[i].name);
+                fputc(':', out);
+                put_value(out, &conv.columns[i], group->value[i]);
+        }
+        fputs("}\n", out);
+
+        return 0;
+}
+
+/**
+ * @brief Converts the stream
+ *
+ * @param fp input file
+ * @param out output file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+convert(FILE *fp, FILE *out)
+{
+        if (read_header(fp) != 0)
+                return -1;
+
+        print_header(out);
+
+        for (;;) {
+                int tag = fgetc(fp);
+                int ret;
+
+                switch (tag) {
+                case MONITOR_BIN_REC_TIME:
+                        ret = read_time(fp);
+                        break;
+                case MONITOR_BIN_REC_GROUP:
+                        ret = read_group(fp);
+                        break;
+                case MONITOR_BIN_REC_ROW:
+                        ret = read_row(fp, out);
+                        break;
+                case MONITOR_BIN_REC_END:
+                        return 0;
+                case EOF:
+                        /* pqos was terminated before the end record */
+                        return 0;
+                default:
+                        ret = -1;
+                        break;
+                }
+
+                if (ret != 0 && feof(fp))
+                        /* last record was not completely written */
+                        return 0;
+                if (ret != 0) {
+                        fprintf(stderr, "Corrupted record at offset %ld\n",
+                                ftell(fp));
+                        return -1;
+                }
+        }
+}
+
+/**
+ * @brief Prints help
+ *
+ * @param name program name
+ */
+static void
+usage(const char *name)
+{
+        printf("Usage: %s [-f csv|json] [-o OUTPUT] [FILE]\n"
+               "Converts pqos binary monitoring output "
+               "(pqos -u bin) to CSV or JSON.\n"
+               "  -f FORMAT, --format=FORMAT\n"
+               "          output FORMAT, csv (default) or json "
+               "(one object per line)\n"
+               "  -o OUTPUT, --output=OUTPUT\n"
+               "          write to OUTPUT file instead of stdout\n"
+               "  -h, --help\n"
+               "          print this help\n"
+               "FILE defaults to stdin.\n",
+               name);
+}
+
+static const struct option long_opts[] = {
+    {"format", required_argument, 0, 'f'},
+    {"output", required_argument, 0, 'o'},
+    {"help", no_argument, 0, 'h'},
+    {0, 0, 0, 0}};
+
+int
+main(int argc, char **argv)
+{
+        FILE *fp = stdin;
+        FILE *out = stdout;
+        const char *output = NULL;
+        unsigned i;
+        int ret;
+        int opt;
+
+        while ((opt = getopt_long(argc, argv, "f:o:h", long_opts, NULL)) !=
+               -1) {
+                switch (opt) {
+                case 'f':
+                        if (strcasecmp(optarg, "csv") == 0)
+                                conv.format = FORMAT_CSV;
+                        else if (strcasecmp(optarg, "json") == 0)
+                                conv.format = FORMAT_JSON;
+                        else {
+                                fprintf(stderr, "Invalid format '%s'\n",
+                                        optarg);
+                                return EXIT_FAILURE;
+                        }
+                        break;
+                case 'o':
+                        output = optarg;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (optind < argc) {
+                fp = fopen(argv[optind], "rb");
+                if (fp == NULL) {
+                        perror(argv[optind]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (output != NULL) {
+                out = fopen(output, "w");
+                if (out == NULL) {
+                        perror(output);
+                        if (fp != stdin)
+                                fclose(fp);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        ret = convert(fp, out);
+
+        for (i = 0; i < conv.num_columns; i++)
+                free(conv.columns[i].name);
+        for (i = 0; i < conv.num_groups; i++)
+                free(conv.groups[i].desc);
+        free(conv.groups);
+
+        if (fp != stdin)
+                fclose(fp);
+        if (out != stdout)
+                fclose(out);
+
+        return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,979 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @brief Replays raw pqos counter recordings
+ *
+ * Rates are recomputed from recorded counter increments, so a recording
+ * can be aggregated over any multiple of its sampling interval and by
+ * socket, L3 cache or class of service without access to the hardware.
+ */
+
+#include "monitor_bin.h"
+#include "monitor_raw.h"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define NS_PER_SEC 1000000000ull
+#define NS_PER_MS  1000000ull
+
+enum output_format {
+        FORMAT_CSV,
+        FORMAT_JSON,
+};
+
+enum group_by {
+        GROUP_BY_GROUP,
+        GROUP_BY_SOCKET,
+        GROUP_BY_L3,
+        GROUP_BY_COS,
+        GROUP_BY_ALL,
+};
+
+/**
+ * Output columns, IPC is derived from instructions and cycles fields
+ */
+enum column_id {
+        COL_LLC = 0,
+        COL_MBL,
+        COL_MBT,
+        COL_MBR,
+        COL_IPC,
+        COL_LLC_MISS,
+        COL_LLC_REF,
+        COL_PCIE_MISS_READ,
+        COL_PCIE_MISS_WRITE,
+        COL_PCIE_REF_READ,
+        COL_PCIE_REF_WRITE,
+        COL_NUM
+};
+
+static const struct {
+        enum pqos_mon_event event;
+        int decimals;
+        const char *name;
+} columns[COL_NUM] = {
+    {PQOS_MON_EVENT_L3_OCCUP, 1, "LLC[KB]"},
+    {PQOS_MON_EVENT_LMEM_BW, 1, "MBL[MB/s]"},
+    {PQOS_MON_EVENT_TMEM_BW, 1, "MBT[MB/s]"},
+    {PQOS_MON_EVENT_RMEM_BW, 1, "MBR[MB/s]"},
+    {PQOS_PERF_EVENT_IPC, 2, "IPC"},
+    {PQOS_PERF_EVENT_LLC_MISS, 0, "LLC Misses"},
+    {PQOS_PERF_EVENT_LLC_REF, 0, "LLC References"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_READ, 0, "LLC Misses Read"},
+    {PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE, 0, "LLC Misses Write"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_READ, 0, "LLC References Read"},
+    {PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE, 0, "LLC References Write"},
+};
+
+/**
+ * Events of the recorded row fields
+ */
+static const enum pqos_mon_event field_event[MONITOR_RAW_FIELD_NUM] = {
+    PQOS_MON_EVENT_L3_OCCUP,
+    PQOS_MON_EVENT_LMEM_BW,
+    PQOS_MON_EVENT_TMEM_BW,
+    PQOS_MON_EVENT_RMEM_BW,
+    PQOS_PERF_EVENT_IPC,
+    PQOS_PERF_EVENT_IPC,
+    PQOS_PERF_EVENT_LLC_MISS,
+    PQOS_PERF_EVENT_LLC_REF,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_MISS_PCIE_WRITE,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_READ,
+    PQOS_PERF_EVENT_LLC_REF_PCIE_WRITE,
+};
+
+struct core {
+        unsigned lcore;
+        unsigned socket;
+        unsigned l3_id;
+};
+
+struct group {
+        uint64_t mask;
+        char *desc;
+        int socket; /**< socket of the first core, -1 if unknown */
+        int l3_id;  /**< L3 id of the first core, -1 if unknown */
+        unsigned key;
+};
+
+/**
+ * Aggregation key state
+ */
+struct key {
+        char *name;
+        uint64_t mask;                       /**< events of the groups */
+        uint64_t sum[MONITOR_RAW_FIELD_NUM]; /**< window totals */
+        double stat_sum[COL_NUM];            /**< sum over windows */
+        double stat_max[COL_NUM];            /**< max over windows */
+        unsigned windows;                    /**< windows with data */
+        int active;                          /**< data in this window */
+};
+
+static struct {
+        enum output_format format;
+        enum group_by group_by;
+        int summary;
+        uint64_t window; /**< aggregation window [ns], 0 - interval */
+        unsigned mode;
+        uint64_t interval; /**< sampling interval [ns] */
+        struct core *cores;
+        unsigned num_cores;
+        struct group *groups;
+        unsigned num_groups;
+        struct key *keys;
+        unsigned num_keys;
+        uint64_t col_mask; /**< events of the printed columns */
+        int header_done;
+        uint64_t monotonic;   /**< time of the last sample [ns] */
+        int64_t realtime;     /**< time of the last sample [ns] */
+        uint64_t win_begin;   /**< window start [ns] */
+        unsigned win_samples; /**< samples in the current window */
+        unsigned samples;
+        char time_str[64];
+} replay;
+
+/**
+ * @brief Reads unsigned LEB128 value
+ *
+ * @param fp input file
+ * @param [out] val decoded value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+get_uint(FILE *fp, uint64_t *val)
+{
+        unsigned shift = 0;
+        int byte;
+
+        *val = 0;
+        do {
+                byte = fgetc(fp);
+                if (byte == EOF || shift > 63)
+                        return -1;
+                *val |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+        } while (byte & 0x80);
+
+        return 0;
+}
+
+/**
+ * @brief Reads zigzag encoded signed value
+ *
+ * @param fp input file
+ * @param [out] val decoded value
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+get_int(FILE *fp, int64_t *val)
+{
+        uint64_t raw;
+
+        if (get_uint(fp, &raw) != 0)
+                return -1;
+
+        *val = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+
+        return 0;
+}
+
+/**
+ * @brief Reads length prefixed string
+ *
+ * @param fp input file
+ *
+ * @return allocated string or NULL on error
+ */
+static char *
+get_str(FILE *fp)
+{
+        uint64_t len;
+        char *str;
+
+        if (get_uint(fp, &len) != 0 || len > 4096)
+                return NULL;
+
+        str = calloc(len + 1, 1);
+        if (str == NULL)
+                return NULL;
+
+        if (fread(str, 1, len, fp) != len) {
+                free(str);
+                return NULL;
+        }
+
+        return str;
+}
+
+/**
+ * @brief Prints string escaped for CSV or JSON double quoted value
+ *
+ * @param out output file
+ * @param str string to print
+ */
+static void
+put_quoted(FILE *out, const char *str)
+{
+        fputc('"', out);
+        for (; *str != '\0'; str++) {
+                if (*str == '"')
+                        fputc(replay.format == FORMAT_CSV ? '"' : '\\', out);
+                else if (*str == '\\' && replay.format == FORMAT_JSON)
+                        fputc('\\', out);
+                fputc(*str, out);
+        }
+        fputc('"', out);
+}
+
+/**
+ * @brief Returns name of the key column
+ */
+static const char *
+key_label(void)
+{
+        switch (replay.group_by) {
+        case GROUP_BY_SOCKET:
+                return "Socket";
+        case GROUP_BY_L3:
+                return "L3";
+        case GROUP_BY_COS:
+                return "COS";
+        case GROUP_BY_ALL:
+                return "All";
+        default:
+                break;
+        }
+
+        switch (replay.mode) {
+        case MONITOR_BIN_MODE_PID:
+                return "PID";
+        case MONITOR_BIN_MODE_UNCORE:
+                return "Socket";
+        default:
+                return "Core";
+        }
+}
+
+/**
+ * @brief Finds aggregation key, adding it when not seen before
+ *
+ * @param name key name
+ * @param mask events of the group
+ *
+ * @return key index or -1 on error
+ */
+static int
+key_get(const char *name, const uint64_t mask)
+{
+        struct key *keys;
+        unsigned i;
+
+        for (i = 0; i < replay.num_keys; i++)
+                if (strcmp(replay.keys[i].name, name) == 0) {
+                        replay.keys[i].mask |= mask;
+                        return i;
+                }
+
+        keys = realloc(replay.keys, (replay.num_keys + 1) * sizeof(*keys));
+        if (keys == NULL)
+                return -1;
+        replay.keys = keys;
+        memset(&keys[i], 0, sizeof(keys[i]));
+        keys[i].name = strdup(name);
+        if (keys[i].name == NULL)
+                return -1;
+        keys[i].mask = mask;
+        replay.num_keys++;
+
+        return i;
+}
+
+/**
+ * @brief Assigns aggregation key to the group
+ *
+ * @param group monitoring group
+ * @param class_id class of service, -1 if unknown
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+group_set_key(struct group *group, const int class_id)
+{
+        char name[32];
+        const char *key = name;
+        int idx;
+
+        switch (replay.group_by) {
+        case GROUP_BY_SOCKET:
+                if (group->socket < 0)
+                        key = "unknown";
+                else
+                        snprintf(name, sizeof(name), "%d", group->socket);
+                break;
+        case GROUP_BY_L3:
+                if (group->l3_id < 0)
+                        key = "unknown";
+                else
+                        snprintf(name, sizeof(name), "%d", group->l3_id);
+                break;
+        case GROUP_BY_COS:
+                if (class_id < 0)
+                        key = "unknown";
+                else
+                        snprintf(name, sizeof(name), "%d", class_id);
+                break;
+        case GROUP_BY_ALL:
+                key = "all";
+                break;
+        default:
+                key = group->desc;
+                break;
+        }
+
+        idx = key_get(key, group->mask);
+        if (idx < 0)
+                return -1;
+        group->key = (unsigned)idx;
+
+        return 0;
+}
+
+/**
+ * @brief Reads and validates stream header
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_header(FILE *fp)
+{
+        char magic[MONITOR_RAW_MAGIC_LEN];
+        uint64_t val;
+        unsigned i;
+
+        if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+            memcmp(magic, MONITOR_RAW_MAGIC, sizeof(magic)) != 0) {
+                fprintf(stderr, "Not a pqos raw monitoring file\n");
+                return -1;
+        }
+
+        if (get_uint(fp, &val) != 0 || val != MONITOR_RAW_VERSION) {
+                fprintf(stderr, "Unsupported format version\n");
+                return -1;
+        }
+
+        if (get_uint(fp, &val) != 0)
+                return -1;
+        replay.mode = (unsigned)val;
+        if (get_uint(fp, &val) != 0 || val == 0)
+                return -1;
+        replay.interval = val * NS_PER_MS;
+        /* L3 size is not needed, LLC is reported in kilobytes */
+        if (get_uint(fp, &val) != 0)
+                return -1;
+        if (get_uint(fp, &val) != 0 || val > 65536)
+                return -1;
+        replay.num_cores = (unsigned)val;
+
+        replay.cores = calloc(replay.num_cores + 1, sizeof(replay.cores[0]));
+        if (replay.cores == NULL)
+                return -1;
+
+        for (i = 0; i < replay.num_cores; i++) {
+                struct core *core = &replay.cores[i];
+
+                if (get_uint(fp, &val) != 0)
+                        return -1;
+                core->lcore = (unsigned)val;
+                if (get_uint(fp, &val) != 0)
+                        return -1;
+                core->socket = (unsigned)val;
+                if (get_uint(fp, &val) != 0)
+                        return -1;
+                core->l3_id = (unsigned)val;
+        }
+
+        if (replay.window == 0)
+                replay.window = replay.interval;
+
+        return 0;
+}
+
+/**
+ * @brief Handles group definition record
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_group(FILE *fp)
+{
+        struct group *groups;
+        struct group *group;
+        uint64_t idx;
+        uint64_t num;
+        uint64_t val;
+        unsigned i;
+
+        if (get_uint(fp, &idx) != 0 || idx != replay.num_groups)
+                return -1;
+
+        groups = realloc(replay.groups, (idx + 1) * sizeof(*groups));
+        if (groups == NULL)
+                return -1;
+        replay.groups = groups;
+        group = &groups[idx];
+        memset(group, 0, sizeof(*group));
+        group->socket = -1;
+        group->l3_id = -1;
+
+        if (get_uint(fp, &group->mask) != 0)
+                return -1;
+        group->desc = get_str(fp);
+        if (group->desc == NULL)
+                return -1;
+        replay.num_groups++;
+
+        if (get_uint(fp, &num) != 0)
+                return -1;
+        for (i = 0; i < num; i++) {
+                unsigned j;
+
+                if (get_uint(fp, &val) != 0)
+                        return -1;
+                if (i > 0 || replay.mode != MONITOR_BIN_MODE_CORE)
+                        continue;
+                for (j = 0; j < replay.num_cores; j++)
+                        if (replay.cores[j].lcore == val) {
+                                group->socket = replay.cores[j].socket;
+                                group->l3_id = replay.cores[j].l3_id;
+                                break;
+                        }
+        }
+
+        /* uncore groups are described by the socket id */
+        if (replay.mode == MONITOR_BIN_MODE_UNCORE)
+                group->socket = atoi(group->desc);
+
+        return group_set_key(group, -1);
+}
+
+/**
+ * @brief Handles class of service association record
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_class(FILE *fp)
+{
+        uint64_t idx;
+        uint64_t class_id;
+
+        if (get_uint(fp, &idx) != 0 || idx >= replay.num_groups)
+                return -1;
+        if (get_uint(fp, &class_id) != 0)
+                return -1;
+
+        if (replay.group_by != GROUP_BY_COS)
+                return 0;
+
+        return group_set_key(&replay.groups[idx], (int)class_id);
+}
+
+/**
+ * @brief Handles row record
+ *
+ * @param fp input file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_row(FILE *fp)
+{
+        struct group *group;
+        struct key *key;
+        uint64_t idx;
+        unsigned i;
+
+        if (get_uint(fp, &idx) != 0 || idx >= replay.num_groups)
+                return -1;
+        group = &replay.groups[idx];
+        key = &replay.keys[group->key];
+
+        for (i = 0; i < MONITOR_RAW_FIELD_NUM; i++) {
+                uint64_t val;
+
+                if (!(group->mask & field_event[i]))
+                        continue;
+                if (get_uint(fp, &val) != 0)
+                        return -1;
+                key->sum[i] += val;
+        }
+        key->active = 1;
+
+        return 0;
+}
+
+/**
+ * @brief Computes column values of the key for the window
+ *
+ * @param key aggregation key
+ * @param elapsed window length [ns]
+ * @param [out] value column values
+ */
+static void
+key_values(const struct key *key, const uint64_t elapsed, double *value)
+{
+        const double sec = (double)elapsed / NS_PER_SEC;
+        const double mb = 1024.0 * 1024.0;
+        const uint64_t *sum = key->sum;
+
+        value[COL_LLC] = (double)sum[MONITOR_RAW_FIELD_LLC] / 1024.0 /
+                         replay.win_samples;
+        value[COL_MBL] = (double)sum[MONITOR_RAW_FIELD_MBL] / mb / sec;
+        value[COL_MBT] = (double)sum[MONITOR_RAW_FIELD_MBT] / mb / sec;
+        value[COL_MBR] = (double)sum[MONITOR_RAW_FIELD_MBR] / mb / sec;
+        value[COL_IPC] = 0.0;
+        if (sum[MONITOR_RAW_FIELD_CYCLES] != 0)
+                value[COL_IPC] = (double)sum[MONITOR_RAW_FIELD_INSTRUCTIONS] /
+                                 (double)sum[MONITOR_RAW_FIELD_CYCLES];
+        value[COL_LLC_MISS] = (double)sum[MONITOR_RAW_FIELD_LLC_MISS];
+        value[COL_LLC_REF] = (double)sum[MONITOR_RAW_FIELD_LLC_REF];
+        value[COL_PCIE_MISS_READ] =
+            (double)sum[MONITOR_RAW_FIELD_PCIE_MISS_READ];
+        value[COL_PCIE_MISS_WRITE] =
+            (double)sum[MONITOR_RAW_FIELD_PCIE_MISS_WRITE];
+        value[COL_PCIE_REF_READ] = (double)sum[MONITOR_RAW_FIELD_PCIE_REF_READ];
+        value[COL_PCIE_REF_WRITE] =
+            (double)sum[MONITOR_RAW_FIELD_PCIE_REF_WRITE];
+}
+
+/**
+ * @brief Prints single output row
+ *
+ * @param out output file
+ * @param time time column
+ * @param key aggregation key
+ * @param value column values
+ */
+static void
+print_row(FILE *out,
+          const char *time,
+          const struct key *key,
+          const double *value)
+{
+        unsigned i;
+
+        if (!replay.header_done) {
+                unsigned j;
+
+                /* all groups are defined before the first window ends */
+                for (j = 0; j < replay.num_keys; j++)
+                        replay.col_mask |= replay.keys[j].mask;
+                if (replay.format == FORMAT_CSV) {
+                        fprintf(out, "Time,%s", key_label());
+                        for (j = 0; j < COL_NUM; j++)
+                                if (replay.col_mask & columns[j].event)
+                                        fprintf(out, ",%s", columns[j].name);
+                        fputs("\n", out);
+                }
+                replay.header_done = 1;
+        }
+
+        if (replay.format == FORMAT_CSV) {
+                fprintf(out, "%s,", time);
+                put_quoted(out, key->name);
+        } else {
+                fprintf(out, "{\"time\":\"%s\",", time);
+                put_quoted(out, key_label());
+                fputc(':', out);
+                put_quoted(out, key->name);
+        }
+
+        for (i = 0; i < COL_NUM; i++) {
+                const int decimals = columns[i].decimals;
+
+                if (!(replay.col_mask & columns[i].event))
+                        continue;
+                if (replay.format == FORMAT_CSV) {
+                        fputc(',', out);
+                        if (key->mask & columns[i].event)
+                                fprintf(out, "%.*f", decimals, value[i]);
+                        continue;
+                }
+                if (!(key->mask & columns[i].event))
+                        continue;
+                fputc(',', out);
+                put_quoted(out, columns[i].name);
+                fprintf(out, ":%.*f", decimals, value[i]);
+        }
+
+        fputs(replay.format == FORMAT_CSV ? "\n" : "}\n", out);
+}
+
+/**
+ * @brief Formats time of the last sample
+ */
+static void
+format_time(void)
+{
+        struct tm tm;
+        time_t sec;
+        size_t len;
+
+        sec = (time_t)(replay.realtime / (int64_t)NS_PER_SEC);
+        if (localtime_r(&sec, &tm) == NULL) {
+                replay.time_str[0] = '\0';
+                return;
+        }
+
+        len = strftime(replay.time_str, sizeof(replay.time_str),
+                       "%Y-%m-%d %H:%M:%S", &tm);
+        snprintf(replay.time_str + len, sizeof(replay.time_str) - len, ".%03d",
+                 (int)((replay.realtime / (int64_t)NS_PER_MS) % 1000));
+}
+
+/**
+ * @brief Emits and resets the current aggregation window
+ *
+ * @param out output file
+ */
+static void
+flush_window(FILE *out)
+{
+        const uint64_t elapsed = replay.monotonic - replay.win_begin;
+        unsigned i;
+
+        if (replay.win_samples == 0 || elapsed == 0)
+                return;
+
+        format_time();
+
+        for (i = 0; i < replay.num_keys; i++) {
+                struct key *key = &replay.keys[i];
+                double value[COL_NUM];
+                unsigned j;
+
+                if (!key->active)
+                        continue;
+
+                key_values(key, elapsed, value);
+                if (!replay.summary)
+                        print_row(out, replay.time_str, key, value);
+
+                for (j = 0; j < COL_NUM; j++) {
+                        key->stat_sum[j] += value[j];
+                        if (key->windows == 0 || value[j] > key->stat_max[j])
+                                key->stat_max[j] = value[j];
+                }
+                key->windows++;
+                memset(key->sum, 0, sizeof(key->sum));
+                key->active = 0;
+        }
+
+        replay.win_begin = replay.monotonic;
+        replay.win_samples = 0;
+}
+
+/**
+ * @brief Handles sample record
+ *
+ * @param fp input file
+ * @param out output file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+read_sample(FILE *fp, FILE *out)
+{
+        uint64_t monotonic;
+        int64_t realtime;
+
+        if (get_uint(fp, &monotonic) != 0 || get_int(fp, &realtime) != 0)
+                return -1;
+
+        if (replay.samples > 0 &&
+            replay.monotonic - replay.win_begin + replay.interval / 2 >=
+                replay.window)
+                flush_window(out);
+
+        replay.monotonic += monotonic;
+        replay.realtime += realtime;
+
+        /* counters of the first poll cover about one interval */
+        if (replay.samples == 0 && replay.monotonic > replay.interval)
+                replay.win_begin = replay.monotonic - replay.interval;
+        replay.samples++;
+        replay.win_samples++;
+
+        return 0;
+}
+
+/**
+ * @brief Prints average and maximum of every key over all windows
+ *
+ * @param out output file
+ */
+static void
+print_summary(FILE *out)
+{
+        unsigned i;
+
+        for (i = 0; i < replay.num_keys; i++) {
+                struct key *key = &replay.keys[i];
+                double avg[COL_NUM];
+                unsigned j;
+
+                if (key->windows == 0)
+                        continue;
+
+                for (j = 0; j < COL_NUM; j++)
+                        avg[j] = key->stat_sum[j] / key->windows;
+
+                print_row(out, "avg", key, avg);
+                print_row(out, "max", key, key->stat_max);
+        }
+}
+
+/**
+ * @brief Replays the recording
+ *
+ * @param fp input file
+ * @param out output file
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+replay_stream(FILE *fp, FILE *out)
+{
+        if (read_header(fp) != 0)
+                return -1;
+
+        for (;;) {
+                int tag = fgetc(fp);
+                int ret;
+
+                switch (tag) {
+                case MONITOR_RAW_REC_SAMPLE:
+                        ret = read_sample(fp, out);
+                        break;
+                case MONITOR_RAW_REC_GROUP:
+                        ret = read_group(fp);
+                        break;
+                case MONITOR_RAW_REC_CLASS:
+                        ret = read_class(fp);
+                        break;
+                case MONITOR_RAW_REC_ROW:
+                        ret = read_row(fp);
+                        break;
+                case MONITOR_RAW_REC_END:
+                case EOF:
+                        /* EOF - pqos was terminated before the end record */
+                        ret = 1;
+                        break;
+                default:
+                        ret = -1;
+                        break;
+                }
+
+                if (ret > 0 || (ret != 0 && feof(fp)))
+                        /* last record might not be completely written */
+                        break;
+                if (ret != 0) {
+                        fprintf(stderr, "Corrupted record at offset %ld\n",
+                                ftell(fp));
+                        return -1;
+                }
+        }
+
+        flush_window(out);
+        if (replay.summary)
+                print_summary(out);
+
+        return 0;
+}
+
+/**
+ * @brief Prints help
+ *
+ * @param name program name
+ */
+static void
+usage(const char *name)
+{
+        printf("Usage: %s [-g KEY] [-i INTERVAL] [-s] [-f csv|json] "
+               "[-o OUTPUT] [FILE]\n"
+               "Replays pqos raw counter recording (pqos -u raw).\n"
+               "  -g KEY, --group-by=KEY\n"
+               "          aggregate monitoring groups by KEY: group "
+               "(default),\n"
+               "          socket, l3, cos or all\n"
+               "  -i INTERVAL, --interval=INTERVAL\n"
+               "          aggregation window in milliseconds, rounded to\n"
+               "          recorded samples (default: sampling interval)\n"
+               "  -s, --summary\n"
+               "          print average and maximum of every key instead "
+               "of\n"
+               "          per window values\n"
+               "  -f FORMAT, --format=FORMAT\n"
+               "          output FORMAT, csv (default) or json "
+               "(one object per line)\n"
+               "  -o OUTPUT, --output=OUTPUT\n"
+               "          write to OUTPUT file instead of stdout\n"
+               "  -h, --help\n"
+               "          print this help\n"
+               "FILE defaults to stdin.\n",
+               name);
+}
+
+static const struct option long_opts[] = {
+    {"group-by", required_argument, 0, 'g'},
+    {"interval", required_argument, 0, 'i'},
+    {"summary", no_argument, 0, 's'},
+    {"format", required_argument, 0, 'f'},
+    {"output", required_argument, 0, 'o'},
+    {"help", no_argument, 0, 'h'},
+    {0, 0, 0, 0}};
+
+int
+main(int argc, char **argv)
+{
+        static const char *const group_by[] = {"group", "socket", "l3", "cos",
+                                               "all"};
+        FILE *fp = stdin;
+        FILE *out = stdout;
+        const char *output = NULL;
+        unsigned long interval;
+        char *endptr;
+        unsigned i;
+        int ret;
+        int opt;
+
+        while ((opt = getopt_long(argc, argv, "g:i:sf:o:h", long_opts,
+                                  NULL)) != -1) {
+                switch (opt) {
+                case 'g':
+                        for (i = 0; i < sizeof(group_by) / sizeof(group_by[0]);
+                             i++)
+                                if (strcasecmp(optarg, group_by[i]) == 0)
+                                        break;
+                        if (i == sizeof(group_by) / sizeof(group_by[0])) {
+                                fprintf(stderr, "Invalid key '%s'\n", optarg);
+                                return EXIT_FAILURE;
+                        }
+                        replay.group_by = (enum group_by)i;
+                        break;
+                case 'i':
+                        interval = strtoul(optarg, &endptr, 10);
+                        if (*optarg == '\0' || *endptr != '\0' ||
+                            interval == 0) {
+                                fprintf(stderr, "Invalid interval '%s'\n",
+                                        optarg);
+                                return EXIT_FAILURE;
+                        }
+                        replay.window = (uint64_t)interval * NS_PER_MS;
+                        break;
+                case 's':
+                        replay.summary = 1;
+                        break;
+                case 'f':
+                        if (strcasecmp(optarg, "csv") == 0)
+                                replay.format = FORMAT_CSV;
+                        else if (strcasecmp(optarg, "json") == 0)
+                                replay.format = FORMAT_JSON;
+                        else {
+                                fprintf(stderr, "Invalid format '%s'\n",
+                                        optarg);
+                                return EXIT_FAILURE;
+                        }
+                        break;
+                case 'o':
+                        output = optarg;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (optind < argc) {
+                fp = fopen(argv[optind], "rb");
+                if (fp == NULL) {
+                        perror(argv[optind]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (output != NULL) {
+                out = fopen(output, "w");
+                if (out == NULL) {
+                        perror(output);
+                        if (fp != stdin)
+                                fclose(fp);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        ret = replay_stream(fp, out);
+
+        for (i = 0; i < replay.num_keys; i++)
+                free(replay.keys[i].name);
+        free(replay.keys);
+        for (i = 0; i < replay.num_groups; i++)
+                free(replay.groups[i].desc);
+        free(replay.groups);
+        free(replay.cores);
+
+        if (fp != stdin)
+                fclose(fp);
+        if (out != stdout)
+                fclose(out);
+
+        return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -33,6 +33,7 @@
 #include "cpu_registers.h"
 #include "cpuinfo.h"
 #include "pqos.h"
+#include "topology.h"
 
 #include <setjmp.h>
 #include <stdarg.h>
@@ -89,7 +90,7 @@ test_cpuinfo_init(struct test_data *data)
 
         data->cpu = cpu;
 
-        return 0;
+        return topo_init(cpu) == PQOS_RETVAL_OK ? 0 : -1;
 }
 
 static inline int
@@ -205,8 +206,10 @@ test_fini(void **state)
         struct test_data *data = (struct test_data *)*state;
 
         if (data != NULL) {
-                if (data->cpu != NULL)
+                if (data->cpu != NULL) {
+                        topo_fini();
                         free(data->cpu);
+                }
                 if (data->cap != NULL)
                         free(data->cap);
                 if (data->cap_mon != NULL)
@@ -575,6 +575,251 @@ test_pqos_alloc_assign_pid_param(void **state __attribute__((unused)))
         assert_int_equal(ret, PQOS_RETVAL_PARAM);
 }
 
+/* ======== pqos_alloc_swap ======== */
+
+static void
+test_pqos_alloc_swap_init(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_alloc_cos cfg;
+        unsigned core_array[] = {1};
+        pid_t task_array[] = {1};
+        unsigned class_id;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        wrap_check_init(1, PQOS_RETVAL_INIT);
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+
+        wrap_check_init(1, PQOS_RETVAL_INIT);
+        ret = pqos_alloc_swap_pid(&cfg, task_array, DIM(task_array),
+                                  &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+}
+
+static void
+test_pqos_alloc_swap_param(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_alloc_cos cfg;
+        struct pqos_l3ca l3ca;
+        unsigned core_array[] = {1};
+        pid_t task_array[] = {1};
+        unsigned class_id;
+
+        memset(&cfg, 0, sizeof(cfg));
+        memset(&l3ca, 0, sizeof(l3ca));
+
+        ret = pqos_alloc_swap(NULL, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_alloc_swap(&cfg, NULL, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_alloc_swap(&cfg, core_array, 0, &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_alloc_swap_pid(&cfg, NULL, DIM(task_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        /* zero bit mask */
+        cfg.l3ca = &l3ca;
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_alloc_swap_os(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_alloc_cos cfg;
+        struct pqos_l3ca l3ca;
+        struct pqos_l2ca l2ca;
+        struct pqos_mba mba;
+        struct cpuinfo_config config;
+        unsigned core_array[] = {0, 1};
+        unsigned technology = (1 << PQOS_CAP_TYPE_L3CA) |
+                              (1 << PQOS_CAP_TYPE_L2CA) |
+                              (1 << PQOS_CAP_TYPE_MBA);
+        unsigned class_id;
+        unsigned i;
+
+        memset(&l3ca, 0, sizeof(l3ca));
+        memset(&l2ca, 0, sizeof(l2ca));
+        memset(&mba, 0, sizeof(mba));
+        memset(&config, 0, sizeof(config));
+        l3ca.u.ways_mask = 0xf;
+        l2ca.u.ways_mask = 0x3;
+        mba.mb_max = 50;
+        config.mba_max = 100;
+        cfg.l3ca = &l3ca;
+        cfg.l2ca = &l2ca;
+        cfg.mba = &mba;
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        will_return(__wrap__pqos_get_cap, data->cap);
+        will_return_always(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap_cpuinfo_get_config, &config);
+
+        for (i = 0; i < DIM(core_array); i++) {
+                expect_value(__wrap_os_alloc_assoc_get, lcore, core_array[i]);
+                expect_any(__wrap_os_alloc_assoc_get, class_id);
+                will_return(__wrap_os_alloc_assoc_get, PQOS_RETVAL_OK);
+                will_return(__wrap_os_alloc_assoc_get, 1);
+        }
+
+        expect_value(__wrap_os_alloc_cos_unused, technology, technology);
+        expect_value(__wrap_os_alloc_cos_unused, core_array, core_array);
+        expect_value(__wrap_os_alloc_cos_unused, core_num, DIM(core_array));
+        expect_value(__wrap_os_alloc_cos_unused, class_id, &class_id);
+        will_return(__wrap_os_alloc_cos_unused, PQOS_RETVAL_OK);
+        will_return(__wrap_os_alloc_cos_unused, 5);
+
+        /* new class is programmed before cores are moved */
+        expect_value(__wrap_os_l3ca_set, l3cat_id, 0);
+        expect_value(__wrap_os_l3ca_set, num_cos, 1);
+        expect_any(__wrap_os_l3ca_set, ca);
+        will_return(__wrap_os_l3ca_set, PQOS_RETVAL_OK);
+
+        expect_value(__wrap_os_l2ca_set, l2id, 0);
+        expect_value(__wrap_os_l2ca_set, num_cos, 1);
+        expect_any(__wrap_os_l2ca_set, ca);
+        will_return(__wrap_os_l2ca_set, PQOS_RETVAL_OK);
+
+        expect_value(__wrap_os_mba_set, mba_id, 0);
+        expect_value(__wrap_os_mba_set, num_cos, 1);
+        expect_any(__wrap_os_mba_set, requested);
+        expect_value(__wrap_os_mba_set, actual, NULL);
+        will_return(__wrap_os_mba_set, PQOS_RETVAL_OK);
+
+        for (i = 0; i < DIM(core_array); i++) {
+                expect_value(__wrap_os_alloc_assoc_set, lcore, core_array[i]);
+                expect_value(__wrap_os_alloc_assoc_set, class_id, 5);
+                will_return(__wrap_os_alloc_assoc_set, PQOS_RETVAL_OK);
+        }
+
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(class_id, 5);
+}
+
+static void
+test_pqos_alloc_swap_os_shared(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_alloc_cos cfg;
+        unsigned core_array[] = {0, 1};
+        unsigned class_id;
+        unsigned i;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        will_return(__wrap__pqos_get_cap, data->cap);
+
+        /* cores use different classes */
+        for (i = 0; i < DIM(core_array); i++) {
+                expect_value(__wrap_os_alloc_assoc_get, lcore, core_array[i]);
+                expect_any(__wrap_os_alloc_assoc_get, class_id);
+                will_return(__wrap_os_alloc_assoc_get, PQOS_RETVAL_OK);
+                will_return(__wrap_os_alloc_assoc_get, i);
+        }
+
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_alloc_swap_os_rollback(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_alloc_cos cfg;
+        struct pqos_l3ca l3ca;
+        struct pqos_l2ca l2ca;
+        struct pqos_mba mba;
+        unsigned core_array[] = {0, 1};
+        unsigned class_id;
+        unsigned i;
+
+        memset(&l3ca, 0, sizeof(l3ca));
+        memset(&l2ca, 0, sizeof(l2ca));
+        memset(&mba, 0, sizeof(mba));
+        l3ca.u.ways_mask = 0xf;
+        l2ca.u.ways_mask = 0x3;
+        mba.ctrl = 1;
+        mba.mb_max = 1000;
+        cfg.l3ca = &l3ca;
+        cfg.l2ca = &l2ca;
+        cfg.mba = &mba;
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        will_return(__wrap__pqos_get_cap, data->cap);
+        will_return_always(__wrap__pqos_get_cpu, data->cpu);
+
+        for (i = 0; i < DIM(core_array); i++) {
+                expect_value(__wrap_os_alloc_assoc_get, lcore, core_array[i]);
+                expect_any(__wrap_os_alloc_assoc_get, class_id);
+                will_return(__wrap_os_alloc_assoc_get, PQOS_RETVAL_OK);
+                will_return(__wrap_os_alloc_assoc_get, 2);
+        }
+
+        expect_any(__wrap_os_alloc_cos_unused, technology);
+        expect_any(__wrap_os_alloc_cos_unused, core_array);
+        expect_any(__wrap_os_alloc_cos_unused, core_num);
+        expect_any(__wrap_os_alloc_cos_unused, class_id);
+        will_return(__wrap_os_alloc_cos_unused, PQOS_RETVAL_OK);
+        will_return(__wrap_os_alloc_cos_unused, 5);
+
+        expect_any(__wrap_os_l3ca_set, l3cat_id);
+        expect_any(__wrap_os_l3ca_set, num_cos);
+        expect_any(__wrap_os_l3ca_set, ca);
+        will_return(__wrap_os_l3ca_set, PQOS_RETVAL_OK);
+        expect_any(__wrap_os_l2ca_set, l2id);
+        expect_any(__wrap_os_l2ca_set, num_cos);
+        expect_any(__wrap_os_l2ca_set, ca);
+        will_return(__wrap_os_l2ca_set, PQOS_RETVAL_OK);
+        expect_any(__wrap_os_mba_set, mba_id);
+        expect_any(__wrap_os_mba_set, num_cos);
+        expect_any(__wrap_os_mba_set, requested);
+        expect_any(__wrap_os_mba_set, actual);
+        will_return(__wrap_os_mba_set, PQOS_RETVAL_OK);
+
+        expect_value(__wrap_os_alloc_assoc_set, lcore, 0);
+        expect_value(__wrap_os_alloc_assoc_set, class_id, 5);
+        will_return(__wrap_os_alloc_assoc_set, PQOS_RETVAL_OK);
+        expect_value(__wrap_os_alloc_assoc_set, lcore, 1);
+        expect_value(__wrap_os_alloc_assoc_set, class_id, 5);
+        will_return(__wrap_os_alloc_assoc_set, PQOS_RETVAL_ERROR);
+
+        /* core 0 is moved back */
+        expect_value(__wrap_os_alloc_assoc_set, lcore, 0);
+        expect_value(__wrap_os_alloc_assoc_set, class_id, 2);
+        will_return(__wrap_os_alloc_assoc_set, PQOS_RETVAL_OK);
+
+        ret = pqos_alloc_swap(&cfg, core_array, DIM(core_array), &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+static void
+test_pqos_alloc_swap_pid_hw(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_alloc_cos cfg;
+        pid_t task_array[] = {1};
+        unsigned class_id;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+
+        ret = pqos_alloc_swap_pid(&cfg, task_array, DIM(task_array),
+                                  &class_id);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+}
+
 /* ======== pqos_alloc_release_pid ======== */
 
 static void
@@ -1632,6 +1877,24 @@ test_pqos_mon_reset_hw(void **state __attribute__((unused)))
         assert_int_equal(ret, PQOS_RETVAL_OK);
 }
 
+/* ======== pqos_mon_reclaim ======== */
+
+static void
+test_pqos_mon_reclaim_hw(void **state __attribute__((unused)))
+{
+        unsigned num = 0;
+        int ret;
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+
+        will_return(__wrap_hw_mon_reclaim, PQOS_RETVAL_OK);
+        will_return(__wrap_hw_mon_reclaim, 2);
+
+        ret = pqos_mon_reclaim(&num);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(num, 2);
+}
+
 /* ======== pqos_mon_assoc_get ======== */
 
 static void
@@ -1911,12 +2174,76 @@ test_pqos_mon_poll(void **state __attribute__((unused)))
         wrap_check_init(1, PQOS_RETVAL_OK);
 
         expect_value(__wrap_pqos_mon_poll_events, group, &group);
+        expect_value(__wrap_pqos_mon_poll_events, events,
+                     PQOS_MON_EVENT_LMEM_BW);
         will_return(__wrap_pqos_mon_poll_events, PQOS_RETVAL_OK);
 
         ret = pqos_mon_poll(groups, num_groups);
         assert_int_equal(ret, PQOS_RETVAL_OK);
 }
 
+/* ======== pqos_mon_poll_subset ======== */
+
+static void
+test_pqos_mon_poll_subset(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_mon_data group[2];
+        struct pqos_mon_data *groups[] = {&group[0], &group[1]};
+
+        memset(group, 0, sizeof(group));
+        group[0].valid = 0x00DEAD00;
+        group[0].event = PQOS_MON_EVENT_L3_OCCUP | PQOS_MON_EVENT_LMEM_BW;
+        group[1].valid = 0x00DEAD00;
+        group[1].event = PQOS_MON_EVENT_L3_OCCUP;
+
+        /* group not monitoring the events is skipped */
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        expect_value(__wrap_pqos_mon_poll_events, group, &group[0]);
+        expect_value(__wrap_pqos_mon_poll_events, events,
+                     PQOS_MON_EVENT_LMEM_BW);
+        will_return(__wrap_pqos_mon_poll_events, PQOS_RETVAL_OK);
+
+        ret = pqos_mon_poll_subset(groups, DIM(groups),
+                                   PQOS_MON_EVENT_LMEM_BW);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        expect_value(__wrap_pqos_mon_poll_events, group, &group[0]);
+        expect_value(__wrap_pqos_mon_poll_events, events,
+                     PQOS_MON_EVENT_L3_OCCUP);
+        will_return(__wrap_pqos_mon_poll_events, PQOS_RETVAL_OK);
+        expect_value(__wrap_pqos_mon_poll_events, group, &group[1]);
+        expect_value(__wrap_pqos_mon_poll_events, events,
+                     PQOS_MON_EVENT_L3_OCCUP);
+        will_return(__wrap_pqos_mon_poll_events, PQOS_RETVAL_OK);
+
+        ret = pqos_mon_poll_subset(groups, DIM(groups),
+                                   PQOS_MON_EVENT_L3_OCCUP);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_mon_poll_subset_param(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+
+        memset(&group, 0, sizeof(group));
+        group.valid = 0x00DEAD00;
+        group.event = PQOS_MON_EVENT_LMEM_BW;
+
+        ret = pqos_mon_poll_subset(groups, 1, (enum pqos_mon_event)0);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_poll_subset(NULL, 1, PQOS_MON_EVENT_LMEM_BW);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_poll_subset(groups, 0, PQOS_MON_EVENT_LMEM_BW);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
 static void
 test_pqos_mon_poll_param(void **state __attribute__((unused)))
 {
@@ -2705,6 +3032,110 @@ test_pqos_mon_get_ipc(void **state __attribute__((unused)))
         assert_int_equal(value, group.values.ipc);
 }
 
+/* ======== pqos_mon_get_values ======== */
+
+static void
+test_pqos_mon_get_values_init(void **state __attribute__((unused)))
+{
+        int ret;
+        uint64_t llc;
+        struct pqos_mon_values values;
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+
+        memset(&group, 0, sizeof(group));
+        group.valid = 0x00DEAD00;
+        memset(&values, 0, sizeof(values));
+        values.llc = &llc;
+
+        wrap_check_init(1, PQOS_RETVAL_INIT);
+
+        ret = pqos_mon_get_values(groups, DIM(groups), &values);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+}
+
+static void
+test_pqos_mon_get_values_param(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_mon_values values;
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+        struct pqos_mon_data *null_groups[] = {NULL};
+
+        memset(&group, 0, sizeof(group));
+        memset(&values, 0, sizeof(values));
+
+        ret = pqos_mon_get_values(NULL, 1, &values);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_get_values(groups, 0, &values);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_get_values(groups, 1, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_get_values(null_groups, 1, &values);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        /* group not started */
+        ret = pqos_mon_get_values(groups, 1, &values);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_mon_get_values(void **state __attribute__((unused)))
+{
+        int ret;
+        unsigned i;
+        struct pqos_mon_data_internal intl[2];
+        struct pqos_mon_data group[2];
+        struct pqos_mon_data *groups[] = {&group[0], &group[1]};
+        struct pqos_mon_values values;
+        uint64_t llc[2];
+        double mbl[2];
+        double mbt[2];
+        double ipc[2];
+        uint64_t misses[2];
+
+        memset(group, 0, sizeof(group));
+        memset(intl, 0, sizeof(intl));
+        group[0].valid = 0x00DEAD00;
+        group[0].intl = &intl[0];
+        group[0].values.llc = 1024;
+        group[0].values.mbm_local_delta = 1000;
+        group[0].values.mbm_total_delta = 3000;
+        group[0].values.ipc = 1.5;
+        group[0].values.llc_misses_delta = 10;
+        for (i = 0; i < MON_POLL_EVENT_NUM; i++)
+                intl[0].poll.interval[i] = 500000000;
+        /* group polled only once */
+        group[1].valid = 0x00DEAD00;
+        group[1].intl = &intl[1];
+        group[1].values.llc = 2048;
+        group[1].values.mbm_local_delta = 1000;
+
+        memset(&values, 0, sizeof(values));
+        values.llc = llc;
+        values.mbm_local_rate = mbl;
+        values.mbm_total_rate = mbt;
+        values.ipc = ipc;
+        values.llc_misses = misses;
+
+        wrap_check_init(1, PQOS_RETVAL_OK);
+        ret = pqos_mon_get_values(groups, DIM(groups), &values);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(llc[0], 1024);
+        assert_int_equal(llc[1], 2048);
+        assert_true(mbl[0] == 2000);
+        assert_true(mbl[1] == 0);
+        assert_true(mbt[0] == 6000);
+        assert_true(ipc[0] == 1.5);
+        assert_true(ipc[1] == 0);
+        assert_int_equal(misses[0], 10);
+        assert_int_equal(misses[1], 0);
+}
+
 int
 main(void)
 {
@@ -2718,6 +3149,7 @@ main(void)
             cmocka_unit_test(test_pqos_alloc_assign_init),
             cmocka_unit_test(test_pqos_alloc_release_init),
             cmocka_unit_test(test_pqos_alloc_assign_pid_init),
+            cmocka_unit_test(test_pqos_alloc_swap_init),
             cmocka_unit_test(test_pqos_alloc_release_pid_init),
             cmocka_unit_test(test_pqos_alloc_reset_init),
             cmocka_unit_test(test_pqos_pid_get_pid_assoc_init),
@@ -2741,6 +3173,7 @@ main(void)
             cmocka_unit_test(test_pqos_mon_start_uncore_init),
             cmocka_unit_test(test_pqos_mon_get_value_init),
             cmocka_unit_test(test_pqos_mon_get_ipc_init),
+            cmocka_unit_test(test_pqos_mon_get_values_init),
         };
 
         const struct CMUnitTest tests_param[] = {
@@ -2753,6 +3186,7 @@ main(void)
             cmocka_unit_test(test_pqos_alloc_assign_param_id_null),
             cmocka_unit_test(test_pqos_alloc_release_param),
             cmocka_unit_test(test_pqos_alloc_assign_pid_param),
+            cmocka_unit_test(test_pqos_alloc_swap_param),
             cmocka_unit_test(test_pqos_alloc_release_pid_param),
             cmocka_unit_test(test_pqos_alloc_reset_param),
             cmocka_unit_test(test_pqos_pid_get_pid_assoc_param),
@@ -2768,6 +3202,7 @@ main(void)
             cmocka_unit_test(test_pqos_mon_start_param),
             cmocka_unit_test(test_pqos_mon_stop_param),
             cmocka_unit_test(test_pqos_mon_poll_param),
+            cmocka_unit_test(test_pqos_mon_poll_subset_param),
             cmocka_unit_test(test_pqos_mon_start_pids_param),
             cmocka_unit_test(test_pqos_mon_start_pids2_param),
             cmocka_unit_test(test_pqos_mon_add_pids_param),
@@ -2775,6 +3210,7 @@ main(void)
             cmocka_unit_test(test_pqos_mon_start_uncore_param),
             cmocka_unit_test(test_pqos_mon_get_value_param),
             cmocka_unit_test(test_pqos_mon_get_ipc_param),
+            cmocka_unit_test(test_pqos_mon_get_values_param),
         };
 
         const struct CMUnitTest tests_hw[] = {
@@ -2785,6 +3221,7 @@ main(void)
             cmocka_unit_test(test_pqos_alloc_assign_hw),
             cmocka_unit_test(test_pqos_alloc_release_hw),
             cmocka_unit_test(test_pqos_alloc_assign_pid_hw),
+            cmocka_unit_test(test_pqos_alloc_swap_pid_hw),
             cmocka_unit_test(test_pqos_alloc_release_pid_hw),
             cmocka_unit_test(test_pqos_alloc_reset_hw),
             cmocka_unit_test(test_pqos_pid_get_pid_assoc_hw),
@@ -2799,10 +3236,12 @@ main(void)
             cmocka_unit_test(test_pqos_mba_set_hw),
             cmocka_unit_test(test_pqos_mba_get_hw),
             cmocka_unit_test(test_pqos_mon_reset_hw),
+            cmocka_unit_test(test_pqos_mon_reclaim_hw),
             cmocka_unit_test(test_pqos_mon_assoc_get_hw),
             cmocka_unit_test(test_pqos_mon_start_hw),
             cmocka_unit_test(test_pqos_mon_stop_hw),
             cmocka_unit_test(test_pqos_mon_poll),
+            cmocka_unit_test(test_pqos_mon_poll_subset),
             cmocka_unit_test(test_pqos_mon_start_pids_hw),
             cmocka_unit_test(test_pqos_mon_start_pids2_hw),
             cmocka_unit_test(test_pqos_mon_start_pid_hw),
@@ -2810,7 +3249,8 @@ main(void)
             cmocka_unit_test(test_pqos_mon_remove_pids_hw),
             cmocka_unit_test(test_pqos_mon_start_uncore_hw),
             cmocka_unit_test(test_pqos_mon_get_value),
-            cmocka_unit_test(test_pqos_mon_get_ipc)};
+            cmocka_unit_test(test_pqos_mon_get_ipc),
+            cmocka_unit_test(test_pqos_mon_get_values)};
 
 #ifdef __linux__
         const struct CMUnitTest tests_os[] = {
@@ -2821,6 +3261,9 @@ main(void)
             cmocka_unit_test(test_pqos_alloc_assign_os),
             cmocka_unit_test(test_pqos_alloc_release_os),
             cmocka_unit_test(test_pqos_alloc_assign_pid_os),
+            cmocka_unit_test(test_pqos_alloc_swap_os),
+            cmocka_unit_test(test_pqos_alloc_swap_os_shared),
+            cmocka_unit_test(test_pqos_alloc_swap_os_rollback),
             cmocka_unit_test(test_pqos_alloc_release_pid_os),
             cmocka_unit_test(test_pqos_alloc_reset_os),
             cmocka_unit_test(test_pqos_pid_get_pid_assoc_os),
@@ -2838,6 +3281,7 @@ main(void)
             cmocka_unit_test(test_pqos_mon_start_os),
             cmocka_unit_test(test_pqos_mon_stop_os),
             cmocka_unit_test(test_pqos_mon_poll),
+            cmocka_unit_test(test_pqos_mon_poll_subset),
             cmocka_unit_test(test_pqos_mon_start_pids_os),
             cmocka_unit_test(test_pqos_mon_start_pids2_os),
             cmocka_unit_test(test_pqos_mon_start_pid_os),
@@ -379,6 +379,174 @@ test_pqos_fini(void **state __attribute__((unused)))
         assert_int_equal(ret, PQOS_RETVAL_OK);
 }
 
+/* ======== pqos_ctx_init ======== */
+
+static void
+test_pqos_ctx_init_param(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        ret = pqos_ctx_init(NULL, &ctx);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_ctx_init(&cfg, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_ctx_fini(NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_ctx_init_attach(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+        struct test_data *data;
+        enum pqos_interface interface;
+
+        data = (struct test_data *)*state;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.verbose = LOG_VER_SILENT;
+        cfg.fd_log = -1;
+        cfg.interface = PQOS_INTER_AUTO;
+
+        ret = pqos_ctx_init(&cfg, &ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_non_null(ctx);
+
+        ret = pqos_ctx_inter_get(ctx, &interface);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(interface, data->interface);
+
+        /* handle did not initialize the library so it does not shut it down */
+        ret = pqos_ctx_fini(ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_ctx_init_inter(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+        struct test_data *data;
+
+        data = (struct test_data *)*state;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.verbose = LOG_VER_SILENT;
+        cfg.fd_log = -1;
+        if (data->interface == PQOS_INTER_MSR)
+                cfg.interface = PQOS_INTER_OS;
+        else
+                cfg.interface = PQOS_INTER_MSR;
+
+        ret = pqos_ctx_init(&cfg, &ctx);
+        assert_int_equal(ret, PQOS_RETVAL_INTER);
+}
+
+static void
+test_pqos_ctx_init_compat(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+        struct test_data *data;
+        enum pqos_interface interface;
+
+        data = (struct test_data *)*state;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.verbose = LOG_VER_SILENT;
+        cfg.fd_log = -1;
+        cfg.interface = PQOS_INTER_OS;
+
+        ret = pqos_ctx_init(&cfg, &ctx);
+        if (data->interface == PQOS_INTER_MSR) {
+                assert_int_equal(ret, PQOS_RETVAL_INTER);
+                return;
+        }
+        /* resctrl monitoring interface serves OS interface requests */
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_ctx_inter_get(ctx, &interface);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(interface, data->interface);
+
+        ret = pqos_ctx_fini(ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_ctx_invalid(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+        struct pqos_ctx *bogus = (struct pqos_ctx *)&cfg;
+        const struct pqos_cap *p_cap;
+        const struct pqos_cpuinfo *p_cpu;
+        enum pqos_interface interface;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.verbose = LOG_VER_SILENT;
+        cfg.fd_log = -1;
+        cfg.interface = PQOS_INTER_AUTO;
+
+        ret = pqos_ctx_cap_get(bogus, &p_cap, &p_cpu);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_ctx_inter_get(bogus, &interface);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_ctx_fini(bogus);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        /* released handle is rejected */
+        ret = pqos_ctx_init(&cfg, &ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_ctx_fini(ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_ctx_inter_get(ctx, &interface);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_ctx_fini_deferred(void **state __attribute__((unused)))
+{
+        int ret;
+        struct pqos_config cfg;
+        struct pqos_ctx *ctx = NULL;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.verbose = LOG_VER_SILENT;
+        cfg.fd_log = -1;
+        cfg.interface = PQOS_INTER_AUTO;
+
+        ret = pqos_ctx_init(&cfg, &ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* shutdown waits for the handle */
+        ret = pqos_fini();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = _pqos_check_init(1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* last handle released shuts the library down */
+        expect_function_call(__wrap_lock_get);
+        expect_function_call(__wrap_lock_release);
+        expect_function_call(__wrap_lock_fini);
+        will_return(__wrap_lock_fini, 0);
+        ret = pqos_ctx_fini(ctx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = _pqos_check_init(0);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
 /* ======== pqos_cap_get ======== */
 
 static void
@@ -570,6 +738,7 @@ main(void)
 
         const struct CMUnitTest tests_cap_param[] = {
             cmocka_unit_test(test_pqos_init_param),
+            cmocka_unit_test(test_pqos_ctx_init_param),
         };
 
         const struct CMUnitTest tests_cap_init[] = {
@@ -591,12 +760,23 @@ main(void)
             cmocka_unit_test(test__pqos_cap_l2cdp_change_os_resctrl_mon),
 #endif
             cmocka_unit_test(test__pqos_cap_mba_change),
+            cmocka_unit_test(test_pqos_ctx_init_attach),
+            cmocka_unit_test(test_pqos_ctx_init_inter),
+            cmocka_unit_test(test_pqos_ctx_init_compat),
+            cmocka_unit_test(test_pqos_ctx_invalid),
             cmocka_unit_test(test_pqos_fini),
         };
 
+        const struct CMUnitTest tests_cap_ctx_fini[] = {
+            cmocka_unit_test(test_pqos_init),
+            cmocka_unit_test(test_pqos_ctx_fini_deferred),
+        };
+
         result += cmocka_run_group_tests(tests_cap_param, NULL, NULL);
         result += cmocka_run_group_tests(tests_cap_init, setup_cap_init_msr,
                                          test_fini);
+        result += cmocka_run_group_tests(tests_cap_ctx_fini,
+                                         setup_cap_init_msr, test_fini);
 #ifdef __linux__
         result += cmocka_run_group_tests(tests_cap_init, setup_cap_init_os,
                                          test_fini);
@@ -0,0 +1,209 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cap_cache.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ======== helpers  ======== */
+
+static char cache_path[64];
+
+static int
+setup_cache(void **state)
+{
+        snprintf(cache_path, sizeof(cache_path), "/tmp/pqos-cap-cache-%d",
+                 (int)getpid());
+        setenv(CAP_CACHE_ENV, cache_path, 1);
+
+        return test_init_all(state);
+}
+
+static int
+teardown_cache(void **state)
+{
+        cap_cache_fini();
+        unlink(cache_path);
+        unsetenv(CAP_CACHE_ENV);
+
+        return test_fini(state);
+}
+
+static void
+free_cap(struct pqos_cap *cap)
+{
+        unsigned i;
+
+        for (i = 0; i < cap->num_cap; i++)
+                free(cap->capabilities[i].u.generic_ptr);
+        free(cap);
+}
+
+/* ======== cap_cache_load ======== */
+
+static void
+test_cap_cache_load_disabled(void **state __attribute__((unused)))
+{
+        int ret;
+
+        unsetenv(CAP_CACHE_ENV);
+
+        ret = cap_cache_load(PQOS_INTER_MSR);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        assert_null(cap_cache_cpu_get());
+        assert_null(cap_cache_cap_get());
+
+        setenv(CAP_CACHE_ENV, cache_path, 1);
+}
+
+static void
+test_cap_cache_load_missing(void **state __attribute__((unused)))
+{
+        int ret;
+
+        unlink(cache_path);
+
+        ret = cap_cache_load(PQOS_INTER_MSR);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        assert_null(cap_cache_cpu_get());
+}
+
+/* ======== cap_cache_store ======== */
+
+static void
+test_cap_cache_store(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_cpuinfo *cpu;
+        struct pqos_cap *cap;
+        unsigned i;
+        int ret;
+
+        ret = cap_cache_store(PQOS_INTER_MSR, data->cpu, data->cap);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = cap_cache_load(PQOS_INTER_MSR);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        cpu = cap_cache_cpu_get();
+        assert_non_null(cpu);
+        assert_null(cap_cache_cpu_get());
+        assert_int_equal(cpu->num_cores, data->cpu->num_cores);
+        assert_int_equal(cpu->vendor, data->cpu->vendor);
+        for (i = 0; i < cpu->num_cores; i++) {
+                assert_int_equal(cpu->cores[i].lcore,
+                                 data->cpu->cores[i].lcore);
+                assert_int_equal(cpu->cores[i].l3_id,
+                                 data->cpu->cores[i].l3_id);
+        }
+
+        cap = cap_cache_cap_get();
+        assert_non_null(cap);
+        assert_int_equal(cap->num_cap, data->cap->num_cap);
+        for (i = 0; i < cap->num_cap; i++) {
+                const struct pqos_capability *item = &cap->capabilities[i];
+
+                assert_int_equal(item->type, data->cap->capabilities[i].type);
+                if (item->type == PQOS_CAP_TYPE_L3CA)
+                        assert_memory_equal(item->u.l3ca, &data->cap_l3ca,
+                                            sizeof(data->cap_l3ca));
+                else if (item->type == PQOS_CAP_TYPE_MON) {
+                        assert_int_equal(item->u.mon->num_events,
+                                         data->cap_mon->num_events);
+                        assert_int_equal(item->u.mon->events[6].type,
+                                         PQOS_PERF_EVENT_LLC_REF);
+                }
+        }
+
+        free(cpu);
+        free_cap(cap);
+}
+
+static void
+test_cap_cache_store_inter(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+
+        ret = cap_cache_store(PQOS_INTER_MSR, data->cpu, data->cap);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* snapshot taken with different interface */
+        ret = cap_cache_load(PQOS_INTER_OS);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        assert_null(cap_cache_cpu_get());
+        assert_null(cap_cache_cap_get());
+}
+
+static void
+test_cap_cache_load_corrupted(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct stat st;
+        int ret;
+
+        ret = cap_cache_store(PQOS_INTER_MSR, data->cpu, data->cap);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* cut last capability entry */
+        ret = stat(cache_path, &st);
+        assert_int_equal(ret, 0);
+        ret = truncate(cache_path, st.st_size - 8);
+        assert_int_equal(ret, 0);
+
+        ret = cap_cache_load(PQOS_INTER_MSR);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        assert_null(cap_cache_cpu_get());
+        assert_null(cap_cache_cap_get());
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_cap_cache_load_disabled),
+            cmocka_unit_test(test_cap_cache_load_missing),
+            cmocka_unit_test(test_cap_cache_store),
+            cmocka_unit_test(test_cap_cache_store_inter),
+            cmocka_unit_test(test_cap_cache_load_corrupted),
+        };
+
+        result += cmocka_run_group_tests(tests, setup_cache, teardown_cache);
+
+        return result;
+}
@@ -0,0 +1,256 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cos_table.h"
+#include "test.h"
+
+/* ======== mock ======== */
+
+static uint64_t lock_counter;
+
+int
+__wrap_lock_counter_get(uint64_t *value)
+{
+        *value = lock_counter;
+
+        return 0;
+}
+
+int
+__wrap_lock_counter_inc(uint64_t *value)
+{
+        lock_counter++;
+        if (value != NULL)
+                *value = lock_counter;
+
+        return 0;
+}
+
+static void
+expect_assoc_read(const struct pqos_cpuinfo *cpu, const unsigned *assoc)
+{
+        unsigned i;
+
+        for (i = 0; i < cpu->num_cores; i++) {
+                expect_value(__wrap_hw_alloc_assoc_read, lcore,
+                             cpu->cores[i].lcore);
+                will_return(__wrap_hw_alloc_assoc_read, assoc[i]);
+                will_return(__wrap_hw_alloc_assoc_read, PQOS_RETVAL_OK);
+        }
+}
+
+static void
+cos_table_reset(void)
+{
+        cos_table_init();
+        lock_counter = 0;
+}
+
+/* ======== cos_table_sync ======== */
+
+static void
+test_cos_table_sync(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned assoc[] = {0, 1, 1, 0, 2, 0, 0, 3};
+        int ret;
+
+        cos_table_reset();
+
+        expect_assoc_read(data->cpu, assoc);
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 0), 2);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 1), 2);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 1), 0);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_MBA, 1, 2), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_MBA, 1, 3), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, 0, 1), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, 1, 1), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, 3, 3), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 5, 0), 0);
+
+        /* table is in sync, no hardware access */
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_cos_table_sync_error(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+
+        cos_table_reset();
+
+        expect_value(__wrap_hw_alloc_assoc_read, lcore, 0);
+        will_return(__wrap_hw_alloc_assoc_read, 0);
+        will_return(__wrap_hw_alloc_assoc_read, PQOS_RETVAL_ERROR);
+
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 0), 0);
+}
+
+static void
+test_cos_table_disabled(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+
+        cos_table_reset();
+        cos_table_fini();
+
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        /* association writes are not tracked */
+        cos_table_update(0, 1);
+        assert_int_equal(lock_counter, 0);
+}
+
+/* ======== cos_table_update ======== */
+
+static void
+test_cos_table_update(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned assoc[] = {0, 1, 1, 0, 2, 0, 0, 3};
+        int ret;
+
+        cos_table_reset();
+
+        expect_assoc_read(data->cpu, assoc);
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* release */
+        cos_table_update(1, 0);
+        cos_table_update(2, 0);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 1), 0);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 0), 4);
+        assert_int_equal(lock_counter, 2);
+
+        /* reuse */
+        cos_table_update(3, 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 0, 1), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, 1, 1), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_MBA, 0, 0), 3);
+
+        /* own changes do not require hardware access */
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_cos_table_update_other(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned assoc[] = {0, 1, 1, 0, 2, 0, 0, 3};
+        const unsigned assoc_new[] = {0, 1, 1, 0, 2, 2, 0, 3};
+        int ret;
+
+        cos_table_reset();
+
+        expect_assoc_read(data->cpu, assoc);
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* association changed by other process */
+        lock_counter++;
+
+        expect_assoc_read(data->cpu, assoc_new);
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 2), 2);
+}
+
+/* ======== cos_table_verify ======== */
+
+static void
+test_cos_table_verify(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned assoc[] = {0, 1, 1, 0, 2, 0, 0, 3};
+        unsigned i;
+        int ret;
+
+        cos_table_reset();
+
+        ret = cos_table_verify(TOPO_OBJ_L3CAT, 1);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+
+        expect_assoc_read(data->cpu, assoc);
+        ret = cos_table_sync(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 1), 0);
+
+        /* core 6 moved to COS 1 without the counter being bumped */
+        for (i = 4; i < 8; i++) {
+                expect_value(__wrap_hw_alloc_assoc_read, lcore, i);
+                will_return(__wrap_hw_alloc_assoc_read, i == 6 ? 1 : assoc[i]);
+                will_return(__wrap_hw_alloc_assoc_read, PQOS_RETVAL_OK);
+        }
+        ret = cos_table_verify(TOPO_OBJ_L3CAT, 1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 1), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 0), 1);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L2_CLUSTER, 3, 1), 1);
+
+        /* read error invalidates the table */
+        expect_value(__wrap_hw_alloc_assoc_read, lcore, 0);
+        will_return(__wrap_hw_alloc_assoc_read, 0);
+        will_return(__wrap_hw_alloc_assoc_read, PQOS_RETVAL_ERROR);
+        ret = cos_table_verify(TOPO_OBJ_L3CAT, 0);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(cos_table_refcnt(TOPO_OBJ_L3CAT, 1, 1), 0);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_cos_table_sync),
+            cmocka_unit_test(test_cos_table_sync_error),
+            cmocka_unit_test(test_cos_table_disabled),
+            cmocka_unit_test(test_cos_table_update),
+            cmocka_unit_test(test_cos_table_update_other),
+            cmocka_unit_test(test_cos_table_verify),
+        };
+
+        result += cmocka_run_group_tests(tests, test_init_all, test_fini);
+
+        return result;
+}
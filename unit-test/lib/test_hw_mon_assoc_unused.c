@@ -30,9 +30,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_registers.h"
 #include "hw_monitoring.h"
+#include "machine.h"
 #include "mock_cap.h"
+#include "mock_machine.h"
 #include "mock_perf_monitoring.h"
+#include "mock_registry.h"
 #include "test.h"
 
 static int
@@ -43,6 +47,7 @@ wrap_init_mon(void **state)
         expect_any_always(__wrap_perf_mon_init, cpu);
         expect_any_always(__wrap_perf_mon_init, cap);
         will_return_always(__wrap_perf_mon_init, PQOS_RETVAL_OK);
+        will_return_always(__wrap_registry_init, PQOS_RETVAL_RESOURCE);
 
         ret = test_init(state, 1 << PQOS_CAP_TYPE_MON);
         if (ret == 0) {
@@ -111,6 +116,7 @@ test_hw_alloc_assoc_unused(void **state)
 
         will_return_maybe(__wrap__pqos_get_cap, data->cap);
         will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return_maybe(__wrap_registry_is_active, 0);
 
         will_return_count(hw_mon_assoc_read, PQOS_RETVAL_OK,
                           data->cpu->num_cores);
@@ -167,6 +173,7 @@ test_hw_alloc_assoc_unused_range(void **state)
 
         will_return_maybe(__wrap__pqos_get_cap, data->cap);
         will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return_maybe(__wrap_registry_is_active, 0);
 
         will_return_count(hw_mon_assoc_read, PQOS_RETVAL_OK,
                           data->cpu->num_cores / 2);
@@ -194,6 +201,7 @@ test_hw_alloc_assoc_unused_not_found(void **state)
 
         will_return_maybe(__wrap__pqos_get_cap, data->cap);
         will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return_maybe(__wrap_registry_is_active, 0);
 
         will_return_count(hw_mon_assoc_read, PQOS_RETVAL_OK,
                           data->cpu->num_cores / 2);
@@ -206,12 +214,109 @@ test_hw_alloc_assoc_unused_not_found(void **state)
         assert_int_equal(ret, PQOS_RETVAL_ERROR);
 }
 
+static void
+test_hw_alloc_assoc_unused_registry(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_mon_poll_ctx ctx;
+        struct pqos_mon_options opt;
+        /* RMIDs 1-3 associated with cores 1-3 of cluster 0 */
+        const uint8_t busy[] = {1, 1, 1, 0};
+
+        memset(&opt, 0, sizeof(opt));
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap_registry_is_active, 1);
+
+        /* hardware associations are read with registry active */
+        will_return_count(hw_mon_assoc_read, PQOS_RETVAL_OK,
+                          data->cpu->num_cores / 2);
+
+        expect_value(__wrap_registry_claim, type, REGISTRY_TYPE_RMID);
+        expect_value(__wrap_registry_claim, domain, 0);
+        expect_value(__wrap_registry_claim, min_id, 1);
+        expect_value(__wrap_registry_claim, max_id, 4);
+        expect_memory(__wrap_registry_claim, used, busy, sizeof(busy));
+        will_return(__wrap_registry_claim, PQOS_RETVAL_OK);
+        will_return(__wrap_registry_claim, 4);
+        will_return(__wrap_registry_claim, 7);
+
+        ctx.lcore = 1;
+        ctx.cluster = 0;
+
+        ret = hw_mon_assoc_unused(&ctx, PQOS_MON_EVENT_TMEM_BW, 1, 4, &opt);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(ctx.rmid, 4);
+        assert_int_equal(ctx.lease, 7);
+}
+
+static void
+test_hw_alloc_assoc_unused_registry_reclaim(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_mon_poll_ctx ctx;
+        struct pqos_mon_options opt;
+        /* RMID 2 of exited process is associated with core 2 */
+        const uint8_t reclaimed[] = {0, 1, 0};
+
+        memset(&opt, 0, sizeof(opt));
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap_registry_is_active, 1);
+
+        /* scan of cluster cores before claim and during reclaim */
+        will_return_count(hw_mon_assoc_read, PQOS_RETVAL_OK,
+                          data->cpu->num_cores);
+
+        expect_value_count(__wrap_registry_claim, type, REGISTRY_TYPE_RMID, 2);
+        expect_value_count(__wrap_registry_claim, domain, 0, 2);
+        expect_value_count(__wrap_registry_claim, min_id, 1, 2);
+        expect_value_count(__wrap_registry_claim, max_id, 3, 2);
+        expect_any_count(__wrap_registry_claim, used, 2);
+        will_return(__wrap_registry_claim, PQOS_RETVAL_ERROR);
+
+        expect_value(__wrap_registry_reclaim, type, REGISTRY_TYPE_RMID);
+        expect_value(__wrap_registry_reclaim, domain, 0);
+        expect_value(__wrap_registry_reclaim, min_id, 1);
+        expect_value(__wrap_registry_reclaim, max_id, 3);
+        will_return(__wrap_registry_reclaim, reclaimed);
+        will_return(__wrap_registry_reclaim, 1);
+
+        /* core 2 is moved back to RMID0 */
+        expect_value(__wrap_msr_read, lcore, 2);
+        expect_value(__wrap_msr_read, reg, PQOS_MSR_ASSOC);
+        will_return(__wrap_msr_read, MACHINE_RETVAL_OK);
+        will_return(__wrap_msr_read, 2);
+        expect_value(__wrap_msr_write, lcore, 2);
+        expect_value(__wrap_msr_write, reg, PQOS_MSR_ASSOC);
+        expect_value(__wrap_msr_write, value, 0);
+        will_return(__wrap_msr_write, MACHINE_RETVAL_OK);
+
+        will_return(__wrap_registry_claim, PQOS_RETVAL_OK);
+        will_return(__wrap_registry_claim, 2);
+        will_return(__wrap_registry_claim, 3);
+
+        ctx.lcore = 1;
+        ctx.cluster = 0;
+
+        ret = hw_mon_assoc_unused(&ctx, PQOS_MON_EVENT_TMEM_BW, 1, 3, &opt);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(ctx.rmid, 2);
+        assert_int_equal(ctx.lease, 3);
+}
+
 int
 main(void)
 {
         int result = 0;
 
         const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_hw_alloc_assoc_unused_registry),
+            cmocka_unit_test(test_hw_alloc_assoc_unused_registry_reclaim),
             cmocka_unit_test(test_hw_alloc_assoc_unused),
             cmocka_unit_test(test_hw_alloc_assoc_unused_invalid_cluster),
             cmocka_unit_test(test_hw_alloc_assoc_unused_range),
@@ -30,9 +30,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_registers.h"
 #include "hw_monitoring.h"
+#include "machine.h"
 #include "mock_cap.h"
 #include "mock_perf_monitoring.h"
+#include "mock_registry.h"
 #include "test.h"
 
 static int
@@ -43,6 +46,7 @@ wrap_init_mon(void **state)
         expect_any_always(__wrap_perf_mon_init, cpu);
         expect_any_always(__wrap_perf_mon_init, cap);
         will_return_always(__wrap_perf_mon_init, PQOS_RETVAL_OK);
+        will_return_always(__wrap_registry_init, PQOS_RETVAL_RESOURCE);
 
         ret = test_init(state, 1 << PQOS_CAP_TYPE_MON);
         if (ret == 0) {
@@ -238,6 +242,163 @@ test_hw_mon_read_counter_llc(void **state)
         assert_int_equal(group.values.llc, 5 * pmon->scale_factor);
 }
 
+static void
+test_hw_mon_read_counter_offline(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        unsigned num_cores = 1;
+        unsigned cores[] = {9};
+        struct pqos_mon_data group;
+        struct pqos_mon_data_internal intl;
+        struct pqos_mon_poll_ctx ctx;
+        enum pqos_mon_event event = PQOS_MON_EVENT_L3_OCCUP;
+        int ret;
+
+        memset(&group, 0, sizeof(struct pqos_mon_data));
+        group.intl = &intl;
+        group.num_cores = num_cores;
+        group.cores = cores;
+        memset(&intl, 0, sizeof(struct pqos_mon_data_internal));
+        intl.hw.ctx = &ctx;
+        intl.hw.num_ctx = 1;
+        /* contexts set up with previous topology */
+        intl.hw.topo_gen = topo_generation() + 1;
+        memset(&ctx, 0, sizeof(struct pqos_mon_poll_ctx));
+        ctx.lcore = cores[0];
+        ctx.cluster = 1;
+        ctx.rmid = 2;
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+
+        /* core 9 is offline, counter is read through core of cluster 1 */
+        expect_value(hw_mon_read, lcore, 4);
+        expect_value(hw_mon_read, rmid, ctx.rmid);
+        expect_value(hw_mon_read, event, 1);
+        will_return(hw_mon_read, 5);
+        will_return(hw_mon_read, PQOS_RETVAL_OK);
+
+        ret = hw_mon_read_counter(&group, event);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(ctx.lcore, 4);
+        assert_int_equal(intl.hw.topo_gen, topo_generation());
+}
+
+/* ======== hw_mon_poll perf hotplug ======== */
+
+static void
+expect_msr_read(const unsigned lcore, const uint32_t reg, const uint64_t value)
+{
+        expect_value(__wrap_msr_read, lcore, lcore);
+        expect_value(__wrap_msr_read, reg, reg);
+        will_return(__wrap_msr_read, MACHINE_RETVAL_OK);
+        will_return(__wrap_msr_read, value);
+}
+
+static void
+expect_msr_write(const unsigned lcore, const uint32_t reg, const uint64_t value)
+{
+        expect_value(__wrap_msr_write, lcore, lcore);
+        expect_value(__wrap_msr_write, reg, reg);
+        expect_value(__wrap_msr_write, value, value);
+        will_return(__wrap_msr_write, MACHINE_RETVAL_OK);
+}
+
+static void
+test_hw_mon_poll_perf_hotplug(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_cpuinfo *cpu = data->cpu;
+        struct pqos_coreinfo core2 = cpu->cores[2];
+        unsigned cores[] = {1, 2};
+        struct pqos_mon_data group;
+        struct pqos_mon_data_internal intl;
+        struct pqos_mon_poll_ctx ctx;
+        const uint64_t evtsel = IA32_EVENT_LLC_MISS_MASK |
+                                (IA32_EVENT_LLC_MISS_UMASK << 8) |
+                                (1ULL << 16) | (1ULL << 17) | (1ULL << 22);
+        unsigned i;
+        int ret;
+
+        memset(&group, 0, sizeof(struct pqos_mon_data));
+        group.intl = &intl;
+        group.num_cores = 2;
+        group.cores = cores;
+        memset(&intl, 0, sizeof(struct pqos_mon_data_internal));
+        intl.hw.event = PQOS_PERF_EVENT_LLC_MISS;
+        intl.hw.ctx = &ctx;
+        intl.hw.num_ctx = 1;
+        intl.hw.topo_gen = topo_generation();
+        memset(&ctx, 0, sizeof(struct pqos_mon_poll_ctx));
+        ctx.lcore = 1;
+        ctx.cluster = 0;
+        ctx.rmid = 3;
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+
+        expect_msr_read(1, IA32_MSR_PMC0, 10);
+        expect_msr_read(2, IA32_MSR_PMC0, 20);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(group.values.llc_misses, 30);
+
+        /* core 2 goes offline in the middle of the poll */
+        expect_msr_read(1, IA32_MSR_PMC0, 14);
+        expect_value(__wrap_msr_read, lcore, 2);
+        expect_value(__wrap_msr_read, reg, IA32_MSR_PMC0);
+        will_return(__wrap_msr_read, MACHINE_RETVAL_ERROR);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+
+        /* poll is retried after topology refresh */
+        for (i = 2; i < cpu->num_cores - 1; i++)
+                cpu->cores[i] = cpu->cores[i + 1];
+        cpu->num_cores--;
+        assert_int_equal(topo_init(cpu), PQOS_RETVAL_OK);
+
+        expect_msr_read(1, PQOS_MSR_ASSOC, 3);
+        expect_msr_read(1, IA32_MSR_PMC0, 15);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(group.values.llc_misses, 15);
+        assert_int_equal(group.values.llc_misses_delta, 0);
+
+        expect_msr_read(1, IA32_MSR_PMC0, 18);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(group.values.llc_misses_delta, 3);
+
+        /* core 2 back online, RMID association and counters restored */
+        cpu->num_cores++;
+        for (i = cpu->num_cores - 1; i > 2; i--)
+                cpu->cores[i] = cpu->cores[i - 1];
+        cpu->cores[2] = core2;
+        assert_int_equal(topo_init(cpu), PQOS_RETVAL_OK);
+
+        expect_msr_read(1, PQOS_MSR_ASSOC, 3);
+        expect_msr_read(2, PQOS_MSR_ASSOC, 0);
+        expect_msr_read(2, PQOS_MSR_ASSOC, 0);
+        expect_msr_write(2, PQOS_MSR_ASSOC, 3);
+        expect_msr_read(2, IA32_MSR_PERF_GLOBAL_CTRL, 0);
+        expect_msr_write(2, IA32_MSR_PERF_GLOBAL_CTRL, 0);
+        expect_msr_write(2, IA32_MSR_PMC0, 0);
+        expect_msr_write(2, IA32_MSR_PERFEVTSEL0, evtsel);
+        expect_msr_write(2, IA32_MSR_PERF_GLOBAL_CTRL, 1);
+        expect_msr_read(1, IA32_MSR_PMC0, 20);
+        expect_msr_read(2, IA32_MSR_PMC0, 4);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(group.values.llc_misses, 24);
+        assert_int_equal(group.values.llc_misses_delta, 0);
+
+        expect_msr_read(1, IA32_MSR_PMC0, 25);
+        expect_msr_read(2, IA32_MSR_PMC0, 9);
+        ret = hw_mon_poll(&group, PQOS_PERF_EVENT_LLC_MISS);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(group.values.llc_misses_delta, 10);
+}
+
 int
 main(void)
 {
@@ -246,7 +407,9 @@ main(void)
         const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_hw_mon_read_counter_tmem),
             cmocka_unit_test(test_hw_mon_read_counter_lmem),
-            cmocka_unit_test(test_hw_mon_read_counter_llc)};
+            cmocka_unit_test(test_hw_mon_read_counter_llc),
+            cmocka_unit_test(test_hw_mon_read_counter_offline),
+            cmocka_unit_test(test_hw_mon_poll_perf_hotplug)};
 
         result += cmocka_run_group_tests(tests, wrap_init_mon, wrap_fini_mon);
 
@@ -33,6 +33,7 @@
 #include "hw_monitoring.h"
 #include "mock_cap.h"
 #include "mock_perf_monitoring.h"
+#include "mock_registry.h"
 #include "test.h"
 
 static int
@@ -43,6 +44,7 @@ wrap_init_mon(void **state)
         expect_any_always(__wrap_perf_mon_init, cpu);
         expect_any_always(__wrap_perf_mon_init, cap);
         will_return_always(__wrap_perf_mon_init, PQOS_RETVAL_OK);
+        will_return_always(__wrap_registry_init, PQOS_RETVAL_RESOURCE);
 
         ret = test_init(state, 1 << PQOS_CAP_TYPE_MON);
         if (ret == 0) {
@@ -34,6 +34,7 @@
 #include "hw_monitoring.h"
 #include "mock_cap.h"
 #include "mock_perf_monitoring.h"
+#include "mock_registry.h"
 #include "perf_monitoring.h"
 #include "test.h"
 
@@ -47,6 +48,7 @@ wrap_init_mon(void **state)
         expect_any_always(__wrap_perf_mon_init, cpu);
         expect_any_always(__wrap_perf_mon_init, cap);
         will_return_always(__wrap_perf_mon_init, PQOS_RETVAL_OK);
+        will_return_always(__wrap_registry_init, PQOS_RETVAL_RESOURCE);
 
         ret = test_init(state, 1 << PQOS_CAP_TYPE_MON);
         if (ret == 0) {
@@ -252,6 +254,66 @@ test_hw_mon_reset_error(void **state)
         assert_int_equal(ret, PQOS_RETVAL_ERROR);
 }
 
+/* ======== hw_mon_reclaim ======== */
+
+static void
+test_hw_mon_reclaim(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        /* RMID 2 of cluster 0 is reclaimed */
+        uint8_t reclaimed[31];
+        const uint8_t none[31] = {0};
+        unsigned num = 0;
+        unsigned i;
+        int ret;
+
+        memset(reclaimed, 0, sizeof(reclaimed));
+        reclaimed[1] = 1;
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap_registry_is_active, 1);
+
+        expect_value_count(__wrap_registry_reclaim, type, REGISTRY_TYPE_RMID,
+                           2);
+        expect_value(__wrap_registry_reclaim, domain, 0);
+        expect_value(__wrap_registry_reclaim, domain, 1);
+        expect_value_count(__wrap_registry_reclaim, min_id, 1, 2);
+        expect_value_count(__wrap_registry_reclaim, max_id, 31, 2);
+        will_return(__wrap_registry_reclaim, reclaimed);
+        will_return(__wrap_registry_reclaim, 1);
+        will_return(__wrap_registry_reclaim, none);
+        will_return(__wrap_registry_reclaim, 0);
+
+        /* only core 2 of cluster 0 is still associated with RMID 2 */
+        for (i = 0; i < 4; i++) {
+                expect_value(hw_mon_assoc_read, lcore, i);
+                will_return(hw_mon_assoc_read, i == 2 ? 2 : 0);
+                will_return(hw_mon_assoc_read, PQOS_RETVAL_OK);
+        }
+        expect_value(hw_mon_assoc_write, lcore, 2);
+        expect_value(hw_mon_assoc_write, rmid, 0);
+        will_return(hw_mon_assoc_write, PQOS_RETVAL_OK);
+
+        ret = hw_mon_reclaim(&num);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(num, 1);
+}
+
+static void
+test_hw_mon_reclaim_unavailable(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+
+        will_return_maybe(__wrap__pqos_get_cap, data->cap);
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap_registry_is_active, 0);
+
+        ret = hw_mon_reclaim(NULL);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+}
+
 /* ======== hw_mon_start ======== */
 
 static void
@@ -394,6 +456,8 @@ main(void)
             cmocka_unit_test(test_hw_mon_assoc_get_param),
             cmocka_unit_test(test_hw_mon_reset),
             cmocka_unit_test(test_hw_mon_reset_error),
+            cmocka_unit_test(test_hw_mon_reclaim),
+            cmocka_unit_test(test_hw_mon_reclaim_unavailable),
             cmocka_unit_test(test_hw_mon_start_mbm),
             cmocka_unit_test(test_hw_mon_start_perf),
             cmocka_unit_test(test_hw_mon_poll)};
@@ -122,7 +122,7 @@ test_lock_init_error(void **state __attribute__((unused)))
 
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, -1);
         ret = lock_init();
@@ -130,7 +130,7 @@ test_lock_init_error(void **state __attribute__((unused)))
 
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, LOCKFILENO);
         expect_function_call(__wrap_pthread_mutex_init);
@@ -147,7 +147,7 @@ test_lock_init_exit(void **state __attribute__((unused)))
 {
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, LOCKFILENO);
         expect_function_call(__wrap_pthread_mutex_init);
@@ -165,7 +165,7 @@ test_lock_init_exit(void **state __attribute__((unused)))
 
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, LOCKFILENO);
         expect_function_call(__wrap_pthread_mutex_init);
@@ -181,7 +181,7 @@ test_lock_init_exit(void **state __attribute__((unused)))
 
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, LOCKFILENO);
         expect_function_call(__wrap_pthread_mutex_init);
@@ -202,7 +202,7 @@ test_lock_get(void **state __attribute__((unused)))
         /* init */
         expect_function_call(__wrap_open);
         expect_string(__wrap_open, path, LOCKFILE);
-        expect_value(__wrap_open, oflags, O_WRONLY | O_CREAT);
+        expect_value(__wrap_open, oflags, O_RDWR | O_CREAT);
         expect_value(__wrap_open, mode, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         will_return(__wrap_open, LOCKFILENO);
         expect_function_call(__wrap_pthread_mutex_init);
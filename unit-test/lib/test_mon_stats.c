@@ -0,0 +1,288 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+/* ======== helpers  ======== */
+
+/**
+ * @brief Feeds \a num samples of memory bandwidth, one per second
+ */
+static void
+feed_mbl(struct pqos_mon_stats *stats,
+         uint64_t *time,
+         const uint64_t *rate,
+         const unsigned num)
+{
+        struct pqos_mon_data group;
+        unsigned i;
+
+        memset(&group, 0, sizeof(group));
+        group.event = PQOS_MON_EVENT_LMEM_BW;
+
+        for (i = 0; i < num; i++) {
+                group.values.mbm_local_delta = rate[i];
+                *time += NS_PER_SEC;
+                assert_int_equal(pqos_mon_stats_update(stats, &group, *time),
+                                 PQOS_RETVAL_OK);
+        }
+}
+
+/* ======== pqos_mon_stats_create ======== */
+
+static void
+test_pqos_mon_stats_create_param(void **state __attribute__((unused)))
+{
+        struct pqos_mon_stats_config config;
+        struct pqos_mon_stats *stats;
+        int ret;
+
+        ret = pqos_mon_stats_create(NULL, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        memset(&config, 0, sizeof(config));
+        config.accuracy = 1.0;
+        ret = pqos_mon_stats_create(&config, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        config.accuracy = 0;
+        config.window = -1;
+        ret = pqos_mon_stats_create(&config, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_stats_create(NULL, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_mon_stats_destroy(stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+/* ======== pqos_mon_stats_get ======== */
+
+static void
+test_pqos_mon_stats_get(void **state __attribute__((unused)))
+{
+        const uint64_t rate[] = {100, 300, 200};
+        struct pqos_mon_stat stat;
+        struct pqos_mon_stats *stats;
+        struct pqos_mon_data group;
+        uint64_t time = 0;
+        int ret;
+
+        ret = pqos_mon_stats_create(NULL, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* events that are not tracked */
+        ret = pqos_mon_stats_get(stats, PQOS_PERF_EVENT_LLC_MISS_PCIE_READ,
+                                 &stat);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        /* rate needs two updates */
+        memset(&group, 0, sizeof(group));
+        group.event = PQOS_MON_EVENT_LMEM_BW | PQOS_MON_EVENT_L3_OCCUP;
+        group.values.llc = 4096;
+        ret = pqos_mon_stats_update(stats, &group, NS_PER_SEC);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_LMEM_BW, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_L3_OCCUP, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(stat.count, 1);
+        assert_true(stat.last == 4096);
+
+        time = NS_PER_SEC;
+        feed_mbl(stats, &time, rate, DIM(rate));
+
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_LMEM_BW, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(stat.count, 3);
+        assert_true(stat.last == 200);
+        assert_true(stat.min == 100);
+        assert_true(stat.max == 300);
+        assert_true(stat.ewma > 100 && stat.ewma < 300);
+
+        ret = pqos_mon_stats_reset(stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_LMEM_BW, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        pqos_mon_stats_destroy(stats);
+}
+
+static void
+test_pqos_mon_stats_ewma(void **state __attribute__((unused)))
+{
+        struct pqos_mon_stats_config config;
+        struct pqos_mon_stat stat;
+        struct pqos_mon_stats *stats;
+        uint64_t rate[2] = {0, 1000};
+        uint64_t time = 0;
+        int ret;
+
+        memset(&config, 0, sizeof(config));
+        config.half_life = 1.0;
+        ret = pqos_mon_stats_create(&config, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* after one half-life the average moves half way to the sample */
+        feed_mbl(stats, &time, rate, 1);
+        feed_mbl(stats, &time, rate, 2);
+
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_LMEM_BW, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(stat.ewma > 499.9 && stat.ewma < 500.1);
+
+        pqos_mon_stats_destroy(stats);
+}
+
+static void
+test_pqos_mon_stats_window(void **state __attribute__((unused)))
+{
+        struct pqos_mon_stats_config config;
+        struct pqos_mon_stat stat;
+        struct pqos_mon_stats *stats;
+        uint64_t rate[10];
+        uint64_t time = 0;
+        unsigned i;
+        int ret;
+
+        memset(&config, 0, sizeof(config));
+        config.window = 10;
+        ret = pqos_mon_stats_create(&config, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* first update only sets the rate reference */
+        feed_mbl(stats, &time, rate, 1);
+        rate[0] = 1000000;
+        feed_mbl(stats, &time, rate, 1);
+        for (i = 0; i < DIM(rate); i++)
+                rate[i] = 10 + i;
+        feed_mbl(stats, &time, rate, DIM(rate));
+
+        /* peak has left the window */
+        ret = pqos_mon_stats_get(stats, PQOS_MON_EVENT_LMEM_BW, &stat);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(stat.max == 19);
+        assert_true(stat.min >= 10);
+
+        pqos_mon_stats_destroy(stats);
+}
+
+/* ======== pqos_mon_stats_get_quantile ======== */
+
+static void
+test_pqos_mon_stats_get_quantile(void **state __attribute__((unused)))
+{
+        struct pqos_mon_stats_config config;
+        struct pqos_mon_stats *stats;
+        uint64_t rate[1000];
+        uint64_t time = 0;
+        double value;
+        unsigned i;
+        int ret;
+
+        memset(&config, 0, sizeof(config));
+        config.window = 10000;
+        ret = pqos_mon_stats_create(&config, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 0.5,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        feed_mbl(stats, &time, rate, 1);
+        for (i = 0; i < DIM(rate); i++)
+                rate[i] = (i + 1) * 1000000ULL;
+        feed_mbl(stats, &time, rate, DIM(rate));
+
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 1.5,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 0.5,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(value > 500e6 * 0.99 && value < 500e6 * 1.01);
+
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 0.99,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(value > 990e6 * 0.99 && value < 990e6 * 1.01);
+
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 1.0,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(value == 1000e6);
+
+        pqos_mon_stats_destroy(stats);
+}
+
+static void
+test_pqos_mon_stats_get_quantile_zero(void **state __attribute__((unused)))
+{
+        struct pqos_mon_stats *stats;
+        uint64_t rate[4] = {0, 0, 0, 0};
+        uint64_t time = 0;
+        double value;
+        int ret;
+
+        ret = pqos_mon_stats_create(NULL, &stats);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        feed_mbl(stats, &time, rate, DIM(rate));
+        ret = pqos_mon_stats_get_quantile(stats, PQOS_MON_EVENT_LMEM_BW, 0.99,
+                                          &value);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(value == 0);
+
+        pqos_mon_stats_destroy(stats);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_pqos_mon_stats_create_param),
+            cmocka_unit_test(test_pqos_mon_stats_get),
+            cmocka_unit_test(test_pqos_mon_stats_ewma),
+            cmocka_unit_test(test_pqos_mon_stats_window),
+            cmocka_unit_test(test_pqos_mon_stats_get_quantile),
+            cmocka_unit_test(test_pqos_mon_stats_get_quantile_zero),
+        };
+
+        result += cmocka_run_group_tests(tests, NULL, NULL);
+
+        return result;
+}
@@ -0,0 +1,253 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mock_cap.h"
+#include "mock_lock.h"
+#include "monitoring.h"
+#include "test.h"
+
+/* ======== mock ======== */
+
+static unsigned hw_mon_init_calls = 0;
+static unsigned hw_mon_fini_calls = 0;
+
+int __wrap_hw_mon_init(const struct pqos_cpuinfo *cpu,
+                       const struct pqos_cap *cap);
+int __wrap_hw_mon_fini(void);
+
+int
+__wrap_hw_mon_init(const struct pqos_cpuinfo *cpu, const struct pqos_cap *cap)
+{
+        check_expected_ptr(cpu);
+        check_expected_ptr(cap);
+
+        hw_mon_init_calls++;
+
+        return mock_type(int);
+}
+
+int
+__wrap_hw_mon_fini(void)
+{
+        hw_mon_fini_calls++;
+
+        return PQOS_RETVAL_OK;
+}
+
+static int
+setup_mon(void **state)
+{
+        hw_mon_init_calls = 0;
+        hw_mon_fini_calls = 0;
+
+        return test_init_mon(state);
+}
+
+/* ======== pqos_mon_init ======== */
+
+static void
+test_pqos_mon_init_deferred(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_config cfg;
+        int ret;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        ret = pqos_mon_init(data->cpu, data->cap, &cfg);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_init_calls, 0);
+
+        /* backend is not initialized so nothing to shut down */
+        ret = pqos_mon_fini();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_fini_calls, 0);
+}
+
+static void
+test_pqos_mon_init_unsupported(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_config cfg;
+        int ret;
+
+        memset(&cfg, 0, sizeof(cfg));
+        hw_mon_init_calls = 0;
+
+        ret = pqos_mon_init(data->cpu, data->cap, &cfg);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_init_calls, 0);
+}
+
+/* ======== pqos_mon_lazy_init ======== */
+
+static void
+test_pqos_mon_lazy_init(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_config cfg;
+        int ret;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        ret = pqos_mon_init(data->cpu, data->cap, &cfg);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        will_return(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap__pqos_get_cap, data->cap);
+        will_return(__wrap__pqos_get_inter, PQOS_INTER_MSR);
+        expect_value(__wrap_hw_mon_init, cpu, data->cpu);
+        expect_value(__wrap_hw_mon_init, cap, data->cap);
+        will_return(__wrap_hw_mon_init, PQOS_RETVAL_OK);
+
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_init_calls, 1);
+
+        /* backend initialized only once */
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_init_calls, 1);
+
+        will_return(__wrap__pqos_get_inter, PQOS_INTER_MSR);
+
+        ret = pqos_mon_fini();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_fini_calls, 1);
+}
+
+static void
+test_pqos_mon_lazy_init_error(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_config cfg;
+        int ret;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        ret = pqos_mon_init(data->cpu, data->cap, &cfg);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        will_return(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap__pqos_get_cap, data->cap);
+        will_return(__wrap__pqos_get_inter, PQOS_INTER_MSR);
+        expect_value(__wrap_hw_mon_init, cpu, data->cpu);
+        expect_value(__wrap_hw_mon_init, cap, data->cap);
+        will_return(__wrap_hw_mon_init, PQOS_RETVAL_ERROR);
+
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+
+        /* failed initialization is not retried, error is sticky */
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(hw_mon_init_calls, 1);
+
+        ret = pqos_mon_fini();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_fini_calls, 0);
+
+        /* error is cleared by shutdown */
+        ret = pqos_mon_lazy_init();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_mon_lazy_init_error_start(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_config cfg;
+        struct pqos_mon_data group;
+        unsigned cores[] = {1};
+        unsigned i;
+        int ret;
+
+        memset(&cfg, 0, sizeof(cfg));
+
+        ret = pqos_mon_init(data->cpu, data->cap, &cfg);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        will_return(__wrap__pqos_get_cpu, data->cpu);
+        will_return(__wrap__pqos_get_cap, data->cap);
+        will_return(__wrap__pqos_get_inter, PQOS_INTER_MSR);
+        expect_value(__wrap_hw_mon_init, cpu, data->cpu);
+        expect_value(__wrap_hw_mon_init, cap, data->cap);
+        will_return(__wrap_hw_mon_init, PQOS_RETVAL_RESOURCE);
+
+        /* backend is never used once its initialization failed */
+        for (i = 0; i < 2; i++) {
+                expect_function_call(__wrap_lock_get);
+                expect_value(__wrap__pqos_check_init, expect, 1);
+                will_return(__wrap__pqos_check_init, PQOS_RETVAL_OK);
+                expect_function_call(__wrap_lock_release);
+
+                memset(&group, 0, sizeof(group));
+                ret = pqos_mon_start(1, cores, PQOS_MON_EVENT_LMEM_BW, NULL,
+                                     &group);
+                assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+                assert_int_equal(hw_mon_init_calls, 1);
+        }
+
+        ret = pqos_mon_fini();
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(hw_mon_fini_calls, 0);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests_mon[] = {
+            cmocka_unit_test_setup_teardown(test_pqos_mon_init_deferred,
+                                            setup_mon, test_fini),
+            cmocka_unit_test_setup_teardown(test_pqos_mon_lazy_init,
+                                            setup_mon, test_fini),
+            cmocka_unit_test_setup_teardown(test_pqos_mon_lazy_init_error,
+                                            setup_mon, test_fini),
+            cmocka_unit_test_setup_teardown(
+                test_pqos_mon_lazy_init_error_start, setup_mon, test_fini),
+        };
+
+        const struct CMUnitTest tests_unsupported[] = {
+            cmocka_unit_test(test_pqos_mon_init_unsupported),
+        };
+
+        result += cmocka_run_group_tests(tests_mon, NULL, NULL);
+        result += cmocka_run_group_tests(tests_unsupported, test_init_l3ca,
+                                         test_fini);
+
+        return result;
+}
@@ -309,6 +309,56 @@ test_os_cpuinfo_cpu_node(void **state __attribute__((unused)))
 }
 #endif
 
+/* ======== os_cpuinfo_apicid ======== */
+
+static void
+test_os_cpuinfo_apicid(void **state __attribute__((unused)))
+{
+        uint32_t apicid[4] = {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
+        unsigned count;
+        int ret;
+        const char *data = "processor\t: 0\n"
+                           "flags\t\t: fpu vme apicid\n"
+                           "apicid\t\t: 0\n"
+                           "initial apicid\t: 0\n"
+                           "\n"
+                           "processor\t: 2\n"
+                           "apicid\t\t: 36\n"
+                           "initial apicid\t: 36\n"
+                           "\n"
+                           "processor\t: 7\n"
+                           "apicid\t\t: 7\n";
+
+        expect_string(__wrap_pqos_fopen, name, "/proc/cpuinfo");
+        expect_string(__wrap_pqos_fopen, mode, "r");
+        will_return(__wrap_pqos_fopen, data);
+
+        ret = os_cpuinfo_apicid(DIM(apicid), apicid, &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 2);
+        assert_int_equal(apicid[0], 0);
+        assert_int_equal(apicid[1], UINT32_MAX);
+        assert_int_equal(apicid[2], 36);
+        assert_int_equal(apicid[3], UINT32_MAX);
+}
+
+static void
+test_os_cpuinfo_apicid_resource(void **state __attribute__((unused)))
+{
+        uint32_t apicid[2] = {UINT32_MAX, UINT32_MAX};
+        unsigned count;
+        int ret;
+
+        expect_string(__wrap_pqos_fopen, name, "/proc/cpuinfo");
+        expect_string(__wrap_pqos_fopen, mode, "r");
+        will_return(__wrap_pqos_fopen, NULL);
+
+        ret = os_cpuinfo_apicid(DIM(apicid), apicid, &count);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        assert_int_equal(count, 0);
+        assert_int_equal(apicid[0], UINT32_MAX);
+}
+
 int
 main(void)
 {
@@ -324,6 +374,8 @@ main(void)
                 cmocka_unit_test(test_os_cpuinfo_cpu_cache_level_2),
                 cmocka_unit_test(test_os_cpuinfo_cpu_cache_level_3),
                 cmocka_unit_test(test_os_cpuinfo_cpu_cache_error),
+                cmocka_unit_test(test_os_cpuinfo_apicid),
+                cmocka_unit_test(test_os_cpuinfo_apicid_resource),
 #if PQOS_VERSION >= 50000
                 cmocka_unit_test(test_os_cpuinfo_cpu_node),
 #endif
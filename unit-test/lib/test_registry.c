@@ -0,0 +1,452 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "registry.h"
+#include "test.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ======== mock ======== */
+
+static char registry_dir[] = "/tmp/test_registry.XXXXXX";
+static char registry_path[sizeof(registry_dir) + 16];
+static char target_path[sizeof(registry_dir) + 16];
+
+int __real_open(const char *path, int oflags, int mode);
+
+int
+__wrap_open(const char *path, int oflags, int mode)
+{
+        if (strcmp(path, REGISTRY_FILE) == 0)
+                path = registry_path;
+
+        return __real_open(path, oflags, mode);
+}
+
+static int
+test_registry_init(void **state __attribute__((unused)))
+{
+        if (mkdtemp(registry_dir) == NULL)
+                return -1;
+        snprintf(registry_path, sizeof(registry_path), "%s/registry",
+                 registry_dir);
+        snprintf(target_path, sizeof(target_path), "%s/target", registry_dir);
+
+        return registry_init() == PQOS_RETVAL_OK ? 0 : -1;
+}
+
+static int
+test_registry_fini(void **state __attribute__((unused)))
+{
+        registry_fini();
+        unlink(registry_path);
+        unlink(target_path);
+        rmdir(registry_dir);
+
+        return 0;
+}
+
+/**
+ * @brief Writes \a len bytes of \a data at the beginning of \a path
+ */
+static int
+write_file(const char *path, const void *data, const size_t len)
+{
+        int fd = open(path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
+        ssize_t ret;
+
+        if (fd < 0)
+                return -1;
+        ret = pwrite(fd, data, len, 0);
+        close(fd);
+
+        return ret == (ssize_t)len ? 0 : -1;
+}
+
+/**
+ * @brief Checks that \a path starts with \a len bytes of \a data
+ */
+static int
+check_file(const char *path, const void *data, const size_t len)
+{
+        char buf[16];
+        int fd = open(path, O_RDONLY);
+        ssize_t ret;
+
+        if (fd < 0 || len > sizeof(buf))
+                return -1;
+        ret = pread(fd, buf, len, 0);
+        close(fd);
+
+        return ret == (ssize_t)len && memcmp(buf, data, len) == 0 ? 0 : -1;
+}
+
+/* ======== registry_init ======== */
+
+static void
+test_registry_init_existing(void **state __attribute__((unused)))
+{
+        uint8_t used[1] = {0};
+        unsigned id, lease;
+        struct stat st;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* registry is private to the user */
+        assert_int_equal(stat(registry_path, &st), 0);
+        assert_int_equal(st.st_mode & (S_IRWXG | S_IRWXO), 0);
+
+        /* entries are kept */
+        registry_fini();
+        assert_false(registry_is_active());
+        assert_int_equal(registry_init(), PQOS_RETVAL_OK);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+static void
+test_registry_init_symlink(void **state __attribute__((unused)))
+{
+        const char data[] = "data";
+
+        registry_fini();
+        assert_int_equal(unlink(registry_path), 0);
+        assert_int_equal(write_file(target_path, data, sizeof(data)), 0);
+        assert_int_equal(symlink(target_path, registry_path), 0);
+
+        /* link is not followed, target is left intact */
+        assert_int_equal(registry_init(), PQOS_RETVAL_RESOURCE);
+        assert_false(registry_is_active());
+        assert_int_equal(check_file(target_path, data, sizeof(data)), 0);
+
+        assert_int_equal(unlink(registry_path), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_OK);
+}
+
+static void
+test_registry_init_invalid(void **state __attribute__((unused)))
+{
+        const char data[] = "data";
+        struct stat st;
+
+        /* unknown layout is not reinitialized */
+        registry_fini();
+        assert_int_equal(write_file(registry_path, data, sizeof(data)), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_RESOURCE);
+        assert_int_equal(check_file(registry_path, data, sizeof(data)), 0);
+
+        /* file of unexpected size is not truncated */
+        assert_int_equal(unlink(registry_path), 0);
+        assert_int_equal(write_file(registry_path, data, sizeof(data)), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_RESOURCE);
+        assert_int_equal(stat(registry_path, &st), 0);
+        assert_int_equal(st.st_size, sizeof(data));
+
+        /* registry writable by others is not used */
+        assert_int_equal(unlink(registry_path), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_OK);
+        registry_fini();
+        assert_int_equal(chmod(registry_path, 0666), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_RESOURCE);
+
+        assert_int_equal(unlink(registry_path), 0);
+        assert_int_equal(registry_init(), PQOS_RETVAL_OK);
+}
+
+/* ======== registry_claim ======== */
+
+static void
+test_registry_claim(void **state __attribute__((unused)))
+{
+        uint8_t used[2];
+        unsigned id, lease1, lease2;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+        assert_true(registry_is_active());
+
+        memset(used, 0, sizeof(used));
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, &lease1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 1);
+        assert_int_equal(used[0], 1);
+
+        memset(used, 0, sizeof(used));
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, &lease2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 2);
+        assert_int_not_equal(lease1, lease2);
+
+        /* all RMIDs in use */
+        memset(used, 0, sizeof(used));
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, &lease2);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(used[0], 1);
+        assert_int_equal(used[1], 1);
+
+        /* other domain is independent */
+        memset(used, 0, sizeof(used));
+        ret = registry_claim(REGISTRY_TYPE_RMID, 1, 1, 2, used, &id, &lease2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 1);
+
+        /* released RMID can be claimed again */
+        registry_release(lease1);
+        memset(used, 0, sizeof(used));
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, &lease1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 1);
+}
+
+static void
+test_registry_claim_param(void **state __attribute__((unused)))
+{
+        uint8_t used[2] = {0, 0};
+        unsigned id, lease;
+        int ret;
+
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 2, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, NULL, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, NULL, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_registry_claim_busy(void **state __attribute__((unused)))
+{
+        uint8_t busy[] = {1, 0, 1};
+        unsigned id, lease;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        /* ids in use outside of registry are skipped */
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 3, busy, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 2);
+
+        busy[1] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 3, busy, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+static void
+test_registry_reclaim_live_owner(void **state __attribute__((unused)))
+{
+        uint8_t used[1] = {0};
+        uint8_t reclaimed[1] = {0};
+        unsigned id, lease, num;
+        int pipe_claimed[2], pipe_exit[2];
+        int status;
+        char c = 0;
+        pid_t pid;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+        assert_int_equal(pipe(pipe_claimed), 0);
+        assert_int_equal(pipe(pipe_exit), 0);
+
+        /* child process claims RMID and keeps running */
+        pid = fork();
+        assert_true(pid >= 0);
+        if (pid == 0) {
+                ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id,
+                                     &lease);
+                c = ret == PQOS_RETVAL_OK;
+                if (write(pipe_claimed[1], &c, 1) != 1 ||
+                    read(pipe_exit[0], &c, 1) != 1)
+                        _exit(1);
+                _exit(0);
+        }
+        assert_int_equal(read(pipe_claimed[0], &c, 1), 1);
+        assert_int_equal(c, 1);
+
+        /* RMID of running process is never reclaimed */
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        num = registry_reclaim(REGISTRY_TYPE_RMID, 0, 1, 1, reclaimed);
+        assert_int_equal(num, 0);
+        assert_int_equal(reclaimed[0], 0);
+
+        assert_int_equal(write(pipe_exit[1], &c, 1), 1);
+        assert_int_equal(waitpid(pid, &status, 0), pid);
+        assert_true(WIFEXITED(status));
+        assert_int_equal(WEXITSTATUS(status), 0);
+
+        num = registry_reclaim(REGISTRY_TYPE_RMID, 0, 1, 1, reclaimed);
+        assert_int_equal(num, 1);
+        assert_int_equal(reclaimed[0], 1);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 1);
+
+        close(pipe_claimed[0]);
+        close(pipe_claimed[1]);
+        close(pipe_exit[0]);
+        close(pipe_exit[1]);
+}
+
+static void
+test_registry_reclaim_stale(void **state __attribute__((unused)))
+{
+        uint8_t used[2] = {0, 0};
+        uint8_t reclaimed[2] = {0, 0};
+        unsigned id, lease, num;
+        int status;
+        pid_t pid;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        /* child process exits without releasing its RMID */
+        pid = fork();
+        assert_true(pid >= 0);
+        if (pid == 0) {
+                ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id,
+                                     &lease);
+                _exit(ret == PQOS_RETVAL_OK ? 0 : 1);
+        }
+        assert_int_equal(waitpid(pid, &status, 0), pid);
+        assert_true(WIFEXITED(status));
+        assert_int_equal(WEXITSTATUS(status), 0);
+
+        /* claim does not reclaim */
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+
+        /* own entries and entries of other domains are kept */
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 2, 2, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 1, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        num = registry_reclaim(REGISTRY_TYPE_RMID, 0, 1, 2, reclaimed);
+        assert_int_equal(num, 1);
+        assert_int_equal(reclaimed[0], 1);
+        assert_int_equal(reclaimed[1], 0);
+
+        used[0] = 0;
+        used[1] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 2, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(id, 1);
+}
+
+/* ======== registry_release ======== */
+
+static void
+test_registry_release_all(void **state __attribute__((unused)))
+{
+        uint8_t used[1];
+        unsigned id, lease;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_registry_release_invalid(void **state __attribute__((unused)))
+{
+        uint8_t used[1];
+        unsigned id, lease;
+        int ret;
+
+        registry_release_all(REGISTRY_TYPE_RMID);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* invalid leases are ignored */
+        registry_release(0);
+        registry_release(lease + 1);
+
+        used[0] = 0;
+        ret = registry_claim(REGISTRY_TYPE_RMID, 0, 1, 1, used, &id, &lease);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_registry_init_existing),
+            cmocka_unit_test(test_registry_init_symlink),
+            cmocka_unit_test(test_registry_init_invalid),
+            cmocka_unit_test(test_registry_claim),
+            cmocka_unit_test(test_registry_claim_param),
+            cmocka_unit_test(test_registry_claim_busy),
+            cmocka_unit_test(test_registry_reclaim_live_owner),
+            cmocka_unit_test(test_registry_reclaim_stale),
+            cmocka_unit_test(test_registry_release_all),
+            cmocka_unit_test(test_registry_release_invalid),
+        };
+
+        result += cmocka_run_group_tests(tests, test_registry_init,
+                                         test_registry_fini);
+
+        return result;
+}
@@ -35,6 +35,7 @@
 #include "test.h"
 
 #include <sys/stat.h>
+#include <unistd.h>
 
 /* ======== mock ======== */
 
@@ -96,6 +97,85 @@ test_resctrl_mon_rmdir(void **state __attribute__((unused)))
         assert_int_equal(ret, PQOS_RETVAL_OK);
 }
 
+/* ======== resctrl_mon_group_owner ======== */
+
+#define TEST_STAT(starttime)                                                   \
+        "1 (comm (1)) S 0 1 1 0 -1 4194560 1 2 0 0 3 4 0 0 20 0 1 0 "        \
+        starttime " 1 2 3"
+
+static void
+expect_proc_stat(const pid_t pid, const char *stat)
+{
+        char path[64];
+
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+        expect_string(__wrap_pqos_fopen, name, path);
+        expect_string(__wrap_pqos_fopen, mode, "r");
+        will_return(__wrap_pqos_fopen, stat);
+}
+
+static void
+test_resctrl_mon_proc_starttime(void **state __attribute__((unused)))
+{
+        int ret;
+        uint64_t starttime = 0;
+
+        expect_proc_stat(100, TEST_STAT("1234"));
+        ret = resctrl_mon_proc_starttime(100, &starttime);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(starttime, 1234);
+
+        /* process does not exist */
+        expect_proc_stat(100, NULL);
+        ret = resctrl_mon_proc_starttime(100, &starttime);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        expect_proc_stat(100, "1 (comm) S");
+        ret = resctrl_mon_proc_starttime(100, &starttime);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+static void
+test_resctrl_mon_group_owner(void **state __attribute__((unused)))
+{
+        char name[64];
+
+        assert_int_equal(resctrl_mon_group_owner("test"),
+                         RESCTRL_MON_OWNER_NONE);
+        assert_int_equal(resctrl_mon_group_owner("pqos-test"),
+                         RESCTRL_MON_OWNER_NONE);
+
+        /* own group */
+        expect_proc_stat(getpid(), TEST_STAT("1000"));
+        snprintf(name, sizeof(name), "pqos-%d-1000-0", (int)getpid());
+        assert_int_equal(resctrl_mon_group_owner(name),
+                         RESCTRL_MON_OWNER_SELF);
+
+        /* own group without start time */
+        snprintf(name, sizeof(name), "pqos-%d-0", (int)getpid());
+        assert_int_equal(resctrl_mon_group_owner(name),
+                         RESCTRL_MON_OWNER_SELF);
+
+        /* owner is running */
+        expect_proc_stat(1, TEST_STAT("10"));
+        assert_int_equal(resctrl_mon_group_owner("pqos-1-10-0"),
+                         RESCTRL_MON_OWNER_OTHER);
+
+        expect_proc_stat(1, TEST_STAT("10"));
+        assert_int_equal(resctrl_mon_group_owner("pqos-1-2"),
+                         RESCTRL_MON_OWNER_OTHER);
+
+        /* owner has exited */
+        expect_proc_stat(1, NULL);
+        assert_int_equal(resctrl_mon_group_owner("pqos-1-10-0"),
+                         RESCTRL_MON_OWNER_DEAD);
+
+        /* pid reused by other process */
+        expect_proc_stat(1, TEST_STAT("20"));
+        assert_int_equal(resctrl_mon_group_owner("pqos-1-10-0"),
+                         RESCTRL_MON_OWNER_DEAD);
+}
+
 /* ======== resctrl_mon_read_counter ======== */
 
 static void
@@ -177,6 +257,8 @@ main(void)
         const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_resctrl_mon_mkdir),
             cmocka_unit_test(test_resctrl_mon_rmdir),
+            cmocka_unit_test(test_resctrl_mon_proc_starttime),
+            cmocka_unit_test(test_resctrl_mon_group_owner),
             cmocka_unit_test(test_resctrl_mon_read_counter),
             cmocka_unit_test(test_resctrl_mon_read_counter_error),
         };
@@ -0,0 +1,311 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cap.h"
+#include "mock_cap.h"
+#include "monitoring.h"
+#include "test.h"
+
+#include <poll.h>
+
+/* ======== mock  ======== */
+
+int
+_pqos_check_init(const int expect)
+{
+        return __wrap__pqos_check_init(expect);
+}
+
+static unsigned sampler_polls = 0;
+
+int __wrap_pqos_mon_poll(struct pqos_mon_data **groups,
+                         const unsigned num_groups);
+
+int
+__wrap_pqos_mon_poll(struct pqos_mon_data **groups, const unsigned num_groups)
+{
+        unsigned i;
+
+        /* called from the sampler thread so cmocka checks cannot be used */
+        sampler_polls++;
+        for (i = 0; i < num_groups; i++)
+                groups[i]->values.llc = sampler_polls * (i + 1);
+
+        return PQOS_RETVAL_OK;
+}
+
+/* ======== helpers  ======== */
+
+static struct pqos_sampler *
+sampler_start(struct pqos_mon_data **groups,
+              const unsigned num_groups,
+              const unsigned depth)
+{
+        struct pqos_sampler_config cfg;
+        struct pqos_sampler *sampler = NULL;
+        int ret;
+
+        cfg.interval_us = 1000;
+        cfg.depth = depth;
+
+        expect_function_call(__wrap_lock_get);
+        expect_value(__wrap__pqos_check_init, expect, 1);
+        will_return(__wrap__pqos_check_init, PQOS_RETVAL_OK);
+        expect_function_call(__wrap_lock_release);
+
+        ret = pqos_sampler_start(&cfg, groups, num_groups, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_non_null(sampler);
+
+        return sampler;
+}
+
+static void
+sampler_wait(struct pqos_sampler_reader *reader)
+{
+        struct pollfd fds;
+        uint64_t event;
+        int ret;
+
+        fds.fd = pqos_sampler_reader_fd(reader);
+        fds.events = POLLIN;
+
+        ret = poll(&fds, 1, 1000);
+        assert_int_equal(ret, 1);
+
+        ret = (int)read(fds.fd, &event, sizeof(event));
+        assert_int_equal(ret, sizeof(event));
+}
+
+/* ======== pqos_sampler_start ======== */
+
+static void
+test_pqos_sampler_start_param(void **state __attribute__((unused)))
+{
+        struct pqos_sampler_config cfg;
+        struct pqos_sampler *sampler = NULL;
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+        int ret;
+
+        memset(&group, 0, sizeof(group));
+        group.valid = GROUP_VALID_MARKER;
+        cfg.interval_us = 1000;
+        cfg.depth = 0;
+
+        ret = pqos_sampler_start(NULL, groups, 1, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_sampler_start(&cfg, NULL, 1, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_sampler_start(&cfg, groups, 0, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_sampler_start(&cfg, groups, 1, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        cfg.interval_us = 0;
+        ret = pqos_sampler_start(&cfg, groups, 1, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        cfg.interval_us = 1000;
+        group.valid = 0;
+        ret = pqos_sampler_start(&cfg, groups, 1, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+static void
+test_pqos_sampler_start_init(void **state __attribute__((unused)))
+{
+        struct pqos_sampler_config cfg;
+        struct pqos_sampler *sampler = NULL;
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+        int ret;
+
+        memset(&group, 0, sizeof(group));
+        group.valid = GROUP_VALID_MARKER;
+        cfg.interval_us = 1000;
+        cfg.depth = 0;
+
+        expect_function_call(__wrap_lock_get);
+        expect_value(__wrap__pqos_check_init, expect, 1);
+        will_return(__wrap__pqos_check_init, PQOS_RETVAL_INIT);
+        expect_function_call(__wrap_lock_release);
+
+        ret = pqos_sampler_start(&cfg, groups, 1, &sampler);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+        assert_null(sampler);
+}
+
+/* ======== pqos_sampler_read ======== */
+
+static void
+test_pqos_sampler_read(void **state __attribute__((unused)))
+{
+        struct pqos_mon_data group[2];
+        struct pqos_mon_data *groups[] = {&group[0], &group[1]};
+        struct pqos_event_values values[2];
+        struct pqos_sample_info info;
+        struct pqos_sampler *sampler;
+        struct pqos_sampler_reader *reader1;
+        struct pqos_sampler_reader *reader2;
+        int ret;
+
+        memset(group, 0, sizeof(group));
+        group[0].valid = GROUP_VALID_MARKER;
+        group[1].valid = GROUP_VALID_MARKER;
+
+        sampler = sampler_start(groups, 2, 0);
+
+        ret = pqos_sampler_reader_open(sampler, &reader1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_sampler_reader_open(sampler, &reader2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_sampler_read(reader1, &info, values, 1);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        sampler_wait(reader1);
+        ret = pqos_sampler_read(reader1, &info, values, 2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(info.status, PQOS_RETVAL_OK);
+        assert_int_equal(info.lost, 0);
+        assert_int_equal(values[1].llc, 2 * values[0].llc);
+
+        /* second reader consumes the same samples independently */
+        sampler_wait(reader2);
+        ret = pqos_sampler_read(reader2, &info, values, 2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(info.seq, 0);
+        assert_int_equal(values[1].llc, 2 * values[0].llc);
+
+        ret = pqos_sampler_stop(sampler);
+        assert_int_equal(ret, PQOS_RETVAL_BUSY);
+
+        ret = pqos_sampler_reader_close(reader1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = pqos_sampler_reader_close(reader2);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_sampler_stop(sampler);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_sampler_read_lost(void **state __attribute__((unused)))
+{
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+        struct pqos_event_values values;
+        struct pqos_sample_info info;
+        struct pqos_sampler *sampler;
+        struct pqos_sampler_reader *reader;
+        uint64_t seq;
+        int ret;
+
+        memset(&group, 0, sizeof(group));
+        group.valid = GROUP_VALID_MARKER;
+
+        sampler = sampler_start(groups, 1, 4);
+
+        ret = pqos_sampler_reader_open(sampler, &reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* let the sampler wrap the ring */
+        usleep(20000);
+
+        ret = pqos_sampler_read(reader, &info, &values, 1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(info.lost > 0);
+        assert_true(info.seq >= info.lost);
+
+        /* samples are returned in order */
+        seq = info.seq;
+        ret = pqos_sampler_read(reader, &info, &values, 1);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_true(info.seq > seq);
+
+        ret = pqos_sampler_reader_close(reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_sampler_stop(sampler);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+static void
+test_pqos_sampler_read_empty(void **state __attribute__((unused)))
+{
+        struct pqos_mon_data group;
+        struct pqos_mon_data *groups[] = {&group};
+        struct pqos_event_values values;
+        struct pqos_sample_info info;
+        struct pqos_sampler *sampler;
+        struct pqos_sampler_reader *reader;
+        int ret;
+
+        memset(&group, 0, sizeof(group));
+        group.valid = GROUP_VALID_MARKER;
+
+        sampler = sampler_start(groups, 1, 0);
+
+        ret = pqos_sampler_reader_open(sampler, &reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        sampler_wait(reader);
+        do
+                ret = pqos_sampler_read(reader, &info, &values, 1);
+        while (ret == PQOS_RETVAL_OK);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        ret = pqos_sampler_reader_close(reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_sampler_stop(sampler);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_pqos_sampler_start_param),
+            cmocka_unit_test(test_pqos_sampler_start_init),
+            cmocka_unit_test(test_pqos_sampler_read),
+            cmocka_unit_test(test_pqos_sampler_read_lost),
+            cmocka_unit_test(test_pqos_sampler_read_empty),
+        };
+
+        result += cmocka_run_group_tests(tests, NULL, NULL);
+
+        return result;
+}
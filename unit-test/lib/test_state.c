@@ -0,0 +1,729 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "api.h"
+#include "mock_cap.h"
+#include "mock_cpuinfo.h"
+#include "pqos.h"
+#include "test.h"
+
+#include <errno.h>
+
+#ifndef DIM
+#define DIM(x) (sizeof(x) / sizeof(x[0]))
+#endif
+
+/* ======== mock ======== */
+
+/**
+ * Allocation state of the emulated platform
+ */
+static struct {
+        struct pqos_l3ca l3ca[2][4]; /**< per L3 CAT id and COS */
+        struct pqos_l2ca l2ca[4][3]; /**< per L2 id and COS */
+        struct pqos_mba mba[2][4];   /**< per MBA id and COS */
+        unsigned core[8];            /**< COS of each core */
+        unsigned task[2];            /**< COS of tasks 100 and 101 */
+} m_hw;
+
+static int m_init_ret;
+static unsigned m_writes;
+static unsigned m_fail_write;
+static pid_t m_fail_task;
+static pid_t m_exited_task;
+
+int __wrap__pqos_check_init(const int expect);
+void __wrap_lock_get(void);
+void __wrap_lock_release(void);
+int __wrap_os_l3ca_get(const unsigned l3cat_id,
+                       const unsigned max_num_ca,
+                       unsigned *num_ca,
+                       struct pqos_l3ca *ca);
+int __wrap_os_l3ca_set(const unsigned l3cat_id,
+                       const unsigned num_cos,
+                       const struct pqos_l3ca *ca);
+int __wrap_os_l2ca_get(const unsigned l2id,
+                       const unsigned max_num_ca,
+                       unsigned *num_ca,
+                       struct pqos_l2ca *ca);
+int __wrap_os_l2ca_set(const unsigned l2id,
+                       const unsigned num_cos,
+                       const struct pqos_l2ca *ca);
+int __wrap_os_mba_get(const unsigned mba_id,
+                      const unsigned max_num_cos,
+                      unsigned *num_cos,
+                      struct pqos_mba *mba_tab);
+int __wrap_os_mba_set(const unsigned mba_id,
+                      const unsigned num_cos,
+                      const struct pqos_mba *requested,
+                      struct pqos_mba *actual);
+int __wrap_os_alloc_assoc_get(const unsigned lcore, unsigned *class_id);
+int __wrap_os_alloc_assoc_set(const unsigned lcore, const unsigned class_id);
+int __wrap_os_alloc_assoc_set_pid(const pid_t task, const unsigned class_id);
+unsigned *__wrap_os_pid_get_pid_assoc(const unsigned class_id,
+                                      unsigned *count);
+int __wrap_os_alloc_reset(const struct pqos_alloc_config *cfg);
+int __wrap_kill(pid_t pid, int sig);
+
+/**
+ * @brief Counts programming requests, fails the one selected by the test
+ */
+static int
+test_write(void)
+{
+        m_writes++;
+
+        return m_writes == m_fail_write ? PQOS_RETVAL_ERROR : PQOS_RETVAL_OK;
+}
+
+static void
+test_hw_init(void)
+{
+        unsigned i, j;
+
+        memset(&m_hw, 0, sizeof(m_hw));
+        for (i = 0; i < DIM(m_hw.l3ca); i++)
+                for (j = 0; j < DIM(m_hw.l3ca[i]); j++) {
+                        m_hw.l3ca[i][j].class_id = j;
+                        m_hw.l3ca[i][j].u.ways_mask = 0xffff >> j;
+                }
+        for (i = 0; i < DIM(m_hw.l2ca); i++)
+                for (j = 0; j < DIM(m_hw.l2ca[i]); j++) {
+                        m_hw.l2ca[i][j].class_id = j;
+                        m_hw.l2ca[i][j].u.ways_mask = 0xff >> j;
+                }
+        for (i = 0; i < DIM(m_hw.mba); i++)
+                for (j = 0; j < DIM(m_hw.mba[i]); j++) {
+                        m_hw.mba[i][j].class_id = j;
+                        m_hw.mba[i][j].mb_max = 100 - 10 * j;
+                }
+        for (i = 0; i < DIM(m_hw.core); i++)
+                m_hw.core[i] = i % 3;
+        m_hw.task[0] = 1;
+
+        m_init_ret = PQOS_RETVAL_OK;
+        m_writes = 0;
+        m_fail_write = 0;
+        m_fail_task = 0;
+        m_exited_task = 0;
+}
+
+/**
+ * @brief Turns classes of service of \a l3cat_id into CDP ones
+ */
+static void
+test_hw_l3cdp(const unsigned l3cat_id)
+{
+        unsigned i;
+
+        for (i = 0; i < DIM(m_hw.l3ca[l3cat_id]); i++) {
+                m_hw.l3ca[l3cat_id][i].cdp = 1;
+                m_hw.l3ca[l3cat_id][i].u.s.code_mask = 0xff;
+        }
+}
+
+int
+__wrap__pqos_check_init(const int expect __attribute__((unused)))
+{
+        return m_init_ret;
+}
+
+void
+__wrap_lock_get(void)
+{
+}
+
+void
+__wrap_lock_release(void)
+{
+}
+
+int
+__wrap_os_l3ca_get(const unsigned l3cat_id,
+                   const unsigned max_num_ca,
+                   unsigned *num_ca,
+                   struct pqos_l3ca *ca)
+{
+        if (l3cat_id >= DIM(m_hw.l3ca) || max_num_ca < DIM(m_hw.l3ca[0]))
+                return PQOS_RETVAL_PARAM;
+
+        *num_ca = DIM(m_hw.l3ca[0]);
+        memcpy(ca, m_hw.l3ca[l3cat_id], sizeof(m_hw.l3ca[0]));
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_l3ca_set(const unsigned l3cat_id,
+                   const unsigned num_cos,
+                   const struct pqos_l3ca *ca)
+{
+        unsigned i;
+        int ret = test_write();
+
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+        if (l3cat_id >= DIM(m_hw.l3ca))
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < num_cos; i++) {
+                if (ca[i].class_id >= DIM(m_hw.l3ca[0]))
+                        return PQOS_RETVAL_PARAM;
+                m_hw.l3ca[l3cat_id][ca[i].class_id] = ca[i];
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_l2ca_get(const unsigned l2id,
+                   const unsigned max_num_ca,
+                   unsigned *num_ca,
+                   struct pqos_l2ca *ca)
+{
+        if (l2id >= DIM(m_hw.l2ca) || max_num_ca < DIM(m_hw.l2ca[0]))
+                return PQOS_RETVAL_PARAM;
+
+        *num_ca = DIM(m_hw.l2ca[0]);
+        memcpy(ca, m_hw.l2ca[l2id], sizeof(m_hw.l2ca[0]));
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_l2ca_set(const unsigned l2id,
+                   const unsigned num_cos,
+                   const struct pqos_l2ca *ca)
+{
+        unsigned i;
+        int ret = test_write();
+
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+        if (l2id >= DIM(m_hw.l2ca))
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < num_cos; i++) {
+                if (ca[i].class_id >= DIM(m_hw.l2ca[0]))
+                        return PQOS_RETVAL_PARAM;
+                m_hw.l2ca[l2id][ca[i].class_id] = ca[i];
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_mba_get(const unsigned mba_id,
+                  const unsigned max_num_cos,
+                  unsigned *num_cos,
+                  struct pqos_mba *mba_tab)
+{
+        if (mba_id >= DIM(m_hw.mba) || max_num_cos < DIM(m_hw.mba[0]))
+                return PQOS_RETVAL_PARAM;
+
+        *num_cos = DIM(m_hw.mba[0]);
+        memcpy(mba_tab, m_hw.mba[mba_id], sizeof(m_hw.mba[0]));
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_mba_set(const unsigned mba_id,
+                  const unsigned num_cos,
+                  const struct pqos_mba *requested,
+                  struct pqos_mba *actual)
+{
+        unsigned i;
+        int ret = test_write();
+
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+        if (mba_id >= DIM(m_hw.mba))
+                return PQOS_RETVAL_PARAM;
+
+        for (i = 0; i < num_cos; i++) {
+                if (requested[i].class_id >= DIM(m_hw.mba[0]))
+                        return PQOS_RETVAL_PARAM;
+                m_hw.mba[mba_id][requested[i].class_id] = requested[i];
+                if (actual != NULL)
+                        actual[i] = requested[i];
+        }
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_alloc_assoc_get(const unsigned lcore, unsigned *class_id)
+{
+        if (lcore >= DIM(m_hw.core))
+                return PQOS_RETVAL_PARAM;
+
+        *class_id = m_hw.core[lcore];
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_alloc_assoc_set(const unsigned lcore, const unsigned class_id)
+{
+        int ret = test_write();
+
+        if (ret != PQOS_RETVAL_OK)
+                return ret;
+        if (lcore >= DIM(m_hw.core))
+                return PQOS_RETVAL_PARAM;
+
+        m_hw.core[lcore] = class_id;
+
+        return PQOS_RETVAL_OK;
+}
+
+int
+__wrap_os_alloc_assoc_set_pid(const pid_t task, const unsigned class_id)
+{
+        if (task < 100 || task >= 100 + (pid_t)DIM(m_hw.task) ||
+            task == m_fail_task)
+                return PQOS_RETVAL_PARAM;
+
+        m_hw.task[task - 100] = class_id;
+
+        return PQOS_RETVAL_OK;
+}
+
+unsigned *
+__wrap_os_pid_get_pid_assoc(const unsigned class_id, unsigned *count)
+{
+        unsigned *tasks = calloc(DIM(m_hw.task), sizeof(*tasks));
+        unsigned i;
+
+        if (tasks == NULL)
+                return NULL;
+
+        *count = 0;
+        for (i = 0; i < DIM(m_hw.task); i++)
+                if (m_hw.task[i] == class_id)
+                        tasks[(*count)++] = 100 + i;
+
+        return tasks;
+}
+
+int
+__wrap_os_alloc_reset(const struct pqos_alloc_config *cfg
+                      __attribute__((unused)))
+{
+        int ret = test_write();
+
+        if (ret == PQOS_RETVAL_OK)
+                test_hw_init();
+
+        return ret;
+}
+
+int
+__wrap_kill(pid_t pid, int sig __attribute__((unused)))
+{
+        if (pid == m_exited_task) {
+                errno = ESRCH;
+                return -1;
+        }
+
+        return 0;
+}
+
+/* ======== setup ======== */
+
+static int
+setup_state(void **state)
+{
+        struct test_data *data;
+        int ret;
+
+        ret = test_init_all(state);
+        if (ret != 0)
+                return ret;
+
+        data = (struct test_data *)*state;
+        data->interface = PQOS_INTER_OS;
+
+        return api_init(PQOS_INTER_OS, PQOS_VENDOR_INTEL);
+}
+
+static void
+test_state_save(struct test_data *data, void **buf, size_t *size)
+{
+        int ret;
+
+        will_return_always(__wrap__pqos_get_cap, data->cap);
+        will_return_always(__wrap__pqos_get_cpu, data->cpu);
+        will_return_always(__wrap_cpuinfo_get_config, &data->config);
+
+        *buf = NULL;
+        ret = pqos_state_save(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_non_null(*buf);
+}
+
+/**
+ * @brief Saves current state, restores it over default state and checks
+ *        that restore fails without programming anything
+ */
+static void
+test_state_restore_invalid(struct test_data *data)
+{
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_state_save(data, &buf, &size);
+
+        test_hw_init();
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        assert_int_equal(m_writes, 0);
+
+        free(buf);
+}
+
+/* ======== pqos_state_save ======== */
+
+static void
+test_pqos_state_init(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        void *buf = NULL;
+        void *saved;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        test_state_save(data, &saved, &size);
+
+        m_init_ret = PQOS_RETVAL_INIT;
+        ret = pqos_state_save(&buf, &size);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+        assert_null(buf);
+
+        ret = pqos_state_restore(saved, size);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+        assert_int_equal(m_writes, 0);
+
+        free(saved);
+}
+
+static void
+test_pqos_state_param(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        void *buf;
+        size_t size;
+        int ret;
+
+        ret = pqos_state_save(NULL, &size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_state_save(&buf, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        test_hw_init();
+        test_state_save(data, &buf, &size);
+
+        ret = pqos_state_restore(NULL, size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_state_restore(buf, 1);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_state_restore(buf, size - 1);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_state_restore(buf, size / 2);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        /* corrupted signature */
+        ((uint8_t *)buf)[0] ^= 0xff;
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        assert_int_equal(m_writes, 0);
+
+        free(buf);
+}
+
+/* ======== pqos_state_restore ======== */
+
+static void
+test_pqos_state_restore_unchanged(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        test_state_save(data, &buf, &size);
+
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(m_writes, 0);
+
+        free(buf);
+}
+
+static void
+test_pqos_state_restore_round_trip(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        unsigned core[DIM(m_hw.core)];
+        struct pqos_l3ca l3ca;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        m_hw.l3ca[1][2].u.ways_mask = 0x3c;
+        m_hw.task[1] = 2;
+        l3ca = m_hw.l3ca[1][2];
+        memcpy(core, m_hw.core, sizeof(core));
+        test_state_save(data, &buf, &size);
+
+        /* one class of service of each technology and one core changed */
+        m_hw.l3ca[1][2].u.ways_mask = 0x3;
+        m_hw.l2ca[3][1].u.ways_mask = 0x1;
+        m_hw.mba[0][3].mb_max = 50;
+        m_hw.core[5] = 0;
+        m_hw.task[0] = 0;
+        m_hw.task[1] = 0;
+
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(m_writes, 4);
+
+        assert_int_equal(m_hw.l3ca[1][2].u.ways_mask, l3ca.u.ways_mask);
+        assert_int_equal(m_hw.l2ca[3][1].u.ways_mask, 0xff >> 1);
+        assert_int_equal(m_hw.mba[0][3].mb_max, 70);
+        assert_memory_equal(m_hw.core, core, sizeof(core));
+        assert_int_equal(m_hw.task[0], 1);
+        assert_int_equal(m_hw.task[1], 2);
+
+        free(buf);
+}
+
+static void
+test_pqos_state_restore_invalid(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+
+        /* zero mask */
+        test_hw_init();
+        m_hw.l3ca[0][1].u.ways_mask = 0;
+        test_state_restore_invalid(data);
+
+        /* non-contiguous mask */
+        test_hw_init();
+        m_hw.l2ca[1][1].u.ways_mask = 0x5;
+        test_state_restore_invalid(data);
+
+        /* mask exceeds number of ways */
+        test_hw_init();
+        m_hw.l3ca[0][1].u.ways_mask = 0x10000;
+        test_state_restore_invalid(data);
+
+        /* MBA rate out of range */
+        test_hw_init();
+        m_hw.mba[1][2].mb_max = 0;
+        test_state_restore_invalid(data);
+
+        test_hw_init();
+        m_hw.mba[1][2].mb_max = data->config.mba_max + 1;
+        test_state_restore_invalid(data);
+
+        /* core associated with COS not shared by all technologies */
+        test_hw_init();
+        m_hw.core[2] = 3;
+        test_state_restore_invalid(data);
+
+        /* CDP not supported */
+        test_hw_init();
+        test_hw_l3cdp(0);
+        test_hw_l3cdp(1);
+        test_state_restore_invalid(data);
+}
+
+static void
+test_pqos_state_restore_invalid_cdp(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+
+        data->cap_l3ca.cdp = 1;
+
+        /* CDP enabled on one L3 CAT id only */
+        test_hw_init();
+        test_hw_l3cdp(0);
+        test_state_restore_invalid(data);
+
+        data->cap_l3ca.cdp = 0;
+}
+
+static void
+test_pqos_state_restore_platform(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        unsigned i;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        test_state_save(data, &buf, &size);
+
+        /* fewer classes of service than in the snapshot */
+        data->cap_l3ca.num_classes = 2;
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        assert_int_equal(m_writes, 0);
+        data->cap_l3ca.num_classes = 4;
+
+        /* L2 CAT not supported */
+        for (i = 0; i < data->cap->num_cap; i++)
+                if (data->cap->capabilities[i].type == PQOS_CAP_TYPE_L2CA)
+                        break;
+        assert_true(i < data->cap->num_cap);
+        data->cap->capabilities[i].type = PQOS_CAP_TYPE_NUMOF;
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        assert_int_equal(m_writes, 0);
+        data->cap->capabilities[i].type = PQOS_CAP_TYPE_L2CA;
+
+        free(buf);
+}
+
+static void
+test_pqos_state_restore_revert(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_l3ca l3ca;
+        struct pqos_l2ca l2ca;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        test_state_save(data, &buf, &size);
+
+        m_hw.l3ca[1][2].u.ways_mask = 0x3;
+        m_hw.l2ca[3][1].u.ways_mask = 0x1;
+        l3ca = m_hw.l3ca[1][2];
+        l2ca = m_hw.l2ca[3][1];
+
+        /* L3 CAT is restored, L2 CAT fails */
+        m_fail_write = 2;
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(m_writes, 3);
+
+        assert_int_equal(m_hw.l3ca[1][2].u.ways_mask, l3ca.u.ways_mask);
+        assert_int_equal(m_hw.l2ca[3][1].u.ways_mask, l2ca.u.ways_mask);
+
+        free(buf);
+}
+
+static void
+test_pqos_state_restore_task_exited(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        m_hw.task[1] = 2;
+        test_state_save(data, &buf, &size);
+
+        m_hw.core[5] = 0;
+        m_hw.task[0] = 0;
+        m_hw.task[1] = 0;
+
+        /* task 101 exited in the meantime */
+        m_fail_task = 101;
+        m_exited_task = 101;
+        ret = pqos_state_restore(buf, size);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(m_hw.core[5], 5 % 3);
+        assert_int_equal(m_hw.task[0], 1);
+
+        free(buf);
+}
+
+static void
+test_pqos_state_restore_task_error(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        void *buf;
+        size_t size;
+        int ret;
+
+        test_hw_init();
+        m_hw.task[1] = 2;
+        test_state_save(data, &buf, &size);
+
+        m_hw.core[5] = 0;
+        m_hw.task[1] = 0;
+
+        /* running task can not be associated */
+        m_fail_task = 101;
+        ret = pqos_state_restore(buf, size);
+        assert_int_not_equal(ret, PQOS_RETVAL_OK);
+
+        /* core association is reverted */
+        assert_int_equal(m_hw.core[5], 0);
+        assert_int_equal(m_hw.task[1], 0);
+
+        free(buf);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_pqos_state_init),
+            cmocka_unit_test(test_pqos_state_param),
+            cmocka_unit_test(test_pqos_state_restore_unchanged),
+            cmocka_unit_test(test_pqos_state_restore_round_trip),
+            cmocka_unit_test(test_pqos_state_restore_invalid),
+            cmocka_unit_test(test_pqos_state_restore_invalid_cdp),
+            cmocka_unit_test(test_pqos_state_restore_platform),
+            cmocka_unit_test(test_pqos_state_restore_revert),
+            cmocka_unit_test(test_pqos_state_restore_task_exited),
+            cmocka_unit_test(test_pqos_state_restore_task_error),
+        };
+
+        result += cmocka_run_group_tests(tests, setup_state, test_fini);
+
+        return result;
+}
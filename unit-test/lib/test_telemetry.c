@@ -0,0 +1,166 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+/* ======== helpers  ======== */
+
+static char telemetry_name[64];
+
+static int
+setup_telemetry(void **state __attribute__((unused)))
+{
+        snprintf(telemetry_name, sizeof(telemetry_name), "pqos-test-%d",
+                 (int)getpid());
+        return 0;
+}
+
+/* ======== pqos_telemetry_create ======== */
+
+static void
+test_pqos_telemetry_create_param(void **state __attribute__((unused)))
+{
+        struct pqos_telemetry *telemetry;
+        int ret;
+
+        ret = pqos_telemetry_create(NULL, 1, &telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_telemetry_create("", 1, &telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_telemetry_create("a/b", 1, &telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_telemetry_create(telemetry_name, 0, &telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_telemetry_create(telemetry_name, 1, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+/* ======== pqos_telemetry_open ======== */
+
+static void
+test_pqos_telemetry_open_missing(void **state __attribute__((unused)))
+{
+        struct pqos_telemetry_reader *reader;
+        int ret;
+
+        ret = pqos_telemetry_open(telemetry_name, &reader);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        ret = pqos_telemetry_open(telemetry_name, NULL);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+}
+
+/* ======== pqos_telemetry_read ======== */
+
+static void
+test_pqos_telemetry_read(void **state __attribute__((unused)))
+{
+        struct pqos_telemetry *telemetry;
+        struct pqos_telemetry_reader *reader;
+        struct pqos_telemetry_record record;
+        struct pqos_mon_data group;
+        unsigned num;
+        int ret;
+
+        memset(&group, 0, sizeof(group));
+        group.event = PQOS_MON_EVENT_L3_OCCUP | PQOS_MON_EVENT_LMEM_BW;
+        group.values.llc = 1024;
+        group.values.mbm_local_delta = 2048;
+
+        ret = pqos_telemetry_create(telemetry_name, 2, &telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_telemetry_open(telemetry_name, &reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_telemetry_get_num(reader, &num);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(num, 2);
+
+        ret = pqos_telemetry_read(reader, 0, &record);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+        ret = pqos_telemetry_read(reader, 2, &record);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+
+        ret = pqos_telemetry_update(telemetry, 2, "0-3", &group);
+        assert_int_equal(ret, PQOS_RETVAL_PARAM);
+        ret = pqos_telemetry_update(telemetry, 1, "0-3", &group);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_telemetry_read(reader, 1, &record);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_string_equal(record.desc, "0-3");
+        assert_int_equal(record.event, group.event);
+        assert_int_equal(record.values.llc, 1024);
+        assert_int_equal(record.interval, 0);
+        assert_true(record.mbm_local_rate == 0);
+
+        /* rates are derived from the interval between updates */
+        usleep(1000);
+        ret = pqos_telemetry_update(telemetry, 1, NULL, &group);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        ret = pqos_telemetry_read(reader, 1, &record);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_string_equal(record.desc, "0-3");
+        assert_true(record.interval >= 1000000);
+        assert_true(record.mbm_local_rate > 0);
+
+        ret = pqos_telemetry_destroy(telemetry);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+
+        /* reader finds out that the publisher has gone */
+        ret = pqos_telemetry_read(reader, 1, &record);
+        assert_int_equal(ret, PQOS_RETVAL_INIT);
+
+        ret = pqos_telemetry_close(reader);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_pqos_telemetry_create_param),
+            cmocka_unit_test(test_pqos_telemetry_open_missing),
+            cmocka_unit_test(test_pqos_telemetry_read),
+        };
+
+        result += cmocka_run_group_tests(tests, setup_telemetry, NULL);
+
+        return result;
+}
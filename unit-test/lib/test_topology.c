@@ -0,0 +1,230 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "topology.h"
+
+/* ======== topo_obj_ids ======== */
+
+static void
+test_topo_obj_ids(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned *ids;
+        unsigned count;
+        int ret;
+
+        ret = topo_obj_ids(data->cpu, TOPO_OBJ_L2_CLUSTER, &ids, &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 4);
+        assert_int_equal(ids[0], 0);
+        assert_int_equal(ids[1], 1);
+        assert_int_equal(ids[2], 2);
+        assert_int_equal(ids[3], 3);
+
+        ret = topo_obj_ids(data->cpu, TOPO_OBJ_SOCKET, &ids, &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 2);
+        assert_int_equal(ids[0], 0);
+        assert_int_equal(ids[1], 1);
+}
+
+/* ======== topo_obj_idx ======== */
+
+static void
+test_topo_obj_idx(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        unsigned idx;
+        int ret;
+
+        ret = topo_obj_idx(data->cpu, TOPO_OBJ_MBA, 1, &idx);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(idx, 1);
+
+        ret = topo_obj_idx(data->cpu, TOPO_OBJ_MBA, 5, &idx);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+/* ======== topo_obj_cores ======== */
+
+static void
+test_topo_obj_cores(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned *cores;
+        unsigned count;
+        int ret;
+
+        ret = topo_obj_cores(data->cpu, TOPO_OBJ_L3_CLUSTER, 1, &cores,
+                             &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 4);
+        assert_int_equal(cores[0], 4);
+        assert_int_equal(cores[1], 5);
+        assert_int_equal(cores[2], 6);
+        assert_int_equal(cores[3], 7);
+
+        ret = topo_obj_cores(data->cpu, TOPO_OBJ_L2_CLUSTER, 2, &cores,
+                             &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 2);
+        assert_int_equal(cores[0], 4);
+        assert_int_equal(cores[1], 5);
+
+        ret = topo_obj_cores(data->cpu, TOPO_OBJ_L3CAT, 9, &cores, &count);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+/* ======== topo_core_info ======== */
+
+static void
+test_topo_core_info(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const struct pqos_coreinfo *info;
+        int ret;
+
+        ret = topo_core_info(data->cpu, 5, &info);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_ptr_equal(info, &data->cpu->cores[5]);
+
+        ret = topo_core_info(data->cpu, 8, &info);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+/* ======== sparse ids ======== */
+
+static void
+test_topo_sparse(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        struct pqos_cpuinfo *cpu;
+        const struct pqos_coreinfo *info;
+        const unsigned *cores;
+        unsigned count;
+        unsigned i;
+        int ret;
+
+        cpu = malloc(sizeof(*cpu) +
+                     data->cpu->num_cores * sizeof(struct pqos_coreinfo));
+        assert_non_null(cpu);
+        memcpy(cpu, data->cpu,
+               sizeof(*cpu) +
+                   data->cpu->num_cores * sizeof(struct pqos_coreinfo));
+        for (i = 0; i < cpu->num_cores; i++) {
+                cpu->cores[i].lcore = 100000 + i;
+                cpu->cores[i].socket = 100000 * (i % 2);
+        }
+
+        ret = topo_init(cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(topo_is_indexed(cpu), 1);
+
+        /* index of replaced topology stays valid until the next change */
+        assert_int_equal(topo_is_indexed(data->cpu), 1);
+        ret = topo_core_info(data->cpu, 6, &info);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_ptr_equal(info, &data->cpu->cores[6]);
+
+        ret = topo_obj_cores(cpu, TOPO_OBJ_SOCKET, 100000, &cores, &count);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(count, 4);
+        assert_int_equal(cores[0], 100001);
+        assert_int_equal(cores[3], 100007);
+
+        ret = topo_core_info(cpu, 100006, &info);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_ptr_equal(info, &cpu->cores[6]);
+
+        ret = topo_core_info(cpu, 6, &info);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+
+        /* only one previous index is kept */
+        ret = topo_init(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = topo_init(cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(topo_is_indexed(cpu), 1);
+        assert_int_equal(topo_is_indexed(data->cpu), 1);
+        ret = topo_init(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        ret = topo_init(data->cpu);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(topo_is_indexed(cpu), 0);
+
+        topo_fini();
+        free(cpu);
+}
+
+/* ======== not indexed ======== */
+
+static void
+test_topo_not_indexed(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        const unsigned *ids;
+        unsigned count;
+        unsigned *sockets;
+        int ret;
+
+        topo_fini();
+        assert_int_equal(topo_is_indexed(data->cpu), 0);
+
+        ret = topo_obj_ids(data->cpu, TOPO_OBJ_SOCKET, &ids, &count);
+        assert_int_equal(ret, PQOS_RETVAL_RESOURCE);
+
+        /* utility functions fall back to topology scan */
+        sockets = pqos_cpu_get_sockets(data->cpu, &count);
+        assert_non_null(sockets);
+        assert_int_equal(count, 2);
+        free(sockets);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_topo_obj_ids),
+            cmocka_unit_test(test_topo_obj_idx),
+            cmocka_unit_test(test_topo_obj_cores),
+            cmocka_unit_test(test_topo_core_info),
+            cmocka_unit_test(test_topo_sparse),
+            cmocka_unit_test(test_topo_not_indexed),
+        };
+
+        result += cmocka_run_group_tests(tests, test_init_all, test_fini);
+
+        return result;
+}
@@ -901,6 +901,7 @@ static void
 test_uncore_mon_poll_error(void **state)
 {
         struct test_data *data = (struct test_data *)*state;
+        unsigned i;
         int ret;
         struct pqos_mon_data grp;
         struct pqos_mon_data_internal intl;
@@ -914,14 +915,49 @@ test_uncore_mon_poll_error(void **state)
 
         will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
 
+        /* read fails on every core of the socket */
+        for (i = 0; i < 4; i++) {
+                expect_value(__wrap_msr_read, lcore, i);
+                /* reg_unit_ctrl = IAT_MSR_C_UNIT_CTRL + 0x10 *
+                   UNCORE_EVENT_LLC_MISS_PCIE_READ + OFFSET_CTR0 */
+                expect_value(__wrap_msr_read, reg, 3592);
+                will_return(__wrap_msr_read, MACHINE_RETVAL_ERROR);
+        }
+
+        ret = uncore_mon_poll(&grp, PQOS_PERF_EVENT_LLC_MISS_PCIE_READ);
+        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+}
+
+static void
+test_uncore_mon_poll_offline(void **state)
+{
+        struct test_data *data = (struct test_data *)*state;
+        int ret;
+        struct pqos_mon_data grp;
+        struct pqos_mon_data_internal intl;
+        unsigned sockets[] = {0};
+        uint64_t value = 0xDEAD;
+
+        memset(&grp, 0, sizeof(grp));
+        memset(&intl, 0, sizeof(intl));
+        grp.intl = &intl;
+        grp.intl->uncore.sockets = (unsigned *)&sockets;
+        grp.intl->uncore.num_sockets = DIM(sockets);
+
+        will_return_maybe(__wrap__pqos_get_cpu, data->cpu);
+
+        /* core 0 went offline, counter is read through core 1 */
         expect_value(__wrap_msr_read, lcore, 0);
-        /* reg_unit_ctrl = IAT_MSR_C_UNIT_CTRL + 0x10 *
-           UNCORE_EVENT_LLC_MISS_PCIE_READ + OFFSET_CTR0 */
         expect_value(__wrap_msr_read, reg, 3592);
         will_return(__wrap_msr_read, MACHINE_RETVAL_ERROR);
+        expect_value(__wrap_msr_read, lcore, 1);
+        expect_value(__wrap_msr_read, reg, 3592);
+        will_return(__wrap_msr_read, MACHINE_RETVAL_OK);
+        will_return(__wrap_msr_read, value);
 
         ret = uncore_mon_poll(&grp, PQOS_PERF_EVENT_LLC_MISS_PCIE_READ);
-        assert_int_equal(ret, PQOS_RETVAL_ERROR);
+        assert_int_equal(ret, PQOS_RETVAL_OK);
+        assert_int_equal(grp.intl->values.pcie.llc_misses.read, value);
 }
 
 int
@@ -953,6 +989,7 @@ main(void)
             cmocka_unit_test(test_uncore_mon_poll_llc_ref_pcie_write),
             cmocka_unit_test(test_uncore_mon_poll_param),
             cmocka_unit_test(test_uncore_mon_poll_error),
+            cmocka_unit_test(test_uncore_mon_poll_offline),
         };
 
         const struct CMUnitTest tests_neg[] = {
@@ -78,6 +78,26 @@ __wrap_hw_alloc_assign(const unsigned technology,
         return ret;
 }
 
+int
+__wrap_hw_alloc_cos_unused(const unsigned technology,
+                           const unsigned *core_array,
+                           const unsigned core_num,
+                           unsigned *class_id)
+{
+        int ret;
+
+        check_expected(technology);
+        check_expected_ptr(core_array);
+        check_expected(core_num);
+        check_expected_ptr(class_id);
+
+        ret = mock_type(int);
+        if (ret == PQOS_RETVAL_OK)
+                *class_id = mock_type(int);
+
+        return ret;
+}
+
 int
 __wrap_hw_alloc_release(const unsigned *core_array, const unsigned core_num)
 {
@@ -41,6 +41,10 @@ int __wrap_hw_alloc_assign(const unsigned technology,
                            const unsigned *core_array,
                            const unsigned core_num,
                            unsigned *class_id);
+int __wrap_hw_alloc_cos_unused(const unsigned technology,
+                               const unsigned *core_array,
+                               const unsigned core_num,
+                               unsigned *class_id);
 int __wrap_hw_alloc_release(const unsigned *core_array,
                             const unsigned core_num);
 int __wrap_hw_alloc_reset(const struct pqos_alloc_config *cfg);
@@ -40,6 +40,17 @@ __wrap_hw_mon_reset(void)
         return mock_type(int);
 }
 
+int
+__wrap_hw_mon_reclaim(unsigned *num_groups)
+{
+        int ret = mock_type(int);
+
+        if (ret == PQOS_RETVAL_OK && num_groups != NULL)
+                *num_groups = mock_type(unsigned);
+
+        return ret;
+}
+
 int
 __wrap_hw_mon_assoc_get(const unsigned lcore, pqos_rmid_t *rmid)
 {
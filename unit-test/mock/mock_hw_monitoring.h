@@ -36,6 +36,7 @@
 #include "hw_monitoring.h"
 
 int __wrap_hw_mon_reset(void);
+int __wrap_hw_mon_reclaim(unsigned *num_groups);
 int __wrap_hw_mon_assoc_get(const unsigned lcore, pqos_rmid_t *rmid);
 int __wrap_hw_mon_start_cores(const unsigned num_cores,
                               const unsigned *cores,
@@ -35,9 +35,11 @@
 #include "mock_test.h"
 
 int
-__wrap_pqos_mon_poll_events(struct pqos_mon_data *group)
+__wrap_pqos_mon_poll_events(struct pqos_mon_data *group,
+                            const enum pqos_mon_event events)
 {
         check_expected_ptr(group);
+        check_expected(events);
 
         return mock_type(int);
 }
@@ -45,6 +45,10 @@ int __wrap_os_alloc_assign(const unsigned technology,
                            const unsigned *core_array,
                            const unsigned core_num,
                            unsigned *class_id);
+int __wrap_os_alloc_cos_unused(const unsigned technology,
+                               const unsigned *core_array,
+                               const unsigned core_num,
+                               unsigned *class_id);
 int __wrap_os_alloc_release(const unsigned *core_array,
                             const unsigned core_num);
 int __wrap_os_alloc_assign_pid(const unsigned technology,
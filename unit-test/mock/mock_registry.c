@@ -0,0 +1,100 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mock_registry.h"
+
+#include "mock_test.h"
+
+#include <string.h>
+
+int
+__wrap_registry_init(void)
+{
+        return mock_type(int);
+}
+
+void
+__wrap_registry_fini(void)
+{
+}
+
+int
+__wrap_registry_is_active(void)
+{
+        return mock_type(int);
+}
+
+int
+__wrap_registry_claim(const enum registry_type type,
+                      const unsigned domain,
+                      const unsigned min_id,
+                      const unsigned max_id,
+                      uint8_t *used,
+                      unsigned *id,
+                      unsigned *lease)
+{
+        int ret;
+
+        check_expected(type);
+        check_expected(domain);
+        check_expected(min_id);
+        check_expected(max_id);
+        check_expected_ptr(used);
+
+        ret = mock_type(int);
+        if (ret == PQOS_RETVAL_OK) {
+                *id = mock_type(unsigned);
+                *lease = mock_type(unsigned);
+        }
+
+        return ret;
+}
+
+unsigned
+__wrap_registry_reclaim(const enum registry_type type,
+                        const unsigned domain,
+                        const unsigned min_id,
+                        const unsigned max_id,
+                        uint8_t *reclaimed)
+{
+        const uint8_t *ids;
+
+        check_expected(type);
+        check_expected(domain);
+        check_expected(min_id);
+        check_expected(max_id);
+
+        ids = mock_ptr_type(const uint8_t *);
+        memcpy(reclaimed, ids, max_id - min_id + 1);
+
+        return mock_type(unsigned);
+}
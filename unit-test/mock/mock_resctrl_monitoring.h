@@ -63,6 +63,8 @@ int __wrap_resctrl_mon_cpumask_write(const unsigned class_id,
 char *resctrl_mon_new_group(void);
 int resctrl_mon_mkdir(const unsigned class_id, const char *name);
 int resctrl_mon_rmdir(const unsigned class_id, const char *name);
+int resctrl_mon_proc_starttime(const pid_t pid, uint64_t *starttime);
+enum resctrl_mon_owner resctrl_mon_group_owner(const char *name);
 int resctrl_mon_cpumask_read(const unsigned class_id,
                              const char *resctrl_group,
                              struct resctrl_cpumask *mask);
@@ -0,0 +1,288 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+/* clang-format off */
+#include <cmocka.h>
+#include "proc_scan.c"
+/* clang-format on */
+
+struct test_proc {
+        char dir[64];
+        struct proc_scan *scan;
+};
+
+/**
+ * @brief Writes fake /proc/<pid>/stat file
+ *
+ * File is rewritten in place so cached descriptors see the new content.
+ */
+static void
+proc_write(const struct test_proc *data,
+           const pid_t pid,
+           const char state,
+           const unsigned ticks,
+           const unsigned starttime)
+{
+        char path[128];
+        FILE *fp;
+
+        snprintf(path, sizeof(path), "%s/%d", data->dir, pid);
+        mkdir(path, 0700);
+        snprintf(path, sizeof(path), "%s/%d/stat", data->dir, pid);
+
+        fp = fopen(path, "w");
+        assert_non_null(fp);
+        fprintf(fp,
+                "%d (proc %d) %c 1 %d %d 0 -1 4194560 100 0 0 0 %u 0 0 0 20 0 "
+                "1 0 %u 1000 100\n",
+                pid, pid, state, pid, pid, ticks, starttime);
+        fclose(fp);
+}
+
+static void
+proc_remove(const struct test_proc *data, const pid_t pid)
+{
+        char path[128];
+
+        snprintf(path, sizeof(path), "%s/%d/stat", data->dir, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d", data->dir, pid);
+        rmdir(path);
+}
+
+static int
+setup_proc(void **state)
+{
+        struct test_proc *data = calloc(1, sizeof(*data));
+
+        if (data == NULL)
+                return -1;
+
+        strcpy(data->dir, "/tmp/test_proc_scan.XXXXXX");
+        if (mkdtemp(data->dir) == NULL) {
+                free(data);
+                return -1;
+        }
+
+        data->scan = proc_scan_create(data->dir);
+        if (data->scan == NULL)
+                return -1;
+
+        *state = data;
+        return 0;
+}
+
+static int
+teardown_proc(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct dirent *file;
+        DIR *dir;
+
+        proc_scan_destroy(data->scan);
+
+        dir = opendir(data->dir);
+        while (dir != NULL && (file = readdir(dir)) != NULL)
+                if (file->d_name[0] != '.')
+                        proc_remove(data, atoi(file->d_name));
+        if (dir != NULL)
+                closedir(dir);
+        rmdir(data->dir);
+        free(data);
+
+        return 0;
+}
+
+/* ======== proc_stat_parse ======== */
+
+static void
+test_proc_stat_parse(void **state __attribute__((unused)))
+{
+        struct proc_scan_entry entry;
+        const char *stat = "42 (a) b (c)) S 7 42 42 0 -1 4194560 100 0 0 0 "
+                           "30 12 0 0 20 0 1 0 5000 1000 100\n";
+
+        memset(&entry, 0, sizeof(entry));
+        assert_int_equal(proc_stat_parse(stat, &entry), 0);
+        assert_string_equal(entry.comm, "a) b (c)");
+        assert_int_equal(entry.state, 'S');
+        assert_int_equal(entry.ppid, 7);
+        assert_int_equal(entry.ticks, 42);
+        assert_int_equal(entry.starttime, 5000);
+
+        assert_int_equal(proc_stat_parse("42 (a) S 7", &entry), -1);
+        assert_int_equal(proc_stat_parse("42 a S 7", &entry), -1);
+}
+
+/* ======== proc_scan_update ======== */
+
+static void
+test_proc_scan_update(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_scan_entry top[4];
+
+        proc_write(data, 100, 'R', 10, 1);
+        proc_write(data, 200, 'S', 20, 1);
+
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_scan_num(data->scan), 2);
+        /* no deltas after the first scan */
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 4), 0);
+
+        proc_write(data, 100, 'R', 50, 1);
+        proc_write(data, 200, 'S', 25, 1);
+        proc_write(data, 300, 'R', 1000, 1);
+
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_scan_num(data->scan), 3);
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 4), 2);
+        assert_int_equal(top[0].pid, 100);
+        assert_int_equal(top[0].ticks_delta, 40);
+        assert_int_equal(top[1].pid, 200);
+        assert_int_equal(top[1].ticks_delta, 5);
+}
+
+static void
+test_proc_scan_exit_reuse(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_scan_entry top[4];
+
+        proc_write(data, 100, 'R', 10, 1);
+        proc_write(data, 200, 'R', 10, 1);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+
+        /* 100 exits, 200 is reused by another process */
+        proc_remove(data, 100);
+        proc_write(data, 200, 'R', 30, 2);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_scan_num(data->scan), 1);
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 4), 0);
+
+        proc_write(data, 200, 'R', 35, 2);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 4), 1);
+        assert_int_equal(top[0].pid, 200);
+        assert_int_equal(top[0].ticks_delta, 5);
+}
+
+/* ======== proc_scan_top ======== */
+
+static void
+test_proc_scan_top(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_scan_entry top[3];
+        pid_t pid;
+
+        for (pid = 1; pid <= 20; pid++)
+                proc_write(data, pid, pid == 20 ? 'Z' : 'R', 0, 1);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+
+        /* CPU usage grows with PID, zombie uses the most */
+        for (pid = 1; pid <= 20; pid++)
+                proc_write(data, pid, pid == 20 ? 'Z' : 'R', pid * 10, 1);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+
+        assert_int_equal(proc_scan_top(data->scan, "RSD", top, 3), 3);
+        assert_int_equal(top[0].pid, 19);
+        assert_int_equal(top[1].pid, 18);
+        assert_int_equal(top[2].pid, 17);
+
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 3), 3);
+        assert_int_equal(top[0].pid, 20);
+        assert_int_equal(top[0].state, 'Z');
+}
+
+/* ======== proc_scan_set_fd_budget ======== */
+
+static void
+test_proc_scan_fd_budget(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct rlimit rlim;
+        struct proc_scan_entry top[4];
+        pid_t pid;
+
+        /* default budget does not touch the open files limit */
+        assert_int_equal(getrlimit(RLIMIT_NOFILE, &rlim), 0);
+        assert_true(data->scan->fd_budget <= PROC_SCAN_FD_MAX);
+        if (rlim.rlim_cur != RLIM_INFINITY)
+                assert_true(data->scan->fd_budget <= rlim.rlim_cur / 2);
+
+        for (pid = 1; pid <= 8; pid++)
+                proc_write(data, pid, 'R', 0, 1);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(data->scan->fd_used, 8);
+
+        /* lowered budget closes cached descriptors */
+        proc_scan_set_fd_budget(data->scan, 3);
+        assert_int_equal(data->scan->fd_used, 3);
+
+        /* processes above the budget are still scanned */
+        for (pid = 1; pid <= 8; pid++)
+                proc_write(data, pid, 'R', pid, 1);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(data->scan->fd_used, 3);
+        assert_int_equal(proc_scan_top(data->scan, NULL, top, 4), 4);
+        assert_int_equal(top[0].pid, 8);
+        assert_int_equal(top[0].ticks_delta, 8);
+
+        proc_scan_set_fd_budget(data->scan, 0);
+        assert_int_equal(data->scan->fd_used, 0);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_proc_stat_parse),
+            cmocka_unit_test_setup_teardown(test_proc_scan_update, setup_proc,
+                                            teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_scan_exit_reuse,
+                                            setup_proc, teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_scan_top, setup_proc,
+                                            teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_scan_fd_budget,
+                                            setup_proc, teardown_proc)};
+
+        result += cmocka_run_group_tests(tests, NULL, NULL);
+
+        return result;
+}
@@ -0,0 +1,400 @@
+/*
+ * BSD LICENSE
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+/* clang-format off */
+#include <cmocka.h>
+#include "proc_scan.c"
+#include "proc_select.c"
+/* clang-format on */
+
+struct test_proc {
+        char dir[64];
+        struct proc_scan *scan;
+};
+
+/**
+ * @brief Writes fake /proc/<pid>/stat and cmdline files
+ *
+ * Spaces in \a cmdline separate the arguments.
+ */
+static void
+proc_write(const struct test_proc *data,
+           const pid_t pid,
+           const pid_t ppid,
+           const char *comm,
+           const unsigned starttime,
+           const char *cmdline)
+{
+        char path[128];
+        char args[128] = "";
+        size_t i;
+        FILE *fp;
+
+        snprintf(path, sizeof(path), "%s/%d", data->dir, pid);
+        mkdir(path, 0700);
+
+        snprintf(path, sizeof(path), "%s/%d/stat", data->dir, pid);
+        fp = fopen(path, "w");
+        assert_non_null(fp);
+        fprintf(fp,
+                "%d (%s) S %d %d %d 0 -1 4194560 100 0 0 0 0 0 0 0 20 0 "
+                "1 0 %u 1000 100\n",
+                pid, comm, ppid, pid, pid, starttime);
+        fclose(fp);
+
+        /* arguments are NUL separated */
+        snprintf(path, sizeof(path), "%s/%d/cmdline", data->dir, pid);
+        fp = fopen(path, "w");
+        assert_non_null(fp);
+        if (cmdline != NULL) {
+                strcpy(args, cmdline);
+                for (i = 0; args[i] != '\0'; i++)
+                        if (args[i] == ' ')
+                                args[i] = '\0';
+                fwrite(args, 1, strlen(cmdline) + 1, fp);
+        }
+        fclose(fp);
+}
+
+static void
+proc_remove(const struct test_proc *data, const pid_t pid)
+{
+        char path[128];
+
+        snprintf(path, sizeof(path), "%s/%d/stat", data->dir, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d/cmdline", data->dir, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d", data->dir, pid);
+        rmdir(path);
+}
+
+static int
+setup_proc(void **state)
+{
+        struct test_proc *data = calloc(1, sizeof(*data));
+
+        if (data == NULL)
+                return -1;
+
+        strcpy(data->dir, "/tmp/test_proc_select.XXXXXX");
+        if (mkdtemp(data->dir) == NULL) {
+                free(data);
+                return -1;
+        }
+
+        data->scan = proc_scan_create(data->dir);
+        if (data->scan == NULL)
+                return -1;
+
+        *state = data;
+        return 0;
+}
+
+static int
+teardown_proc(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct dirent *file;
+        DIR *dir;
+
+        proc_scan_destroy(data->scan);
+
+        dir = opendir(data->dir);
+        while (dir != NULL && (file = readdir(dir)) != NULL)
+                if (file->d_name[0] != '.')
+                        proc_remove(data, atoi(file->d_name));
+        if (dir != NULL)
+                closedir(dir);
+        rmdir(data->dir);
+        free(data);
+
+        return 0;
+}
+
+/**
+ * @brief Checks selected PIDs
+ */
+static void
+check_pids(const struct proc_select *sel, const pid_t *expected,
+           const unsigned num)
+{
+        const pid_t *pids;
+        unsigned num_pids;
+        unsigned i;
+
+        pids = proc_select_pids(sel, &num_pids);
+        assert_int_equal(num_pids, num);
+        for (i = 0; i < num; i++)
+                assert_int_equal(pids[i], expected[i]);
+}
+
+/* ======== proc_scan_changed ======== */
+
+static void
+test_proc_scan_changed(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        const struct proc_scan_entry *const *changed;
+        unsigned num;
+
+        proc_write(data, 100, 1, "a", 1, "a");
+        proc_write(data, 200, 1, "b", 1, "b");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        changed = proc_scan_changed(data->scan, &num);
+        assert_int_equal(num, 2);
+
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        changed = proc_scan_changed(data->scan, &num);
+        assert_int_equal(num, 0);
+
+        /* exec, new process and reparenting */
+        proc_write(data, 100, 1, "c", 1, "c");
+        proc_write(data, 200, 100, "b", 1, "b");
+        proc_write(data, 300, 1, "d", 1, "d");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        changed = proc_scan_changed(data->scan, &num);
+        assert_int_equal(num, 3);
+        assert_int_equal(changed[0]->changed, 1);
+        assert_int_equal(proc_scan_get(data->scan, 200)->ppid, 100);
+        assert_null(proc_scan_get(data->scan, 400));
+}
+
+static void
+test_proc_scan_cmdline(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        char buf[16];
+
+        proc_write(data, 100, 1, "a", 1, "python -m app");
+        assert_int_equal(proc_scan_cmdline(data->scan, 100, buf, sizeof(buf)),
+                         0);
+        assert_string_equal(buf, "python -m app");
+
+        /* long command line is truncated */
+        assert_int_equal(proc_scan_cmdline(data->scan, 100, buf, 10), 0);
+        assert_string_equal(buf, "python -m");
+
+        assert_int_equal(proc_scan_cmdline(data->scan, 200, buf, sizeof(buf)),
+                         -1);
+}
+
+/* ======== proc_select_create ======== */
+
+static void
+test_proc_select_is_expr(void **state __attribute__((unused)))
+{
+        assert_int_equal(proc_select_is_expr("comm:nginx"), 1);
+        assert_int_equal(proc_select_is_expr("cmdline~x"), 1);
+        assert_int_equal(proc_select_is_expr("user:root"), 1);
+        assert_int_equal(proc_select_is_expr("ppid:1"), 1);
+        assert_int_equal(proc_select_is_expr("all:1,2"), 0);
+        assert_int_equal(proc_select_is_expr("1-3"), 0);
+        assert_int_equal(proc_select_is_expr(NULL), 0);
+}
+
+static void
+test_proc_select_create_invalid(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        const char *const invalid[] = {"comm:",
+                                       "comm:0123456789abcdef",
+                                       "cmdline~(",
+                                       "ppid:x",
+                                       "ppid:0",
+                                       "ppid:5+kids",
+                                       "user:no-such-user-exists",
+                                       "pid:1"};
+        unsigned i;
+
+        for (i = 0; i < DIM(invalid); i++)
+                assert_null(proc_select_create(invalid[i], data->scan));
+}
+
+/* ======== proc_select_update ======== */
+
+static void
+test_proc_select_comm(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_select *sel;
+        const pid_t first[] = {100, 200};
+        const pid_t second[] = {300};
+
+        sel = proc_select_create("comm:nginx", data->scan);
+        assert_non_null(sel);
+        assert_string_equal(proc_select_expr(sel), "comm:nginx");
+
+        proc_write(data, 200, 1, "nginx", 1, "nginx");
+        proc_write(data, 100, 1, "nginx", 1, "nginx");
+        proc_write(data, 150, 1, "bash", 1, "bash");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(sel, data->scan), 0);
+        check_pids(sel, first, DIM(first));
+
+        /* 100 exits, 200 executes other program, 300 starts */
+        proc_remove(data, 100);
+        proc_write(data, 200, 1, "sh", 1, "sh");
+        proc_write(data, 300, 1, "nginx", 2, "nginx");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(sel, data->scan), 0);
+        check_pids(sel, second, DIM(second));
+
+        /* 300 reused by another program without a rescan in between */
+        proc_write(data, 300, 1, "bash", 3, "bash");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(sel, data->scan), 0);
+        check_pids(sel, NULL, 0);
+
+        proc_select_destroy(sel);
+}
+
+static void
+test_proc_select_cmdline(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_select *sel;
+        const pid_t expected[] = {100, 300};
+
+        proc_write(data, 100, 1, "python", 1, "python worker.py -n 1");
+        proc_write(data, 200, 1, "python", 1, "python server.py");
+        proc_write(data, 300, 1, "python3", 1, "/usr/bin/python3 worker.py");
+        proc_write(data, 400, 2, "kworker", 1, NULL);
+        assert_int_equal(proc_scan_update(data->scan), 0);
+
+        /* selector created after the first scan resolves all processes */
+        sel = proc_select_create("cmdline~python[0-9]* worker", data->scan);
+        assert_non_null(sel);
+        assert_int_equal(proc_select_update(sel, data->scan), 0);
+        check_pids(sel, expected, DIM(expected));
+
+        proc_select_destroy(sel);
+}
+
+static void
+test_proc_select_ppid(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_select *children;
+        struct proc_select *descendants;
+        const pid_t direct[] = {11, 13};
+        const pid_t all[] = {11, 12, 13};
+        const pid_t left[] = {13};
+
+        proc_write(data, 10, 1, "init", 1, "init");
+        proc_write(data, 11, 10, "a", 1, "a");
+        proc_write(data, 12, 11, "b", 1, "b");
+        proc_write(data, 13, 10, "c", 1, "c");
+        proc_write(data, 20, 1, "d", 1, "d");
+
+        children = proc_select_create("ppid:10", data->scan);
+        assert_non_null(children);
+        descendants = proc_select_create("ppid:10+descendants", data->scan);
+        assert_non_null(descendants);
+
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(children, data->scan), 0);
+        assert_int_equal(proc_select_update(descendants, data->scan), 0);
+        check_pids(children, direct, DIM(direct));
+        check_pids(descendants, all, DIM(all));
+
+        /* 11 is reparented, its unchanged child leaves with it */
+        proc_write(data, 11, 1, "a", 1, "a");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(children, data->scan), 0);
+        assert_int_equal(proc_select_update(descendants, data->scan), 0);
+        check_pids(children, left, DIM(left));
+        check_pids(descendants, left, DIM(left));
+
+        proc_select_destroy(children);
+        proc_select_destroy(descendants);
+}
+
+static void
+test_proc_select_user(void **state)
+{
+        struct test_proc *data = (struct test_proc *)*state;
+        struct proc_select *owner;
+        struct proc_select *other;
+        const pid_t expected[] = {100, 200};
+        char expr[32];
+
+        /* fake process directories are owned by the test user */
+        snprintf(expr, sizeof(expr), "user:%u", (unsigned)getuid());
+        owner = proc_select_create(expr, data->scan);
+        assert_non_null(owner);
+        snprintf(expr, sizeof(expr), "user:%u", (unsigned)getuid() + 1);
+        other = proc_select_create(expr, data->scan);
+        assert_non_null(other);
+
+        proc_write(data, 100, 1, "a", 1, "a");
+        proc_write(data, 200, 1, "b", 1, "b");
+        assert_int_equal(proc_scan_update(data->scan), 0);
+        assert_int_equal(proc_select_update(owner, data->scan), 0);
+        assert_int_equal(proc_select_update(other, data->scan), 0);
+        check_pids(owner, expected, DIM(expected));
+        check_pids(other, NULL, 0);
+
+        proc_select_destroy(owner);
+        proc_select_destroy(other);
+}
+
+int
+main(void)
+{
+        int result = 0;
+
+        const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup_teardown(test_proc_scan_changed,
+                                            setup_proc, teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_scan_cmdline,
+                                            setup_proc, teardown_proc),
+            cmocka_unit_test(test_proc_select_is_expr),
+            cmocka_unit_test_setup_teardown(test_proc_select_create_invalid,
+                                            setup_proc, teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_select_comm, setup_proc,
+                                            teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_select_cmdline,
+                                            setup_proc, teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_select_ppid, setup_proc,
+                                            teardown_proc),
+            cmocka_unit_test_setup_teardown(test_proc_select_user, setup_proc,
+                                            teardown_proc)};
+
+        result += cmocka_run_group_tests(tests, NULL, NULL);
+
+        return result;
+}